@@ -43,6 +43,7 @@ BasicTaskScheduler::BasicTaskScheduler(unsigned maxSchedulerGranularity)
   FD_ZERO(&fExceptionSet);
 
   if (maxSchedulerGranularity > 0) schedulerTickTask(); // ensures that we handle events frequently
+  setUpPostedEventWakeup(); // ensures that "postEvent()" wakes us up
 }
 
 BasicTaskScheduler::~BasicTaskScheduler() {
@@ -177,36 +178,7 @@ void BasicTaskScheduler::SingleStep(unsigned maxDelayTime) {
 
   // Also handle any newly-triggered event (Note that we do this *after* calling a socket handler,
   // in case the triggered event handler modifies The set of readable sockets.)
-  if (fTriggersAwaitingHandling != 0) {
-    if (fTriggersAwaitingHandling == fLastUsedTriggerMask) {
-      // Common-case optimization for a single event trigger:
-      fTriggersAwaitingHandling &=~ fLastUsedTriggerMask;
-      if (fTriggeredEventHandlers[fLastUsedTriggerNum] != NULL) {
-	(*fTriggeredEventHandlers[fLastUsedTriggerNum])(fTriggeredEventClientDatas[fLastUsedTriggerNum]);
-      }
-    } else {
-      // Look for an event trigger that needs handling (making sure that we make forward progress through all possible triggers):
-      unsigned i = fLastUsedTriggerNum;
-      EventTriggerId mask = fLastUsedTriggerMask;
-
-      do {
-	i = (i+1)%MAX_NUM_EVENT_TRIGGERS;
-	mask >>= 1;
-	if (mask == 0) mask = 0x80000000;
-
-	if ((fTriggersAwaitingHandling&mask) != 0) {
-	  fTriggersAwaitingHandling &=~ mask;
-	  if (fTriggeredEventHandlers[i] != NULL) {
-	    (*fTriggeredEventHandlers[i])(fTriggeredEventClientDatas[i]);
-	  }
-
-	  fLastUsedTriggerMask = mask;
-	  fLastUsedTriggerNum = i;
-	  break;
-	}
-      } while (i != fLastUsedTriggerNum);
-    }
-  }
+  handleTriggeredEvent();
 
   // Also handle any delayed event that may have come due.
   fDelayQueue.handleAlarm();
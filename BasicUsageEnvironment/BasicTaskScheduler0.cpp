@@ -19,6 +19,29 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 
 #include "BasicUsageEnvironment0.hh"
 #include "HandlerSet.hh"
+#if !defined(__WIN32__) && !defined(_WIN32)
+#include <unistd.h>
+#include <fcntl.h>
+#endif
+#if defined(__linux__)
+#include <sys/eventfd.h>
+#endif
+
+// Atomic operations, used to implement "postEvent()":
+#if defined(__WIN32__) || defined(_WIN32)
+#include <windows.h>
+static inline void* atomicExchangePtr(void* volatile* ptr, void* val) { return InterlockedExchangePointer(ptr, val); }
+static inline void* atomicLoadPtr(void* volatile* ptr) { void* result = *ptr; MemoryBarrier(); return result; }
+static inline void atomicStorePtr(void* volatile* ptr, void* val) { MemoryBarrier(); *ptr = val; }
+static inline int atomicExchangeInt(int volatile* ptr, int val) { return (int)InterlockedExchange((LONG volatile*)ptr, val); }
+static inline void atomicStoreInt(int volatile* ptr, int val) { InterlockedExchange((LONG volatile*)ptr, val); }
+#else
+static inline void* atomicExchangePtr(void* volatile* ptr, void* val) { return __atomic_exchange_n(ptr, val, __ATOMIC_SEQ_CST); }
+static inline void* atomicLoadPtr(void* volatile* ptr) { return __atomic_load_n(ptr, __ATOMIC_ACQUIRE); }
+static inline void atomicStorePtr(void* volatile* ptr, void* val) { __atomic_store_n(ptr, val, __ATOMIC_RELEASE); }
+static inline int atomicExchangeInt(int volatile* ptr, int val) { return __atomic_exchange_n(ptr, val, __ATOMIC_SEQ_CST); }
+static inline void atomicStoreInt(int volatile* ptr, int val) { __atomic_store_n(ptr, val, __ATOMIC_SEQ_CST); }
+#endif
 
 ////////// A subclass of DelayQueueEntry,
 //////////     used to implement BasicTaskScheduler0::scheduleDelayedTask()
@@ -44,15 +67,33 @@ private:
 ////////// BasicTaskScheduler0 //////////
 
 BasicTaskScheduler0::BasicTaskScheduler0()
-  : fLastHandledSocketNum(-1), fTriggersAwaitingHandling(0), fLastUsedTriggerMask(1), fLastUsedTriggerNum(MAX_NUM_EVENT_TRIGGERS-1) {
+  : fLastHandledSocketNum(-1), fTriggersAwaitingHandling(0), fLastUsedTriggerMask(1), fLastUsedTriggerNum(MAX_NUM_EVENT_TRIGGERS-1),
+    fPostedEventHead(&fPostedEventStub), fPostedEventTail(&fPostedEventStub), fPostedEventWakeupPending(0),
+    fPostedEventWakeupReadFd(-1), fPostedEventWakeupWriteFd(-1) {
   fHandlers = new HandlerSet;
   for (unsigned i = 0; i < MAX_NUM_EVENT_TRIGGERS; ++i) {
     fTriggeredEventHandlers[i] = NULL;
     fTriggeredEventClientDatas[i] = NULL;
   }
+
+  fPostedEventStub.next = NULL;
+  fPostedEventStub.handlerProc = NULL;
+  fPostedEventStub.clientData = NULL;
 }
 
 BasicTaskScheduler0::~BasicTaskScheduler0() {
+  // Delete any posted events that were never handled:
+  PostedEvent* event = fPostedEventHead;
+  while (event != NULL) {
+    PostedEvent* nextEvent = event->next;
+    if (event != &fPostedEventStub) delete event;
+    event = nextEvent;
+  }
+
+#if !defined(__WIN32__) && !defined(_WIN32)
+  if (fPostedEventWakeupReadFd >= 0) close(fPostedEventWakeupReadFd);
+  if (fPostedEventWakeupWriteFd >= 0 && fPostedEventWakeupWriteFd != fPostedEventWakeupReadFd) close(fPostedEventWakeupWriteFd);
+#endif
   delete fHandlers;
 }
 
@@ -142,6 +183,139 @@ void BasicTaskScheduler0::triggerEvent(EventTriggerId eventTriggerId, void* clie
   fTriggersAwaitingHandling |= eventTriggerId;
 }
 
+Boolean BasicTaskScheduler0::postEvent(TaskFunc* handlerProc, void* clientData) {
+  PostedEvent* event = new PostedEvent;
+  event->next = NULL;
+  event->handlerProc = handlerProc;
+  event->clientData = clientData;
+
+  // Append "event" to the queue.  (Only the swap of "fPostedEventTail" needs to be atomic; until the following
+  // store to "prevTail->next", the event loop simply sees the queue as ending at "prevTail".)
+  PostedEvent* prevTail = (PostedEvent*)atomicExchangePtr((void* volatile*)&fPostedEventTail, event);
+  atomicStorePtr((void* volatile*)&prevTail->next, event);
+
+  // Then, wake up the event loop - unless a previous (still unhandled) wakeup will do this for us:
+  if (atomicExchangeInt(&fPostedEventWakeupPending, 1) == 0) wakeUpForPostedEvents();
+  return True;
+}
+
+void BasicTaskScheduler0::setUpPostedEventWakeup() {
+  if (fPostedEventWakeupReadFd >= 0) return; // we've already done this
+
+#if defined(__linux__)
+  fPostedEventWakeupReadFd = fPostedEventWakeupWriteFd = eventfd(0, EFD_NONBLOCK|EFD_CLOEXEC);
+#elif !defined(__WIN32__) && !defined(_WIN32)
+  int fds[2];
+  if (pipe(fds) == 0) {
+    fcntl(fds[0], F_SETFL, fcntl(fds[0], F_GETFL, 0)|O_NONBLOCK);
+    fcntl(fds[1], F_SETFL, fcntl(fds[1], F_GETFL, 0)|O_NONBLOCK);
+    fPostedEventWakeupReadFd = fds[0];
+    fPostedEventWakeupWriteFd = fds[1];
+  }
+#endif
+  // (Otherwise, posted events get handled - without any explicit wakeup - within the scheduler's 'granularity'.)
+
+  if (fPostedEventWakeupReadFd >= 0) {
+    setBackgroundHandling(fPostedEventWakeupReadFd, SOCKET_READABLE, postedEventWakeupHandler, this);
+  }
+}
+
+void BasicTaskScheduler0::wakeUpForPostedEvents() {
+#if !defined(__WIN32__) && !defined(_WIN32)
+  if (fPostedEventWakeupWriteFd >= 0) {
+    u_int64_t one = 1; // (an "eventfd" requires an 8-byte write; a pipe doesn't care)
+    if (write(fPostedEventWakeupWriteFd, &one, sizeof one) < 0) {
+      // The "eventfd" counter (or pipe) is already full, so the event loop is already due to wake up
+    }
+  }
+#endif
+}
+
+void BasicTaskScheduler0::postedEventWakeupHandler(void* clientData, int /*mask*/) {
+  BasicTaskScheduler0* scheduler = (BasicTaskScheduler0*)clientData;
+
+#if !defined(__WIN32__) && !defined(_WIN32)
+  u_int64_t buf[16];
+  while (read(scheduler->fPostedEventWakeupReadFd, buf, sizeof buf) > 0) {}
+#endif
+
+  // Allow the next "postEvent()" to signal a new wakeup.  We do this *before* handling the queue, so that any event that's
+  // posted after our handling - having seen "fPostedEventWakeupPending" as 1 - is guaranteed to get handled here:
+  atomicStoreInt(&scheduler->fPostedEventWakeupPending, 0);
+  scheduler->handlePostedEvents();
+}
+
+#define MAX_POSTED_EVENTS_PER_STEP 256
+
+void BasicTaskScheduler0::handlePostedEvents() {
+  for (unsigned numHandled = 0; numHandled < MAX_POSTED_EVENTS_PER_STEP; ++numHandled) {
+    // Dequeue the next event (if any).  (This is the consumer side of a Vyukov-style 'intrusive' MPSC queue.)
+    PostedEvent* head = fPostedEventHead;
+    PostedEvent* next = (PostedEvent*)atomicLoadPtr((void* volatile*)&head->next);
+    if (head == &fPostedEventStub) {
+      if (next == NULL) return; // the queue is empty
+      fPostedEventHead = head = next;
+      next = (PostedEvent*)atomicLoadPtr((void* volatile*)&head->next);
+    }
+
+    if (next == NULL) {
+      // "head" is the last event in the queue (unless another thread is still in the middle of adding one).
+      // Before we can dequeue it, we need to put the 'stub' entry behind it:
+      if (head != (PostedEvent*)atomicLoadPtr((void* volatile*)&fPostedEventTail)) return; // try again later
+      fPostedEventStub.next = NULL;
+      PostedEvent* prevTail = (PostedEvent*)atomicExchangePtr((void* volatile*)&fPostedEventTail, &fPostedEventStub);
+      atomicStorePtr((void* volatile*)&prevTail->next, &fPostedEventStub);
+
+      next = (PostedEvent*)atomicLoadPtr((void* volatile*)&head->next);
+      if (next == NULL) return; // try again later
+    }
+    fPostedEventHead = next;
+
+    TaskFunc* handlerProc = head->handlerProc;
+    void* clientData = head->clientData;
+    delete head;
+    if (handlerProc != NULL) (*handlerProc)(clientData);
+  }
+
+  // There may be more events, but we've handled enough for now.  Make sure that we don't wait before handling the rest:
+  if (atomicExchangeInt(&fPostedEventWakeupPending, 1) == 0) wakeUpForPostedEvents();
+}
+
+void BasicTaskScheduler0::handleTriggeredEvent() {
+  handlePostedEvents();
+
+  if (fTriggersAwaitingHandling != 0) {
+    if (fTriggersAwaitingHandling == fLastUsedTriggerMask) {
+      // Common-case optimization for a single event trigger:
+      fTriggersAwaitingHandling &=~ fLastUsedTriggerMask;
+      if (fTriggeredEventHandlers[fLastUsedTriggerNum] != NULL) {
+	(*fTriggeredEventHandlers[fLastUsedTriggerNum])(fTriggeredEventClientDatas[fLastUsedTriggerNum]);
+      }
+    } else {
+      // Look for an event trigger that needs handling (making sure that we make forward progress through all possible triggers):
+      unsigned i = fLastUsedTriggerNum;
+      EventTriggerId mask = fLastUsedTriggerMask;
+
+      do {
+	i = (i+1)%MAX_NUM_EVENT_TRIGGERS;
+	mask >>= 1;
+	if (mask == 0) mask = 0x80000000;
+
+	if ((fTriggersAwaitingHandling&mask) != 0) {
+	  fTriggersAwaitingHandling &=~ mask;
+	  if (fTriggeredEventHandlers[i] != NULL) {
+	    (*fTriggeredEventHandlers[i])(fTriggeredEventClientDatas[i]);
+	  }
+
+	  fLastUsedTriggerMask = mask;
+	  fLastUsedTriggerNum = i;
+	  break;
+	}
+      } while (i != fLastUsedTriggerNum);
+    }
+  }
+}
+
 
 ////////// HandlerSet (etc.) implementation //////////
 
@@ -19,6 +19,7 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 // Implementation
 
 #include "DelayQueue.hh"
+#include "HashTable.hh"
 #include "GroupsockHelper.hh"
 
 static const int MILLION = 1000000;
@@ -95,9 +96,19 @@ const DelayInterval ETERNITY(INT_MAX, MILLION-1);
 intptr_t DelayQueueEntry::tokenCounter = 0;
 
 DelayQueueEntry::DelayQueueEntry(DelayInterval delay)
-  : fDeltaTimeRemaining(delay) {
-  fNext = fPrev = this;
-  fToken = ++tokenCounter;
+  : fNext(NULL), fPrev(NULL), fDelay(delay), fExpirationTime(0), fSlotNum(-1) {
+  // Note: Entries can be created - for different schedulers - by several threads at once, so the (shared) token counter
+  // must be incremented atomically.  (Otherwise two entries could get the same token, and one would be found - e.g., by
+  // "unscheduleDelayedTask()" - in place of the other.)
+#if defined(__WIN32__) || defined(_WIN32)
+#if defined(_WIN64)
+  fToken = (intptr_t)InterlockedIncrement64((LONGLONG volatile*)&tokenCounter);
+#else
+  fToken = (intptr_t)InterlockedIncrement((LONG volatile*)&tokenCounter);
+#endif
+#else
+  fToken = __sync_add_and_fetch(&tokenCounter, 1);
+#endif
 }
 
 DelayQueueEntry::~DelayQueueEntry() {
@@ -110,41 +121,52 @@ void DelayQueueEntry::handleTimeout() {
 
 ///// DelayQueue /////
 
+#define OVERFLOW_SLOT_NUM (DELAY_QUEUE_NUM_SLOTS-1)
+
+static unsigned lowestSetBit(u_int64_t bits) { // "bits" must be nonzero
+#if defined(__GNUC__)
+  return (unsigned)__builtin_ctzll(bits);
+#else
+  unsigned result = 0;
+  while ((bits&1) == 0) { bits >>= 1; ++result; }
+  return result;
+#endif
+}
+
 DelayQueue::DelayQueue()
-  : DelayQueueEntry(ETERNITY) {
+  : fCurrentTime(0), fCurrentTick(0), fTimeToNextAlarm(DELAY_ZERO) {
   fLastSyncTime = TimeNow();
+  for (unsigned i = 0; i < DELAY_QUEUE_NUM_SLOTS; ++i) fSlotHeads[i] = fSlotTails[i] = NULL;
+  for (unsigned i = 0; i < DELAY_QUEUE_NUM_LEVELS; ++i) fOccupiedSlots[i] = 0;
+  fEntriesByToken = HashTable::create(ONE_WORD_HASH_KEYS);
 }
 
 DelayQueue::~DelayQueue() {
-  while (fNext != this) {
-    DelayQueueEntry* entryToRemove = fNext;
-    removeEntry(entryToRemove);
-    delete entryToRemove;
+  for (unsigned i = 0; i < DELAY_QUEUE_NUM_SLOTS; ++i) {
+    while (fSlotHeads[i] != NULL) {
+      DelayQueueEntry* entryToRemove = fSlotHeads[i];
+      removeEntry(entryToRemove);
+      delete entryToRemove;
+    }
   }
+  delete fEntriesByToken;
 }
 
 void DelayQueue::addEntry(DelayQueueEntry* newEntry) {
+  if (newEntry == NULL || newEntry->fSlotNum >= 0) return; // sanity check
   synchronize();
 
-  DelayQueueEntry* cur = head();
-  while (newEntry->fDeltaTimeRemaining >= cur->fDeltaTimeRemaining) {
-    newEntry->fDeltaTimeRemaining -= cur->fDeltaTimeRemaining;
-    cur = cur->fNext;
-  }
-
-  cur->fDeltaTimeRemaining -= newEntry->fDeltaTimeRemaining;
-
-  // Add "newEntry" to the queue, just before "cur":
-  newEntry->fNext = cur;
-  newEntry->fPrev = cur->fPrev;
-  cur->fPrev = newEntry->fPrev->fNext = newEntry;
+  newEntry->fExpirationTime = fCurrentTime
+    + (u_int64_t)newEntry->fDelay.seconds()*MILLION + newEntry->fDelay.useconds();
+  insertIntoSlot(newEntry);
+  fEntriesByToken->Add((char const*)(newEntry->token()), newEntry);
 }
 
 void DelayQueue::updateEntry(DelayQueueEntry* entry, DelayInterval newDelay) {
   if (entry == NULL) return;
 
   removeEntry(entry);
-  entry->fDeltaTimeRemaining = newDelay;
+  entry->fDelay = newDelay;
   addEntry(entry);
 }
 
@@ -154,13 +176,11 @@ void DelayQueue::updateEntry(intptr_t tokenToFind, DelayInterval newDelay) {
 }
 
 void DelayQueue::removeEntry(DelayQueueEntry* entry) {
-  if (entry == NULL || entry->fNext == NULL) return;
+  if (entry == NULL || entry->fSlotNum < 0) return;
+  // (Checking "fSlotNum" handles the case where we try to remove the entry again.)
 
-  entry->fNext->fDeltaTimeRemaining += entry->fDeltaTimeRemaining;
-  entry->fPrev->fNext = entry->fNext;
-  entry->fNext->fPrev = entry->fPrev;
-  entry->fNext = entry->fPrev = NULL;
-  // in case we should try to remove it again
+  removeFromSlot(entry);
+  fEntriesByToken->Remove((char const*)(entry->token()));
 }
 
 DelayQueueEntry* DelayQueue::removeEntry(intptr_t tokenToFind) {
@@ -170,32 +190,61 @@ DelayQueueEntry* DelayQueue::removeEntry(intptr_t tokenToFind) {
 }
 
 DelayInterval const& DelayQueue::timeToNextAlarm() {
-  if (head()->fDeltaTimeRemaining == DELAY_ZERO) return DELAY_ZERO; // a common case
-
   synchronize();
-  return head()->fDeltaTimeRemaining;
+
+  u_int64_t uSecondsToDelay;
+  if (fOccupiedSlots[0] != 0) {
+    // The earliest entry is at the head of the first non-empty level 0 slot:
+    DelayQueueEntry* nextEntry = fSlotHeads[lowestSetBit(fOccupiedSlots[0])];
+    if (nextEntry->fExpirationTime <= fCurrentTime) return DELAY_ZERO; // a common case
+
+    uSecondsToDelay = nextEntry->fExpirationTime - fCurrentTime;
+  } else {
+    // The earliest entry is in a higher-level slot.  Wake up when that slot is due to be cascaded
+    // (at which point we'll know the entry's exact expiration time):
+    unsigned level;
+    for (level = 1; level < DELAY_QUEUE_NUM_LEVELS; ++level) {
+      if (fOccupiedSlots[level] != 0) break;
+    }
+
+    u_int64_t nextTick;
+    if (level < DELAY_QUEUE_NUM_LEVELS) {
+      unsigned shift = level*DELAY_QUEUE_LEVEL_BITS;
+      nextTick = ((fCurrentTick>>(shift+DELAY_QUEUE_LEVEL_BITS))<<(shift+DELAY_QUEUE_LEVEL_BITS))
+	| ((u_int64_t)lowestSetBit(fOccupiedSlots[level])<<shift);
+    } else if (fSlotHeads[OVERFLOW_SLOT_NUM] != NULL) {
+      unsigned shift = DELAY_QUEUE_NUM_LEVELS*DELAY_QUEUE_LEVEL_BITS;
+      nextTick = ((fCurrentTick>>shift) + 1)<<shift;
+    } else {
+      // The queue is empty:
+      return ETERNITY;
+    }
+
+    u_int64_t nextTime = nextTick<<DELAY_QUEUE_TICK_SHIFT;
+    uSecondsToDelay = nextTime > fCurrentTime ? nextTime - fCurrentTime : 0;
+  }
+
+  fTimeToNextAlarm = DelayInterval((time_base_seconds)(uSecondsToDelay/MILLION),
+				   (time_base_seconds)(uSecondsToDelay%MILLION));
+  return fTimeToNextAlarm;
 }
 
 void DelayQueue::handleAlarm() {
-  if (head()->fDeltaTimeRemaining != DELAY_ZERO) synchronize();
+  synchronize();
 
-  if (head()->fDeltaTimeRemaining == DELAY_ZERO) {
-    // This event is due to be handled:
-    DelayQueueEntry* toRemove = head();
-    removeEntry(toRemove); // do this first, in case handler accesses queue
+  if (fOccupiedSlots[0] != 0) {
+    DelayQueueEntry* nextEntry = fSlotHeads[lowestSetBit(fOccupiedSlots[0])];
+    if (nextEntry->fExpirationTime <= fCurrentTime) {
+      // This event is due to be handled:
+      removeEntry(nextEntry); // do this first, in case handler accesses queue
 
-    toRemove->handleTimeout();
+      nextEntry->handleTimeout();
+    }
   }
 }
 
 DelayQueueEntry* DelayQueue::findEntryByToken(intptr_t tokenToFind) {
-  DelayQueueEntry* cur = head();
-  while (cur != this) {
-    if (cur->token() == tokenToFind) return cur;
-    cur = cur->fNext;
-  }
-
-  return NULL;
+  return (DelayQueueEntry*)(fEntriesByToken->Lookup((char const*)tokenToFind));
 }
 
 void DelayQueue::synchronize() {
@@ -208,15 +257,112 @@ void DelayQueue::synchronize() {
   }
   DelayInterval timeSinceLastSync = timeNow - fLastSyncTime;
   fLastSyncTime = timeNow;
+  fCurrentTime += (u_int64_t)timeSinceLastSync.seconds()*MILLION + timeSinceLastSync.useconds();
+
+  // Then, advance the wheel's current tick, cascading any higher-level slots that we reach:
+  u_int64_t const targetTick = fCurrentTime>>DELAY_QUEUE_TICK_SHIFT;
+  while (fCurrentTick < targetTick) {
+    if (fOccupiedSlots[0] != 0) {
+      // We can't move past the current level 0 'rotation' until all of its entries have been handled:
+      u_int64_t const lastTickInRotation = fCurrentTick|(DELAY_QUEUE_SLOTS_PER_LEVEL-1);
+      fCurrentTick = targetTick < lastTickInRotation ? targetTick : lastTickInRotation;
+      break;
+    }
+
+    // Find the next higher-level slot that will need to be cascaded:
+    unsigned level;
+    for (level = 1; level < DELAY_QUEUE_NUM_LEVELS; ++level) {
+      if (fOccupiedSlots[level] != 0) break;
+    }
+
+    u_int64_t nextTick;
+    int slotNum;
+    if (level < DELAY_QUEUE_NUM_LEVELS) {
+      unsigned const index = lowestSetBit(fOccupiedSlots[level]);
+      unsigned const shift = level*DELAY_QUEUE_LEVEL_BITS;
+      nextTick = ((fCurrentTick>>(shift+DELAY_QUEUE_LEVEL_BITS))<<(shift+DELAY_QUEUE_LEVEL_BITS))
+	| ((u_int64_t)index<<shift);
+      slotNum = level*DELAY_QUEUE_SLOTS_PER_LEVEL + index;
+    } else if (fSlotHeads[OVERFLOW_SLOT_NUM] != NULL) {
+      unsigned const shift = DELAY_QUEUE_NUM_LEVELS*DELAY_QUEUE_LEVEL_BITS;
+      nextTick = ((fCurrentTick>>shift) + 1)<<shift;
+      slotNum = OVERFLOW_SLOT_NUM;
+    } else {
+      // The wheel is empty, so we can jump straight to the target:
+      fCurrentTick = targetTick;
+      break;
+    }
+
+    if (nextTick > targetTick) {
+      fCurrentTick = targetTick;
+      break;
+    }
+    fCurrentTick = nextTick;
+    cascade(slotNum);
+  }
+}
+
+void DelayQueue::insertIntoSlot(DelayQueueEntry* entry) {
+  u_int64_t tick = entry->fExpirationTime>>DELAY_QUEUE_TICK_SHIFT;
+  if (tick < fCurrentTick) tick = fCurrentTick; // overdue
+
+  // The entry's level is determined by the highest group of bits in which its tick differs from the current tick:
+  u_int64_t const diff = tick^fCurrentTick;
+  unsigned level = 0;
+  while (level < DELAY_QUEUE_NUM_LEVELS && (diff>>((level+1)*DELAY_QUEUE_LEVEL_BITS)) != 0) ++level;
+
+  int slotNum;
+  if (level < DELAY_QUEUE_NUM_LEVELS) {
+    unsigned const index = (unsigned)(tick>>(level*DELAY_QUEUE_LEVEL_BITS))&(DELAY_QUEUE_SLOTS_PER_LEVEL-1);
+    slotNum = level*DELAY_QUEUE_SLOTS_PER_LEVEL + index;
+    fOccupiedSlots[level] |= ((u_int64_t)1)<<index;
+  } else {
+    slotNum = OVERFLOW_SLOT_NUM;
+  }
+  entry->fSlotNum = slotNum;
+
+  // Level 0 slots are kept sorted by expiration time (with entries that expire at the same time kept in
+  // the order that they were added).  Other slots are unsorted:
+  DelayQueueEntry* prev = fSlotTails[slotNum];
+  if (level == 0) {
+    while (prev != NULL && prev->fExpirationTime > entry->fExpirationTime) prev = prev->fPrev;
+  }
+
+  // Add "entry" to the slot, just after "prev":
+  entry->fPrev = prev;
+  entry->fNext = prev == NULL ? fSlotHeads[slotNum] : prev->fNext;
+  if (entry->fNext == NULL) fSlotTails[slotNum] = entry; else entry->fNext->fPrev = entry;
+  if (prev == NULL) fSlotHeads[slotNum] = entry; else prev->fNext = entry;
+}
+
+void DelayQueue::removeFromSlot(DelayQueueEntry* entry) {
+  int const slotNum = entry->fSlotNum;
+
+  if (entry->fPrev == NULL) fSlotHeads[slotNum] = entry->fNext; else entry->fPrev->fNext = entry->fNext;
+  if (entry->fNext == NULL) fSlotTails[slotNum] = entry->fPrev; else entry->fNext->fPrev = entry->fPrev;
+  entry->fNext = entry->fPrev = NULL;
+  entry->fSlotNum = -1;
+
+  if (fSlotHeads[slotNum] == NULL && slotNum != OVERFLOW_SLOT_NUM) {
+    fOccupiedSlots[slotNum/DELAY_QUEUE_SLOTS_PER_LEVEL] &=~ (((u_int64_t)1)<<(slotNum%DELAY_QUEUE_SLOTS_PER_LEVEL));
+  }
+}
+
+void DelayQueue::cascade(int slotNum) {
+  // Move each entry in this slot (in order) to the slot where it now belongs (usually at a lower level).
+  // We detach the slot's entries first, because (for the 'overflow' slot) some may end up back in the same slot:
+  DelayQueueEntry* entry = fSlotHeads[slotNum];
+  fSlotHeads[slotNum] = fSlotTails[slotNum] = NULL;
+  if (slotNum != OVERFLOW_SLOT_NUM) {
+    fOccupiedSlots[slotNum/DELAY_QUEUE_SLOTS_PER_LEVEL] &=~ (((u_int64_t)1)<<(slotNum%DELAY_QUEUE_SLOTS_PER_LEVEL));
+  }
 
-  // Then, adjust the delay queue for any entries whose time is up:
-  DelayQueueEntry* curEntry = head();
-  while (timeSinceLastSync >= curEntry->fDeltaTimeRemaining) {
-    timeSinceLastSync -= curEntry->fDeltaTimeRemaining;
-    curEntry->fDeltaTimeRemaining = DELAY_ZERO;
-    curEntry = curEntry->fNext;
+  while (entry != NULL) {
+    DelayQueueEntry* nextEntry = entry->fNext;
+    entry->fNext = entry->fPrev = NULL;
+    insertIntoSlot(entry);
+    entry = nextEntry;
   }
-  curEntry->fDeltaTimeRemaining -= timeSinceLastSync;
 }
 
 
@@ -0,0 +1,263 @@
+/**********
+This library is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the
+Free Software Foundation; either version 3 of the License, or (at your
+option) any later version. (See <http://www.gnu.org/copyleft/lesser.html>.)
+
+This library is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+**********/
+// Copyright (c) 1996-2017 Live Networks, Inc.  All rights reserved.
+// Basic Usage Environment: for a simple, non-scripted, console application
+// Implementation of a "epoll()"-based task scheduler (Linux only)
+
+#if defined(__linux__)
+
+#include "BasicUsageEnvironment.hh"
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+
+// The maximum number of ready sockets that we ask "epoll_wait()" for, in each call.
+// (Any more than this will be reported by the next call.)
+#define MAX_EPOLL_EVENTS_PER_STEP 256
+
+#ifndef MILLION
+#define MILLION 1000000
+#endif
+
+////////// EpollTaskScheduler //////////
+
+EpollTaskScheduler* EpollTaskScheduler::createNew(unsigned maxSchedulerGranularity) {
+  int epollFd = epoll_create1(EPOLL_CLOEXEC);
+  if (epollFd < 0) return NULL;
+
+  return new EpollTaskScheduler(epollFd, maxSchedulerGranularity);
+}
+
+EpollTaskScheduler::EpollTaskScheduler(int epollFd, unsigned maxSchedulerGranularity)
+  : fMaxSchedulerGranularity(maxSchedulerGranularity), fEpollFd(epollFd),
+    fSocketTable(NULL), fSocketTableSize(0),
+    fAlwaysReadySockets(NULL), fNumAlwaysReadySockets(0), fAlwaysReadySocketsSize(0), fNextAlwaysReadyIndex(0) {
+  if (maxSchedulerGranularity > 0) schedulerTickTask(); // ensures that we handle events frequently
+  setUpPostedEventWakeup(); // ensures that "postEvent()" wakes us up
+}
+
+EpollTaskScheduler::~EpollTaskScheduler() {
+  close(fEpollFd);
+  delete[] fSocketTable;
+  delete[] fAlwaysReadySockets;
+}
+
+void EpollTaskScheduler::schedulerTickTask(void* clientData) {
+  ((EpollTaskScheduler*)clientData)->schedulerTickTask();
+}
+
+void EpollTaskScheduler::schedulerTickTask() {
+  scheduleDelayedTask(fMaxSchedulerGranularity, schedulerTickTask, this);
+}
+
+static unsigned epollConditionsFor(int conditionSet) {
+  unsigned events = 0;
+  if (conditionSet&SOCKET_READABLE) events |= EPOLLIN;
+  if (conditionSet&SOCKET_WRITABLE) events |= EPOLLOUT;
+  if (conditionSet&SOCKET_EXCEPTION) events |= EPOLLPRI;
+
+  return events;
+}
+
+void EpollTaskScheduler::SingleStep(unsigned maxDelayTime) {
+  // Compute how long (in milliseconds, rounded up) we can wait in "epoll_wait()":
+  DelayInterval const& timeToDelay = fDelayQueue.timeToNextAlarm();
+  long secondsToDelay = timeToDelay.seconds();
+  long uSecondsToDelay = timeToDelay.useconds();
+  // Don't wait any longer than 1 million seconds (11.5 days), to avoid overflow:
+  const long MAX_SECONDS_TO_DELAY = MILLION;
+  if (secondsToDelay > MAX_SECONDS_TO_DELAY) {
+    secondsToDelay = MAX_SECONDS_TO_DELAY;
+  }
+  // Also check our "maxDelayTime" parameter (if it's > 0):
+  if (maxDelayTime > 0 &&
+      (secondsToDelay > (long)maxDelayTime/MILLION ||
+       (secondsToDelay == (long)maxDelayTime/MILLION &&
+	uSecondsToDelay > (long)maxDelayTime%MILLION))) {
+    secondsToDelay = maxDelayTime/MILLION;
+    uSecondsToDelay = maxDelayTime%MILLION;
+  }
+  int timeoutMs = (int)(secondsToDelay*1000 + (uSecondsToDelay+999)/1000);
+  if (fNumAlwaysReadySockets > 0) timeoutMs = 0; // we already have something to do
+
+  struct epoll_event events[MAX_EPOLL_EVENTS_PER_STEP];
+      // Note: This is a local (not member) variable, in case a handler calls "doEventLoop()" reentrantly.
+  int numReady = epoll_wait(fEpollFd, events, MAX_EPOLL_EVENTS_PER_STEP, timeoutMs);
+  if (numReady < 0) {
+    if (errno != EINTR && errno != EAGAIN) {
+      // Unexpected error - treat this as fatal:
+      perror("EpollTaskScheduler::SingleStep(): epoll_wait() fails");
+      internalError();
+    }
+    numReady = 0;
+  }
+
+  // Call the handler function for each ready socket:
+  for (int i = 0; i < numReady; ++i) {
+    unsigned readyEvents = events[i].events;
+    int resultConditionSet = 0;
+    if (readyEvents&EPOLLIN) resultConditionSet |= SOCKET_READABLE;
+    if (readyEvents&EPOLLOUT) resultConditionSet |= SOCKET_WRITABLE;
+    if (readyEvents&EPOLLPRI) resultConditionSet |= SOCKET_EXCEPTION;
+    // Like "select()", report an error or hangup as the socket being both readable and writable,
+    // so that the handler will notice it when it next reads or writes:
+    if (readyEvents&(EPOLLERR|EPOLLHUP)) resultConditionSet |= SOCKET_READABLE|SOCKET_WRITABLE;
+
+    handleSocket(events[i].data.fd, resultConditionSet);
+  }
+
+  // Then handle (at most) one descriptor that "epoll()" can't watch (and so is always ready):
+  if (fNumAlwaysReadySockets > 0) {
+    if (fNextAlwaysReadyIndex >= fNumAlwaysReadySockets) fNextAlwaysReadyIndex = 0;
+    int sock = fAlwaysReadySockets[fNextAlwaysReadyIndex++];
+    handleSocket(sock, SOCKET_READABLE|SOCKET_WRITABLE);
+  }
+
+  // Also handle any newly-triggered event (Note that we do this *after* calling socket handlers,
+  // in case the triggered event handler modifies The set of readable sockets.)
+  handleTriggeredEvent();
+
+  // Also handle any delayed event that may have come due.
+  fDelayQueue.handleAlarm();
+}
+
+void EpollTaskScheduler::handleSocket(int socketNum, int resultConditionSet) {
+  // Look up the handler again (rather than remembering it from before), because an earlier handler
+  // (in this same "SingleStep()") might have changed or removed it:
+  if (socketNum < 0 || (unsigned)socketNum >= fSocketTableSize) return;
+  SocketHandler& handler = fSocketTable[socketNum];
+
+  resultConditionSet &= handler.conditionSet;
+  if (resultConditionSet != 0 && handler.handlerProc != NULL) {
+    fLastHandledSocketNum = socketNum;
+    (*handler.handlerProc)(handler.clientData, resultConditionSet);
+  }
+}
+
+void EpollTaskScheduler
+  ::setBackgroundHandling(int socketNum, int conditionSet, BackgroundHandlerProc* handlerProc, void* clientData) {
+  if (socketNum < 0) return;
+
+  if (conditionSet == 0) {
+    if ((unsigned)socketNum >= fSocketTableSize) return; // no handler
+    SocketHandler& handler = fSocketTable[socketNum];
+    if (handler.conditionSet == 0) return; // no handler
+
+    if (handler.isAlwaysReady) {
+      removeAlwaysReadySocket(socketNum);
+    } else {
+      // Note: This fails harmlessly if the socket has already been closed:
+      struct epoll_event ev; // (needed only for kernels before 2.6.9)
+      memset(&ev, 0, sizeof ev);
+      epoll_ctl(fEpollFd, EPOLL_CTL_DEL, socketNum, &ev);
+    }
+    handler.conditionSet = 0;
+    handler.isAlwaysReady = False;
+    handler.handlerProc = NULL;
+    handler.clientData = NULL;
+    return;
+  }
+
+  if (!growSocketTable(socketNum)) return;
+  SocketHandler& handler = fSocketTable[socketNum];
+
+  if (!handler.isAlwaysReady) {
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof ev);
+    ev.events = epollConditionsFor(conditionSet);
+    ev.data.fd = socketNum;
+
+    int op = handler.conditionSet == 0 ? EPOLL_CTL_ADD : EPOLL_CTL_MOD;
+    int result = epoll_ctl(fEpollFd, op, socketNum, &ev);
+    if (result < 0 && op == EPOLL_CTL_ADD && errno == EEXIST) {
+      result = epoll_ctl(fEpollFd, EPOLL_CTL_MOD, socketNum, &ev);
+    } else if (result < 0 && op == EPOLL_CTL_MOD && errno == ENOENT) {
+      // The socket was closed (and perhaps reopened) without its handler first being removed:
+      result = epoll_ctl(fEpollFd, EPOLL_CTL_ADD, socketNum, &ev);
+    }
+
+    if (result < 0) {
+      if (errno != EPERM) return; // the socket number is bad
+      // "epoll()" doesn't support this kind of descriptor (e.g., a regular file), because it's always ready:
+      handler.isAlwaysReady = True;
+      addAlwaysReadySocket(socketNum);
+    }
+  }
+
+  handler.conditionSet = conditionSet;
+  handler.handlerProc = handlerProc;
+  handler.clientData = clientData;
+}
+
+void EpollTaskScheduler::moveSocketHandling(int oldSocketNum, int newSocketNum) {
+  if (oldSocketNum < 0 || newSocketNum < 0) return; // sanity check
+  if ((unsigned)oldSocketNum >= fSocketTableSize) return; // no handler
+
+  SocketHandler handler = fSocketTable[oldSocketNum];
+  if (handler.conditionSet == 0) return; // no handler
+
+  setBackgroundHandling(oldSocketNum, 0, NULL, NULL);
+  setBackgroundHandling(newSocketNum, handler.conditionSet, handler.handlerProc, handler.clientData);
+}
+
+Boolean EpollTaskScheduler::growSocketTable(int socketNum) {
+  if ((unsigned)socketNum < fSocketTableSize) return True;
+
+  unsigned newSize = fSocketTableSize == 0 ? 64 : fSocketTableSize;
+  while (newSize <= (unsigned)socketNum) newSize *= 2;
+
+  SocketHandler* newTable = new SocketHandler[newSize];
+  if (newTable == NULL) return False;
+  for (unsigned i = 0; i < fSocketTableSize; ++i) newTable[i] = fSocketTable[i];
+  for (unsigned i = fSocketTableSize; i < newSize; ++i) {
+    newTable[i].conditionSet = 0;
+    newTable[i].isAlwaysReady = False;
+    newTable[i].handlerProc = NULL;
+    newTable[i].clientData = NULL;
+  }
+
+  delete[] fSocketTable;
+  fSocketTable = newTable;
+  fSocketTableSize = newSize;
+  return True;
+}
+
+void EpollTaskScheduler::addAlwaysReadySocket(int socketNum) {
+  if (fNumAlwaysReadySockets == fAlwaysReadySocketsSize) {
+    unsigned newSize = fAlwaysReadySocketsSize == 0 ? 4 : 2*fAlwaysReadySocketsSize;
+    int* newSockets = new int[newSize];
+    for (unsigned i = 0; i < fNumAlwaysReadySockets; ++i) newSockets[i] = fAlwaysReadySockets[i];
+
+    delete[] fAlwaysReadySockets;
+    fAlwaysReadySockets = newSockets;
+    fAlwaysReadySocketsSize = newSize;
+  }
+
+  fAlwaysReadySockets[fNumAlwaysReadySockets++] = socketNum;
+}
+
+void EpollTaskScheduler::removeAlwaysReadySocket(int socketNum) {
+  for (unsigned i = 0; i < fNumAlwaysReadySockets; ++i) {
+    if (fAlwaysReadySockets[i] == socketNum) {
+      fAlwaysReadySockets[i] = fAlwaysReadySockets[--fNumAlwaysReadySockets];
+      return;
+    }
+  }
+}
+
+#endif
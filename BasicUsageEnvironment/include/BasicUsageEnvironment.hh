@@ -83,4 +83,55 @@ private:
 #endif
 };
 
+#if defined(__linux__)
+
+// A task scheduler that uses Linux's "epoll()", rather than "select()", to wait for socket events.
+// Each "SingleStep()" costs O(number of ready sockets), rather than O(highest socket number),
+// and there is no "FD_SETSIZE" limit on socket numbers.
+class EpollTaskScheduler: public BasicTaskScheduler0 {
+public:
+  static EpollTaskScheduler* createNew(unsigned maxSchedulerGranularity = 10000/*microseconds*/);
+    // "maxSchedulerGranularity" has the same meaning as for "BasicTaskScheduler::createNew()".
+    // Returns NULL if "epoll_create()" fails.
+  virtual ~EpollTaskScheduler();
+
+protected:
+  EpollTaskScheduler(int epollFd, unsigned maxSchedulerGranularity);
+      // called only by "createNew()"
+
+  static void schedulerTickTask(void* clientData);
+  void schedulerTickTask();
+
+protected:
+  // Redefined virtual functions:
+  virtual void SingleStep(unsigned maxDelayTime);
+
+  virtual void setBackgroundHandling(int socketNum, int conditionSet, BackgroundHandlerProc* handlerProc, void* clientData);
+  virtual void moveSocketHandling(int oldSocketNum, int newSocketNum);
+
+private:
+  Boolean growSocketTable(int socketNum);
+  void handleSocket(int socketNum, int resultConditionSet);
+  void addAlwaysReadySocket(int socketNum);
+  void removeAlwaysReadySocket(int socketNum);
+
+protected:
+  unsigned fMaxSchedulerGranularity;
+  int fEpollFd;
+
+  // A table of handlers, indexed by socket number:
+  struct SocketHandler {
+    int conditionSet; // 0 iff no handler
+    Boolean isAlwaysReady; // for descriptors (e.g., regular files) that "epoll()" can't watch
+    BackgroundHandlerProc* handlerProc;
+    void* clientData;
+  }* fSocketTable;
+  unsigned fSocketTableSize;
+
+  // Descriptors that "epoll()" refused (because they're always readable/writable), handled round-robin:
+  int* fAlwaysReadySockets;
+  unsigned fNumAlwaysReadySockets, fAlwaysReadySocketsSize, fNextAlwaysReadyIndex;
+};
+#endif
+
 #endif
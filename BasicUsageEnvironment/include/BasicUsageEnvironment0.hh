@@ -91,10 +91,24 @@ public:
   virtual EventTriggerId createEventTrigger(TaskFunc* eventHandlerProc);
   virtual void deleteEventTrigger(EventTriggerId eventTriggerId);
   virtual void triggerEvent(EventTriggerId eventTriggerId, void* clientData = NULL);
+  virtual Boolean postEvent(TaskFunc* handlerProc, void* clientData = NULL);
 
 protected:
   BasicTaskScheduler0();
 
+  void handleTriggeredEvent();
+      // called by "SingleStep()" implementations, to handle (at most) one pending 'triggered event'
+      // (and any pending 'posted events')
+
+  void setUpPostedEventWakeup();
+      // called by subclass constructors, so that a "postEvent()" call (from another thread) makes the
+      // next (or current) "SingleStep()" return immediately, rather than after its full timeout
+
+private:
+  void handlePostedEvents();
+  void wakeUpForPostedEvents();
+  static void postedEventWakeupHandler(void* clientData, int mask);
+
 protected:
   // To implement delayed operations:
   DelayQueue fDelayQueue;
@@ -109,6 +123,19 @@ protected:
   TaskFunc* fTriggeredEventHandlers[MAX_NUM_EVENT_TRIGGERS];
   void* fTriggeredEventClientDatas[MAX_NUM_EVENT_TRIGGERS];
   unsigned fLastUsedTriggerNum; // in the range [0,MAX_NUM_EVENT_TRIGGERS)
+
+  // To implement posted events (using a lock-free, multiple-producer, single-consumer queue):
+  struct PostedEvent {
+    PostedEvent* volatile next;
+    TaskFunc* handlerProc;
+    void* clientData;
+  };
+  PostedEvent fPostedEventStub;
+  PostedEvent* fPostedEventHead; // accessed only from the event loop
+  PostedEvent* volatile fPostedEventTail; // accessed from any thread
+  int volatile fPostedEventWakeupPending; // non-zero iff a wakeup has been signaled, but not yet handled
+  int fPostedEventWakeupReadFd; // -1 if none (the default)
+  int fPostedEventWakeupWriteFd; // (same as "fPostedEventWakeupReadFd" if we're using an "eventfd")
 };
 
 #endif
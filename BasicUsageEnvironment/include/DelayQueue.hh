@@ -149,7 +149,9 @@ private:
   friend class DelayQueue;
   DelayQueueEntry* fNext;
   DelayQueueEntry* fPrev;
-  DelayInterval fDeltaTimeRemaining;
+  DelayInterval fDelay; // the delay requested when we were (last) added to the queue
+  u_int64_t fExpirationTime; // in microseconds, measured by the queue's internal clock
+  int fSlotNum; // the queue 'slot' that we're currently in, or -1 if we're not in a queue
 
   intptr_t fToken;
   static intptr_t tokenCounter;
@@ -157,7 +159,22 @@ private:
 
 ///// DelayQueue /////
 
-class DelayQueue: public DelayQueueEntry {
+// The queue is implemented as a 'hierarchical timing wheel', so that adding, removing, or
+// updating an entry takes O(1) time, regardless of the number of entries in the queue.
+// Level 0 of the wheel has one slot per 'tick' (of 2^DELAY_QUEUE_TICK_SHIFT microseconds);
+// each higher level has slots that are DELAY_QUEUE_SLOTS_PER_LEVEL times as wide as those
+// of the level below it.  Entries in a higher-level slot get moved ('cascaded') to lower levels
+// as time advances.  Entries within a level 0 slot are kept sorted by expiration time.
+
+#define DELAY_QUEUE_TICK_SHIFT 10
+#define DELAY_QUEUE_LEVEL_BITS 6
+#define DELAY_QUEUE_SLOTS_PER_LEVEL (1<<DELAY_QUEUE_LEVEL_BITS)
+#define DELAY_QUEUE_NUM_LEVELS 6
+#define DELAY_QUEUE_NUM_SLOTS (DELAY_QUEUE_NUM_LEVELS*DELAY_QUEUE_SLOTS_PER_LEVEL + 1/*for very long delays*/)
+
+class HashTable; // forward
+
+class DelayQueue {
 public:
   DelayQueue();
   virtual ~DelayQueue();
@@ -172,11 +189,20 @@ public:
   void handleAlarm();
 
 private:
-  DelayQueueEntry* head() { return fNext; }
   DelayQueueEntry* findEntryByToken(intptr_t token);
-  void synchronize(); // bring the 'time remaining' fields up-to-date
+  void synchronize(); // bring our internal clock - and the wheel - up-to-date
+  void insertIntoSlot(DelayQueueEntry* entry);
+  void removeFromSlot(DelayQueueEntry* entry);
+  void cascade(int slotNum);
 
   _EventTime fLastSyncTime;
+  u_int64_t fCurrentTime; // in microseconds; unlike the system clock, this never goes backwards
+  u_int64_t fCurrentTick; // the tick from which entries' slots are computed; never later than "fCurrentTime"
+  DelayQueueEntry* fSlotHeads[DELAY_QUEUE_NUM_SLOTS];
+  DelayQueueEntry* fSlotTails[DELAY_QUEUE_NUM_SLOTS];
+  u_int64_t fOccupiedSlots[DELAY_QUEUE_NUM_LEVELS]; // for each level, a bitmap of its non-empty slots
+  HashTable* fEntriesByToken;
+  DelayInterval fTimeToNextAlarm;
 };
 
 #endif
@@ -56,6 +56,11 @@ void TaskScheduler::rescheduleDelayedTask(TaskToken& task,
   task = scheduleDelayedTask(microseconds, proc, clientData);
 }
 
+Boolean TaskScheduler::postEvent(TaskFunc* /*handlerProc*/, void* /*clientData*/) {
+  // By default, we don't support posting events (see the comment in "UsageEnvironment.hh"):
+  return False;
+}
+
 // By default, we handle 'should not occur'-type library errors by calling abort().  Subclasses can redefine this, if desired.
 void TaskScheduler::internalError() {
   abort();
@@ -157,6 +157,14 @@ public:
       // - to signal an external event.  (However, "triggerEvent()" should not be called with the
       // same 'event trigger id' from different threads.)
 
+  virtual Boolean postEvent(TaskFunc* handlerProc, void* clientData = NULL);
+      // Causes "handlerProc(clientData)" to be called (once) from the event loop.
+      // Like "triggerEvent()", this function may be called from an external thread.  Unlike "triggerEvent()", however, it
+      // needs no previously-created 'event trigger', and it may be called concurrently from any number of threads.
+      // Each call is queued - and handled, in order - separately, so (unlike with "triggerEvent()") no "clientData" is lost.
+      // Returns False iff the scheduler doesn't support this.  (The default implementation does nothing, and returns False,
+      // because it can't be implemented safely using the (single-threaded) 'event trigger' functions above.)
+
   // The following two functions are deprecated, and are provided for backwards-compatibility only:
   void turnOnBackgroundReadHandling(int socketNum, BackgroundHandlerProc* handlerProc, void* clientData) {
     setBackgroundHandling(socketNum, SOCKET_READABLE, handlerProc, clientData);
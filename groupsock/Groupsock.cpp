@@ -26,24 +26,62 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 #include <sstream>
 #endif
 #include <stdio.h>
+#if defined(__linux__)
+#include <netinet/udp.h>
+#include <linux/net_tstamp.h>
+#include <linux/errqueue.h>
+#include <time.h>
+#ifndef UDP_SEGMENT
+#define UDP_SEGMENT 103 // for older header files
+#endif
+#ifndef SOL_UDP
+#define SOL_UDP 17
+#endif
+#ifndef SO_TXTIME
+#define SO_TXTIME 61 // for older header files
+#define SCM_TXTIME SO_TXTIME
+#endif
+#ifndef SO_EE_ORIGIN_TXTIME
+#define SO_EE_ORIGIN_TXTIME 6 // for older header files
+#define SOF_TXTIME_REPORT_ERRORS (1<<1)
+#endif
+#ifndef SO_MAX_PACING_RATE
+#define SO_MAX_PACING_RATE 47 // for older header files
+#endif
+#endif
 
 ///////// OutputSocket //////////
 
+NetInterfaceBatchStats OutputSocket::statsOutgoingBatches;
+unsigned OutputSocket::defaultOutputBatchSize = 1;
+
 OutputSocket::OutputSocket(UsageEnvironment& env)
   : Socket(env, 0 /* let kernel choose port */),
     fSourcePort(0), fLastSentTTL(256/*hack: a deliberately invalid value*/) {
+  initOutputBatching();
 }
 
 OutputSocket::OutputSocket(UsageEnvironment& env, Port port)
   : Socket(env, port),
     fSourcePort(0), fLastSentTTL(256/*hack: a deliberately invalid value*/) {
+  initOutputBatching();
 }
 
 OutputSocket::~OutputSocket() {
+  flushQueuedWrites();
+  env().taskScheduler().unscheduleDelayedTask(fFlushTask);
+  delete[] fOutputBatchBuffer; delete[] fQueuedWrites;
 }
 
 Boolean OutputSocket::write(netAddressBits address, portNumBits portNum, u_int8_t ttl,
 			    unsigned char* buffer, unsigned bufferSize) {
+#if defined(__linux__)
+  if (fLaunchTimesEnabled && fNextLaunchTime != 0) {
+    if (!setTTLIfNecessary(ttl) || !writeWithLaunchTime(address, portNum, buffer, bufferSize)) return False;
+    return updateSourcePortIfNecessary();
+  }
+#endif
+
   struct in_addr destAddr; destAddr.s_addr = address;
   if ((unsigned)ttl == fLastSentTTL) {
     // Optimization: Don't do a 'set TTL' system call again
@@ -53,6 +91,10 @@ Boolean OutputSocket::write(netAddressBits address, portNumBits portNum, u_int8_
     fLastSentTTL = (unsigned)ttl;
   }
 
+  return updateSourcePortIfNecessary();
+}
+
+Boolean OutputSocket::updateSourcePortIfNecessary() {
   if (sourcePortNum() == 0) {
     // Now that we've sent a packet, we can find out what the
     // kernel chose as our ephemeral source port number:
@@ -68,6 +110,375 @@ Boolean OutputSocket::write(netAddressBits address, portNumBits portNum, u_int8_
   return True;
 }
 
+void OutputSocket::initOutputBatching() {
+  fOutputBatchSize = 1;
+  fOutputBatchBuffer = NULL;
+  fOutputBatchBufferSize = fOutputBatchBufferUsed = 0;
+  fQueuedWrites = NULL;
+  fNumQueuedWrites = 0;
+  fFlushTask = NULL;
+#if defined(__linux__)
+  fUseGSO = True; // until we find out otherwise
+#else
+  fUseGSO = False;
+#endif
+  fLaunchTimesEnabled = False;
+  fNextLaunchTime = 0;
+  fNumPacketsSinceLaunchTimeErrorCheck = fNumLaunchTimeErrors = 0;
+
+  if (defaultOutputBatchSize > 1) setOutputBatchSize(defaultOutputBatchSize);
+}
+
+// Packets larger than this are not queued; they're sent immediately (after any queued packets):
+#define MAX_QUEUED_PACKET_SIZE 1500
+
+void OutputSocket::setOutputBatchSize(unsigned maxPackets) {
+  flushQueuedWrites();
+  delete[] fOutputBatchBuffer; delete[] fQueuedWrites;
+  fOutputBatchBuffer = NULL; fQueuedWrites = NULL;
+  fOutputBatchBufferSize = 0;
+
+  if (maxPackets == 0) maxPackets = 1;
+  if (maxPackets > MAX_DATAGRAMS_PER_BATCH) maxPackets = MAX_DATAGRAMS_PER_BATCH;
+  fOutputBatchSize = maxPackets;
+  if (maxPackets > 1) {
+    fOutputBatchBufferSize = maxPackets*MAX_QUEUED_PACKET_SIZE;
+    fOutputBatchBuffer = new unsigned char[fOutputBatchBufferSize];
+    fQueuedWrites = new QueuedWrite[maxPackets];
+  }
+}
+
+Boolean OutputSocket::queueWrite(netAddressBits address, portNumBits portNum, u_int8_t ttl,
+				 unsigned char* buffer, unsigned bufferSize) {
+  if (fOutputBatchSize <= 1 || bufferSize > MAX_QUEUED_PACKET_SIZE) {
+    // Send this packet now (but - to preserve the order of packets - only after any that are already queued):
+    flushQueuedWrites();
+    return write(address, portNum, ttl, buffer, bufferSize);
+  }
+
+  if (fNumQueuedWrites == fOutputBatchSize || fOutputBatchBufferUsed + bufferSize > fOutputBatchBufferSize) {
+    flushQueuedWrites(); // to make room
+  }
+
+  QueuedWrite& qw = fQueuedWrites[fNumQueuedWrites++];
+  qw.address = address;
+  qw.portNum = portNum;
+  qw.ttl = ttl;
+  qw.offset = fOutputBatchBufferUsed;
+  qw.size = bufferSize;
+  qw.launchTime = fLaunchTimesEnabled ? fNextLaunchTime : 0;
+  memmove(&fOutputBatchBuffer[fOutputBatchBufferUsed], buffer, bufferSize);
+  fOutputBatchBufferUsed += bufferSize;
+
+  // Make sure that the queued packets get sent before the event loop next blocks:
+  if (fFlushTask == NULL) {
+    fFlushTask = env().taskScheduler().scheduleDelayedTask(0, flushQueuedWritesTask, this);
+  }
+  return True;
+}
+
+void OutputSocket::flushQueuedWritesTask(void* clientData) {
+  OutputSocket* socket = (OutputSocket*)clientData;
+  socket->fFlushTask = NULL;
+  socket->flushQueuedWrites();
+}
+
+void OutputSocket::flushQueuedWrites() {
+  if (fNumQueuedWrites == 0) return;
+
+  sendQueuedWrites();
+  fNumQueuedWrites = 0;
+  fOutputBatchBufferUsed = 0;
+}
+
+Boolean OutputSocket::setTTLIfNecessary(u_int8_t ttl) {
+  if ((unsigned)ttl == fLastSentTTL) return True;
+
+#if defined(__WIN32__) || defined(_WIN32)
+  int ttlToSet = (int)ttl;
+#else
+  u_int8_t ttlToSet = ttl;
+#endif
+  if (setsockopt(socketNum(), IPPROTO_IP, IP_MULTICAST_TTL, (const char*)&ttlToSet, sizeof ttlToSet) < 0) {
+    env().setResultErrMsg("setsockopt(IP_MULTICAST_TTL) error: ");
+    return False;
+  }
+  fLastSentTTL = (unsigned)ttl;
+  return True;
+}
+
+#if defined(__linux__)
+// The maximum number of packets - and total payload size - that the kernel allows in a UDP GSO 'super-packet':
+#define MAX_GSO_SEGMENTS 64
+#define MAX_GSO_PAYLOAD_SIZE 65000
+
+void OutputSocket::sendQueuedWrites() {
+  // First, reorder the queued packets so that those for the same destination (and TTL) are adjacent.
+  // (The order of packets for each destination is unchanged.)
+  unsigned order[MAX_DATAGRAMS_PER_BATCH];
+  Boolean used[MAX_DATAGRAMS_PER_BATCH];
+  unsigned i, j, numOrdered = 0;
+  for (i = 0; i < fNumQueuedWrites; ++i) used[i] = False;
+  for (i = 0; i < fNumQueuedWrites; ++i) {
+    if (used[i]) continue;
+    QueuedWrite const& qw = fQueuedWrites[i];
+    for (j = i; j < fNumQueuedWrites; ++j) {
+      QueuedWrite const& qw2 = fQueuedWrites[j];
+      if (!used[j] && qw2.address == qw.address && qw2.portNum == qw.portNum && qw2.ttl == qw.ttl) {
+	order[numOrdered++] = j;
+	used[j] = True;
+      }
+    }
+  }
+
+  // Then, build one message for each run of packets that can be sent together (using GSO), or for each packet:
+  struct mmsghdr msgs[MAX_DATAGRAMS_PER_BATCH];
+  struct iovec iovs[MAX_DATAGRAMS_PER_BATCH];
+  struct sockaddr_in addrs[MAX_DATAGRAMS_PER_BATCH];
+  char controls[MAX_DATAGRAMS_PER_BATCH][CMSG_SPACE(sizeof (u_int16_t)) + CMSG_SPACE(sizeof (u_int64_t))];
+  unsigned firstOrderIndex[MAX_DATAGRAMS_PER_BATCH]; // for each message
+  unsigned numMsgs = 0;
+  for (i = 0; i < numOrdered; ) {
+    QueuedWrite const& first = fQueuedWrites[order[i]];
+    unsigned segmentSize = first.size;
+    unsigned numSegments = 1, totSize = first.size;
+    while (fUseGSO && i + numSegments < numOrdered && numSegments < MAX_GSO_SEGMENTS) {
+      QueuedWrite const& next = fQueuedWrites[order[i + numSegments]];
+      if (next.address != first.address || next.portNum != first.portNum || next.ttl != first.ttl
+	  || next.launchTime != first.launchTime // packets that are to be sent at different times can't be combined
+	  || next.size > segmentSize || totSize + next.size > MAX_GSO_PAYLOAD_SIZE) break;
+      ++numSegments; totSize += next.size;
+      if (next.size < segmentSize) break; // only the last segment may be smaller
+    }
+
+    struct sockaddr_in& addr = addrs[numMsgs];
+    memset(&addr, 0, sizeof addr);
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = first.address;
+    addr.sin_port = first.portNum;
+
+    for (j = 0; j < numSegments; ++j) {
+      QueuedWrite const& qw = fQueuedWrites[order[i + j]];
+      iovs[i + j].iov_base = &fOutputBatchBuffer[qw.offset];
+      iovs[i + j].iov_len = qw.size;
+    }
+
+    struct msghdr& hdr = msgs[numMsgs].msg_hdr;
+    memset(&hdr, 0, sizeof hdr);
+    hdr.msg_name = &addr;
+    hdr.msg_namelen = sizeof addr;
+    hdr.msg_iov = &iovs[i];
+    hdr.msg_iovlen = numSegments;
+    if (numSegments > 1 || first.launchTime != 0) {
+      hdr.msg_control = controls[numMsgs];
+      hdr.msg_controllen = 0;
+      struct cmsghdr* cm = (struct cmsghdr*)controls[numMsgs];
+      if (numSegments > 1) {
+	cm->cmsg_level = SOL_UDP;
+	cm->cmsg_type = UDP_SEGMENT;
+	cm->cmsg_len = CMSG_LEN(sizeof (u_int16_t));
+	u_int16_t gsoSize = (u_int16_t)segmentSize;
+	memcpy(CMSG_DATA(cm), &gsoSize, sizeof gsoSize);
+	hdr.msg_controllen += CMSG_SPACE(sizeof (u_int16_t));
+	cm = (struct cmsghdr*)&controls[numMsgs][hdr.msg_controllen];
+      }
+      if (first.launchTime != 0) {
+	cm->cmsg_level = SOL_SOCKET;
+	cm->cmsg_type = SCM_TXTIME;
+	cm->cmsg_len = CMSG_LEN(sizeof (u_int64_t));
+	memcpy(CMSG_DATA(cm), &first.launchTime, sizeof first.launchTime);
+	hdr.msg_controllen += CMSG_SPACE(sizeof (u_int64_t));
+      }
+    }
+
+    firstOrderIndex[numMsgs++] = i;
+    i += numSegments;
+  }
+
+  // Finally, send the messages - as few "sendmmsg()" calls as possible (one for each TTL used):
+  for (i = 0; i < numMsgs; ) {
+    u_int8_t ttl = fQueuedWrites[order[firstOrderIndex[i]]].ttl;
+    if (!setTTLIfNecessary(ttl)) break;
+    unsigned numWithThisTTL = 1;
+    while (i + numWithThisTTL < numMsgs && fQueuedWrites[order[firstOrderIndex[i + numWithThisTTL]]].ttl == ttl) {
+      ++numWithThisTTL;
+    }
+
+    int numSent = sendmmsg(socketNum(), &msgs[i], numWithThisTTL, 0);
+    if (numSent > 0) {
+      unsigned numPacketsSent = 0;
+      for (j = 0; j < (unsigned)numSent; ++j) numPacketsSent += msgs[i + j].msg_hdr.msg_iovlen;
+      statsOutgoingBatches.countBatch(numPacketsSent);
+      statsGroupOutgoingBatches.countBatch(numPacketsSent);
+      i += numSent;
+      continue;
+    }
+
+    // The first of these messages could not be sent:
+    int err = env().getErrno();
+    struct msghdr& hdr = msgs[i].msg_hdr;
+    if (hdr.msg_iovlen > 1) {
+      // The failure may have been caused by our use of GSO.  If GSO is not supported at all, then stop using it:
+      if (err == EIO || err == ENOPROTOOPT || err == EOPNOTSUPP) fUseGSO = False;
+
+      // Send each of the message's packets separately instead:
+      u_int64_t launchTime = fQueuedWrites[order[firstOrderIndex[i]]].launchTime;
+      for (j = 0; j < hdr.msg_iovlen; ++j) {
+	if (launchTime != 0) {
+	  writeWithLaunchTime(addrs[i].sin_addr.s_addr, addrs[i].sin_port,
+			      (unsigned char*)hdr.msg_iov[j].iov_base, hdr.msg_iov[j].iov_len, launchTime);
+	} else {
+	  struct in_addr destAddr; destAddr.s_addr = addrs[i].sin_addr.s_addr;
+	  writeSocket(env(), socketNum(), destAddr, addrs[i].sin_port,
+		      (unsigned char*)hdr.msg_iov[j].iov_base, hdr.msg_iov[j].iov_len);
+	}
+      }
+    } else if (DebugLevel >= 1) {
+      env().setResultErrMsg("sendmmsg() error: ");
+      env() << *this << ": failed to send a queued packet: " << env().getResultMsg() << "\n";
+    }
+    ++i;
+  }
+
+  if (fLaunchTimesEnabled) checkForLaunchTimeErrors(fNumQueuedWrites);
+  updateSourcePortIfNecessary();
+}
+
+Boolean OutputSocket::enableLaunchTimes() {
+  if (fLaunchTimesEnabled) return True;
+
+  struct sock_txtime txTimeConfig;
+  memset(&txTimeConfig, 0, sizeof txTimeConfig);
+  txTimeConfig.clockid = CLOCK_MONOTONIC; // the clock used by the "fq" queueing discipline
+  txTimeConfig.flags = SOF_TXTIME_REPORT_ERRORS; // so that we find out about packets that get dropped
+  if (setsockopt(socketNum(), SOL_SOCKET, SO_TXTIME, &txTimeConfig, sizeof txTimeConfig) < 0) {
+    env().setResultErrMsg("setsockopt(SO_TXTIME) error: ");
+    return False;
+  }
+
+  fLaunchTimesEnabled = True;
+  fNumPacketsSinceLaunchTimeErrorCheck = 0;
+  return True;
+}
+
+// How often (in packets sent) we check our socket's error queue for packets that the kernel dropped:
+#define LAUNCH_TIME_ERROR_CHECK_INTERVAL 64
+
+void OutputSocket::checkForLaunchTimeErrors(unsigned numPacketsSent) {
+  fNumPacketsSinceLaunchTimeErrorCheck += numPacketsSent;
+  if (fNumPacketsSinceLaunchTimeErrorCheck < LAUNCH_TIME_ERROR_CHECK_INTERVAL) return;
+  fNumPacketsSinceLaunchTimeErrorCheck = 0;
+
+  // A packet that the kernel could not send at its launch time (e.g., because the "etf" queueing discipline had no
+  // room for it, or because its launch time had already passed) gets dropped, and reported on our error queue.
+  // (We don't need the dropped packets' data, so we read only the control messages.)
+  unsigned numErrors = 0;
+  char control[CMSG_SPACE(sizeof (struct sock_extended_err) + sizeof (struct sockaddr_in))];
+  while (1) {
+    struct msghdr hdr;
+    memset(&hdr, 0, sizeof hdr);
+    hdr.msg_control = control;
+    hdr.msg_controllen = sizeof control;
+    if (recvmsg(socketNum(), &hdr, MSG_ERRQUEUE|MSG_DONTWAIT) < 0) break; // the error queue is empty
+
+    for (struct cmsghdr* cm = CMSG_FIRSTHDR(&hdr); cm != NULL; cm = CMSG_NXTHDR(&hdr, cm)) {
+      if (cm->cmsg_level != SOL_IP || cm->cmsg_type != IP_RECVERR) continue;
+
+      struct sock_extended_err err;
+      memcpy(&err, CMSG_DATA(cm), sizeof err);
+      if (err.ee_origin == SO_EE_ORIGIN_TXTIME) ++numErrors;
+    }
+  }
+  if (numErrors == 0) return;
+
+  // Our launch times aren't being honored, so stop using them.  (Our packets will then be sent immediately.)
+  fNumLaunchTimeErrors += numErrors;
+  fLaunchTimesEnabled = False;
+  fNextLaunchTime = 0;
+  if (DebugLevel >= 1) {
+    env() << *this << ": the kernel dropped " << numErrors
+	  << " packet(s) that were given launch times; no longer using launch times\n";
+  }
+}
+
+u_int64_t OutputSocket::launchTimeFor(struct timeval const& sendTime) {
+  struct timespec monotonicNow;
+  struct timeval timeNow;
+  clock_gettime(CLOCK_MONOTONIC, &monotonicNow);
+  gettimeofday(&timeNow, NULL);
+
+  int64_t nsFromNow = ((int64_t)(sendTime.tv_sec - timeNow.tv_sec))*1000000000
+    + ((int64_t)(sendTime.tv_usec - timeNow.tv_usec))*1000;
+  u_int64_t now = ((u_int64_t)monotonicNow.tv_sec)*1000000000 + monotonicNow.tv_nsec;
+  return nsFromNow < 0 ? now : now + nsFromNow;
+}
+
+Boolean OutputSocket::setMaxPacingRate(unsigned bytesPerSecond) {
+  if (setsockopt(socketNum(), SOL_SOCKET, SO_MAX_PACING_RATE, &bytesPerSecond, sizeof bytesPerSecond) < 0) {
+    env().setResultErrMsg("setsockopt(SO_MAX_PACING_RATE) error: ");
+    return False;
+  }
+  return True;
+}
+
+Boolean OutputSocket::writeWithLaunchTime(netAddressBits address, portNumBits portNum,
+					  unsigned char* buffer, unsigned bufferSize, u_int64_t launchTime) {
+  if (launchTime == 0) launchTime = fNextLaunchTime;
+
+  MAKE_SOCKADDR_IN(dest, address, portNum);
+  struct iovec iov;
+  iov.iov_base = buffer;
+  iov.iov_len = bufferSize;
+  char control[CMSG_SPACE(sizeof (u_int64_t))];
+
+  struct msghdr hdr;
+  memset(&hdr, 0, sizeof hdr);
+  hdr.msg_name = &dest;
+  hdr.msg_namelen = sizeof dest;
+  hdr.msg_iov = &iov;
+  hdr.msg_iovlen = 1;
+  hdr.msg_control = control;
+  hdr.msg_controllen = sizeof control;
+  struct cmsghdr* cm = CMSG_FIRSTHDR(&hdr);
+  cm->cmsg_level = SOL_SOCKET;
+  cm->cmsg_type = SCM_TXTIME;
+  cm->cmsg_len = CMSG_LEN(sizeof (u_int64_t));
+  memcpy(CMSG_DATA(cm), &launchTime, sizeof launchTime);
+
+  if (sendmsg(socketNum(), &hdr, 0) != (int)bufferSize) {
+    env().setResultErrMsg("sendmsg() error: ");
+    return False;
+  }
+
+  checkForLaunchTimeErrors(1);
+  return True;
+}
+#else
+void OutputSocket::sendQueuedWrites() {
+  // We don't have "sendmmsg()", so send the queued packets one at a time:
+  for (unsigned i = 0; i < fNumQueuedWrites; ++i) {
+    QueuedWrite const& qw = fQueuedWrites[i];
+    write(qw.address, qw.portNum, qw.ttl, &fOutputBatchBuffer[qw.offset], qw.size);
+  }
+  statsOutgoingBatches.countBatch(fNumQueuedWrites);
+  statsGroupOutgoingBatches.countBatch(fNumQueuedWrites);
+}
+
+Boolean OutputSocket::enableLaunchTimes() {
+  env().setResultMsg("launch times (\"SO_TXTIME\") are not supported on this platform");
+  return False;
+}
+
+u_int64_t OutputSocket::launchTimeFor(struct timeval const& /*sendTime*/) {
+  return 0;
+}
+
+Boolean OutputSocket::setMaxPacingRate(unsigned /*bytesPerSecond*/) {
+  env().setResultMsg("\"SO_MAX_PACING_RATE\" is not supported on this platform");
+  return False;
+}
+#endif
+
 // By default, we don't do reads:
 Boolean OutputSocket
 ::handleRead(unsigned char* /*buffer*/, unsigned /*bufferMaxSize*/,
@@ -95,6 +506,7 @@ NetInterfaceTrafficStats Groupsock::statsIncoming;
 NetInterfaceTrafficStats Groupsock::statsOutgoing;
 NetInterfaceTrafficStats Groupsock::statsRelayedIncoming;
 NetInterfaceTrafficStats Groupsock::statsRelayedOutgoing;
+NetInterfaceBatchStats Groupsock::statsIncomingBatches;
 
 // Constructor for a source-independent multicast group
 Groupsock::Groupsock(UsageEnvironment& env, struct in_addr const& groupAddr,
@@ -102,7 +514,9 @@ Groupsock::Groupsock(UsageEnvironment& env, struct in_addr const& groupAddr,
   : OutputSocket(env, port),
     deleteIfNoMembers(False), isSlave(False),
     fDests(new destRecord(groupAddr, port, ttl, 0, NULL)),
-    fIncomingGroupEId(groupAddr, port.num(), ttl) {
+    fIncomingGroupEId(groupAddr, port.num(), ttl),
+    fArrivalTimestampsEnabled(False) {
+  fLastArrivalTime.tv_sec = fLastArrivalTime.tv_usec = 0;
 
   if (!socketJoinGroup(env, socketNum(), groupAddr.s_addr)) {
     if (DebugLevel >= 1) {
@@ -129,7 +543,10 @@ Groupsock::Groupsock(UsageEnvironment& env, struct in_addr const& groupAddr,
   : OutputSocket(env, port),
     deleteIfNoMembers(False), isSlave(False),
     fDests(new destRecord(groupAddr, port, 255, 0, NULL)),
-    fIncomingGroupEId(groupAddr, sourceFilterAddr, port.num()) {
+    fIncomingGroupEId(groupAddr, sourceFilterAddr, port.num()),
+    fArrivalTimestampsEnabled(False) {
+  fLastArrivalTime.tv_sec = fLastArrivalTime.tv_usec = 0;
+
   // First try a SSM join.  If that fails, try a regular join:
   if (!socketJoinGroupSSM(env, socketNum(), groupAddr.s_addr,
 			  sourceFilterAddr.s_addr)) {
@@ -264,9 +681,10 @@ Boolean Groupsock::output(UsageEnvironment& env, unsigned char* buffer, unsigned
   do {
     // First, do the datagram send, to each destination:
     Boolean writeSuccess = True;
+    // (If batched output is enabled, then the packets are just queued here, to be sent later.)
     for (destRecord* dests = fDests; dests != NULL; dests = dests->fNext) {
-      if (!write(dests->fGroupEId.groupAddress().s_addr, dests->fGroupEId.portNum(), dests->fGroupEId.ttl(),
-		 buffer, bufferSize)) {
+      if (!queueWrite(dests->fGroupEId.groupAddress().s_addr, dests->fGroupEId.portNum(), dests->fGroupEId.ttl(),
+		      buffer, bufferSize)) {
 	writeSuccess = False;
 	break;
       }
@@ -313,7 +731,8 @@ Boolean Groupsock::handleRead(unsigned char* buffer, unsigned bufferMaxSize,
 
   int maxBytesToRead = bufferMaxSize - TunnelEncapsulationTrailerMaxSize;
   int numBytes = readSocket(env(), socketNum(),
-			    buffer, maxBytesToRead, fromAddressAndPort);
+			    buffer, maxBytesToRead, fromAddressAndPort,
+			    fArrivalTimestampsEnabled ? &fLastArrivalTime : NULL);
   if (numBytes < 0) {
     if (DebugLevel >= 0) { // this is a fatal error
       UsageEnvironment::MsgString msg = strDup(env().getResultMsg());
@@ -323,16 +742,52 @@ Boolean Groupsock::handleRead(unsigned char* buffer, unsigned bufferMaxSize,
     return False;
   }
 
+  bytesRead = handleIncomingPacket(buffer, (unsigned)numBytes, fromAddressAndPort);
+  return True;
+}
+
+int Groupsock::handleReadBatch(unsigned char* const* buffers, unsigned bufferMaxSize,
+			       unsigned* bytesRead, struct sockaddr_in* fromAddressesAndPorts,
+			       unsigned maxPackets,
+			       struct timeval* arrivalTimes) {
+  unsigned maxBytesToRead = bufferMaxSize - TunnelEncapsulationTrailerMaxSize;
+  int numPackets = readSocketBatch(env(), socketNum(), buffers, maxBytesToRead,
+				   bytesRead, fromAddressesAndPorts, maxPackets, arrivalTimes);
+  if (numPackets < 0) {
+    if (DebugLevel >= 0) { // this is a fatal error
+      UsageEnvironment::MsgString msg = strDup(env().getResultMsg());
+      env().setResultMsg("Groupsock read failed: ", msg);
+      delete[] (char*)msg;
+    }
+    return -1;
+  }
+
+  statsIncomingBatches.countBatch(numPackets);
+  statsGroupIncomingBatches.countBatch(numPackets);
+  for (int i = 0; i < numPackets; ++i) {
+    bytesRead[i] = handleIncomingPacket(buffers[i], bytesRead[i], fromAddressesAndPorts[i]);
+  }
+
+  return numPackets;
+}
+
+Boolean Groupsock::enableArrivalTimestamps() {
+  fArrivalTimestampsEnabled = True; // even if the kernel can't timestamp packets, we'll timestamp them when they're read
+  return enableReceiveTimestamps(env(), socketNum());
+}
+
+unsigned Groupsock::handleIncomingPacket(unsigned char* buffer, unsigned numBytes,
+					 struct sockaddr_in& fromAddressAndPort) {
   // If we're a SSM group, make sure the source address matches:
   if (isSSM()
       && fromAddressAndPort.sin_addr.s_addr != sourceFilterAddress().s_addr) {
-    return True;
+    return 0;
   }
 
   // We'll handle this data.
   // Also write it (with the encapsulation trailer) to each member,
   // unless the packet was originally sent by us to begin with.
-  bytesRead = numBytes;
+  unsigned bytesRead = numBytes;
 
   int numMembers = 0;
   if (!wasLoopedBackFromUs(env(), fromAddressAndPort)) {
@@ -355,7 +810,7 @@ Boolean Groupsock::handleRead(unsigned char* buffer, unsigned bufferMaxSize,
     env() << "\n";
   }
 
-  return True;
+  return bytesRead;
 }
 
 Boolean Groupsock::wasLoopedBackFromUs(UsageEnvironment& env,
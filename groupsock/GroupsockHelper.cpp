@@ -213,7 +213,7 @@ Boolean makeSocketBlocking(int sock, unsigned writeTimeoutInMilliseconds) {
 }
 
 int setupStreamSocket(UsageEnvironment& env,
-                      Port port, Boolean makeNonBlocking) {
+                      Port port, Boolean makeNonBlocking, Boolean reusePort) {
   if (!initializeWinsockIfNecessary()) {
     socketErr(env, "Failed to initialize 'winsock': ");
     return -1;
@@ -235,21 +235,27 @@ int setupStreamSocket(UsageEnvironment& env,
   }
 
   // SO_REUSEPORT doesn't really make sense for TCP sockets, so we
-  // normally don't set them.  However, if you really want to do this
+  // normally don't set them (unless "reusePort" is True - e.g., so that several threads
+  // can each accept() connections on the same port).  However, if you really want to do this
   // #define REUSE_FOR_TCP
-#ifdef REUSE_FOR_TCP
+#ifndef REUSE_FOR_TCP
+  if (reusePort) {
+#endif
 #if defined(__WIN32__) || defined(_WIN32)
   // Windoze doesn't properly handle SO_REUSEPORT
 #else
 #ifdef SO_REUSEPORT
+  int reusePortFlag = reusePort ? 1 : reuseFlag;
   if (setsockopt(newSocket, SOL_SOCKET, SO_REUSEPORT,
-		 (const char*)&reuseFlag, sizeof reuseFlag) < 0) {
+		 (const char*)&reusePortFlag, sizeof reusePortFlag) < 0) {
     socketErr(env, "setsockopt(SO_REUSEPORT) error: ");
     closeSocket(newSocket);
     return -1;
   }
 #endif
 #endif
+#ifndef REUSE_FOR_TCP
+  }
 #endif
 
   // Note: Windoze requires binding, even if the port number is 0
@@ -282,13 +288,74 @@ int setupStreamSocket(UsageEnvironment& env,
   return newSocket;
 }
 
+#if defined(__linux__) && defined(SO_TIMESTAMPNS)
+#define ARRIVAL_TIMESTAMP_CONTROL_SIZE CMSG_SPACE(sizeof (struct timespec))
+
+static void getArrivalTime(struct msghdr const& hdr, struct timeval& arrivalTime) {
+  for (struct cmsghdr* cm = CMSG_FIRSTHDR(&hdr); cm != NULL; cm = CMSG_NXTHDR((struct msghdr*)&hdr, cm)) {
+    if (cm->cmsg_level == SOL_SOCKET && cm->cmsg_type == SCM_TIMESTAMPNS) {
+      struct timespec ts;
+      memcpy(&ts, CMSG_DATA(cm), sizeof ts);
+      arrivalTime.tv_sec = ts.tv_sec;
+      arrivalTime.tv_usec = ts.tv_nsec/1000;
+      return;
+    }
+  }
+
+  // The kernel didn't timestamp this datagram (probably because "enableReceiveTimestamps()" wasn't called), so use the
+  // current time instead:
+  gettimeofday(&arrivalTime, NULL);
+}
+#endif
+
+Boolean enableReceiveTimestamps(UsageEnvironment& env, int socket) {
+#if defined(__linux__) && defined(SO_TIMESTAMPNS)
+  int enable = 1;
+  if (setsockopt(socket, SOL_SOCKET, SO_TIMESTAMPNS, (const char*)&enable, sizeof enable) < 0) {
+    socketErr(env, "setsockopt(SO_TIMESTAMPNS) error: ");
+    return False;
+  }
+  return True;
+#else
+  env.setResultMsg("receive timestamps (\"SO_TIMESTAMPNS\") are not supported on this platform");
+  return False;
+#endif
+}
+
 int readSocket(UsageEnvironment& env,
 	       int socket, unsigned char* buffer, unsigned bufferSize,
-	       struct sockaddr_in& fromAddress) {
-  SOCKLEN_T addressSize = sizeof fromAddress;
-  int bytesRead = recvfrom(socket, (char*)buffer, bufferSize, 0,
-			   (struct sockaddr*)&fromAddress,
-			   &addressSize);
+	       struct sockaddr_in& fromAddress,
+	       struct timeval* arrivalTime) {
+  int bytesRead;
+#if defined(__linux__) && defined(SO_TIMESTAMPNS)
+  if (arrivalTime != NULL) {
+    // Use "recvmsg()", so that we also get the datagram's timestamp (if any):
+    struct iovec iov;
+    iov.iov_base = buffer;
+    iov.iov_len = bufferSize;
+    char control[ARRIVAL_TIMESTAMP_CONTROL_SIZE];
+
+    struct msghdr hdr;
+    memset(&hdr, 0, sizeof hdr);
+    hdr.msg_name = &fromAddress;
+    hdr.msg_namelen = sizeof fromAddress;
+    hdr.msg_iov = &iov;
+    hdr.msg_iovlen = 1;
+    hdr.msg_control = control;
+    hdr.msg_controllen = sizeof control;
+    bytesRead = recvmsg(socket, &hdr, 0);
+    if (bytesRead > 0) getArrivalTime(hdr, *arrivalTime);
+  } else
+#endif
+  {
+    SOCKLEN_T addressSize = sizeof fromAddress;
+    bytesRead = recvfrom(socket, (char*)buffer, bufferSize, 0,
+			 (struct sockaddr*)&fromAddress,
+			 &addressSize);
+#if !(defined(__linux__) && defined(SO_TIMESTAMPNS))
+    if (bytesRead > 0 && arrivalTime != NULL) gettimeofday(arrivalTime, NULL);
+#endif
+  }
   if (bytesRead < 0) {
     //##### HACK to work around bugs in Linux and Windows:
     int err = env.getErrno();
@@ -318,6 +385,78 @@ int readSocket(UsageEnvironment& env,
   return bytesRead;
 }
 
+int readSocketBatch(UsageEnvironment& env,
+		    int socket, unsigned char* const* buffers, unsigned bufferSize,
+		    unsigned* bytesRead, struct sockaddr_in* fromAddresses,
+		    unsigned maxDatagrams,
+		    struct timeval* arrivalTimes) {
+  if (maxDatagrams > MAX_DATAGRAMS_PER_BATCH) maxDatagrams = MAX_DATAGRAMS_PER_BATCH;
+  if (maxDatagrams == 0) return 0;
+
+#if defined(__linux__) && defined(MSG_WAITFORONE)
+  struct mmsghdr msgs[MAX_DATAGRAMS_PER_BATCH];
+  struct iovec iovs[MAX_DATAGRAMS_PER_BATCH];
+#ifdef SO_TIMESTAMPNS
+  char controls[MAX_DATAGRAMS_PER_BATCH][ARRIVAL_TIMESTAMP_CONTROL_SIZE];
+#endif
+  for (unsigned i = 0; i < maxDatagrams; ++i) {
+    iovs[i].iov_base = buffers[i];
+    iovs[i].iov_len = bufferSize;
+
+    struct msghdr& hdr = msgs[i].msg_hdr;
+    hdr.msg_name = &fromAddresses[i];
+    hdr.msg_namelen = sizeof fromAddresses[i];
+    hdr.msg_iov = &iovs[i];
+    hdr.msg_iovlen = 1;
+    hdr.msg_control = NULL;
+    hdr.msg_controllen = 0;
+#ifdef SO_TIMESTAMPNS
+    if (arrivalTimes != NULL) {
+      hdr.msg_control = controls[i];
+      hdr.msg_controllen = sizeof controls[i];
+    }
+#endif
+    hdr.msg_flags = 0;
+  }
+
+  int numDatagrams = recvmmsg(socket, msgs, maxDatagrams, MSG_DONTWAIT, NULL);
+  if (numDatagrams < 0) {
+    int err = env.getErrno();
+    if (err == 111 /*ECONNREFUSED (Linux)*/ || err == EAGAIN || err == 113 /*EHOSTUNREACH (Linux)*/) {
+      return 0; // as in "readSocket()", above
+    }
+    socketErr(env, "recvmmsg() error: ");
+    return -1;
+  }
+
+  for (int i = 0; i < numDatagrams; ++i) {
+    bytesRead[i] = msgs[i].msg_len;
+    if (arrivalTimes != NULL) {
+#ifdef SO_TIMESTAMPNS
+      getArrivalTime(msgs[i].msg_hdr, arrivalTimes[i]);
+#else
+      gettimeofday(&arrivalTimes[i], NULL);
+#endif
+    }
+  }
+  return numDatagrams;
+#else
+  // Emulate "recvmmsg()" by reading datagrams one at a time, until there are no more:
+  unsigned numDatagrams;
+  for (numDatagrams = 0; numDatagrams < maxDatagrams; ++numDatagrams) {
+    int result = readSocket(env, socket, buffers[numDatagrams], bufferSize, fromAddresses[numDatagrams],
+			    arrivalTimes == NULL ? NULL : &arrivalTimes[numDatagrams]);
+    if (result < 0) {
+      if (numDatagrams == 0) return -1;
+      break;
+    }
+    if (result == 0) break; // no more datagrams are waiting
+    bytesRead[numDatagrams] = (unsigned)result;
+  }
+  return (int)numDatagrams;
+#endif
+}
+
 Boolean writeSocket(UsageEnvironment& env,
 		    int socket, struct in_addr address, portNumBits portNum,
 		    u_int8_t ttlArg,
@@ -172,3 +172,22 @@ void NetInterfaceTrafficStats::countPacket(unsigned packetSize) {
 Boolean NetInterfaceTrafficStats::haveSeenTraffic() const {
   return fTotNumPackets != 0.0;
 }
+
+
+////////// NetInterfaceBatchStats //////////
+
+NetInterfaceBatchStats::NetInterfaceBatchStats()
+  : fTotNumBatches(0), fTotNumPackets(0) {
+  for (unsigned i = 0; i < NUM_BATCH_SIZE_BUCKETS; ++i) fNumBatchesInBucket[i] = 0;
+}
+
+void NetInterfaceBatchStats::countBatch(unsigned batchSize) {
+  if (batchSize == 0) return;
+
+  ++fTotNumBatches;
+  fTotNumPackets += batchSize;
+
+  unsigned bucket = 0;
+  while (bucket < NUM_BATCH_SIZE_BUCKETS-1 && (batchSize >>= 1) != 0) ++bucket;
+  ++fNumBatchesInBucket[bucket];
+}
@@ -48,19 +48,90 @@ public:
     return write(addressAndPort.sin_addr.s_addr, addressAndPort.sin_port, ttl, buffer, bufferSize);
   }
 
+  // Batched output:
+  void setOutputBatchSize(unsigned maxPackets);
+      // If "maxPackets" > 1, then "Groupsock::output()" doesn't send each packet immediately.  Instead, it queues up to
+      // "maxPackets" (at most MAX_DATAGRAMS_PER_BATCH) packets, which get sent together - from the event loop, before
+      // it next blocks - using a single "sendmmsg()" system call (if possible).  Also, if UDP 'generic segmentation
+      // offload' is supported, consecutive packets for the same destination are sent as a single 'super-packet'.
+      // (The default "maxPackets" is 1 - i.e., no batching - unless "setDefaultOutputBatchSize()" was called.)
+  static void setDefaultOutputBatchSize(unsigned maxPackets) { defaultOutputBatchSize = maxPackets; }
+      // sets the "maxPackets" for each subsequently-created socket
+  unsigned outputBatchSize() const { return fOutputBatchSize; }
+  Boolean queueWrite(netAddressBits address, portNumBits portNum/*in network order*/, u_int8_t ttl,
+		     unsigned char* buffer, unsigned bufferSize);
+      // like "write()", except that (if batching is enabled) the packet is queued, to be sent later
+  void flushQueuedWrites(); // sends any queued packets now
+
+  static NetInterfaceBatchStats statsOutgoingBatches;
+  NetInterfaceBatchStats statsGroupOutgoingBatches; // *not* static
+
+  // Kernel-paced output (Linux only):
+  Boolean enableLaunchTimes();
+      // Uses "SO_TXTIME", so that each packet that's written (or queued) after a call to "setNextLaunchTime()" is
+      // given a time at which the kernel is to send it.  Returns False if "SO_TXTIME" is not supported.
+      // NOTE: The launch times are honored only if the outgoing interface uses the "fq" (or "etf") queueing
+      // discipline - e.g., after "tc qdisc replace dev eth0 root fq".  Other queueing disciplines (e.g., the
+      // default "pfifo_fast" or "fq_codel") silently ignore them, and send each packet as soon as it's written -
+      // which we can't detect.  (Packets that "etf" drops, however, are reported to us; if this happens, we stop
+      // using launch times - see "launchTimesEnabled()" and "numLaunchTimeErrors()".)
+  Boolean launchTimesEnabled() const { return fLaunchTimesEnabled; }
+  unsigned numLaunchTimeErrors() const { return fNumLaunchTimeErrors; } // packets that the kernel dropped
+  void setNextLaunchTime(u_int64_t launchTime) { fNextLaunchTime = launchTime; }
+      // "launchTime" is in nanoseconds, on the kernel's "CLOCK_MONOTONIC" clock (e.g., as returned by "launchTimeFor()").
+      // 0 means 'send immediately'.
+  static u_int64_t launchTimeFor(struct timeval const& sendTime);
+      // converts a time (as returned by "gettimeofday()") to a launch time
+  Boolean setMaxPacingRate(unsigned bytesPerSecond);
+      // Uses "SO_MAX_PACING_RATE" to have the kernel spread out the packets that we send, so that they're sent at no
+      // more than this rate.  Returns False if this is not supported.
+
 protected:
   OutputSocket(UsageEnvironment& env, Port port);
 
   portNumBits sourcePortNum() const {return fSourcePort.num();}
+  Boolean updateSourcePortIfNecessary();
 
 private: // redefined virtual function
   virtual Boolean handleRead(unsigned char* buffer, unsigned bufferMaxSize,
 			     unsigned& bytesRead,
 			     struct sockaddr_in& fromAddressAndPort);
 
+private:
+  void initOutputBatching();
+  static void flushQueuedWritesTask(void* clientData);
+  void sendQueuedWrites();
+  Boolean setTTLIfNecessary(u_int8_t ttl);
+  Boolean writeWithLaunchTime(netAddressBits address, portNumBits portNum,
+			      unsigned char* buffer, unsigned bufferSize, u_int64_t launchTime = 0);
+      // "launchTime" 0 means: use "fNextLaunchTime"
+  void checkForLaunchTimeErrors(unsigned numPacketsSent);
+
 private:
   Port fSourcePort;
   unsigned fLastSentTTL;
+
+  // Used to implement batched output:
+  static unsigned defaultOutputBatchSize;
+  struct QueuedWrite {
+    netAddressBits address;
+    portNumBits portNum;
+    u_int8_t ttl;
+    unsigned offset, size; // within "fOutputBatchBuffer"
+    u_int64_t launchTime;
+  };
+  unsigned fOutputBatchSize;
+  unsigned char* fOutputBatchBuffer;
+  unsigned fOutputBatchBufferSize, fOutputBatchBufferUsed;
+  QueuedWrite* fQueuedWrites;
+  unsigned fNumQueuedWrites;
+  TaskToken fFlushTask;
+  Boolean fUseGSO;
+
+  // Used to implement kernel-paced output:
+  Boolean fLaunchTimesEnabled;
+  u_int64_t fNextLaunchTime;
+  unsigned fNumPacketsSinceLaunchTimeErrorCheck, fNumLaunchTimeErrors;
 };
 
 class destRecord {
@@ -144,6 +215,8 @@ public:
   NetInterfaceTrafficStats statsGroupOutgoing; // *not* static
   NetInterfaceTrafficStats statsGroupRelayedIncoming; // *not* static
   NetInterfaceTrafficStats statsGroupRelayedOutgoing; // *not* static
+  static NetInterfaceBatchStats statsIncomingBatches;
+  NetInterfaceBatchStats statsGroupIncomingBatches; // *not* static
 
   Boolean wasLoopedBackFromUs(UsageEnvironment& env, struct sockaddr_in& fromAddressAndPort);
 
@@ -152,10 +225,28 @@ public: // redefined virtual functions
 			     unsigned& bytesRead,
 			     struct sockaddr_in& fromAddressAndPort);
 
+  int handleReadBatch(unsigned char* const* buffers, unsigned bufferMaxSize,
+		      unsigned* bytesRead, struct sockaddr_in* fromAddressesAndPorts,
+		      unsigned maxPackets,
+		      struct timeval* arrivalTimes = NULL);
+      // A version of "handleRead()" that reads up to "maxPackets" packets (each into "buffers[i]") at once.
+      // Returns the number of packets read, or -1 on error.  (A packet that we're not to handle - e.g., because
+      // its source address doesn't match our SSM source filter - is returned with "bytesRead[i]" == 0.)
+      // If "arrivalTimes" is non-NULL, then "arrivalTimes[i]" is set to the arrival time of each packet.
+
+  Boolean enableArrivalTimestamps();
+      // Has the kernel timestamp each incoming packet as it arrives (if possible; otherwise returns False, and packets are
+      // timestamped when they're read).  Afterwards, "lastArrivalTime()" returns the arrival time of the packet that
+      // was most recently read by "handleRead()".
+  struct timeval const& lastArrivalTime() const { return fLastArrivalTime; }
+
 protected:
   destRecord* lookupDestRecordFromDestination(struct sockaddr_in const& destAddrAndPort) const;
 
 private:
+  unsigned handleIncomingPacket(unsigned char* buffer, unsigned numBytes,
+				struct sockaddr_in& fromAddressAndPort);
+      // used to implement "handleRead()" and "handleReadBatch()"; returns the number of bytes that we're to handle
   void removeDestinationFrom(destRecord*& dests, unsigned sessionId);
     // used to implement (the public) "removeDestination()", and "changeDestinationParameters()"
   int outputToAllMembersExcept(DirectedNetInterface* exceptInterface,
@@ -168,6 +259,8 @@ protected:
 private:
   GroupEId fIncomingGroupEId;
   DirectedNetInterfaceSet fMembers;
+  Boolean fArrivalTimestampsEnabled;
+  struct timeval fLastArrivalTime;
 };
 
 UsageEnvironment& operator<<(UsageEnvironment& s, const Groupsock& g);
@@ -27,11 +27,32 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 
 int setupDatagramSocket(UsageEnvironment& env, Port port);
 int setupStreamSocket(UsageEnvironment& env,
-		      Port port, Boolean makeNonBlocking = True);
+		      Port port, Boolean makeNonBlocking = True,
+		      Boolean reusePort = False);
+    // If "reusePort" is True, we also set SO_REUSEPORT (if supported), so that several
+    // listening sockets (e.g., one per thread) can be bound to the same port.
 
 int readSocket(UsageEnvironment& env,
 	       int socket, unsigned char* buffer, unsigned bufferSize,
-	       struct sockaddr_in& fromAddress);
+	       struct sockaddr_in& fromAddress,
+	       struct timeval* arrivalTime = NULL);
+    // If "arrivalTime" is non-NULL, it's set to the time at which the datagram arrived (see "enableReceiveTimestamps()")
+
+#define MAX_DATAGRAMS_PER_BATCH 64
+int readSocketBatch(UsageEnvironment& env,
+		    int socket, unsigned char* const* buffers, unsigned bufferSize,
+		    unsigned* bytesRead, struct sockaddr_in* fromAddresses,
+		    unsigned maxDatagrams,
+		    struct timeval* arrivalTimes = NULL);
+    // Reads up to "maxDatagrams" (at most MAX_DATAGRAMS_PER_BATCH) datagrams that are already waiting on "socket" -
+    // each into "buffers[i]" - using a single "recvmmsg()" system call if possible.
+    // Returns the number of datagrams read (0 if none was waiting), or -1 on error.
+    // (If "arrivalTimes" is non-NULL, then "arrivalTimes[i]" is set to the time at which each datagram arrived.)
+
+Boolean enableReceiveTimestamps(UsageEnvironment& env, int socket);
+    // Asks the kernel to timestamp each datagram as it arrives on "socket" (using "SO_TIMESTAMPNS"), so that the
+    // arrival times returned by "readSocket()" and "readSocketBatch()" are not affected by any delay in reading.
+    // Returns False if this is not supported; the arrival times are then the times at which the datagrams were read.
 
 Boolean writeSocket(UsageEnvironment& env,
 		    int socket, struct in_addr address, portNumBits portNum/*network byte order*/,
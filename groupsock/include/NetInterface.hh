@@ -146,4 +146,24 @@ private:
   float fTotNumBytes;
 };
 
+// Counts the sizes of 'batches' of packets that were read (or written) using a single system call:
+#define NUM_BATCH_SIZE_BUCKETS 8
+class NetInterfaceBatchStats {
+public:
+  NetInterfaceBatchStats();
+
+  void countBatch(unsigned batchSize);
+
+  u_int64_t totNumBatches() const { return fTotNumBatches; }
+  u_int64_t totNumPackets() const { return fTotNumPackets; }
+  u_int64_t numBatchesInBucket(unsigned bucket) const { return fNumBatchesInBucket[bucket]; }
+      // Bucket #i (0 <= i < NUM_BATCH_SIZE_BUCKETS) counts batches of size [2^i, 2^(i+1)-1]
+      // (with the last bucket counting all batches of size >= 2^(NUM_BATCH_SIZE_BUCKETS-1))
+
+private:
+  u_int64_t fTotNumBatches;
+  u_int64_t fTotNumPackets;
+  u_int64_t fNumBatchesInBucket[NUM_BATCH_SIZE_BUCKETS];
+};
+
 #endif
@@ -33,6 +33,7 @@ BasicUDPSink::BasicUDPSink(UsageEnvironment& env, Groupsock* gs,
   : MediaSink(env),
     fGS(gs), fMaxPayloadSize(maxPayloadSize) {
   fOutputBuffer = new unsigned char[fMaxPayloadSize];
+  fKernelPacingLookahead = 0;
   fLastRTPSeq = 0;
 }
 
@@ -40,6 +41,17 @@ BasicUDPSink::~BasicUDPSink() {
   delete[] fOutputBuffer;
 }
 
+Boolean BasicUDPSink::enableKernelPacing(unsigned lookaheadMicroseconds) {
+  if (lookaheadMicroseconds == 0 || !fGS->enableLaunchTimes()) return False;
+
+  fKernelPacingLookahead = lookaheadMicroseconds;
+  return True;
+}
+
+Boolean BasicUDPSink::setMaxPacingRate(unsigned bytesPerSecond) {
+  return fGS->setMaxPacingRate(bytesPerSecond);
+}
+
 Boolean BasicUDPSink::continuePlaying() {
   // Record the fact that we're starting to play now:
   gettimeofday(&fNextSendTime, NULL);
@@ -77,6 +89,11 @@ void BasicUDPSink::afterGettingFrame1(unsigned frameSize, unsigned numTruncatedB
   }
 
   // Send the packet:
+  if (fKernelPacingLookahead > 0 && !fGS->launchTimesEnabled()) {
+    // The kernel has been dropping our packets, so we've stopped using launch times.  Pace the packets ourself:
+    fKernelPacingLookahead = 0;
+  }
+  if (fKernelPacingLookahead > 0) fGS->setNextLaunchTime(OutputSocket::launchTimeFor(fNextSendTime));
   fGS->output(envir(), fOutputBuffer, frameSize);
 
   // Figure out the time at which the next packet should be sent, based
@@ -92,6 +109,11 @@ void BasicUDPSink::afterGettingFrame1(unsigned frameSize, unsigned numTruncatedB
   if (uSecondsToGo < 0 || secsDiff < 0) { // sanity check: Make sure that the time-to-delay is non-negative:
     uSecondsToGo = 0;
   }
+  if (fKernelPacingLookahead > 0) {
+    // The kernel will hold each packet until its launch time, so we need to wake up only when we've fallen less than
+    // half of our 'lookahead' ahead of schedule:
+    uSecondsToGo = uSecondsToGo > fKernelPacingLookahead ? uSecondsToGo - fKernelPacingLookahead/2 : 0;
+  }
 
   // Delay this amount of time:
   nextTask() = envir().taskScheduler().scheduleDelayedTask(uSecondsToGo,
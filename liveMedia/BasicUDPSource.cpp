@@ -27,7 +27,10 @@ BasicUDPSource* BasicUDPSource::createNew(UsageEnvironment& env,
 }
 
 BasicUDPSource::BasicUDPSource(UsageEnvironment& env, Groupsock* inputGS)
-  : FramedSource(env), fInputGS(inputGS), fHaveStartedReading(False) {
+  : FramedSource(env), fInputGS(inputGS), fHaveStartedReading(False), fUseArrivalTimestamps(False),
+    fReceiveBatchSize(1), fMaxBatchedPacketSize(0), fBatchBuffer(NULL), fBatchedPackets(NULL), fBatchedPacketSizes(NULL),
+    fBatchedArrivalTimes(NULL),
+    fNumBatchedPackets(0), fNextBatchedPacket(0) {
   // Try to use a large receive buffer (in the OS):
   increaseReceiveBufferTo(env, inputGS->socketNum(), 512*1024);
 
@@ -40,6 +43,32 @@ BasicUDPSource::BasicUDPSource(UsageEnvironment& env, Groupsock* inputGS)
 
 BasicUDPSource::~BasicUDPSource(){
   envir().taskScheduler().turnOffBackgroundReadHandling(fInputGS->socketNum());
+  delete[] fBatchBuffer; delete[] fBatchedPackets; delete[] fBatchedPacketSizes; delete[] fBatchedArrivalTimes;
+}
+
+void BasicUDPSource::setReceiveBatchSize(unsigned batchSize, unsigned maxPacketSize) {
+  if (batchSize == 0) batchSize = 1;
+  if (batchSize > MAX_DATAGRAMS_PER_BATCH) batchSize = MAX_DATAGRAMS_PER_BATCH;
+
+  // Discard any existing batch buffer (and any packets that are still in it):
+  delete[] fBatchBuffer; delete[] fBatchedPackets; delete[] fBatchedPacketSizes; delete[] fBatchedArrivalTimes;
+  fBatchBuffer = NULL; fBatchedPackets = NULL; fBatchedPacketSizes = NULL; fBatchedArrivalTimes = NULL;
+  fNumBatchedPackets = fNextBatchedPacket = 0;
+
+  fReceiveBatchSize = batchSize;
+  fMaxBatchedPacketSize = maxPacketSize;
+  if (batchSize > 1) {
+    fBatchBuffer = new unsigned char[batchSize*maxPacketSize];
+    fBatchedPackets = new unsigned char*[batchSize];
+    fBatchedPacketSizes = new unsigned[batchSize];
+    fBatchedArrivalTimes = new struct timeval[batchSize];
+    for (unsigned i = 0; i < batchSize; ++i) fBatchedPackets[i] = &fBatchBuffer[i*maxPacketSize];
+  }
+}
+
+Boolean BasicUDPSource::useArrivalTimestamps() {
+  fUseArrivalTimestamps = True;
+  return fInputGS->enableArrivalTimestamps();
 }
 
 void BasicUDPSource::doGetNextFrame() {
@@ -49,6 +78,11 @@ void BasicUDPSource::doGetNextFrame() {
 	 (TaskScheduler::BackgroundHandlerProc*)&incomingPacketHandler, this);
     fHaveStartedReading = True;
   }
+
+  if (fNextBatchedPacket < fNumBatchedPackets) {
+    // We still have packet(s) from the last batch that we read; deliver the next one now:
+    deliverBatchedPacket();
+  }
 }
 
 void BasicUDPSource::doStopGettingFrames() {
@@ -64,10 +98,48 @@ void BasicUDPSource::incomingPacketHandler(BasicUDPSource* source, int /*mask*/)
 void BasicUDPSource::incomingPacketHandler1() {
   if (!isCurrentlyAwaitingData()) return; // we're not ready for the data yet
 
+  if (fReceiveBatchSize > 1) {
+    if (fNextBatchedPacket == fNumBatchedPackets) {
+      // Read a new batch of packets:
+      struct sockaddr_in fromAddresses[MAX_DATAGRAMS_PER_BATCH];
+      int numPackets = fInputGS->handleReadBatch(fBatchedPackets, fMaxBatchedPacketSize,
+						 fBatchedPacketSizes, fromAddresses, fReceiveBatchSize,
+						 fUseArrivalTimestamps ? fBatchedArrivalTimes : NULL);
+      if (numPackets <= 0) return;
+      fNumBatchedPackets = (unsigned)numPackets;
+      fNextBatchedPacket = 0;
+    }
+    deliverBatchedPacket();
+    return;
+  }
+
   // Read the packet into our desired destination:
   struct sockaddr_in fromAddress;
   if (!fInputGS->handleRead(fTo, fMaxSize, fFrameSize, fromAddress)) return;
+  if (fUseArrivalTimestamps) fPresentationTime = fInputGS->lastArrivalTime();
 
   // Tell our client that we have new data:
   afterGetting(this); // we're preceded by a net read; no infinite recursion
 }
+
+void BasicUDPSource::deliverBatchedPacket() {
+  // Deliver the next of our batched packets (skipping any that are not for us):
+  while (fNextBatchedPacket < fNumBatchedPackets && fBatchedPacketSizes[fNextBatchedPacket] == 0) ++fNextBatchedPacket;
+  if (fNextBatchedPacket == fNumBatchedPackets) return; // there are none left; await the next batch
+
+  unsigned i = fNextBatchedPacket++;
+  unsigned packetSize = fBatchedPacketSizes[i];
+  if (packetSize > fMaxSize) {
+    fNumTruncatedBytes = packetSize - fMaxSize;
+    packetSize = fMaxSize;
+  } else {
+    fNumTruncatedBytes = 0;
+  }
+  memmove(fTo, fBatchedPackets[i], packetSize);
+  fFrameSize = packetSize;
+  if (fUseArrivalTimestamps) fPresentationTime = fBatchedArrivalTimes[i];
+
+  // Tell our client that we have new data.  (If our client then requests another frame - from within this call - we'll
+  // deliver the next batched packet directly.  This recursion is bounded by the batch size.)
+  afterGetting(this);
+}
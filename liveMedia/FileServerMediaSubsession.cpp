@@ -20,6 +20,7 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 // Implementation
 
 #include "FileServerMediaSubsession.hh"
+#include "MediaFileSDPCache.hh"
 
 FileServerMediaSubsession
 ::FileServerMediaSubsession(UsageEnvironment& env, char const* fileName,
@@ -32,3 +33,24 @@ FileServerMediaSubsession
 FileServerMediaSubsession::~FileServerMediaSubsession() {
   delete[] (char*)fFileName;
 }
+
+// The aux SDP line depends upon the RTP payload type (in its "a=fmtp:" line), so we include this in the cache key:
+static void makeAuxSDPLineKey(char* key, char const* subsessionType, RTPSink* rtpSink) {
+  sprintf(key, "%.80s:auxSDPLine:%u", subsessionType, rtpSink->rtpPayloadType());
+}
+
+char const* FileServerMediaSubsession
+::lookupCachedAuxSDPLine(char const* subsessionType, RTPSink* rtpSink) {
+  char key[120];
+  makeAuxSDPLineKey(key, subsessionType, rtpSink);
+  return MediaFileSDPCache::ourCache(envir())->lookup(fFileName, key);
+}
+
+void FileServerMediaSubsession
+::cacheAuxSDPLine(char const* subsessionType, RTPSink* rtpSink, char const* auxSDPLine) {
+  if (auxSDPLine == NULL) return;
+
+  char key[120];
+  makeAuxSDPLineKey(key, subsessionType, rtpSink);
+  MediaFileSDPCache::ourCache(envir())->add(fFileName, key, auxSDPLine);
+}
@@ -21,18 +21,43 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 #include "FramedSource.hh"
 #include <stdlib.h>
 
+////////// SharedFrame //////////
+
+SharedFrame* SharedFrame::createNew(unsigned maxSize) {
+  return new SharedFrame(maxSize);
+}
+
+SharedFrame::SharedFrame(unsigned maxSize)
+  : fData(new unsigned char[maxSize]), fMaxSize(maxSize),
+    fFrameSize(0), fNumTruncatedBytes(0), fDurationInMicroseconds(0), fRefCount(1) {
+  fPresentationTime.tv_sec = fPresentationTime.tv_usec = 0;
+}
+
+SharedFrame::~SharedFrame() {
+  delete[] fData;
+}
+
+void SharedFrame::release() {
+  if (--fRefCount == 0) delete this;
+}
+
+
 ////////// FramedSource //////////
 
+unsigned FramedSource::frameRefBufferSize = 300000;
+
 FramedSource::FramedSource(UsageEnvironment& env)
   : MediaSource(env),
+    fIsReadingFrameRef(False), fFrameRef(NULL),
     fAfterGettingFunc(NULL), fAfterGettingClientData(NULL),
     fOnCloseFunc(NULL), fOnCloseClientData(NULL),
-    fAfterGettingPacketFunc(NULL),
+    fAfterGettingPacketFunc(NULL), fAfterGettingFrameRefFunc(NULL),
     fIsCurrentlyAwaitingData(False) {
   fPresentationTime.tv_sec = fPresentationTime.tv_usec = 0; // initially
 }
 
 FramedSource::~FramedSource() {
+  if (fFrameRef != NULL) fFrameRef->release();
 }
 
 Boolean FramedSource::isFramedSource() const {
@@ -76,11 +101,51 @@ void FramedSource::getNextFrame(unsigned char* to, unsigned maxSize,
   fOnCloseFunc = onCloseFunc;
   fOnCloseClientData = onCloseClientData;
   fAfterGettingPacketFunc = afterGettingPacketFunc;
+  fAfterGettingFrameRefFunc = NULL;
+  fIsReadingFrameRef = False;
   fIsCurrentlyAwaitingData = True;
 
   doGetNextFrame();
 }
 
+void FramedSource::getNextFrameRef(afterGettingFrameRefFunc* afterGettingFrameRefFunc,
+				   void* afterGettingClientData,
+				   onCloseFunc* onCloseFunc,
+				   void* onCloseClientData) {
+  // Make sure we're not already being read:
+  if (fIsCurrentlyAwaitingData) {
+    envir() << "FramedSource[" << this << "]::getNextFrameRef(): attempting to read more than once at the same time!\n";
+    envir().internalError();
+  }
+
+  fTo = NULL;
+  fMaxSize = 0;
+  fNumTruncatedBytes = 0; // by default; could be changed by doGetNextFrameRef()
+  fDurationInMicroseconds = 0; // by default; could be changed by doGetNextFrameRef()
+  fAfterGettingFunc = NULL;
+  fAfterGettingClientData = afterGettingClientData;
+  fOnCloseFunc = onCloseFunc;
+  fOnCloseClientData = onCloseClientData;
+  fAfterGettingPacketFunc = NULL;
+  fAfterGettingFrameRefFunc = afterGettingFrameRefFunc;
+  fIsReadingFrameRef = True;
+  fIsCurrentlyAwaitingData = True;
+
+  doGetNextFrameRef();
+}
+
+void FramedSource::doGetNextFrameRef() {
+  // Default implementation: Read the frame (using "doGetNextFrame()") into a newly-allocated "SharedFrame":
+  unsigned bufferSize = maxFrameSize();
+  if (bufferSize == 0) bufferSize = frameRefBufferSize;
+  if (fFrameRef != NULL) fFrameRef->release(); // sanity check; shouldn't happen
+  fFrameRef = SharedFrame::createNew(bufferSize);
+  fTo = fFrameRef->fData;
+  fMaxSize = bufferSize;
+
+  doGetNextFrame();
+}
+
 void FramedSource::afterGetting(FramedSource* source) {
   source->nextTask() = NULL;
   source->fIsCurrentlyAwaitingData = False;
@@ -88,7 +153,22 @@ void FramedSource::afterGetting(FramedSource* source) {
       // Note that this needs to be done here, in case the "fAfterFunc"
       // called below tries to read another frame (which it usually will)
 
-  if (source->fAfterGettingFunc != NULL) {
+  if (source->fIsReadingFrameRef) {
+    // Complete the delivery of the (shared) frame.  Our caller now owns the reference that we were holding:
+    SharedFrame* frame = source->fFrameRef;
+    source->fFrameRef = NULL;
+    if (frame == NULL) return; // shouldn't happen
+
+    frame->fFrameSize = source->fFrameSize;
+    frame->fNumTruncatedBytes = source->fNumTruncatedBytes;
+    frame->fPresentationTime = source->fPresentationTime;
+    frame->fDurationInMicroseconds = source->fDurationInMicroseconds;
+    if (source->fAfterGettingFrameRefFunc != NULL) {
+      (*(source->fAfterGettingFrameRefFunc))(source->fAfterGettingClientData, frame);
+    } else {
+      frame->release();
+    }
+  } else if (source->fAfterGettingFunc != NULL) {
     (*(source->fAfterGettingFunc))(source->fAfterGettingClientData,
 				   source->fFrameSize, source->fNumTruncatedBytes,
 				   source->fPresentationTime,
@@ -111,6 +191,10 @@ void FramedSource::handleClosure(void* clientData) {
 
 void FramedSource::handleClosure() {
   fIsCurrentlyAwaitingData = False; // because we got a close instead
+  if (fFrameRef != NULL) {
+    fFrameRef->release();
+    fFrameRef = NULL;
+  }
   if (fOnCloseFunc != NULL) {
     (*fOnCloseFunc)(fOnCloseClientData);
   }
@@ -119,10 +203,16 @@ void FramedSource::handleClosure() {
 void FramedSource::stopGettingFrames() {
   fIsCurrentlyAwaitingData = False; // indicates that we can be read again
   fAfterGettingFunc = NULL;
+  fAfterGettingFrameRefFunc = NULL;
   fOnCloseFunc = NULL;
 
   // Perform any specialized action now:
   doStopGettingFrames();
+
+  if (fFrameRef != NULL) {
+    fFrameRef->release();
+    fFrameRef = NULL;
+  }
 }
 
 void FramedSource::doStopGettingFrames() {
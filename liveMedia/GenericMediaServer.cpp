@@ -43,6 +43,21 @@ ServerMediaSession* GenericMediaServer
   return (ServerMediaSession*)(fServerMediaSessions->Lookup(streamName));
 }
 
+void GenericMediaServer
+::lookupServerMediaSession(char const* streamName,
+			   lookupServerMediaSessionCompletionFunc* completionFunc, void* completionClientData,
+			   Boolean isFirstLookupInSession) {
+  // Default implementation: Do a synchronous lookup, and complete immediately:
+  ServerMediaSession* sessionLookedUp = lookupServerMediaSession(streamName, isFirstLookupInSession);
+  if (completionFunc != NULL) (*completionFunc)(completionClientData, sessionLookedUp);
+}
+
+void GenericMediaServer
+::cancelLookupServerMediaSession(lookupServerMediaSessionCompletionFunc* /*completionFunc*/,
+				 void* /*completionClientData*/) {
+  // Default implementation: Nothing to do, because our lookups complete immediately
+}
+
 void GenericMediaServer::removeServerMediaSession(ServerMediaSession* serverMediaSession) {
   if (serverMediaSession == NULL) return;
   
@@ -94,7 +109,8 @@ GenericMediaServer
     fServerSocket(ourSocket), fServerPort(ourPort), fReclamationSeconds(reclamationSeconds),
     fServerMediaSessions(HashTable::create(STRING_HASH_KEYS)),
     fClientConnections(HashTable::create(ONE_WORD_HASH_KEYS)),
-    fClientSessions(HashTable::create(STRING_HASH_KEYS)) {
+    fClientSessions(HashTable::create(STRING_HASH_KEYS)),
+    fConnectionBufferPool() {
   ignoreSigPipeOnSocket(fServerSocket); // so that clients on the same host that are killed don't also kill us
   
   // Arrange to handle connections from others:
@@ -138,18 +154,21 @@ void GenericMediaServer::cleanup() {
 
 #define LISTEN_BACKLOG_SIZE 20
 
-int GenericMediaServer::setUpOurSocket(UsageEnvironment& env, Port& ourPort) {
+int GenericMediaServer::setUpOurSocket(UsageEnvironment& env, Port& ourPort, Boolean reusePort) {
   int ourSocket = -1;
   
   do {
-    // The following statement is enabled by default.
+    // The following statement is enabled by default (unless we've been asked to share the port).
     // Don't disable it (by defining ALLOW_SERVER_PORT_REUSE) unless you know what you're doing.
 #if !defined(ALLOW_SERVER_PORT_REUSE) && !defined(ALLOW_RTSP_SERVER_PORT_REUSE)
     // ALLOW_RTSP_SERVER_PORT_REUSE is for backwards-compatibility #####
-    NoReuse dummy(env); // Don't use this socket if there's already a local server using it
+    NoReuse* noReuse = reusePort ? NULL : new NoReuse(env); // Don't use this socket if there's already a local server using it
 #endif
     
-    ourSocket = setupStreamSocket(env, ourPort);
+    ourSocket = setupStreamSocket(env, ourPort, True, reusePort);
+#if !defined(ALLOW_SERVER_PORT_REUSE) && !defined(ALLOW_RTSP_SERVER_PORT_REUSE)
+    delete noReuse;
+#endif
     if (ourSocket < 0) break;
     
     // Make sure we have a big send buffer:
@@ -209,7 +228,8 @@ void GenericMediaServer::incomingConnectionHandlerOnSocket(int serverSocket) {
 
 GenericMediaServer::ClientConnection
 ::ClientConnection(GenericMediaServer& ourServer, int clientSocket, struct sockaddr_in clientAddr)
-  : fOurServer(ourServer), fOurSocket(clientSocket), fClientAddr(clientAddr) {
+  : fOurServer(ourServer), fOurSocket(clientSocket), fClientAddr(clientAddr),
+    fRequestBuffer(NULL), fRequestBufferSize(0), fResponseBuffer(NULL), fResponseBufferSize(0) {
   // Add ourself to our 'client connections' table:
   fOurServer.fClientConnections->Add((char const*)this, this);
   
@@ -224,6 +244,10 @@ GenericMediaServer::ClientConnection::~ClientConnection() {
   fOurServer.fClientConnections->Remove((char const*)this);
   
   closeSockets();
+
+  // Return our buffers (if any) to our server's pool:
+  if (fRequestBuffer != NULL) fOurServer.fConnectionBufferPool.release(fRequestBuffer, fRequestBufferSize);
+  releaseResponseBuffer();
 }
 
 void GenericMediaServer::ClientConnection::closeSockets() {
@@ -242,13 +266,86 @@ void GenericMediaServer::ClientConnection::incomingRequestHandler(void* instance
 void GenericMediaServer::ClientConnection::incomingRequestHandler() {
   struct sockaddr_in dummy; // 'from' address, meaningless in this case
   
-  int bytesRead = readSocket(envir(), fOurSocket, &fRequestBuffer[fRequestBytesAlreadySeen], fRequestBufferBytesLeft, dummy);
-  handleRequestBytes(bytesRead);
+  (void)ensureRequestBufferSpace(1);
+
+  // If a read fills our request buffer, then we grow the buffer (if we can), and read again, so that a large request
+  // isn't mistaken for one that's too big for us:
+  int totalBytesRead = 0;
+  while (1) {
+    int bytesRead = readSocket(envir(), fOurSocket, &fRequestBuffer[fRequestBytesAlreadySeen + totalBytesRead],
+			       fRequestBufferBytesLeft - totalBytesRead, dummy);
+    if (bytesRead <= 0) {
+      if (totalBytesRead == 0) totalBytesRead = bytesRead;
+      break;
+    }
+
+    totalBytesRead += bytesRead;
+    if ((unsigned)totalBytesRead < fRequestBufferBytesLeft) break; // there's still room in the buffer
+    if (!ensureRequestBufferSpace(totalBytesRead)) break; // the request is too big for us
+  }
+  handleRequestBytes(totalBytesRead);
 }
 
 void GenericMediaServer::ClientConnection::resetRequestBuffer() {
   fRequestBytesAlreadySeen = 0;
-  fRequestBufferBytesLeft = sizeof fRequestBuffer;
+  fRequestBufferBytesLeft = fRequestBufferSize;
+}
+
+Boolean GenericMediaServer::ClientConnection::ensureRequestBufferSpace(unsigned numBytes) {
+  if (fRequestBufferBytesLeft > numBytes) return True; // we already have enough space
+
+  unsigned newSize = fRequestBuffer == NULL ? REQUEST_BUFFER_INITIAL_SIZE : fRequestBufferSize;
+  while (newSize < REQUEST_BUFFER_SIZE && newSize - (fRequestBufferSize - fRequestBufferBytesLeft) <= numBytes) {
+    newSize *= 4;
+  }
+  if (newSize > REQUEST_BUFFER_SIZE) newSize = REQUEST_BUFFER_SIZE;
+
+  if (newSize > fRequestBufferSize) {
+    unsigned char* oldRequestBuffer = fRequestBuffer;
+    fRequestBuffer = fOurServer.fConnectionBufferPool.allocate(newSize);
+
+    if (oldRequestBuffer == NULL) {
+      fRequestBufferSize = newSize;
+      resetRequestBuffer();
+    } else {
+      // Copy the old buffer's contents (including any bytes that have been read, but not yet handled) to the new buffer:
+      memcpy(fRequestBuffer, oldRequestBuffer, fRequestBufferSize);
+      fRequestBufferBytesLeft += newSize - fRequestBufferSize;
+      requestBufferHasMoved(oldRequestBuffer);
+
+      fOurServer.fConnectionBufferPool.release(oldRequestBuffer, fRequestBufferSize);
+      fRequestBufferSize = newSize;
+    }
+  }
+
+  return fRequestBufferBytesLeft > numBytes;
+}
+
+void GenericMediaServer::ClientConnection::requestBufferHasMoved(unsigned char* /*oldRequestBuffer*/) {
+  // By default, we do nothing
+}
+
+void GenericMediaServer::ClientConnection::releaseRequestBuffer() {
+  if (fRequestBuffer == NULL || fRequestBytesAlreadySeen > 0) return;
+
+  fOurServer.fConnectionBufferPool.release(fRequestBuffer, fRequestBufferSize);
+  fRequestBuffer = NULL; fRequestBufferSize = 0;
+  resetRequestBuffer();
+}
+
+void GenericMediaServer::ClientConnection::getResponseBuffer() {
+  if (fResponseBuffer == NULL) {
+    fResponseBufferSize = RESPONSE_BUFFER_SIZE;
+    fResponseBuffer = fOurServer.fConnectionBufferPool.allocate(fResponseBufferSize);
+  }
+  fResponseBuffer[0] = '\0';
+}
+
+void GenericMediaServer::ClientConnection::releaseResponseBuffer() {
+  if (fResponseBuffer == NULL) return;
+
+  fOurServer.fConnectionBufferPool.release(fResponseBuffer, fResponseBufferSize);
+  fResponseBuffer = NULL; fResponseBufferSize = 0;
 }
 
 
@@ -362,6 +459,83 @@ ServerMediaSession* GenericMediaServer::ServerMediaSessionIterator::next() {
 }
 
 
+////////// ConnectionBufferPool implementation //////////
+
+ConnectionBufferPool::ConnectionBufferPool(unsigned maxNumFreeBuffersPerSize)
+  : fMaxNumFreeBuffersPerSize(maxNumFreeBuffersPerSize), fNumFreeLists(0),
+    fNumBuffersInUse(0), fNumBytesInUse(0) {
+}
+
+ConnectionBufferPool::~ConnectionBufferPool() {
+  for (unsigned i = 0; i < fNumFreeLists; ++i) {
+    unsigned char* buffer = fFreeLists[i].head;
+    while (buffer != NULL) {
+      unsigned char* next;
+      memcpy(&next, buffer, sizeof next);
+      delete[] buffer;
+      buffer = next;
+    }
+  }
+}
+
+unsigned char* ConnectionBufferPool::allocate(unsigned size) {
+  if (size < sizeof (unsigned char*)) size = sizeof (unsigned char*); // so that a free buffer can hold a pointer
+  ++fNumBuffersInUse;
+  fNumBytesInUse += size;
+
+  FreeList* freeList = lookupFreeList(size);
+  if (freeList == NULL || freeList->head == NULL) return new unsigned char[size];
+
+  unsigned char* buffer = freeList->head;
+  memcpy(&freeList->head, buffer, sizeof freeList->head);
+  --freeList->numBuffers;
+  return buffer;
+}
+
+void ConnectionBufferPool::release(unsigned char* buffer, unsigned size) {
+  if (buffer == NULL) return;
+  if (size < sizeof (unsigned char*)) size = sizeof (unsigned char*);
+  --fNumBuffersInUse;
+  fNumBytesInUse -= size;
+
+  FreeList* freeList = lookupFreeList(size);
+  if (freeList == NULL || freeList->numBuffers >= fMaxNumFreeBuffersPerSize) {
+    delete[] buffer;
+    return;
+  }
+
+  memcpy(buffer, &freeList->head, sizeof freeList->head);
+  freeList->head = buffer;
+  ++freeList->numBuffers;
+}
+
+unsigned ConnectionBufferPool::numFreeBuffers() const {
+  unsigned result = 0;
+  for (unsigned i = 0; i < fNumFreeLists; ++i) result += fFreeLists[i].numBuffers;
+  return result;
+}
+
+unsigned ConnectionBufferPool::numFreeBytes() const {
+  unsigned result = 0;
+  for (unsigned i = 0; i < fNumFreeLists; ++i) result += fFreeLists[i].numBuffers*fFreeLists[i].size;
+  return result;
+}
+
+ConnectionBufferPool::FreeList* ConnectionBufferPool::lookupFreeList(unsigned size) {
+  for (unsigned i = 0; i < fNumFreeLists; ++i) {
+    if (fFreeLists[i].size == size) return &fFreeLists[i];
+  }
+
+  // This is a new size.  Add a free list for it, if we can:
+  if (fNumFreeLists == MAX_NUM_FREE_LISTS) return NULL;
+  FreeList* freeList = &fFreeLists[fNumFreeLists++];
+  freeList->size = size;
+  freeList->head = NULL;
+  freeList->numBuffers = 0;
+  return freeList;
+}
+
+
 ////////// UserAuthenticationDatabase implementation //////////
 
 UserAuthenticationDatabase::UserAuthenticationDatabase(char const* realm,
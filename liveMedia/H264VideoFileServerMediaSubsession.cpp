@@ -82,6 +82,14 @@ void H264VideoFileServerMediaSubsession::checkForAuxSDPLine1() {
 char const* H264VideoFileServerMediaSubsession::getAuxSDPLine(RTPSink* rtpSink, FramedSource* inputSource) {
   if (fAuxSDPLine != NULL) return fAuxSDPLine; // it's already been set up (for a previous client)
 
+  // If we've already found the 'config' information for this version of the file (perhaps in a previous run of
+  // the server), then use it, rather than reading the file again:
+  char const* cachedAuxSDPLine = lookupCachedAuxSDPLine("H264", rtpSink);
+  if (cachedAuxSDPLine != NULL) {
+    fAuxSDPLine = strDup(cachedAuxSDPLine);
+    return fAuxSDPLine;
+  }
+
   if (fDummyRTPSink == NULL) { // we're not already setting it up for another, concurrent stream
     // Note: For H264 video files, the 'config' information ("profile-level-id" and "sprop-parameter-sets") isn't known
     // until we start reading the file.  This means that "rtpSink"s "auxSDPLine()" will be NULL initially,
@@ -97,6 +105,7 @@ char const* H264VideoFileServerMediaSubsession::getAuxSDPLine(RTPSink* rtpSink,
 
   envir().taskScheduler().doEventLoop(&fDoneFlag);
 
+  cacheAuxSDPLine("H264", rtpSink, fAuxSDPLine);
   return fAuxSDPLine;
 }
 
@@ -155,6 +155,26 @@ Boolean H264or5VideoRTPSink
   return False;
 }
 
+Boolean H264or5VideoRTPSink
+::frameIsDiscardable(unsigned /*fragmentationOffset*/,
+		     unsigned char const* frameStart,
+		     unsigned numBytesInFrame) const {
+  // Each 'frame' here is a single NAL unit, or a fragment of one (FU-A for H.264; FU for H.265).
+  // Only slices of non-key pictures are discardable; parameter sets, SEIs, and key (IDR/IRAP) pictures are not.
+  u_int8_t nal_unit_type;
+  if (fHNumber == 264) {
+    if (numBytesInFrame < 2) return False;
+    nal_unit_type = frameStart[0]&0x1F;
+    if (nal_unit_type == 28/*FU-A*/) nal_unit_type = frameStart[1]&0x1F;
+    return nal_unit_type >= 1 && nal_unit_type <= 4; // non-IDR slice, or slice data partition
+  } else { // 265
+    if (numBytesInFrame < 3) return False;
+    nal_unit_type = (frameStart[0]&0x7E)>>1;
+    if (nal_unit_type == 49/*FU*/) nal_unit_type = frameStart[2]&0x3F;
+    return nal_unit_type <= 9; // a VCL NAL unit of a non-IRAP picture
+  }
+}
+
 
 ////////// H264or5Fragmenter implementation //////////
 
@@ -82,6 +82,14 @@ void H265VideoFileServerMediaSubsession::checkForAuxSDPLine1() {
 char const* H265VideoFileServerMediaSubsession::getAuxSDPLine(RTPSink* rtpSink, FramedSource* inputSource) {
   if (fAuxSDPLine != NULL) return fAuxSDPLine; // it's already been set up (for a previous client)
 
+  // If we've already found the 'config' information for this version of the file (perhaps in a previous run of
+  // the server), then use it, rather than reading the file again:
+  char const* cachedAuxSDPLine = lookupCachedAuxSDPLine("H265", rtpSink);
+  if (cachedAuxSDPLine != NULL) {
+    fAuxSDPLine = strDup(cachedAuxSDPLine);
+    return fAuxSDPLine;
+  }
+
   if (fDummyRTPSink == NULL) { // we're not already setting it up for another, concurrent stream
     // Note: For H265 video files, the 'config' information (used for several payload-format
     // specific parameters in the SDP description) isn't known until we start reading the file.
@@ -98,6 +106,7 @@ char const* H265VideoFileServerMediaSubsession::getAuxSDPLine(RTPSink* rtpSink,
 
   envir().taskScheduler().doEventLoop(&fDoneFlag);
 
+  cacheAuxSDPLine("H265", rtpSink, fAuxSDPLine);
   return fAuxSDPLine;
 }
 
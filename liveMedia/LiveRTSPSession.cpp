@@ -1,4 +1,5 @@
 #include "LiveRTSPSession.hh"
+#include <unistd.h>
 
 #define RTSP_CLIENT_VERBOSITY_LEVEL 1
 #define REQUEST_STREAMING_OVER_TCP True
@@ -17,26 +18,37 @@
     }   }
 
 
-LiveRTSPSession* LiveRTSPSession::createNew(char const* rtspURL, char const* progName)
+LiveRTSPSession* LiveRTSPSession::createNew(char const* rtspURL, char const* progName, LiveRTSPSessionPool* pool)
 {
-	return new LiveRTSPSession(rtspURL, progName);
+	return new LiveRTSPSession(rtspURL, progName, pool);
 }
 
-LiveRTSPSession::LiveRTSPSession(char const* rtspURL, char const* progName)
+LiveRTSPSession::LiveRTSPSession(char const* rtspURL, char const* progName, LiveRTSPSessionPool* pool)
 		: fRTSPClient(NULL),
+		fProgName(strDup(progName)),
 		fScheduler(NULL), fEnv(NULL),
 		fOnGettingSDPFunc(NULL),
 		fOnGettingPacketFunc(NULL),
 		fCallbackData(NULL),
+		fPacketRing(NULL),
 		fThreadWatchVariable(0),
-		fThreadStarted(false)
+		fThreadStarted(false),
+		fPool(pool), fPoolLoopIndex(0), fStoppedInPool(false)
 {
-	fScheduler = BasicTaskScheduler::createNew();
-	fEnv = BasicUsageEnvironment::createNew(*fScheduler);
-
 	Assert(kMaxURLLen >= strlen(rtspURL) + 1);
 	memcpy(fURL, rtspURL, strlen(rtspURL) + 1);
 
+	if (fPool != NULL) {
+		// We share one of the pool's event loops.  Our "RTSPClient" gets created (in that loop's thread) by "Start()":
+		fPoolLoopIndex = fPool->AssignSession(fEnv);
+		pthread_mutex_init(&fStopMutex, NULL);
+		pthread_cond_init(&fStopCond, NULL);
+		return;
+	}
+
+	fScheduler = BasicTaskScheduler::createNew();
+	fEnv = BasicUsageEnvironment::createNew(*fScheduler);
+
 	fRTSPClient = LiveRTSPClient::createNew(*fEnv, rtspURL, *this, RTSP_CLIENT_VERBOSITY_LEVEL, progName);
 	if (fRTSPClient == NULL) {
 		*fEnv << "Failed to create a RTSP client for URL \"" << rtspURL << "\": " << fEnv->getResultMsg() << "\n";
@@ -46,6 +58,17 @@ LiveRTSPSession::LiveRTSPSession(char const* rtspURL, char const* progName)
 
 LiveRTSPSession::~LiveRTSPSession()
 {
+	if (fPool != NULL) {
+		// Our "RTSPClient" (if any) is shut down from within the pool's event loop:
+		StopAndWait();
+		fPool->ReleaseSession(fPoolLoopIndex);
+		pthread_cond_destroy(&fStopCond);
+		pthread_mutex_destroy(&fStopMutex);
+		delete fPacketRing;
+		delete[] fProgName;
+		return;
+	}
+
 	if (fRTSPClient != NULL) {
 		shutdownStream(fRTSPClient);
 		// fRTSPClient has been reclaimed in shutdownStream()
@@ -56,6 +79,16 @@ LiveRTSPSession::~LiveRTSPSession()
 
 	fEnv->reclaim(); fEnv = NULL;
 	delete fScheduler; fScheduler = NULL;
+	delete fPacketRing;
+	delete[] fProgName;
+}
+
+int LiveRTSPSession::EnablePacketRing(unsigned numSlots, unsigned slotSize)
+{
+	if (fThreadStarted || fPacketRing != NULL || numSlots == 0 || slotSize == 0) return -1;
+
+	fPacketRing = new LiveRTSPPacketRing(numSlots, slotSize);
+	return 0;
 }
 
 int LiveRTSPSession::Start(OnGettingSDPFunc* onGettingSDPFunc, OnGettingPacketFunc* onGettingPacketFunc, void* callbackData)
@@ -64,6 +97,19 @@ int LiveRTSPSession::Start(OnGettingSDPFunc* onGettingSDPFunc, OnGettingPacketFu
 	fOnGettingPacketFunc = onGettingPacketFunc;
 	fCallbackData = callbackData;
 
+	if (fPool != NULL) {
+		if (!fThreadStarted) {
+			fThreadStarted = true;
+			fStoppedInPool = false;
+			if (!fEnv->taskScheduler().postEvent(startInPool, this)) {
+				*fEnv << "Failed to start the session in its pool's event loop\n";
+				fThreadStarted = false;
+				return -1;
+			}
+		}
+		return 0;
+	}
+
 	if (!fThreadStarted) {
 		// start thread
 		int err = pthread_create((pthread_t*)&fThread, NULL, thread_entry, (void*)this);
@@ -82,6 +128,20 @@ void LiveRTSPSession::StopAndWait()
 {
 	void *retVal;
 
+	if (fPool != NULL) {
+		// Have our "RTSPClient" shut down from within the pool's event loop, and wait for this to happen:
+		// (Note: Like "pthread_join()" below, this must not be called from within the event loop itself.)
+		if (fThreadStarted) {
+			fEnv->taskScheduler().postEvent(stopInPool, this);
+
+			pthread_mutex_lock(&fStopMutex);
+			while (!fStoppedInPool) pthread_cond_wait(&fStopCond, &fStopMutex);
+			pthread_mutex_unlock(&fStopMutex);
+			fThreadStarted = false;
+		}
+		return;
+	}
+
 	if (fThreadWatchVariable == 0 && fThreadStarted) {
 		fThreadWatchVariable = 1;
 
@@ -101,7 +161,9 @@ void LiveRTSPSession::NotifySDPInfo(char* const sdpInfo)
 
 void LiveRTSPSession::NotifyPacket(char* packetData, unsigned packetSize, int trackIndex)
 {
-	if (fOnGettingPacketFunc != NULL) {
+	if (fPacketRing != NULL) {
+		fPacketRing->Enqueue(packetData, packetSize, trackIndex);
+	} else if (fOnGettingPacketFunc != NULL) {
 		(*fOnGettingPacketFunc)(fCallbackData, packetData, packetSize, trackIndex);
 	}
 }
@@ -128,6 +190,40 @@ void* LiveRTSPSession::thread_entry(void* session)
 	return NULL;
 }
 
+// static
+void LiveRTSPSession::startInPool(void* session)
+{
+	LiveRTSPSession* thiz = (LiveRTSPSession*)session;
+
+	if (thiz->fRTSPClient == NULL) {
+		thiz->fRTSPClient = LiveRTSPClient::createNew(*thiz->fEnv, thiz->fURL, *thiz,
+						RTSP_CLIENT_VERBOSITY_LEVEL, thiz->fProgName);
+		if (thiz->fRTSPClient == NULL) {
+			*(thiz->fEnv) << "Failed to create a RTSP client for URL \"" << thiz->fURL << "\": "
+				<< thiz->fEnv->getResultMsg() << "\n";
+			return;
+		}
+	}
+	thiz->fRTSPClient->sendDescribeCommand(continueAfterDESCRIBE);
+}
+
+// static
+void LiveRTSPSession::stopInPool(void* session)
+{
+	LiveRTSPSession* thiz = (LiveRTSPSession*)session;
+
+	if (thiz->fRTSPClient != NULL) {
+		shutdownStream(thiz->fRTSPClient);
+		// fRTSPClient has been reclaimed in shutdownStream()
+	}
+	*(thiz->fEnv) << "[" << thiz->GetURL() << "] session stopped.\n";
+
+	pthread_mutex_lock(&thiz->fStopMutex);
+	thiz->fStoppedInPool = true;
+	pthread_cond_signal(&thiz->fStopCond);
+	pthread_mutex_unlock(&thiz->fStopMutex);
+}
+
 // Implementation of the RTSP 'response handlers':
 // static
 void LiveRTSPSession::continueAfterDESCRIBE(RTSPClient* rtspClient, int resultCode, char* resultString) {
@@ -239,8 +335,10 @@ void LiveRTSPSession::continueAfterSETUP(RTSPClient* rtspClient, int resultCode,
 
 		env << *rtspClient << "Created a data sink for the \"" << *scs.subsession << "\" subsession\n";
 		scs.subsession->miscPtr = rtspClient; // a hack to let subsession handler functions get the "RTSPClient" from the subsession 
-		scs.subsession->sink->startPlaying(*(scs.subsession->readSource()),
-							subsessionAfterPlaying, scs.subsession);
+		// (Our sink wants only the RTP packets - not frames - so it reads the RTP source directly, if there is one.)
+		FramedSource* source = scs.subsession->rtpSource();
+		if (source == NULL) source = scs.subsession->readSource();
+		scs.subsession->sink->startPlaying(*source, subsessionAfterPlaying, scs.subsession);
 		// Also set a handler to be called if a RTCP "BYE" arrives for this subsession:
 		if (scs.subsession->rtcpInstance() != NULL) {
 			scs.subsession->rtcpInstance()->setByeHandler(subsessionByeHandler, scs.subsession);
@@ -378,6 +476,253 @@ void LiveRTSPSession::shutdownStream(RTSPClient* rtspClient, int exitCode) {
 	live.fThreadWatchVariable = 1;
 }
 
+// Implementation of "LiveRTSPPacketRing":
+static inline unsigned atomicLoadAcquire(unsigned volatile* ptr) { return __atomic_load_n(ptr, __ATOMIC_ACQUIRE); }
+static inline void atomicStoreRelease(unsigned volatile* ptr, unsigned val) { __atomic_store_n(ptr, val, __ATOMIC_RELEASE); }
+static inline void atomicIncrement(u_int64_t volatile* ptr) { __atomic_fetch_add(ptr, 1, __ATOMIC_RELAXED); }
+
+LiveRTSPPacketRing::LiveRTSPPacketRing(unsigned numSlots, unsigned slotSize)
+	: fNumSlots(1), fSlotSize(slotSize), fHead(0), fTail(0),
+	  fNumPacketsEnqueued(0), fNumPacketsDroppedBecauseFull(0), fNumPacketsDroppedBecauseTooLarge(0), fMaxNumPacketsQueued(0),
+	  fConsumerIsWaiting(0) {
+	while (fNumSlots < numSlots) fNumSlots <<= 1;
+
+	fSlotData = new char[fNumSlots*fSlotSize];
+	fSlotSizes = new unsigned[fNumSlots];
+	fSlotTrackIndexes = new int[fNumSlots];
+
+	pthread_mutex_init(&fWaitMutex, NULL);
+	pthread_cond_init(&fWaitCond, NULL);
+}
+
+LiveRTSPPacketRing::~LiveRTSPPacketRing()
+{
+	pthread_cond_destroy(&fWaitCond);
+	pthread_mutex_destroy(&fWaitMutex);
+
+	delete[] fSlotTrackIndexes;
+	delete[] fSlotSizes;
+	delete[] fSlotData;
+}
+
+bool LiveRTSPPacketRing::Enqueue(char const* packetData, unsigned packetSize, int trackIndex)
+{
+	if (packetSize > fSlotSize) {
+		atomicIncrement(&fNumPacketsDroppedBecauseTooLarge);
+		return false;
+	}
+
+	unsigned head = fHead; // only we write this
+	unsigned numQueued = head - atomicLoadAcquire(&fTail);
+	if (numQueued >= fNumSlots) {
+		atomicIncrement(&fNumPacketsDroppedBecauseFull);
+		return false;
+	}
+
+	unsigned slot = head&(fNumSlots-1);
+	memcpy(&fSlotData[slot*fSlotSize], packetData, packetSize);
+	fSlotSizes[slot] = packetSize;
+	fSlotTrackIndexes[slot] = trackIndex;
+	if (numQueued + 1 > fMaxNumPacketsQueued) fMaxNumPacketsQueued = numQueued + 1;
+	atomicIncrement(&fNumPacketsEnqueued);
+
+	// Publish the packet.  Then, if the consumer is (or is about to start) waiting, wake it up.
+	// (The store and the load below are both sequentially consistent, as are those in "Wait()", so that either we'll
+	// see that the consumer is waiting, or else the consumer will see our new packet before it waits.)
+	__atomic_store_n(&fHead, head + 1, __ATOMIC_SEQ_CST);
+	if (__atomic_load_n(&fConsumerIsWaiting, __ATOMIC_SEQ_CST)) {
+		pthread_mutex_lock(&fWaitMutex);
+		pthread_cond_signal(&fWaitCond);
+		pthread_mutex_unlock(&fWaitMutex);
+	}
+
+	return true;
+}
+
+unsigned LiveRTSPPacketRing::Poll(Packet* packets, unsigned maxPackets)
+{
+	unsigned tail = fTail; // only we write this
+	unsigned numQueued = atomicLoadAcquire(&fHead) - tail;
+	if (maxPackets > numQueued) maxPackets = numQueued;
+
+	for (unsigned i = 0; i < maxPackets; ++i) {
+		unsigned slot = (tail + i)&(fNumSlots-1);
+		packets[i].data = &fSlotData[slot*fSlotSize];
+		packets[i].size = fSlotSizes[slot];
+		packets[i].trackIndex = fSlotTrackIndexes[slot];
+	}
+
+	return maxPackets;
+}
+
+void LiveRTSPPacketRing::Release(unsigned numPackets)
+{
+	unsigned tail = fTail; // only we write this
+	unsigned numQueued = atomicLoadAcquire(&fHead) - tail;
+	if (numPackets > numQueued) numPackets = numQueued; // sanity check
+
+	atomicStoreRelease(&fTail, tail + numPackets);
+}
+
+bool LiveRTSPPacketRing::Wait(unsigned timeoutMs)
+{
+	if (atomicLoadAcquire(&fHead) != fTail) return true; // common case
+
+	struct timespec deadline;
+	clock_gettime(CLOCK_REALTIME, &deadline);
+	deadline.tv_sec += timeoutMs/1000;
+	deadline.tv_nsec += (timeoutMs%1000)*1000000;
+	if (deadline.tv_nsec >= 1000000000) {
+		++deadline.tv_sec;
+		deadline.tv_nsec -= 1000000000;
+	}
+
+	pthread_mutex_lock(&fWaitMutex);
+	__atomic_store_n(&fConsumerIsWaiting, 1, __ATOMIC_SEQ_CST);
+	while (__atomic_load_n(&fHead, __ATOMIC_SEQ_CST) == fTail) {
+		if (pthread_cond_timedwait(&fWaitCond, &fWaitMutex, &deadline) != 0) break; // timed out
+	}
+	__atomic_store_n(&fConsumerIsWaiting, 0, __ATOMIC_SEQ_CST);
+	pthread_mutex_unlock(&fWaitMutex);
+
+	return atomicLoadAcquire(&fHead) != fTail;
+}
+
+void LiveRTSPPacketRing::GetStats(Stats& stats) const
+{
+	stats.numPacketsEnqueued = __atomic_load_n(&fNumPacketsEnqueued, __ATOMIC_RELAXED);
+	stats.numPacketsDroppedBecauseFull = __atomic_load_n(&fNumPacketsDroppedBecauseFull, __ATOMIC_RELAXED);
+	stats.numPacketsDroppedBecauseTooLarge = __atomic_load_n(&fNumPacketsDroppedBecauseTooLarge, __ATOMIC_RELAXED);
+	stats.maxNumPacketsQueued = __atomic_load_n(&fMaxNumPacketsQueued, __ATOMIC_RELAXED);
+}
+
+// Implementation of "LiveRTSPSessionPool":
+// static
+LiveRTSPSessionPool* LiveRTSPSessionPool::createNew(unsigned numThreads)
+{
+	if (numThreads == 0) {
+		long numCores = sysconf(_SC_NPROCESSORS_ONLN);
+		numThreads = numCores > 0 ? (unsigned)numCores : 1;
+	}
+
+	LiveRTSPSessionPool* pool = new LiveRTSPSessionPool(numThreads);
+	if (!pool->StartThreads()) {
+		delete pool;
+		return NULL;
+	}
+
+	return pool;
+}
+
+LiveRTSPSessionPool::LiveRTSPSessionPool(unsigned numThreads)
+	: fNumLoops(numThreads) {
+	fLoops = new EventLoop[fNumLoops];
+	pthread_mutex_init(&fMutex, NULL);
+}
+
+LiveRTSPSessionPool::~LiveRTSPSessionPool()
+{
+	StopThreads();
+
+	for (unsigned i = 0; i < fNumLoops; ++i) {
+		if (fLoops[i].fNumSessions > 0) {
+			fprintf(stderr, "LiveRTSPSessionPool: deleted while %u sessions still use it!\n", fLoops[i].fNumSessions);
+		}
+		if (fLoops[i].fEnv != NULL) fLoops[i].fEnv->reclaim();
+		delete fLoops[i].fScheduler;
+	}
+	delete[] fLoops;
+
+	pthread_mutex_destroy(&fMutex);
+}
+
+unsigned LiveRTSPSessionPool::GetNumSessions()
+{
+	unsigned numSessions = 0;
+
+	pthread_mutex_lock(&fMutex);
+	for (unsigned i = 0; i < fNumLoops; ++i) numSessions += fLoops[i].fNumSessions;
+	pthread_mutex_unlock(&fMutex);
+
+	return numSessions;
+}
+
+bool LiveRTSPSessionPool::StartThreads()
+{
+	for (unsigned i = 0; i < fNumLoops; ++i) {
+		EventLoop& loop = fLoops[i];
+
+		// Each loop gets its own task scheduler and usage environment:
+#if defined(__linux__)
+		loop.fScheduler = EpollTaskScheduler::createNew();
+#endif
+		if (loop.fScheduler == NULL) loop.fScheduler = BasicTaskScheduler::createNew();
+		loop.fEnv = BasicUsageEnvironment::createNew(*loop.fScheduler);
+
+		int err = pthread_create(&loop.fThread, NULL, thread_entry, &loop);
+		if (err != 0) {
+			fprintf(stderr, "LiveRTSPSessionPool: failed to create event loop thread (%s)\n", strerror(err));
+			return false;
+		}
+		loop.fThreadStarted = true;
+	}
+
+	return true;
+}
+
+void LiveRTSPSessionPool::StopThreads()
+{
+	// Tell each loop to stop (waking it up, in case it's idle), and then wait for each of their threads to finish:
+	for (unsigned i = 0; i < fNumLoops; ++i) {
+		if (fLoops[i].fThreadStarted) fLoops[i].fScheduler->postEvent(wakeupHandler, &fLoops[i]);
+	}
+	for (unsigned i = 0; i < fNumLoops; ++i) {
+		if (fLoops[i].fThreadStarted) {
+			pthread_join(fLoops[i].fThread, NULL);
+			fLoops[i].fThreadStarted = false;
+		}
+	}
+}
+
+unsigned LiveRTSPSessionPool::AssignSession(UsageEnvironment*& env)
+{
+	// Use the loop that currently has the fewest sessions:
+	pthread_mutex_lock(&fMutex);
+	unsigned loopIndex = 0;
+	for (unsigned i = 1; i < fNumLoops; ++i) {
+		if (fLoops[i].fNumSessions < fLoops[loopIndex].fNumSessions) loopIndex = i;
+	}
+	++fLoops[loopIndex].fNumSessions;
+	pthread_mutex_unlock(&fMutex);
+
+	env = fLoops[loopIndex].fEnv;
+	return loopIndex;
+}
+
+void LiveRTSPSessionPool::ReleaseSession(unsigned loopIndex)
+{
+	pthread_mutex_lock(&fMutex);
+	if (loopIndex < fNumLoops && fLoops[loopIndex].fNumSessions > 0) --fLoops[loopIndex].fNumSessions;
+	pthread_mutex_unlock(&fMutex);
+}
+
+// static
+void* LiveRTSPSessionPool::thread_entry(void* loop)
+{
+	EventLoop* thiz = (EventLoop*)loop;
+
+	thiz->fEnv->taskScheduler().doEventLoop(&thiz->fWatchVariable);
+
+	return NULL;
+}
+
+// static
+void LiveRTSPSessionPool::wakeupHandler(void* loop)
+{
+	// Called (from within the loop's thread) when the pool is being deleted:
+	((EventLoop*)loop)->fWatchVariable = 1;
+}
+
 // Implementation of "LiveRTSPClient":
 // static
 LiveRTSPClient* LiveRTSPClient::createNew(UsageEnvironment& env, char const* rtspURL,
@@ -423,11 +768,11 @@ RTPRelaySink* RTPRelaySink::createNew(UsageEnvironment& env, MediaSubsession& su
 
 RTPRelaySink::RTPRelaySink(UsageEnvironment& env, MediaSubsession& subsession, LiveRTSPSession& liveRTSPSession, char const* streamId)
 	: MediaSink(env),
+	fReceiveBuffer(NULL),
 	fSubsession(subsession),
 	fLastRTPSeq(0),
 	fLiveRTSPSession(liveRTSPSession) {
 	fStreamId = strDup(streamId);
-	fReceiveBuffer = new u_int8_t[DUMMY_SINK_RECEIVE_BUFFER_SIZE];
 
 	MediaSession& session = subsession.parentSession();
 	MediaSubsessionIterator iter(session);
@@ -474,6 +819,13 @@ void RTPRelaySink::afterGettingPacket(void* clientData, char* packetData, unsign
 	sink->afterGettingPacket(packetData, packetSize);
 }
 
+// static
+void RTPRelaySink::afterGettingRTPPacket(void* clientData, BufferedPacket* packet)
+{
+	RTPRelaySink* sink = (RTPRelaySink*)clientData;
+	sink->afterGettingPacket((char*)packet->rtpPacket(), packet->rtpPacketSize());
+}
+
 void RTPRelaySink::afterGettingPacket(char* packetData, unsigned packetSize)
 {
 	// notify of RTP packet
@@ -498,7 +850,19 @@ void RTPRelaySink::afterGettingPacket(char* packetData, unsigned packetSize)
 Boolean RTPRelaySink::continuePlaying() {
 	if (fSource == NULL) return False; // sanity check (should not happen)
 
+	if (fSource == fSubsession.rtpSource()) {
+		// We want only the RTP packets, so have our source deliver each one to us (by reference), without assembling
+		// (and copying) frames.  In this 'packet mode', our "getNextFrame()" call never completes:
+		MultiFramedRTPSource* rtpSource = (MultiFramedRTPSource*)fSource; // (all of our RTP sources are of this type)
+		rtpSource->setPacketMode(afterGettingRTPPacket, this);
+		fSource->getNextFrame(NULL, 0,
+							afterGettingFrame, this,
+							onSourceClosure, this);
+		return True;
+	}
+
 	// Request the next frame of data from our input source.  "afterGettingFrame()" will get called later, when it arrives:
+	if (fReceiveBuffer == NULL) fReceiveBuffer = new u_int8_t[DUMMY_SINK_RECEIVE_BUFFER_SIZE];
 	fSource->getNextFrame(fReceiveBuffer, DUMMY_SINK_RECEIVE_BUFFER_SIZE,
 						afterGettingFrame, this,
 						onSourceClosure, this,
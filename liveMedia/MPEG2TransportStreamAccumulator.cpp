@@ -31,27 +31,77 @@ MPEG2TransportStreamAccumulator::createNew(UsageEnvironment& env,
 #define TRANSPORT_PACKET_SIZE 188
 #endif
 
+// The largest input frame (e.g., UDP datagram) that we read into our own buffer:
+#define MAX_INPUT_FRAME_SIZE 65536
+
 MPEG2TransportStreamAccumulator
 ::MPEG2TransportStreamAccumulator(UsageEnvironment& env,
 				  FramedSource* inputSource, unsigned maxPacketSize)
   : FramedFilter(env, inputSource),
     fDesiredPacketSize(maxPacketSize < TRANSPORT_PACKET_SIZE ? TRANSPORT_PACKET_SIZE : (maxPacketSize/TRANSPORT_PACKET_SIZE)*TRANSPORT_PACKET_SIZE),
-    fNumBytesGathered(0) {
+    fNumBytesGathered(0), fChunkNumTruncatedBytes(0), fChunkDurationInMicroseconds(0),
+    fReadIsIntoBuffer(False), fNumLeftoverBytes(0), fLeftoverDurationInMicroseconds(0),
+    fFlushTimeout(0), fFlushTask(NULL),
+    fNumChunksPassedThrough(0), fNumChunksFlushed(0) {
+  fBuffer = new unsigned char[MAX_INPUT_FRAME_SIZE];
+  fChunkPresentationTime.tv_sec = fChunkPresentationTime.tv_usec = 0;
+  fLeftoverPresentationTime = fChunkPresentationTime;
 }
 
 MPEG2TransportStreamAccumulator::~MPEG2TransportStreamAccumulator() {
+  envir().taskScheduler().unscheduleDelayedTask(fFlushTask);
+  delete[] fBuffer;
+}
+
+void MPEG2TransportStreamAccumulator::setFlushTimeout(unsigned timeoutInMicroseconds) {
+  fFlushTimeout = timeoutInMicroseconds;
 }
 
 void MPEG2TransportStreamAccumulator::doGetNextFrame() {
-  if (fNumBytesGathered >= fDesiredPacketSize) {
-    // Complete the delivery to the client:
-    fFrameSize = fNumBytesGathered;
-    fNumBytesGathered = 0;
-    afterGetting(this);
-  } else {
-    // Ask for more data (delivered directly to the client's buffer);
+  // We gather the next chunk in our client's buffer ("fTo"):
+  fNumBytesGathered = fChunkNumTruncatedBytes = 0;
+
+  if (fNumLeftoverBytes > 0) {
+    // Begin the chunk with the data that we read after the previous chunk was delivered:
+    unsigned numBytes = fNumLeftoverBytes;
+    if (numBytes > fMaxSize) {
+      fChunkNumTruncatedBytes = numBytes - fMaxSize;
+      numBytes = fMaxSize;
+    }
+    memmove(fTo, fBuffer, numBytes);
+    fNumLeftoverBytes = 0;
+    if (addFrame(numBytes, fLeftoverPresentationTime, fLeftoverDurationInMicroseconds)) {
+      deliverChunk();
+      return;
+    }
+  }
+
+  if (fInputSource->isCurrentlyAwaitingData()) return; // a read (into "fBuffer") is still pending; we'll continue when it completes
+  readInput();
+}
+
+void MPEG2TransportStreamAccumulator::doStopGettingFrames() {
+  envir().taskScheduler().unscheduleDelayedTask(fFlushTask);
+  fNumBytesGathered = fNumLeftoverBytes = 0;
+
+  FramedFilter::doStopGettingFrames();
+}
+
+void MPEG2TransportStreamAccumulator::readInput() {
+  if (fNumBytesGathered == 0) {
+    // Read directly into our client's buffer.  (So an input frame that's a complete chunk - e.g., a RTP payload of 7
+    // Transport Stream packets - gets passed through without being copied.)
+    fReadIsIntoBuffer = False;
     fInputSource->getNextFrame(fTo, fMaxSize, afterGettingFrame, this,
-			       FramedSource::handleClosure, this);
+			       FramedSource::handleClosure, this,
+			       (afterGettingPacketFunc*)FramedSource::afterGettingPacket);
+  } else {
+    // We've begun a chunk, which the flush timeout might deliver while this read is still pending.  So read into our
+    // own buffer instead; the data gets copied to the end of the chunk when it arrives:
+    fReadIsIntoBuffer = True;
+    fInputSource->getNextFrame(fBuffer, MAX_INPUT_FRAME_SIZE, afterGettingFrame, this,
+			       FramedSource::handleClosure, this,
+			       (afterGettingPacketFunc*)FramedSource::afterGettingPacket);
   }
 }
 
@@ -71,15 +121,84 @@ void MPEG2TransportStreamAccumulator
 		     unsigned numTruncatedBytes,
 		     struct timeval presentationTime,
 		     unsigned durationInMicroseconds) {
+  if (fReadIsIntoBuffer) {
+    if (!isCurrentlyAwaitingData() || (fNumBytesGathered > 0 && fNumBytesGathered + frameSize > fMaxSize)) {
+      // Either the chunk that this data was to be added to has already been flushed (and our client hasn't yet asked
+      // for another), or this data won't fit in the chunk.  Keep the data; it'll begin the next chunk:
+      fNumLeftoverBytes = frameSize;
+      fLeftoverPresentationTime = presentationTime;
+      fLeftoverDurationInMicroseconds = durationInMicroseconds;
+      if (isCurrentlyAwaitingData()) deliverChunk();
+      return;
+    }
+
+    if (frameSize > fMaxSize) { // this can happen only if the chunk is empty
+      fChunkNumTruncatedBytes += frameSize - fMaxSize;
+      frameSize = fMaxSize;
+    }
+    memmove(&fTo[fNumBytesGathered], fBuffer, frameSize);
+  } else {
+    fChunkNumTruncatedBytes += numTruncatedBytes;
+  }
+
+  if (addFrame(frameSize, presentationTime, durationInMicroseconds)) {
+    deliverChunk();
+  } else {
+    readInput();
+  }
+}
+
+Boolean MPEG2TransportStreamAccumulator
+::addFrame(unsigned frameSize, struct timeval presentationTime, unsigned durationInMicroseconds) {
+  // The frame's data is already at the end of the chunk (in "fTo"); account for it:
   if (fNumBytesGathered == 0) { // this is the first frame of the new chunk
-    fPresentationTime = presentationTime;
-    fDurationInMicroseconds = 0;
+    fChunkPresentationTime = presentationTime;
+    fChunkDurationInMicroseconds = 0;
   }
   fNumBytesGathered += frameSize;
-  fTo += frameSize;
-  fMaxSize -= frameSize;
-  fDurationInMicroseconds += durationInMicroseconds;
+  fChunkDurationInMicroseconds += durationInMicroseconds;
+
+  if (fNumBytesGathered >= fDesiredPacketSize || fNumBytesGathered + frameSize > fDesiredPacketSize
+      || fNumBytesGathered + frameSize > fMaxSize) {
+    // Our chunk is complete (or, at least, another input frame of the same size wouldn't fit in it):
+    if (fNumBytesGathered == frameSize) ++fNumChunksPassedThrough;
+    return True;
+  }
+
+  if (fFlushTimeout > 0 && fFlushTask == NULL) {
+    // Make sure that this chunk gets delivered, even if no more input arrives:
+    fFlushTask = envir().taskScheduler().scheduleDelayedTask(fFlushTimeout, flushChunk, this);
+  }
+  return False;
+}
+
+void MPEG2TransportStreamAccumulator::deliverChunk() {
+  if (fFlushTask != NULL) { // (check first, because we get here for every chunk)
+    envir().taskScheduler().unscheduleDelayedTask(fFlushTask);
+  }
+
+  // Complete the delivery to the client.  (The chunk is already in "fTo".)
+  fFrameSize = fNumBytesGathered;
+  fNumTruncatedBytes = fChunkNumTruncatedBytes;
+  fPresentationTime = fChunkPresentationTime;
+  fDurationInMicroseconds = fChunkDurationInMicroseconds;
+
+  fNumBytesGathered = 0;
+  afterGetting(this);
+}
+
+void MPEG2TransportStreamAccumulator::flushChunk(void* clientData) {
+  MPEG2TransportStreamAccumulator* accumulator
+    = (MPEG2TransportStreamAccumulator*)clientData;
+  accumulator->flushChunk1();
+}
+
+void MPEG2TransportStreamAccumulator::flushChunk1() {
+  fFlushTask = NULL;
+  if (fNumBytesGathered == 0 || !isCurrentlyAwaitingData()) return; // sanity check; shouldn't happen
 
-  // Try again to complete delivery:
-  doGetNextFrame();
+  // Deliver what we have.  (Any read from our input source that's still pending is into "fBuffer", so we don't need
+  // to touch it.  Its data will begin the next chunk.)
+  ++fNumChunksFlushed;
+  deliverChunk();
 }
@@ -0,0 +1,362 @@
+/**********
+This library is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the
+Free Software Foundation; either version 3 of the License, or (at your
+option) any later version. (See <http://www.gnu.org/copyleft/lesser.html>.)
+
+This library is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+**********/
+// "liveMedia"
+// Copyright (c) 1996-2017 Live Networks, Inc.  All rights reserved.
+// Checks the sync bytes and continuity counters of MPEG Transport Stream packets, keeping per-PID error counts.
+// (The packet headers are extracted and checked several at a time, using SSE2 or AVX2 if available.)
+// Implementation
+
+#include "MPEG2TransportStreamChecker.hh"
+#include <string.h>
+
+#define TRANSPORT_PACKET_SIZE 188
+#define TRANSPORT_SYNC_BYTE 0x47
+#define NULL_PID 0x1FFF
+
+// The number of packet headers that we extract at a time:
+#define HEADER_BATCH_SIZE 64
+
+// A packet header (as a big-endian 32-bit word) needs a closer look if - after being ANDed with "SLOW_PATH_MASK" -
+// it's not "FAST_PATH_VALUE": i.e., if it has a bad sync byte, has its 'transport_error_indicator' set, or has an
+// adaptation field (which might have its 'discontinuity_indicator' set):
+#define SLOW_PATH_MASK 0xFF800020
+#define FAST_PATH_VALUE 0x47000000
+
+// Most packets simply continue the previous packet's PID: They have the same PID, carry just a payload, and have the
+// next continuity counter.  Such packets need no per-PID lookup.  A packet header 'continues' the previous one if both
+// are the same after being ANDed with "RUN_MASK" (sync byte, 'transport_error_indicator', PID, and
+// 'adaptation_field_control'), if it's "RUN_VALUE" after being ANDed with "RUN_VALUE_MASK", and if its continuity
+// counter is one more than the previous one's:
+#define RUN_MASK 0xFF9FFF30
+#define RUN_VALUE_MASK 0xFF800030
+#define RUN_VALUE 0x47000010
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && !defined(NO_SIMD)
+#define USE_X86_SIMD 1
+#include <immintrin.h>
+#endif
+
+static inline u_int32_t getHeader(unsigned char const* pkt) {
+  return (pkt[0]<<24) | (pkt[1]<<16) | (pkt[2]<<8) | pkt[3];
+}
+
+// Each "extractHeaders*()" function extracts the headers of "numPackets" (<= "HEADER_BATCH_SIZE") packets into
+// "headers", and sets bit masks of those packets that need a closer look ("slowPathMask"), and of those packets that
+// continue the previous packet's PID ("continuationMask").  "prevHeader" is the header of the packet before "data"
+// (or 0 if none):
+
+static void extractHeadersScalar(unsigned char const* data, unsigned numPackets, u_int32_t prevHeader,
+				 u_int32_t* headers, u_int64_t& slowPathMask, u_int64_t& continuationMask) {
+  slowPathMask = continuationMask = 0;
+  for (unsigned i = 0; i < numPackets; ++i) {
+    u_int32_t const header = headers[i] = getHeader(&data[i*TRANSPORT_PACKET_SIZE]);
+    if ((header&SLOW_PATH_MASK) != FAST_PATH_VALUE) slowPathMask |= ((u_int64_t)1)<<i;
+    if ((header&RUN_MASK) == (prevHeader&RUN_MASK) && (header&RUN_VALUE_MASK) == RUN_VALUE
+	&& ((header - prevHeader)&0x0F) == 1) {
+      continuationMask |= ((u_int64_t)1)<<i;
+    }
+    prevHeader = header;
+  }
+}
+
+#ifdef USE_X86_SIMD
+// Returns the (network byte order) header of packet "i", or 0 if "i" is beyond the end of the data:
+static inline u_int32_t loadRawHeader(unsigned char const* data, unsigned i, unsigned numPackets) {
+  u_int32_t rawHeader = 0;
+  if (i < numPackets) memcpy(&rawHeader, &data[i*TRANSPORT_PACKET_SIZE], 4);
+  return rawHeader;
+}
+
+static inline u_int64_t lowBits(unsigned numBits) {
+  return numBits >= 64 ? ~(u_int64_t)0 : (((u_int64_t)1)<<numBits) - 1;
+}
+
+// Note: Because "headers" has room for "HEADER_BATCH_SIZE" headers (a multiple of 8), the SIMD functions below can
+// handle any final, partial group of packets by storing a whole group's worth of headers (with zeros at the end).
+// Also, the headers are loaded individually, rather than with "_mm256_i32gather_epi32()", because gathers are slow
+// on many CPUs.
+
+__attribute__((target("sse2")))
+static void extractHeadersSSE2(unsigned char const* data, unsigned numPackets, u_int32_t prevHeader,
+			       u_int32_t* headers, u_int64_t& slowPathMask, u_int64_t& continuationMask) {
+  __m128i const slowPathMask4 = _mm_set1_epi32((int)SLOW_PATH_MASK);
+  __m128i const fastPathValue4 = _mm_set1_epi32(FAST_PATH_VALUE);
+  __m128i const runMask4 = _mm_set1_epi32((int)RUN_MASK);
+  __m128i const runValueMask4 = _mm_set1_epi32((int)RUN_VALUE_MASK);
+  __m128i const runValue4 = _mm_set1_epi32(RUN_VALUE);
+  __m128i const ccMask4 = _mm_set1_epi32(0x0F);
+  __m128i const one4 = _mm_set1_epi32(1);
+  slowPathMask = continuationMask = 0;
+  for (unsigned i = 0; i < numPackets; i += 4) {
+    __m128i h = _mm_setr_epi32(loadRawHeader(data, i, numPackets), loadRawHeader(data, i+1, numPackets),
+			       loadRawHeader(data, i+2, numPackets), loadRawHeader(data, i+3, numPackets));
+
+    // Convert each header from network (big-endian) byte order:
+    h = _mm_or_si128(_mm_or_si128(_mm_slli_epi32(h, 24), _mm_srli_epi32(h, 24)),
+		     _mm_or_si128(_mm_and_si128(_mm_slli_epi32(h, 8), _mm_set1_epi32(0x00FF0000)),
+				  _mm_and_si128(_mm_srli_epi32(h, 8), _mm_set1_epi32(0x0000FF00))));
+    _mm_storeu_si128((__m128i*)&headers[i], h);
+
+    __m128i isFastPath = _mm_cmpeq_epi32(_mm_and_si128(h, slowPathMask4), fastPathValue4);
+    slowPathMask |= ((u_int64_t)(~_mm_movemask_ps(_mm_castsi128_ps(isFastPath))&0xF))<<i;
+
+    // Compare each header with the one before it:
+    __m128i prev = _mm_or_si128(_mm_slli_si128(h, 4), _mm_cvtsi32_si128((int)prevHeader));
+    __m128i continues = _mm_and_si128(_mm_cmpeq_epi32(_mm_and_si128(h, runMask4), _mm_and_si128(prev, runMask4)),
+				      _mm_cmpeq_epi32(_mm_and_si128(h, runValueMask4), runValue4));
+    continues = _mm_and_si128(continues, _mm_cmpeq_epi32(_mm_and_si128(_mm_sub_epi32(h, prev), ccMask4), one4));
+    continuationMask |= ((u_int64_t)_mm_movemask_ps(_mm_castsi128_ps(continues)))<<i;
+    prevHeader = headers[i+3];
+  }
+  slowPathMask &= lowBits(numPackets);
+  continuationMask &= lowBits(numPackets);
+}
+
+__attribute__((target("avx2")))
+static void extractHeadersAVX2(unsigned char const* data, unsigned numPackets, u_int32_t prevHeader,
+			       u_int32_t* headers, u_int64_t& slowPathMask, u_int64_t& continuationMask) {
+  __m256i const byteSwap = _mm256_setr_epi8(3,2,1,0, 7,6,5,4, 11,10,9,8, 15,14,13,12,
+					    3,2,1,0, 7,6,5,4, 11,10,9,8, 15,14,13,12);
+  __m256i const rotateByOne = _mm256_setr_epi32(7, 0, 1, 2, 3, 4, 5, 6);
+  __m256i const slowPathMask8 = _mm256_set1_epi32((int)SLOW_PATH_MASK);
+  __m256i const fastPathValue8 = _mm256_set1_epi32(FAST_PATH_VALUE);
+  __m256i const runMask8 = _mm256_set1_epi32((int)RUN_MASK);
+  __m256i const runValueMask8 = _mm256_set1_epi32((int)RUN_VALUE_MASK);
+  __m256i const runValue8 = _mm256_set1_epi32(RUN_VALUE);
+  __m256i const ccMask8 = _mm256_set1_epi32(0x0F);
+  __m256i const one8 = _mm256_set1_epi32(1);
+  slowPathMask = continuationMask = 0;
+  for (unsigned i = 0; i < numPackets; i += 8) {
+    // Load the headers of 8 packets, and convert each from network (big-endian) byte order:
+    __m256i h = _mm256_setr_epi32(loadRawHeader(data, i, numPackets), loadRawHeader(data, i+1, numPackets),
+				  loadRawHeader(data, i+2, numPackets), loadRawHeader(data, i+3, numPackets),
+				  loadRawHeader(data, i+4, numPackets), loadRawHeader(data, i+5, numPackets),
+				  loadRawHeader(data, i+6, numPackets), loadRawHeader(data, i+7, numPackets));
+    h = _mm256_shuffle_epi8(h, byteSwap);
+    _mm256_storeu_si256((__m256i*)&headers[i], h);
+
+    __m256i isFastPath = _mm256_cmpeq_epi32(_mm256_and_si256(h, slowPathMask8), fastPathValue8);
+    slowPathMask |= ((u_int64_t)(~_mm256_movemask_ps(_mm256_castsi256_ps(isFastPath))&0xFF))<<i;
+
+    // Compare each header with the one before it:
+    __m256i prev = _mm256_blend_epi32(_mm256_permutevar8x32_epi32(h, rotateByOne),
+				      _mm256_set1_epi32((int)prevHeader), 0x01);
+    __m256i continues = _mm256_and_si256(_mm256_cmpeq_epi32(_mm256_and_si256(h, runMask8),
+							    _mm256_and_si256(prev, runMask8)),
+					 _mm256_cmpeq_epi32(_mm256_and_si256(h, runValueMask8), runValue8));
+    continues = _mm256_and_si256(continues,
+				 _mm256_cmpeq_epi32(_mm256_and_si256(_mm256_sub_epi32(h, prev), ccMask8), one8));
+    continuationMask |= ((u_int64_t)_mm256_movemask_ps(_mm256_castsi256_ps(continues)))<<i;
+    prevHeader = headers[i+7];
+  }
+  slowPathMask &= lowBits(numPackets);
+  continuationMask &= lowBits(numPackets);
+}
+
+#ifdef __SSE2__
+static unsigned findSyncByteSSE2(unsigned char const* data, unsigned dataSize) {
+  __m128i const syncByte16 = _mm_set1_epi8(TRANSPORT_SYNC_BYTE);
+  unsigned i;
+  for (i = 0; i + 16 <= dataSize; i += 16) {
+    unsigned matchBits = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((__m128i const*)&data[i]), syncByte16));
+    if (matchBits != 0) return i + __builtin_ctz(matchBits);
+  }
+  for (; i < dataSize; ++i) {
+    if (data[i] == TRANSPORT_SYNC_BYTE) break;
+  }
+  return i;
+}
+#endif
+#endif
+
+typedef void (extractHeadersFunc)(unsigned char const* data, unsigned numPackets, u_int32_t prevHeader,
+				  u_int32_t* headers, u_int64_t& slowPathMask, u_int64_t& continuationMask);
+
+static extractHeadersFunc* chooseExtractHeadersFunc() {
+#ifdef USE_X86_SIMD
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) return extractHeadersAVX2;
+  if (__builtin_cpu_supports("sse2")) return extractHeadersSSE2;
+#endif
+  return extractHeadersScalar;
+}
+
+static extractHeadersFunc* extractHeaders = chooseExtractHeadersFunc();
+
+////////// MPEG2TransportStreamChecker //////////
+
+MPEG2TransportStreamChecker::MPEG2TransportStreamChecker()
+  : fPIDIndex(NULL), fPIDStats(NULL), fNumPIDs(0), fPIDStatsSize(0) {
+  reset();
+}
+
+MPEG2TransportStreamChecker::~MPEG2TransportStreamChecker() {
+  delete[] fPIDIndex;
+  delete[] fPIDStats;
+}
+
+void MPEG2TransportStreamChecker::reset() {
+  if (fPIDIndex != NULL) memset(fPIDIndex, 0, (NULL_PID+1)*sizeof (u_int16_t));
+  fNumPIDs = 0;
+  fPrevHeader = 0;
+  fNumPackets = fNumSyncErrors = fNumCCErrors = fNumTransportErrors = 0;
+}
+
+unsigned MPEG2TransportStreamChecker::findSyncByte(unsigned char const* data, unsigned dataSize) {
+#if defined(USE_X86_SIMD) && defined(__SSE2__)
+  return findSyncByteSSE2(data, dataSize);
+#else
+  unsigned i;
+  for (i = 0; i < dataSize; ++i) {
+    if (data[i] == TRANSPORT_SYNC_BYTE) break;
+  }
+  return i;
+#endif
+}
+
+Boolean MPEG2TransportStreamChecker::setImplementation(Implementation implementation) {
+  switch (implementation) {
+    case BEST_IMPLEMENTATION: {
+      extractHeaders = chooseExtractHeadersFunc();
+      return True;
+    }
+    case SCALAR_IMPLEMENTATION: {
+      extractHeaders = extractHeadersScalar;
+      return True;
+    }
+#ifdef USE_X86_SIMD
+    case SSE2_IMPLEMENTATION: {
+      if (!__builtin_cpu_supports("sse2")) return False;
+      extractHeaders = extractHeadersSSE2;
+      return True;
+    }
+    case AVX2_IMPLEMENTATION: {
+      if (!__builtin_cpu_supports("avx2")) return False;
+      extractHeaders = extractHeadersAVX2;
+      return True;
+    }
+#endif
+    default: {
+      return False;
+    }
+  }
+}
+
+unsigned MPEG2TransportStreamChecker::checkPackets(unsigned char const* data, unsigned numPackets) {
+  u_int32_t headers[HEADER_BATCH_SIZE];
+  u_int64_t const numErrorsBefore = fNumSyncErrors + fNumCCErrors + fNumTransportErrors;
+  fNumPackets += numPackets;
+
+  while (numPackets > 0) {
+    unsigned const batchSize = numPackets < HEADER_BATCH_SIZE ? numPackets : HEADER_BATCH_SIZE;
+    u_int64_t slowPathMask, continuationMask;
+    (*extractHeaders)(data, batchSize, fPrevHeader, headers, slowPathMask, continuationMask);
+
+    PIDStats* stats = (continuationMask&1) != 0 ? &pidStatsFor((fPrevHeader>>8)&NULL_PID) : NULL;
+    for (unsigned i = 0; i < batchSize; ++i) {
+      u_int32_t const header = headers[i];
+      if ((continuationMask>>i)&1) {
+	// The common case: This packet continues the previous packet's PID, with no error:
+	++stats->numPackets;
+	stats->lastCC = header&0x0F;
+	stats->lastWasDuplicate = False;
+	continue;
+      }
+
+      Boolean discontinuity_indicator = False;
+      if ((slowPathMask>>i)&1) {
+	unsigned char const* pkt = &data[i*TRANSPORT_PACKET_SIZE];
+	if (pkt[0] != TRANSPORT_SYNC_BYTE) {
+	  ++fNumSyncErrors;
+	  continue;
+	}
+	if ((header&0x00800000) != 0) { // 'transport_error_indicator'
+	  ++fNumTransportErrors;
+	  ++pidStatsFor((header>>8)&NULL_PID).numTransportErrors;
+	  continue; // the rest of the header can't be trusted
+	}
+	discontinuity_indicator = (header&0x20) != 0 && pkt[4] > 0 && (pkt[5]&0x80) != 0;
+      }
+
+      u_int16_t const pid = (header>>8)&NULL_PID;
+      stats = &pidStatsFor(pid);
+      ++stats->numPackets;
+      if (pid == NULL_PID) continue; // null packets' continuity counters are undefined
+
+      // Check the 'continuity_counter'.  It increments only in packets that have a payload; a packet with a payload
+      // may also be sent twice in a row (with the same continuity counter):
+      u_int8_t const cc = header&0x0F;
+      Boolean const hasPayload = (header&0x10) != 0;
+      if (discontinuity_indicator) {
+	++stats->numDiscontinuities;
+      } else if (stats->haveLastCC) {
+	Boolean ccIsValid;
+	if (!hasPayload) {
+	  ccIsValid = cc == stats->lastCC;
+	} else if (cc == stats->lastCC) {
+	  ccIsValid = !stats->lastWasDuplicate;
+	  stats->lastWasDuplicate = True;
+	} else {
+	  ccIsValid = cc == ((stats->lastCC+1)&0x0F);
+	  stats->lastWasDuplicate = False;
+	}
+	if (!ccIsValid) {
+	  ++stats->numCCErrors;
+	  ++fNumCCErrors;
+	}
+	stats->lastCC = cc;
+	continue;
+      }
+      // This is the first packet for this PID (or is after a signalled discontinuity):
+      stats->lastCC = cc;
+      stats->haveLastCC = True;
+      stats->lastWasDuplicate = False;
+    }
+
+    fPrevHeader = headers[batchSize-1];
+    data += batchSize*TRANSPORT_PACKET_SIZE;
+    numPackets -= batchSize;
+  }
+
+  return (unsigned)(fNumSyncErrors + fNumCCErrors + fNumTransportErrors - numErrorsBefore);
+}
+
+MPEG2TransportStreamChecker::PIDStats const* MPEG2TransportStreamChecker::lookupPID(u_int16_t pid) const {
+  if (fPIDIndex == NULL || pid > NULL_PID || fPIDIndex[pid] == 0) return NULL;
+  return &fPIDStats[fPIDIndex[pid]-1];
+}
+
+MPEG2TransportStreamChecker::PIDStats& MPEG2TransportStreamChecker::pidStatsFor(u_int16_t pid) {
+  if (fPIDIndex == NULL) {
+    fPIDIndex = new u_int16_t[NULL_PID+1];
+    memset(fPIDIndex, 0, (NULL_PID+1)*sizeof (u_int16_t));
+  }
+  if (fPIDIndex[pid] != 0) return fPIDStats[fPIDIndex[pid]-1];
+
+  // This is a new PID:
+  if (fNumPIDs == fPIDStatsSize) {
+    fPIDStatsSize = fPIDStatsSize == 0 ? 16 : 2*fPIDStatsSize;
+    PIDStats* newPIDStats = new PIDStats[fPIDStatsSize];
+    if (fNumPIDs > 0) memcpy(newPIDStats, fPIDStats, fNumPIDs*sizeof (PIDStats));
+    delete[] fPIDStats;
+    fPIDStats = newPIDStats;
+  }
+  PIDStats& stats = fPIDStats[fNumPIDs];
+  memset(&stats, 0, sizeof stats);
+  stats.pid = pid;
+  fPIDIndex[pid] = ++fNumPIDs;
+  return stats;
+}
@@ -0,0 +1,145 @@
+/**********
+This library is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the
+Free Software Foundation; either version 3 of the License, or (at your
+option) any later version. (See <http://www.gnu.org/copyleft/lesser.html>.)
+
+This library is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+**********/
+// "liveMedia"
+// Copyright (c) 1996-2017 Live Networks, Inc.  All rights reserved.
+// A RTP sink that sends each incoming datagram of MPEG Transport Stream packets (e.g., read from a "BasicUDPSource")
+// as soon as it arrives, as the payload of a RTP packet - without copying, reassembling or pacing the data.
+// Implementation
+
+#include "MPEG2TransportStreamDatagramRTPSink.hh"
+
+#define TRANSPORT_PACKET_SIZE 188
+#define RTP_HEADER_SIZE 12
+#define MAX_INPUT_DATAGRAM_SIZE 65536
+
+MPEG2TransportStreamDatagramRTPSink*
+MPEG2TransportStreamDatagramRTPSink::createNew(UsageEnvironment& env, Groupsock* RTPgs,
+					       Boolean inputDatagramsAreRTP, unsigned maxTSPacketsPerRTPPacket) {
+  return new MPEG2TransportStreamDatagramRTPSink(env, RTPgs, inputDatagramsAreRTP, maxTSPacketsPerRTPPacket);
+}
+
+MPEG2TransportStreamDatagramRTPSink
+::MPEG2TransportStreamDatagramRTPSink(UsageEnvironment& env, Groupsock* RTPgs,
+				      Boolean inputDatagramsAreRTP, unsigned maxTSPacketsPerRTPPacket)
+  : RTPSink(env, RTPgs, 33, 90000, "MP2T", 1),
+    fInputDatagramsAreRTP(inputDatagramsAreRTP),
+    fNumDatagramsForwarded(0), fNumDatagramsDiscarded(0) {
+  if (maxTSPacketsPerRTPPacket == 0) maxTSPacketsPerRTPPacket = 1;
+  fMaxPayloadSize = maxTSPacketsPerRTPPacket*TRANSPORT_PACKET_SIZE;
+
+  // Each datagram is read into our buffer after space for our own RTP header.  (If the datagram is itself a RTP packet,
+  // then we'll overwrite (the end of) its RTP header instead.)
+  fBuffer = new unsigned char[RTP_HEADER_SIZE + MAX_INPUT_DATAGRAM_SIZE];
+}
+
+MPEG2TransportStreamDatagramRTPSink::~MPEG2TransportStreamDatagramRTPSink() {
+  delete[] fBuffer;
+}
+
+Boolean MPEG2TransportStreamDatagramRTPSink::continuePlaying() {
+  if (fSource == NULL) return False;
+
+  fSource->getNextFrame(&fBuffer[RTP_HEADER_SIZE], MAX_INPUT_DATAGRAM_SIZE,
+			afterGettingFrame, this, onSourceClosure, this);
+  return True;
+}
+
+char const* MPEG2TransportStreamDatagramRTPSink::sdpMediaType() const {
+  return "video";
+}
+
+void MPEG2TransportStreamDatagramRTPSink
+::afterGettingFrame(void* clientData, unsigned frameSize,
+		    unsigned numTruncatedBytes,
+		    struct timeval presentationTime,
+		    unsigned /*durationInMicroseconds*/) {
+  MPEG2TransportStreamDatagramRTPSink* sink = (MPEG2TransportStreamDatagramRTPSink*)clientData;
+  sink->afterGettingFrame1(frameSize, numTruncatedBytes, presentationTime);
+}
+
+void MPEG2TransportStreamDatagramRTPSink
+::afterGettingFrame1(unsigned frameSize, unsigned numTruncatedBytes,
+		     struct timeval presentationTime) {
+  unsigned char* payload = &fBuffer[RTP_HEADER_SIZE];
+  unsigned payloadSize = frameSize;
+
+  do {
+    if (numTruncatedBytes > 0) break;
+
+    if (fInputDatagramsAreRTP) {
+      // Skip over the incoming RTP header (including any CSRCs and header extension), and any padding:
+      if (payloadSize < RTP_HEADER_SIZE || (payload[0]&0xC0) != 0x80) break;
+      unsigned rtpHdrSize = RTP_HEADER_SIZE + 4*(payload[0]&0x0F);
+      if (payload[0]&0x10) { // there's a header extension
+	if (payloadSize < rtpHdrSize + 4) break;
+	rtpHdrSize += 4 + 4*((payload[rtpHdrSize+2]<<8)|payload[rtpHdrSize+3]);
+      }
+      if (payloadSize < rtpHdrSize) break;
+      unsigned numPaddingBytes = (payload[0]&0x20) ? payload[payloadSize-1] : 0;
+      if (payloadSize < rtpHdrSize + numPaddingBytes) break;
+
+      payload += rtpHdrSize;
+      payloadSize -= rtpHdrSize + numPaddingBytes;
+    }
+
+    // The payload must consist of whole Transport Stream packets:
+    if (payloadSize == 0 || payloadSize%TRANSPORT_PACKET_SIZE != 0 || payload[0] != 0x47) break;
+
+    // All RTP packets made from this datagram get the same timestamp:
+    fCurrentTimestamp = convertToRTPTimestamp(presentationTime);
+    fMostRecentPresentationTime = presentationTime;
+    if (fInitialPresentationTime.tv_sec == 0 && fInitialPresentationTime.tv_usec == 0) {
+      fInitialPresentationTime = presentationTime;
+    }
+
+    sendPayload(payload, payloadSize);
+    ++fNumDatagramsForwarded;
+
+    continuePlaying();
+    return;
+  } while (0);
+
+  // The datagram was bad; ignore it, and read another:
+  ++fNumDatagramsDiscarded;
+  continuePlaying();
+}
+
+static inline void putWord(unsigned char* p, u_int32_t word) {
+  p[0] = word>>24; p[1] = word>>16; p[2] = word>>8; p[3] = word;
+}
+
+void MPEG2TransportStreamDatagramRTPSink::sendPayload(unsigned char* payload, unsigned payloadSize) {
+  while (payloadSize > 0) {
+    unsigned const chunkSize = payloadSize < fMaxPayloadSize ? payloadSize : fMaxPayloadSize;
+
+    // Write our RTP header just in front of this chunk.  (If this isn't the first chunk, then this overwrites the end of
+    // the previous chunk - but that has already been sent (or copied into an output queue).)
+    unsigned char* packet = payload - RTP_HEADER_SIZE;
+    putWord(&packet[0], 0x80000000|(rtpPayloadType()<<16)|fSeqNo);
+    putWord(&packet[4], fCurrentTimestamp);
+    putWord(&packet[8], SSRC());
+
+    // Send the packet - once, regardless of how many destinations (clients) it has:
+    fRTPInterface.sendPacket(packet, RTP_HEADER_SIZE + chunkSize);
+    ++fPacketCount;
+    fTotalOctetCount += RTP_HEADER_SIZE + chunkSize;
+    fOctetCount += chunkSize;
+    ++fSeqNo;
+
+    payload += chunkSize;
+    payloadSize -= chunkSize;
+  }
+}
@@ -0,0 +1,373 @@
+/**********
+This library is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the
+Free Software Foundation; either version 3 of the License, or (at your
+option) any later version. (See <http://www.gnu.org/copyleft/lesser.html>.)
+
+This library is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+**********/
+// "liveMedia"
+// Copyright (c) 1996-2017 Live Networks, Inc.  All rights reserved.
+// A de-jitter buffer for MPEG Transport Stream datagrams (e.g., received over UDP): Each datagram is held for a
+// while after it arrives, then released at a time given by a smoothed clock - derived from the stream's PCRs
+// if it has them, or else from the slope of the datagrams' arrival times.
+// Implementation
+
+#include "MPEG2TransportStreamDejitterBuffer.hh"
+#include "MPEG2TransportStreamFramer.hh" // for "getPCR()"
+#include <GroupsockHelper.hh> // for "gettimeofday()"
+
+#define TRANSPORT_PACKET_SIZE 188
+#define TRANSPORT_SYNC_BYTE 0x47
+
+////////// Definitions of constants that control the behavior of this code /////////
+
+#if !defined(MAX_PCR_GAP)
+#define MAX_PCR_GAP 1.0 // (seconds)
+  // A PCR that differs from its predicted value by more than this is treated as a discontinuity
+#endif
+
+#if !defined(CLOCK_WINDOW)
+#define CLOCK_WINDOW 1.0 // (seconds)
+  // The period (of arrival times) over which we measure the arrival bit rate, and the smallest clock offset
+#endif
+
+#if !defined(MAX_CLOCK_SLEW)
+#define MAX_CLOCK_SLEW 0.005 // (seconds per second)
+  // The most that our clock's offset is changed at the end of each window.  This limits how quickly the release rate
+  // can deviate from the stream's (PCR or arrival) bit rate, while still allowing for clock drift.
+#endif
+
+#if !defined(MAX_HOLD_FACTOR)
+#define MAX_HOLD_FACTOR 2
+  // No datagram is held for longer than this multiple of the target latency.  If one would be (or if one arrives later
+  // than its release time by more than the target latency), then the stream (or its clock) has jumped, so we resync.
+#endif
+
+#if !defined(MAX_ARRIVAL_TIME_AGE)
+#define MAX_ARRIVAL_TIME_AGE 10.0 // (seconds)
+  // An input presentation time that's in the future, or older than this, is not an arrival time; we use 'now' instead
+#endif
+
+static double timevalToDouble(struct timeval const& tv) {
+  return tv.tv_sec + tv.tv_usec/1000000.0;
+}
+
+static double timeNowAsDouble() {
+  struct timeval tvNow;
+  gettimeofday(&tvNow, NULL);
+  return timevalToDouble(tvNow);
+}
+
+MPEG2TransportStreamDejitterBuffer*
+MPEG2TransportStreamDejitterBuffer::createNew(UsageEnvironment& env, FramedSource* inputSource,
+					      unsigned latencyInMicroseconds,
+					      unsigned maxNumDatagrams, unsigned maxDatagramSize) {
+  return new MPEG2TransportStreamDejitterBuffer(env, inputSource, latencyInMicroseconds,
+						maxNumDatagrams, maxDatagramSize);
+}
+
+MPEG2TransportStreamDejitterBuffer
+::MPEG2TransportStreamDejitterBuffer(UsageEnvironment& env, FramedSource* inputSource,
+				     unsigned latencyInMicroseconds, unsigned maxNumDatagrams, unsigned maxDatagramSize)
+  : FramedFilter(env, inputSource),
+    fLatency(latencyInMicroseconds/1000000.0),
+    fMaxNumDatagrams(maxNumDatagrams == 0 ? 1 : maxNumDatagrams),
+    fMaxDatagramSize(maxDatagramSize < TRANSPORT_PACKET_SIZE ? TRANSPORT_PACKET_SIZE : maxDatagramSize),
+    fHead(0), fNumDatagramsBuffered(0), fNumBytesBuffered(0), fHaveStartedReading(False), fInputHasClosed(False),
+    fTSPacketCount(0), fHavePCR(False), fPCRPID(0), fLastPCR(0.0), fLastPCRPacketNum(0), fTSPacketDuration(0.0),
+    fStreamTimeIsFromPCR(False), fLastStreamTime(0.0), fLastDatagramSize(0), fArrivalBitrate(0.0),
+    fClockIsValid(False), fOffset(0.0), fWindowStartTime(0.0), fWindowMinOffset(0.0), fWindowNumBytes(0),
+    fNumResyncs(0) {
+  fSlotData = new unsigned char[fMaxNumDatagrams*fMaxDatagramSize];
+  fSlots = new DejitterSlot[fMaxNumDatagrams];
+
+  resetBufferStats();
+}
+
+MPEG2TransportStreamDejitterBuffer::~MPEG2TransportStreamDejitterBuffer() {
+  delete[] fSlots;
+  delete[] fSlotData;
+}
+
+double MPEG2TransportStreamDejitterBuffer::bitrate() const {
+  if (fStreamTimeIsFromPCR) return TRANSPORT_PACKET_SIZE*8/fTSPacketDuration;
+  return fArrivalBitrate;
+}
+
+double MPEG2TransportStreamDejitterBuffer::meanHoldTime() const {
+  return fNumDatagramsDelivered == 0 ? 0.0 : fTotalHoldTime/(double)(int64_t)fNumDatagramsDelivered;
+}
+
+double MPEG2TransportStreamDejitterBuffer::meanJitter() const {
+  return fNumDatagramsDelivered == 0 ? 0.0 : fTotalJitter/(double)(int64_t)fNumDatagramsDelivered;
+}
+
+void MPEG2TransportStreamDejitterBuffer::resetBufferStats() {
+  fMaxNumDatagramsBuffered = fNumDatagramsBuffered;
+  fMaxNumBytesBuffered = fNumBytesBuffered;
+  fNumOverflows = 0;
+  fNumDatagramsDelivered = fNumLateDatagrams = 0;
+  fTotalHoldTime = fMaxHoldTime = fTotalJitter = fMaxJitter = 0.0;
+}
+
+void MPEG2TransportStreamDejitterBuffer::doGetNextFrame() {
+  // Our input is read continually - not just when we're asked for data - so that each datagram is buffered (and
+  // timestamped, if our input source doesn't do that itself) as soon as possible:
+  fHaveStartedReading = True;
+  readInput(); // in case we'd stopped reading because the buffer was full
+
+  deliverDatagram();
+}
+
+void MPEG2TransportStreamDejitterBuffer::doStopGettingFrames() {
+  envir().taskScheduler().unscheduleDelayedTask(nextTask());
+  FramedFilter::doStopGettingFrames();
+
+  // Discard any buffered data, and our clock; we'll start afresh if we're read again.  (Otherwise, because our input
+  // was stopped, the buffered datagrams - and our clock - would be stale by then, and would be released as a burst.)
+  fHead = fNumDatagramsBuffered = fNumBytesBuffered = 0;
+  fHaveStartedReading = False;
+  fHavePCR = fStreamTimeIsFromPCR = fClockIsValid = False;
+  fTSPacketDuration = fArrivalBitrate = 0.0;
+  fLastDatagramSize = 0;
+  fWindowStartTime = 0.0;
+  fWindowNumBytes = 0;
+}
+
+void MPEG2TransportStreamDejitterBuffer::readInput() {
+  if (!fHaveStartedReading || fInputHasClosed || fInputSource->isCurrentlyAwaitingData()) return;
+  if (fNumDatagramsBuffered == fMaxNumDatagrams) return; // we'll resume reading when a datagram has been delivered
+
+  unsigned const tail = (fHead + fNumDatagramsBuffered)%fMaxNumDatagrams;
+  fInputSource->getNextFrame(&fSlotData[tail*fMaxDatagramSize], fMaxDatagramSize,
+			     afterGettingFrame, this,
+			     handleInputClosure, this,
+			     (afterGettingPacketFunc*)FramedSource::afterGettingPacket);
+}
+
+void MPEG2TransportStreamDejitterBuffer
+::afterGettingFrame(void* clientData, unsigned frameSize,
+		    unsigned /*numTruncatedBytes*/,
+		    struct timeval presentationTime,
+		    unsigned /*durationInMicroseconds*/) {
+  MPEG2TransportStreamDejitterBuffer* buffer = (MPEG2TransportStreamDejitterBuffer*)clientData;
+  buffer->afterGettingFrame1(frameSize, presentationTime);
+}
+
+void MPEG2TransportStreamDejitterBuffer::afterGettingFrame1(unsigned frameSize, struct timeval presentationTime) {
+  double const timeNow = timeNowAsDouble();
+  double arrivalTime = timevalToDouble(presentationTime);
+  if (arrivalTime > timeNow || arrivalTime < timeNow - MAX_ARRIVAL_TIME_AGE) arrivalTime = timeNow;
+
+  unsigned const tail = (fHead + fNumDatagramsBuffered)%fMaxNumDatagrams;
+  unsigned char const* datagram = &fSlotData[tail*fMaxDatagramSize];
+  unsigned const numTSPackets = frameSize/TRANSPORT_PACKET_SIZE; // we ignore any trailing partial packet
+  if (numTSPackets == 0 || datagram[0] != TRANSPORT_SYNC_BYTE) {
+    // This isn't Transport Stream data; ignore it:
+    readInput();
+    return;
+  }
+  unsigned const datagramSize = numTSPackets*TRANSPORT_PACKET_SIZE;
+
+  // Compute the datagram's release time:
+  Boolean isDiscontinuity;
+  double const streamTime = streamTimeFor(datagram, numTSPackets, arrivalTime, isDiscontinuity);
+  double const offset = arrivalTime - streamTime;
+  if (!fClockIsValid || isDiscontinuity) resync(offset);
+
+  double releaseTime = streamTime + fOffset + fLatency;
+  double const holdTime = releaseTime - arrivalTime;
+  if (holdTime > MAX_HOLD_FACTOR*fLatency || holdTime < -fLatency) {
+    resync(offset);
+    releaseTime = arrivalTime + fLatency;
+  }
+  updateClock(offset, arrivalTime, datagramSize);
+
+  // Datagrams are released in the order in which they arrived:
+  if (fNumDatagramsBuffered > 0) {
+    double const prevReleaseTime = fSlots[(tail + fMaxNumDatagrams - 1)%fMaxNumDatagrams].releaseTime;
+    if (releaseTime < prevReleaseTime) releaseTime = prevReleaseTime;
+  }
+
+  // Add the datagram to the buffer:
+  DejitterSlot& slot = fSlots[tail];
+  slot.size = datagramSize;
+  slot.arrivalTime = arrivalTime;
+  slot.releaseTime = releaseTime;
+  ++fNumDatagramsBuffered;
+  fNumBytesBuffered += datagramSize;
+  if (fNumDatagramsBuffered > fMaxNumDatagramsBuffered) fMaxNumDatagramsBuffered = fNumDatagramsBuffered;
+  if (fNumBytesBuffered > fMaxNumBytesBuffered) fMaxNumBytesBuffered = fNumBytesBuffered;
+  if (fNumDatagramsBuffered == fMaxNumDatagrams) ++fNumOverflows;
+
+  // If our client is waiting for a datagram that's not yet been scheduled, then this must be it:
+  if (nextTask() == NULL) deliverDatagram();
+
+  readInput();
+}
+
+void MPEG2TransportStreamDejitterBuffer::handleInputClosure(void* clientData) {
+  MPEG2TransportStreamDejitterBuffer* buffer = (MPEG2TransportStreamDejitterBuffer*)clientData;
+
+  // Deliver whatever datagrams we still have (on schedule), before we close:
+  buffer->fInputHasClosed = True;
+  if (buffer->nextTask() == NULL) buffer->deliverDatagram();
+}
+
+double MPEG2TransportStreamDejitterBuffer
+::streamTimeFor(unsigned char const* datagram, unsigned numTSPackets, double arrivalTime,
+		Boolean& isDiscontinuity) {
+  isDiscontinuity = False;
+
+  // Update our PCR 'clock' from any PCRs in the datagram.  (We use the PCRs from just one PID - the first that we see.)
+  u_int64_t const firstPacketNum = fTSPacketCount;
+  for (unsigned i = 0; i < numTSPackets; ++i) {
+    unsigned char const* pkt = &datagram[i*TRANSPORT_PACKET_SIZE];
+    double pcr;
+    unsigned pid;
+    Boolean discontinuity;
+    if (pkt[0] != TRANSPORT_SYNC_BYTE || !MPEG2TransportStreamFramer::getPCR(pkt, pcr, pid, discontinuity)) continue;
+    if (fHavePCR && pid != fPCRPID) continue;
+
+    u_int64_t const pcrPacketNum = firstPacketNum + i;
+    if (!fHavePCR) {
+      fHavePCR = True;
+      fPCRPID = pid;
+    } else {
+      double const pcrGap = pcr - fLastPCR;
+      int64_t const numPacketsSinceLastPCR = (int64_t)(pcrPacketNum - fLastPCRPacketNum);
+      if (discontinuity || pcrGap <= 0.0 || pcrGap > MAX_PCR_GAP || numPacketsSinceLastPCR <= 0) {
+	// We can't use this PCR to measure the bit rate, and must resync our clock from it:
+	isDiscontinuity = True;
+      } else {
+	// The bit rate (and thus the duration of each packet) is assumed to be constant between PCRs:
+	fTSPacketDuration = pcrGap/numPacketsSinceLastPCR;
+      }
+    }
+    fLastPCR = pcr;
+    fLastPCRPacketNum = pcrPacketNum;
+  }
+  fTSPacketCount += numTSPackets;
+
+  // The datagram's stream time is that of its first Transport Stream packet:
+  double streamTime;
+  Boolean const streamTimeIsFromPCR = fHavePCR && fTSPacketDuration > 0.0;
+  if (streamTimeIsFromPCR) {
+    streamTime = fLastPCR + ((int64_t)firstPacketNum - (int64_t)fLastPCRPacketNum)*fTSPacketDuration;
+  } else if (fArrivalBitrate > 0.0 && fLastDatagramSize > 0) {
+    // Assume that the previous datagram took as long to arrive as the arrival bit rate implies:
+    streamTime = fLastStreamTime + fLastDatagramSize*8/fArrivalBitrate;
+  } else {
+    // We don't yet know the bit rate, so can't smooth this datagram; it's just delayed:
+    streamTime = arrivalTime;
+  }
+  if (streamTimeIsFromPCR != fStreamTimeIsFromPCR) {
+    // We've switched between the PCR and arrival clocks (whose stream times are unrelated):
+    fStreamTimeIsFromPCR = streamTimeIsFromPCR;
+    isDiscontinuity = True;
+  }
+
+  fLastStreamTime = streamTime;
+  fLastDatagramSize = numTSPackets*TRANSPORT_PACKET_SIZE;
+  return streamTime;
+}
+
+void MPEG2TransportStreamDejitterBuffer::updateClock(double offset, double arrivalTime, unsigned datagramSize) {
+  if (fWindowStartTime == 0.0) {
+    // This is the first datagram:
+    fWindowStartTime = arrivalTime;
+  } else {
+    if (offset < fWindowMinOffset) fWindowMinOffset = offset;
+
+    double const windowDuration = arrivalTime - fWindowStartTime;
+    if (windowDuration >= CLOCK_WINDOW) {
+      // Update our measurement of the arrival bit rate:
+      double const windowBitrate = fWindowNumBytes*8/windowDuration;
+      fArrivalBitrate = fArrivalBitrate == 0.0 ? windowBitrate : (3*fArrivalBitrate + windowBitrate)/4;
+
+      // Move our clock's offset (slowly) towards that of the earliest-arriving datagrams in this window:
+      double adjustment = fWindowMinOffset - fOffset;
+      double const maxAdjustment = MAX_CLOCK_SLEW*windowDuration;
+      if (adjustment > maxAdjustment) adjustment = maxAdjustment;
+      else if (adjustment < -maxAdjustment) adjustment = -maxAdjustment;
+      fOffset += adjustment;
+
+      // Begin a new window:
+      fWindowStartTime = arrivalTime;
+      fWindowMinOffset = offset;
+      fWindowNumBytes = 0;
+    }
+  }
+
+  fWindowNumBytes += datagramSize; // (these bytes arrive during the *next* inter-datagram interval)
+}
+
+void MPEG2TransportStreamDejitterBuffer::resync(double offset) {
+  fOffset = offset;
+  fWindowMinOffset = offset;
+  if (fClockIsValid) ++fNumResyncs; // don't count the initial synchronization
+  fClockIsValid = True;
+}
+
+void MPEG2TransportStreamDejitterBuffer::deliverDatagram() {
+  if (!isCurrentlyAwaitingData()) return;
+
+  if (fNumDatagramsBuffered == 0) {
+    if (fInputHasClosed) {
+      handleClosure();
+    }
+    return; // we'll be called again when the next datagram arrives
+  }
+
+  DejitterSlot const& slot = fSlots[fHead];
+  double const timeNow = timeNowAsDouble();
+  double const delay = slot.releaseTime - timeNow;
+  if (delay > 0.0) {
+    // It's not yet time to release this datagram:
+    int64_t uSecondsToGo = (int64_t)(delay*1000000);
+    nextTask() = envir().taskScheduler().scheduleDelayedTask(uSecondsToGo, deliverScheduledDatagram, this);
+    return;
+  }
+
+  // Deliver the datagram:
+  if (slot.size > fMaxSize) {
+    fNumTruncatedBytes = slot.size - fMaxSize;
+    fFrameSize = fMaxSize;
+  } else {
+    fNumTruncatedBytes = 0;
+    fFrameSize = slot.size;
+  }
+  memmove(fTo, &fSlotData[fHead*fMaxDatagramSize], fFrameSize);
+  fPresentationTime.tv_sec = (long)slot.releaseTime; // the smoothed time, rather than the (jittered) time now
+  fPresentationTime.tv_usec = (long)((slot.releaseTime - fPresentationTime.tv_sec)*1000000);
+  fDurationInMicroseconds = 0; // because we do the pacing ourself
+
+  double const jitterInMicroseconds = -delay*1000000;
+  double const holdTimeInMicroseconds = (timeNow - slot.arrivalTime)*1000000;
+  ++fNumDatagramsDelivered;
+  if (slot.releaseTime < slot.arrivalTime) ++fNumLateDatagrams;
+  fTotalJitter += jitterInMicroseconds;
+  if (jitterInMicroseconds > fMaxJitter) fMaxJitter = jitterInMicroseconds;
+  fTotalHoldTime += holdTimeInMicroseconds;
+  if (holdTimeInMicroseconds > fMaxHoldTime) fMaxHoldTime = holdTimeInMicroseconds;
+
+  fHead = (fHead + 1)%fMaxNumDatagrams;
+  --fNumDatagramsBuffered;
+  fNumBytesBuffered -= slot.size;
+
+  afterGetting(this);
+}
+
+void MPEG2TransportStreamDejitterBuffer::deliverScheduledDatagram(void* clientData) {
+  MPEG2TransportStreamDejitterBuffer* buffer = (MPEG2TransportStreamDejitterBuffer*)clientData;
+  buffer->nextTask() = NULL;
+  buffer->deliverDatagram();
+}
@@ -75,13 +75,14 @@ MPEG2TransportStreamFramer
   : FramedFilter(env, inputSource),
     fTSPacketCount(0), fTSPacketDurationEstimate(0.0), fTSPCRCount(0),
     fLimitNumTSPacketsToStream(False), fNumTSPacketsToStream(0),
-    fLimitTSPacketsToStreamByPCR(False), fPCRLimit(0.0) {
+    fLimitTSPacketsToStreamByPCR(False), fPCRLimit(0.0), fStreamChecker(NULL) {
   fPIDStatusTable = HashTable::create(ONE_WORD_HASH_KEYS);
 }
 
 MPEG2TransportStreamFramer::~MPEG2TransportStreamFramer() {
   clearPIDStatusTable();
   delete fPIDStatusTable;
+  delete fStreamChecker;
 }
 
 void MPEG2TransportStreamFramer::clearPIDStatusTable() {
@@ -101,6 +102,11 @@ void MPEG2TransportStreamFramer::setPCRLimit(float pcrLimit) {
   fLimitTSPacketsToStreamByPCR = pcrLimit != 0.0;
 }
 
+MPEG2TransportStreamChecker* MPEG2TransportStreamFramer::enableStreamChecking() {
+  if (fStreamChecker == NULL) fStreamChecker = new MPEG2TransportStreamChecker;
+  return fStreamChecker;
+}
+
 void MPEG2TransportStreamFramer::doGetNextFrame() {
   if (fLimitNumTSPacketsToStream) {
     if (fNumTSPacketsToStream == 0) {
@@ -152,10 +158,7 @@ void MPEG2TransportStreamFramer::afterGettingFrame1(unsigned frameSize,
   }
 
   // Make sure the data begins with a sync byte:
-  unsigned syncBytePosition;
-  for (syncBytePosition = 0; syncBytePosition < fFrameSize; ++syncBytePosition) {
-    if (fTo[syncBytePosition] == TRANSPORT_SYNC_BYTE) break;
-  }
+  unsigned syncBytePosition = MPEG2TransportStreamChecker::findSyncByte(fTo, fFrameSize);
   if (syncBytePosition == fFrameSize) {
     envir() << "No Transport Stream sync byte in data.";
     handleClosure();
@@ -173,6 +176,8 @@ void MPEG2TransportStreamFramer::afterGettingFrame1(unsigned frameSize,
 
   fPresentationTime = presentationTime;
 
+  if (fStreamChecker != NULL) fStreamChecker->checkPackets(fTo, numTSPackets);
+
   // Scan through the TS packets that we read, and update our estimate of
   // the duration of each packet:
   struct timeval tvNow;
@@ -203,24 +208,13 @@ Boolean MPEG2TransportStreamFramer::updateTSPacketDurationEstimate(unsigned char
   ++fTSPacketCount;
 
   // If this packet doesn't contain a PCR, then we're not interested in it:
-  u_int8_t const adaptation_field_control = (pkt[3]&0x30)>>4;
-  if (adaptation_field_control != 2 && adaptation_field_control != 3) return True;
-      // there's no adaptation_field
-
-  u_int8_t const adaptation_field_length = pkt[4];
-  if (adaptation_field_length == 0) return True;
-
-  u_int8_t const discontinuity_indicator = pkt[5]&0x80;
-  u_int8_t const pcrFlag = pkt[5]&0x10;
-  if (pcrFlag == 0) return True; // no PCR
+  double clock;
+  unsigned pid;
+  Boolean discontinuity_indicator;
+  if (!getPCR(pkt, clock, pid, discontinuity_indicator)) return True;
 
-  // There's a PCR.  Get it, and the PID:
+  // There's a PCR:
   ++fTSPCRCount;
-  u_int32_t pcrBaseHigh = (pkt[6]<<24)|(pkt[7]<<16)|(pkt[8]<<8)|pkt[9];
-  double clock = pcrBaseHigh/45000.0;
-  if ((pkt[10]&0x80) != 0) clock += 1/90000.0; // add in low-bit (if set)
-  unsigned short pcrExt = ((pkt[10]&0x01)<<8) | pkt[11];
-  clock += pcrExt/27000000.0;
   if (fLimitTSPacketsToStreamByPCR) {
     if (clock > fPCRLimit) {
       // We've hit a preset limit within the stream:
@@ -228,8 +222,6 @@ Boolean MPEG2TransportStreamFramer::updateTSPacketDurationEstimate(unsigned char
     }
   }
 
-  unsigned pid = ((pkt[1]&0x1F)<<8) | pkt[2];
-
   // Check whether we already have a record of a PCR for this PID:
   PIDStatus* pidStatus = (PIDStatus*)(fPIDStatusTable->Lookup((char*)pid));
 
@@ -238,7 +230,7 @@ Boolean MPEG2TransportStreamFramer::updateTSPacketDurationEstimate(unsigned char
     pidStatus = new PIDStatus(clock, timeNow);
     fPIDStatusTable->Add((char*)pid, pidStatus);
 #ifdef DEBUG_PCR
-    fprintf(stderr, "PID 0x%x, FIRST PCR 0x%08x+%d:%03x == %f @ %f, pkt #%lu\n", pid, pcrBaseHigh, pkt[10]>>7, pcrExt, clock, timeNow, fTSPacketCount);
+    fprintf(stderr, "PID 0x%x, FIRST PCR %f @ %f, pkt #%lu\n", pid, clock, timeNow, fTSPacketCount);
 #endif
   } else {
     // We've seen this PID's PCR before; update our per-packet duration estimate:
@@ -258,7 +250,7 @@ Boolean MPEG2TransportStreamFramer::updateTSPacketDurationEstimate(unsigned char
 
     if (fTSPacketDurationEstimate == 0.0) { // we've just started
       fTSPacketDurationEstimate = durationPerPacket;
-    } else if (discontinuity_indicator == 0 && durationPerPacket >= 0.0) {
+    } else if (!discontinuity_indicator && durationPerPacket >= 0.0) {
       fTSPacketDurationEstimate
 	= durationPerPacket*NEW_DURATION_WEIGHT
 	+ fTSPacketDurationEstimate*(1-NEW_DURATION_WEIGHT);
@@ -279,7 +271,7 @@ Boolean MPEG2TransportStreamFramer::updateTSPacketDurationEstimate(unsigned char
       pidStatus->firstRealTime = timeNow;
     }
 #ifdef DEBUG_PCR
-    fprintf(stderr, "PID 0x%x, PCR 0x%08x+%d:%03x == %f @ %f (diffs %f @ %f), pkt #%lu, discon %d => this duration %f, new estimate %f, mean PCR period=%f\n", pid, pcrBaseHigh, pkt[10]>>7, pcrExt, clock, timeNow, clock - pidStatus->firstClock, timeNow - pidStatus->firstRealTime, fTSPacketCount, discontinuity_indicator != 0, durationPerPacket, fTSPacketDurationEstimate, meanPCRPeriod );
+    fprintf(stderr, "PID 0x%x, PCR %f @ %f (diffs %f @ %f), pkt #%lu, discon %d => this duration %f, new estimate %f, mean PCR period=%f\n", pid, clock, timeNow, clock - pidStatus->firstClock, timeNow - pidStatus->firstRealTime, fTSPacketCount, discontinuity_indicator != 0, durationPerPacket, fTSPacketDurationEstimate, meanPCRPeriod );
 #endif
   }
 
@@ -289,3 +281,27 @@ Boolean MPEG2TransportStreamFramer::updateTSPacketDurationEstimate(unsigned char
 
   return True;
 }
+
+Boolean MPEG2TransportStreamFramer
+::getPCR(unsigned char const* pkt, double& pcr, unsigned& pid, Boolean& discontinuityIndicator) {
+  u_int8_t const adaptation_field_control = (pkt[3]&0x30)>>4;
+  if (adaptation_field_control != 2 && adaptation_field_control != 3) return False;
+      // there's no adaptation_field
+
+  u_int8_t const adaptation_field_length = pkt[4];
+  if (adaptation_field_length == 0) return False;
+
+  u_int8_t const pcrFlag = pkt[5]&0x10;
+  if (pcrFlag == 0) return False; // no PCR
+
+  // There's a PCR.  Get it, and the PID:
+  u_int32_t pcrBaseHigh = (pkt[6]<<24)|(pkt[7]<<16)|(pkt[8]<<8)|pkt[9];
+  pcr = pcrBaseHigh/45000.0;
+  if ((pkt[10]&0x80) != 0) pcr += 1/90000.0; // add in low-bit (if set)
+  unsigned short pcrExt = ((pkt[10]&0x01)<<8) | pkt[11];
+  pcr += pcrExt/27000000.0;
+
+  pid = ((pkt[1]&0x1F)<<8) | pkt[2];
+  discontinuityIndicator = (pkt[5]&0x80) != 0;
+  return True;
+}
@@ -0,0 +1,518 @@
+/**********
+This library is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the
+Free Software Foundation; either version 3 of the License, or (at your
+option) any later version. (See <http://www.gnu.org/copyleft/lesser.html>.)
+
+This library is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+**********/
+// "liveMedia"
+// Copyright (c) 1996-2017 Live Networks, Inc.  All rights reserved.
+// A filter that removes unwanted PIDs from a MPEG Transport Stream: It keeps only the selected programs (and/or PIDs),
+// strips null packets, and rewrites the PAT and PMTs to describe only what's left.
+// Implementation
+
+#include "MPEG2TransportStreamPIDFilter.hh"
+#include "MPEG2TransportStreamMultiplexor.hh" // for "calculateCRC()"
+
+#define TRANSPORT_PACKET_SIZE 188
+#define TRANSPORT_SYNC_BYTE 0x47
+#define PAT_PID 0
+#define NULL_PID 0x1FFF
+
+#define MAX_SECTION_SIZE 1024 // for PAT and PMT sections (whose "section_length" is at most 1021)
+#define MAX_PIDS_PER_PROGRAM (1 + (MAX_SECTION_SIZE-16)/5) // the PCR PID, plus the most elementary streams a PMT can list
+
+#if !defined(MAX_NUM_PENDING_PACKETS)
+#define MAX_NUM_PENDING_PACKETS 32
+  // How many rewritten PAT/PMT packets can be waiting for room in the output
+#endif
+
+// Bits in "fPIDFlags[]":
+#define PID_IS_SELECTED 0x01 // by "addPID()"
+#define PID_IS_REMOVED 0x02 // by "removePID()"
+#define PID_IS_PMT 0x04 // for a kept program
+
+////////// PIDFilterProgram and PIDFilterPSIStream //////////
+
+class PIDFilterProgram {
+public:
+  PIDFilterProgram(u_int16_t programNumber, u_int16_t pmtPID)
+    : fProgramNumber(programNumber), fPMTPID(pmtPID), fNumPIDs(0), fWasSeen(True) {
+  }
+
+  u_int16_t fProgramNumber, fPMTPID;
+  u_int16_t fPIDs[MAX_PIDS_PER_PROGRAM]; // the PCR PID and the (kept) elementary stream PIDs, from the most recent PMT
+  unsigned fNumPIDs;
+  Boolean fWasSeen; // used while processing a new PAT
+};
+
+// The state of a PID that carries a PAT or PMT:
+class PIDFilterPSIStream {
+public:
+  PIDFilterPSIStream(u_int16_t pid)
+    : fPID(pid), fSectionSize(0), fInSection(False), fOutputCC(0) {
+  }
+
+  u_int16_t fPID;
+  unsigned char fSection[MAX_SECTION_SIZE]; // the section that's being assembled
+  unsigned fSectionSize;
+  Boolean fInSection;
+  u_int8_t fOutputCC; // the 'continuity_counter' for the next of our (rewritten) packets
+};
+
+////////// MPEG2TransportStreamPIDFilter //////////
+
+MPEG2TransportStreamPIDFilter*
+MPEG2TransportStreamPIDFilter::createNew(UsageEnvironment& env, FramedSource* inputSource) {
+  return new MPEG2TransportStreamPIDFilter(env, inputSource);
+}
+
+MPEG2TransportStreamPIDFilter
+::MPEG2TransportStreamPIDFilter(UsageEnvironment& env, FramedSource* inputSource)
+  : FramedFilter(env, inputSource),
+    fSelectedPrograms(NULL), fNumSelectedPrograms(0),
+    fPrograms(NULL), fNumPrograms(0), fPSIStreams(NULL), fNumPSIStreams(0),
+    fNumPendingBytes(0), fNumPendingBytesAtStart(0), fDurationOfRemovedData(0),
+    fNumPacketsIn(0), fNumPacketsOut(0), fNumNullPacketsRemoved(0), fNumPacketsRemoved(0), fNumBadPackets(0),
+    fNumSectionsRewritten(0) {
+  memset(fPIDFlags, 0, sizeof fPIDFlags);
+  memset(fPIDUseCount, 0, sizeof fPIDUseCount);
+  fPendingPackets = new unsigned char[MAX_NUM_PENDING_PACKETS*TRANSPORT_PACKET_SIZE];
+
+  // We always parse (and rewrite) the PAT:
+  fPSIStreams = new PIDFilterPSIStream*[1];
+  fPSIStreams[fNumPSIStreams++] = new PIDFilterPSIStream(PAT_PID);
+}
+
+MPEG2TransportStreamPIDFilter::~MPEG2TransportStreamPIDFilter() {
+  unsigned i;
+  for (i = 0; i < fNumPrograms; ++i) delete fPrograms[i];
+  delete[] fPrograms;
+  for (i = 0; i < fNumPSIStreams; ++i) delete fPSIStreams[i];
+  delete[] fPSIStreams;
+  delete[] fSelectedPrograms;
+  delete[] fPendingPackets;
+}
+
+void MPEG2TransportStreamPIDFilter::addProgram(u_int16_t programNumber) {
+  if (programIsSelected(programNumber)) return;
+
+  u_int16_t* newSelectedPrograms = new u_int16_t[fNumSelectedPrograms+1];
+  for (unsigned i = 0; i < fNumSelectedPrograms; ++i) newSelectedPrograms[i] = fSelectedPrograms[i];
+  newSelectedPrograms[fNumSelectedPrograms++] = programNumber;
+  delete[] fSelectedPrograms;
+  fSelectedPrograms = newSelectedPrograms;
+}
+
+void MPEG2TransportStreamPIDFilter::addPID(u_int16_t pid) {
+  pid &= NULL_PID;
+  fPIDFlags[pid] = (fPIDFlags[pid]&~PID_IS_REMOVED)|PID_IS_SELECTED;
+}
+
+void MPEG2TransportStreamPIDFilter::removePID(u_int16_t pid) {
+  pid &= NULL_PID;
+  if (pid == PAT_PID) return; // we always keep the PAT
+  fPIDFlags[pid] = (fPIDFlags[pid]&~PID_IS_SELECTED)|PID_IS_REMOVED;
+}
+
+void MPEG2TransportStreamPIDFilter::doGetNextFrame() {
+  // Begin with any rewritten PAT/PMT packets that didn't fit into our previous delivery:
+  unsigned char* to = fTo;
+  flushPendingPackets(to, fTo + fMaxSize);
+  fNumPendingBytesAtStart = to - fTo;
+
+  if (fNumPendingBytesAtStart > 0 && fMaxSize - fNumPendingBytesAtStart < TRANSPORT_PACKET_SIZE) {
+    // There's no room left to read any input; deliver just these packets:
+    fFrameSize = fNumPendingBytesAtStart;
+    fNumTruncatedBytes = 0;
+    fDurationInMicroseconds = 0;
+    afterGetting(this);
+    return;
+  }
+
+  // Read input data into the rest of the client's buffer; we'll then filter it in place:
+  fInputSource->getNextFrame(fTo + fNumPendingBytesAtStart, fMaxSize - fNumPendingBytesAtStart,
+			     afterGettingFrame, this,
+			     FramedSource::handleClosure, this,
+			     (afterGettingPacketFunc*)FramedSource::afterGettingPacket);
+}
+
+void MPEG2TransportStreamPIDFilter
+::afterGettingFrame(void* clientData, unsigned frameSize,
+		    unsigned /*numTruncatedBytes*/,
+		    struct timeval presentationTime,
+		    unsigned durationInMicroseconds) {
+  MPEG2TransportStreamPIDFilter* filter = (MPEG2TransportStreamPIDFilter*)clientData;
+  filter->afterGettingFrame1(frameSize, presentationTime, durationInMicroseconds);
+}
+
+void MPEG2TransportStreamPIDFilter
+::afterGettingFrame1(unsigned frameSize, struct timeval presentationTime, unsigned durationInMicroseconds) {
+  // Go through each incoming Transport Stream packet, moving each one that's to be kept to the front of the buffer.
+  // (Any trailing partial packet is discarded.)
+  unsigned char* const start = fTo + fNumPendingBytesAtStart;
+  unsigned char* to = start;
+  unsigned char* from = start;
+  unsigned char const* const end = start + frameSize;
+  for (; from + TRANSPORT_PACKET_SIZE <= end; from += TRANSPORT_PACKET_SIZE) {
+    // Fill any space that's been freed up by removed packets with rewritten PAT/PMT packets (if any):
+    flushPendingPackets(to, from);
+
+    ++fNumPacketsIn;
+    if (from[0] != TRANSPORT_SYNC_BYTE) {
+      ++fNumBadPackets;
+      continue;
+    }
+
+    u_int16_t const pid = ((from[1]&0x1F)<<8) | from[2];
+    if (pid == PAT_PID || (fPIDFlags[pid]&PID_IS_PMT) != 0) {
+      // We deliver our own (rewritten) version of this table, rather than the original packet:
+      handlePSIPacket(lookupPSIStream(pid), from);
+    } else if (packetIsToBeKept(pid)) {
+      if (to != from) memmove(to, from, TRANSPORT_PACKET_SIZE);
+      to += TRANSPORT_PACKET_SIZE;
+      ++fNumPacketsOut;
+    } else if (pid == NULL_PID) {
+      ++fNumNullPacketsRemoved;
+    } else {
+      ++fNumPacketsRemoved;
+    }
+  }
+  flushPendingPackets(to, fTo + fMaxSize);
+
+  fFrameSize = to - fTo;
+  if (fFrameSize == 0) {
+    // Everything was removed.  Remember the duration of this data (so that our client's timing isn't disturbed),
+    // and read again:
+    fDurationOfRemovedData += durationInMicroseconds;
+    doGetNextFrame();
+    return;
+  }
+
+  fNumTruncatedBytes = 0;
+  fPresentationTime = presentationTime;
+  fDurationInMicroseconds = fDurationOfRemovedData + durationInMicroseconds;
+  fDurationOfRemovedData = 0;
+  afterGetting(this);
+}
+
+Boolean MPEG2TransportStreamPIDFilter::packetIsToBeKept(u_int16_t pid) const {
+  u_int8_t const flags = fPIDFlags[pid];
+  if ((flags&PID_IS_SELECTED) != 0) return True;
+  if ((flags&PID_IS_REMOVED) != 0 || pid == NULL_PID) return False;
+
+  // If we're keeping all programs, then we also keep PIDs that no PMT mentions (e.g., SDT, EIT):
+  return fNumSelectedPrograms == 0 || fPIDUseCount[pid] > 0;
+}
+
+void MPEG2TransportStreamPIDFilter
+::handlePSIPacket(PIDFilterPSIStream* psiStream, unsigned char const* pkt) {
+  if (psiStream == NULL) return; // shouldn't happen
+
+  u_int8_t const adaptation_field_control = (pkt[3]&0x30)>>4;
+  if ((adaptation_field_control&0x1) == 0) return; // there's no payload
+
+  unsigned payloadOffset = 4;
+  if (adaptation_field_control == 3) payloadOffset += 1 + pkt[4];
+  if (payloadOffset >= TRANSPORT_PACKET_SIZE) return;
+  unsigned char const* payload = &pkt[payloadOffset];
+  unsigned payloadSize = TRANSPORT_PACKET_SIZE - payloadOffset;
+
+  Boolean const payload_unit_start_indicator = (pkt[1]&0x40) != 0;
+  if (payload_unit_start_indicator) {
+    // The payload begins with a 'pointer_field', giving the number of bytes (that end the previous section)
+    // before the start of the next section:
+    unsigned const pointer_field = payload[0];
+    ++payload; --payloadSize;
+    if (pointer_field > payloadSize) { // bad data
+      psiStream->fInSection = False;
+      return;
+    }
+    appendToSection(psiStream, payload, pointer_field);
+    payload += pointer_field; payloadSize -= pointer_field;
+
+    // Note: We handle only the first section that begins in each packet.  (PATs and PMTs are almost never packed
+    // more tightly than this.)
+    psiStream->fInSection = True;
+    psiStream->fSectionSize = 0;
+  }
+  appendToSection(psiStream, payload, payloadSize);
+}
+
+void MPEG2TransportStreamPIDFilter
+::appendToSection(PIDFilterPSIStream* psiStream, unsigned char const* data, unsigned dataSize) {
+  if (!psiStream->fInSection || dataSize == 0) return;
+  if (psiStream->fSectionSize == 0 && data[0] == 0xFF) { // this is stuffing, not a section
+    psiStream->fInSection = False;
+    return;
+  }
+
+  unsigned numBytesToCopy = MAX_SECTION_SIZE - psiStream->fSectionSize;
+  if (numBytesToCopy > dataSize) numBytesToCopy = dataSize;
+  memmove(&psiStream->fSection[psiStream->fSectionSize], data, numBytesToCopy);
+  psiStream->fSectionSize += numBytesToCopy;
+  if (psiStream->fSectionSize < 3) return; // we don't yet know the section's size
+
+  unsigned char const* section = psiStream->fSection;
+  unsigned const sectionSize = 3 + (((section[1]&0x0F)<<8) | section[2]);
+  if (sectionSize > MAX_SECTION_SIZE) { // bad data
+    psiStream->fInSection = False;
+  } else if (psiStream->fSectionSize >= sectionSize) {
+    // We have a complete section:
+    psiStream->fSectionSize = sectionSize;
+    psiStream->fInSection = False;
+    handleSection(psiStream);
+  }
+}
+
+void MPEG2TransportStreamPIDFilter::handleSection(PIDFilterPSIStream* psiStream) {
+  unsigned char* section = psiStream->fSection;
+  unsigned sectionSize = psiStream->fSectionSize;
+
+  // Check the section's CRC (which makes the CRC of the whole section 0):
+  if (sectionSize < 12 || calculateCRC(section, sectionSize) != 0) return;
+  if ((section[5]&0x01) == 0) return; // 'current_next_indicator' is 0: The section doesn't yet apply
+  if (section[6] != 0 || section[7] != 0) return; // we don't handle tables that are split into multiple sections
+
+  unsigned const originalSectionSize = sectionSize;
+  Boolean sectionIsValid;
+  if (psiStream->fPID == PAT_PID) {
+    sectionIsValid = section[0] == 0x00 && rewritePAT(section, sectionSize);
+  } else {
+    sectionIsValid = section[0] == 0x02 && rewritePMT(psiStream->fPID, section, sectionSize);
+  }
+  if (!sectionIsValid) return;
+
+  if (sectionSize != originalSectionSize) ++fNumSectionsRewritten;
+  queueSection(psiStream, section, sectionSize);
+}
+
+// Updates a section's "section_length" and "CRC_32" after it has been rewritten.  Returns the new section size:
+static unsigned finishSection(unsigned char* section, unsigned char* crcPosition) {
+  unsigned const sectionSize = (crcPosition - section) + 4;
+  unsigned const section_length = sectionSize - 3;
+  section[1] = (section[1]&0xF0) | (section_length>>8);
+  section[2] = section_length;
+
+  u_int32_t crc = calculateCRC(section, crcPosition - section);
+  *crcPosition++ = crc>>24; *crcPosition++ = crc>>16; *crcPosition++ = crc>>8; *crcPosition++ = crc;
+  return sectionSize;
+}
+
+Boolean MPEG2TransportStreamPIDFilter::rewritePAT(unsigned char* section, unsigned& sectionSize) {
+  unsigned i;
+  for (i = 0; i < fNumPrograms; ++i) fPrograms[i]->fWasSeen = False;
+
+  // Go through each (program_number, PID) entry, keeping only those for the programs that we're keeping:
+  unsigned char* const end = &section[sectionSize-4];
+  unsigned char* to = &section[8];
+  for (unsigned char* from = &section[8]; from + 4 <= end; from += 4) {
+    u_int16_t const program_number = (from[0]<<8) | from[1];
+    u_int16_t const pid = ((from[2]&0x1F)<<8) | from[3];
+    if (pid == PAT_PID || pid == NULL_PID || (fPIDFlags[pid]&PID_IS_REMOVED) != 0) continue;
+
+    if (program_number == 0) {
+      // This entry gives the network PID (for the NIT):
+      if (fNumSelectedPrograms > 0 && (fPIDFlags[pid]&PID_IS_SELECTED) == 0) continue;
+    } else {
+      if (fNumSelectedPrograms > 0 && !programIsSelected(program_number)) continue;
+
+      PIDFilterProgram* program = NULL;
+      for (i = 0; i < fNumPrograms; ++i) {
+	if (fPrograms[i]->fProgramNumber == program_number && fPrograms[i]->fPMTPID == pid) {
+	  program = fPrograms[i];
+	  break;
+	}
+      }
+      if (program != NULL) {
+	if (program->fWasSeen) continue; // a duplicate entry
+	program->fWasSeen = True;
+      } else {
+	// This is a new program:
+	PIDFilterProgram** newPrograms = new PIDFilterProgram*[fNumPrograms+1];
+	for (i = 0; i < fNumPrograms; ++i) newPrograms[i] = fPrograms[i];
+	newPrograms[fNumPrograms++] = new PIDFilterProgram(program_number, pid);
+	delete[] fPrograms;
+	fPrograms = newPrograms;
+	addPMTPID(pid);
+      }
+    }
+
+    if (to != from) memmove(to, from, 4);
+    to += 4;
+  }
+
+  // Delete any programs that are no longer in the PAT:
+  for (i = 0; i < fNumPrograms; ) {
+    if (fPrograms[i]->fWasSeen) {
+      ++i;
+    } else {
+      deleteProgram(i);
+    }
+  }
+
+  if (to != end) sectionSize = finishSection(section, to);
+  return True;
+}
+
+Boolean MPEG2TransportStreamPIDFilter
+::rewritePMT(u_int16_t pid, unsigned char* section, unsigned& sectionSize) {
+  if (sectionSize < 16) return False;
+
+  // Find the (kept) program that this PMT describes:
+  u_int16_t const program_number = (section[3]<<8) | section[4];
+  PIDFilterProgram* program = NULL;
+  unsigned i;
+  for (i = 0; i < fNumPrograms; ++i) {
+    if (fPrograms[i]->fProgramNumber == program_number && fPrograms[i]->fPMTPID == pid) {
+      program = fPrograms[i];
+      break;
+    }
+  }
+  if (program == NULL) return False; // we're not keeping this program
+
+  unsigned char* const end = &section[sectionSize-4];
+  unsigned const program_info_length = ((section[10]&0x0F)<<8) | section[11];
+  unsigned char* from = &section[12 + program_info_length];
+  if (from > end) return False;
+
+  // Replace the PIDs that were used by the program's previous PMT with those that are used by this one:
+  for (i = 0; i < program->fNumPIDs; ++i) --fPIDUseCount[program->fPIDs[i]];
+  program->fNumPIDs = 0;
+  u_int16_t const PCR_PID = ((section[8]&0x1F)<<8) | section[9];
+  if (PCR_PID != NULL_PID) {
+    program->fPIDs[program->fNumPIDs++] = PCR_PID;
+    ++fPIDUseCount[PCR_PID];
+  }
+
+  // Go through each elementary stream entry, keeping only those whose PIDs haven't been removed:
+  unsigned char* to = from;
+  while (from + 5 <= end) {
+    u_int16_t const elementary_PID = ((from[1]&0x1F)<<8) | from[2];
+    unsigned const ES_info_length = ((from[3]&0x0F)<<8) | from[4];
+    unsigned const entrySize = 5 + ES_info_length;
+    if (from + entrySize > end) break; // bad data
+
+    if ((fPIDFlags[elementary_PID]&PID_IS_REMOVED) == 0) {
+      if (to != from) memmove(to, from, entrySize);
+      to += entrySize;
+      if (program->fNumPIDs < MAX_PIDS_PER_PROGRAM) {
+	program->fPIDs[program->fNumPIDs++] = elementary_PID;
+	++fPIDUseCount[elementary_PID];
+      }
+    }
+    from += entrySize;
+  }
+
+  if (to != end) sectionSize = finishSection(section, to);
+  return True;
+}
+
+void MPEG2TransportStreamPIDFilter
+::queueSection(PIDFilterPSIStream* psiStream, unsigned char const* section, unsigned sectionSize) {
+  // Packetize the section (beginning with a 0 'pointer_field'), with our own continuity counters:
+  unsigned const numPackets = (1 + sectionSize + (TRANSPORT_PACKET_SIZE-4) - 1)/(TRANSPORT_PACKET_SIZE-4);
+  if (fNumPendingBytes + numPackets*TRANSPORT_PACKET_SIZE > MAX_NUM_PENDING_PACKETS*TRANSPORT_PACKET_SIZE) {
+    return; // no room; a later repetition of the table will be delivered instead
+  }
+
+  u_int16_t const pid = psiStream->fPID;
+  for (unsigned i = 0; i < numPackets; ++i) {
+    unsigned char* pkt = &fPendingPackets[fNumPendingBytes];
+    pkt[0] = TRANSPORT_SYNC_BYTE;
+    pkt[1] = (i == 0 ? 0x40 : 0x00) | (pid>>8); // 'payload_unit_start_indicator' on the first packet
+    pkt[2] = pid;
+    pkt[3] = 0x10 | psiStream->fOutputCC; // payload only
+    psiStream->fOutputCC = (psiStream->fOutputCC+1)&0x0F;
+
+    unsigned char* payload = &pkt[4];
+    unsigned payloadSize = TRANSPORT_PACKET_SIZE - 4;
+    if (i == 0) {
+      *payload++ = 0; // 'pointer_field'
+      --payloadSize;
+    }
+    unsigned numSectionBytes = sectionSize < payloadSize ? sectionSize : payloadSize;
+    memmove(payload, section, numSectionBytes);
+    section += numSectionBytes; sectionSize -= numSectionBytes;
+    memset(&payload[numSectionBytes], 0xFF, payloadSize - numSectionBytes); // stuffing
+
+    fNumPendingBytes += TRANSPORT_PACKET_SIZE;
+  }
+}
+
+void MPEG2TransportStreamPIDFilter::flushPendingPackets(unsigned char*& to, unsigned char const* limit) {
+  if (fNumPendingBytes == 0) return;
+
+  unsigned numBytesToCopy = ((limit - to)/TRANSPORT_PACKET_SIZE)*TRANSPORT_PACKET_SIZE;
+  if (numBytesToCopy > fNumPendingBytes) numBytesToCopy = fNumPendingBytes;
+  if (numBytesToCopy == 0) return;
+
+  memmove(to, fPendingPackets, numBytesToCopy);
+  to += numBytesToCopy;
+  fNumPacketsOut += numBytesToCopy/TRANSPORT_PACKET_SIZE;
+
+  fNumPendingBytes -= numBytesToCopy;
+  memmove(fPendingPackets, &fPendingPackets[numBytesToCopy], fNumPendingBytes);
+}
+
+Boolean MPEG2TransportStreamPIDFilter::programIsSelected(u_int16_t programNumber) const {
+  for (unsigned i = 0; i < fNumSelectedPrograms; ++i) {
+    if (fSelectedPrograms[i] == programNumber) return True;
+  }
+  return False;
+}
+
+PIDFilterPSIStream* MPEG2TransportStreamPIDFilter::lookupPSIStream(u_int16_t pid) const {
+  for (unsigned i = 0; i < fNumPSIStreams; ++i) {
+    if (fPSIStreams[i]->fPID == pid) return fPSIStreams[i];
+  }
+  return NULL;
+}
+
+void MPEG2TransportStreamPIDFilter::addPMTPID(u_int16_t pid) {
+  ++fPIDUseCount[pid];
+  if ((fPIDFlags[pid]&PID_IS_PMT) != 0) return; // this PID is already being parsed (for another program)
+
+  fPIDFlags[pid] |= PID_IS_PMT;
+  PIDFilterPSIStream** newPSIStreams = new PIDFilterPSIStream*[fNumPSIStreams+1];
+  for (unsigned i = 0; i < fNumPSIStreams; ++i) newPSIStreams[i] = fPSIStreams[i];
+  newPSIStreams[fNumPSIStreams++] = new PIDFilterPSIStream(pid);
+  delete[] fPSIStreams;
+  fPSIStreams = newPSIStreams;
+}
+
+void MPEG2TransportStreamPIDFilter::removePMTPID(u_int16_t pid) {
+  --fPIDUseCount[pid];
+
+  unsigned i;
+  for (i = 0; i < fNumPrograms; ++i) {
+    if (fPrograms[i]->fPMTPID == pid) return; // another program still uses this PID
+  }
+
+  // Stop parsing this PID:
+  fPIDFlags[pid] &= ~PID_IS_PMT;
+  for (i = 0; i < fNumPSIStreams; ++i) {
+    if (fPSIStreams[i]->fPID == pid) {
+      delete fPSIStreams[i];
+      fPSIStreams[i] = fPSIStreams[--fNumPSIStreams];
+      break;
+    }
+  }
+}
+
+void MPEG2TransportStreamPIDFilter::deleteProgram(unsigned index) {
+  PIDFilterProgram* program = fPrograms[index];
+  for (unsigned i = 0; i < program->fNumPIDs; ++i) --fPIDUseCount[program->fPIDs[i]];
+
+  fPrograms[index] = fPrograms[--fNumPrograms];
+  removePMTPID(program->fPMTPID);
+  delete program;
+}
@@ -0,0 +1,271 @@
+/**********
+This library is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the
+Free Software Foundation; either version 3 of the License, or (at your
+option) any later version. (See <http://www.gnu.org/copyleft/lesser.html>.)
+
+This library is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+**********/
+// "liveMedia"
+// Copyright (c) 1996-2017 Live Networks, Inc.  All rights reserved.
+// A filter that collects incoming MPEG Transport Stream packets into chunks (each to be sent in a single
+// outgoing (UDP or RTP) packet), and delivers each chunk at the time given by the stream's PCRs.
+// Implementation
+
+#include "MPEG2TransportStreamPacer.hh"
+#include "MPEG2TransportStreamFramer.hh" // for "getPCR()"
+#include <GroupsockHelper.hh> // for "gettimeofday()"
+
+#define TRANSPORT_PACKET_SIZE 188
+#define TRANSPORT_SYNC_BYTE 0x47
+
+////////// Definitions of constants that control the behavior of this code /////////
+
+#if !defined(MIN_INPUT_BUFFER_NUM_TS_PACKETS)
+#define MIN_INPUT_BUFFER_NUM_TS_PACKETS 64
+  // Our input buffer is large enough for at least this many Transport Stream packets
+  // (or four outgoing chunks, if that's larger)
+#endif
+
+#if !defined(MAX_PCR_GAP)
+#define MAX_PCR_GAP 1.0 // (seconds)
+  // A PCR that differs from its predicted value by more than this is treated as a discontinuity
+#endif
+
+#if !defined(MAX_SCHEDULE_ERROR)
+#define MAX_SCHEDULE_ERROR 1.0 // (seconds)
+  // If a chunk's data arrives this much later than its scheduled time (or if a chunk would be scheduled this much
+  // further in the future than "latency"), then the input's clock has drifted from ours, so we reset the schedule.
+#endif
+
+static double timevalToDouble(struct timeval const& tv) {
+  return tv.tv_sec + tv.tv_usec/1000000.0;
+}
+
+static double timeNowAsDouble() {
+  struct timeval tvNow;
+  gettimeofday(&tvNow, NULL);
+  return timevalToDouble(tvNow);
+}
+
+MPEG2TransportStreamPacer*
+MPEG2TransportStreamPacer::createNew(UsageEnvironment& env, FramedSource* inputSource,
+				     unsigned numTSPacketsPerChunk, unsigned latencyInMicroseconds) {
+  return new MPEG2TransportStreamPacer(env, inputSource, numTSPacketsPerChunk, latencyInMicroseconds);
+}
+
+MPEG2TransportStreamPacer
+::MPEG2TransportStreamPacer(UsageEnvironment& env, FramedSource* inputSource,
+			    unsigned numTSPacketsPerChunk, unsigned latencyInMicroseconds)
+  : FramedFilter(env, inputSource),
+    fNumTSPacketsPerChunk(numTSPacketsPerChunk == 0 ? 1 : numTSPacketsPerChunk),
+    fLatency(latencyInMicroseconds/1000000.0),
+    fInputBufferStart(0), fInputBufferEnd(0), fInputHasClosed(False),
+    fTSPacketCount(0), fHavePCR(False), fPCRPID(0), fLastPCR(0.0), fLastPCRPacketNum(0), fTSPacketDuration(0.0),
+    fScheduleIsValid(False), fScheduleRealTimeBase(0.0), fScheduleStreamTimeBase(0.0), fScheduledTime(0.0),
+    fNumResyncs(0) {
+  unsigned numTSPacketsInBuffer = 4*fNumTSPacketsPerChunk;
+  if (numTSPacketsInBuffer < MIN_INPUT_BUFFER_NUM_TS_PACKETS) numTSPacketsInBuffer = MIN_INPUT_BUFFER_NUM_TS_PACKETS;
+  fInputBufferSize = numTSPacketsInBuffer*TRANSPORT_PACKET_SIZE;
+  fInputBuffer = new unsigned char[fInputBufferSize];
+
+  resetPacingStats();
+}
+
+MPEG2TransportStreamPacer::~MPEG2TransportStreamPacer() {
+  delete[] fInputBuffer;
+}
+
+double MPEG2TransportStreamPacer::meanJitter() const {
+  return fNumChunksDelivered == 0 ? 0.0 : fTotalJitter/(double)(int64_t)fNumChunksDelivered;
+}
+
+double MPEG2TransportStreamPacer::bitrate() const {
+  return fTSPacketDuration == 0.0 ? 0.0 : TRANSPORT_PACKET_SIZE*8/fTSPacketDuration;
+}
+
+void MPEG2TransportStreamPacer::resetPacingStats() {
+  fNumChunksDelivered = fNumLateChunks = 0;
+  fTotalJitter = fMaxJitter = 0.0;
+}
+
+void MPEG2TransportStreamPacer::doGetNextFrame() {
+  // Skip over any data that doesn't begin with a sync byte:
+  while (fInputBufferStart < fInputBufferEnd && fInputBuffer[fInputBufferStart] != TRANSPORT_SYNC_BYTE) {
+    ++fInputBufferStart;
+  }
+
+  unsigned const numTSPacketsAvailable = (fInputBufferEnd - fInputBufferStart)/TRANSPORT_PACKET_SIZE;
+  if (numTSPacketsAvailable >= fNumTSPacketsPerChunk || (fInputHasClosed && numTSPacketsAvailable > 0)) {
+    deliverChunk();
+    return;
+  }
+
+  if (fInputHasClosed) {
+    handleClosure();
+    return;
+  }
+
+  // We need more data.  Move any remaining data to the start of our buffer, then read into the rest of it:
+  if (fInputBufferStart > 0) {
+    memmove(fInputBuffer, &fInputBuffer[fInputBufferStart], fInputBufferEnd - fInputBufferStart);
+    fInputBufferEnd -= fInputBufferStart;
+    fInputBufferStart = 0;
+  }
+  fInputSource->getNextFrame(&fInputBuffer[fInputBufferEnd], fInputBufferSize - fInputBufferEnd,
+			     afterGettingFrame, this,
+			     handleInputClosure, this,
+			     (afterGettingPacketFunc*)FramedSource::afterGettingPacket);
+}
+
+void MPEG2TransportStreamPacer::doStopGettingFrames() {
+  envir().taskScheduler().unscheduleDelayedTask(nextTask());
+  FramedFilter::doStopGettingFrames();
+
+  // Discard any buffered data, and our schedule; we'll start afresh if we're read again:
+  fInputBufferStart = fInputBufferEnd = 0;
+  fHavePCR = fScheduleIsValid = False;
+  fTSPacketDuration = 0.0;
+}
+
+void MPEG2TransportStreamPacer
+::afterGettingFrame(void* clientData, unsigned frameSize,
+		    unsigned /*numTruncatedBytes*/,
+		    struct timeval /*presentationTime*/,
+		    unsigned /*durationInMicroseconds*/) {
+  MPEG2TransportStreamPacer* pacer = (MPEG2TransportStreamPacer*)clientData;
+  pacer->afterGettingFrame1(frameSize);
+}
+
+void MPEG2TransportStreamPacer::afterGettingFrame1(unsigned frameSize) {
+  fInputBufferEnd += frameSize;
+
+  // Try again to complete delivery:
+  doGetNextFrame();
+}
+
+void MPEG2TransportStreamPacer::handleInputClosure(void* clientData) {
+  MPEG2TransportStreamPacer* pacer = (MPEG2TransportStreamPacer*)clientData;
+
+  // Deliver whatever complete Transport Stream packets we still have, before we close:
+  pacer->fInputHasClosed = True;
+  pacer->doGetNextFrame();
+}
+
+void MPEG2TransportStreamPacer::deliverChunk() {
+  // Copy (up to) "fNumTSPacketsPerChunk" Transport Stream packets to our client:
+  unsigned numTSPackets = (fInputBufferEnd - fInputBufferStart)/TRANSPORT_PACKET_SIZE;
+  if (numTSPackets > fNumTSPacketsPerChunk) numTSPackets = fNumTSPacketsPerChunk;
+  fFrameSize = numTSPackets*TRANSPORT_PACKET_SIZE;
+  if (fFrameSize > fMaxSize) {
+    numTSPackets = fMaxSize/TRANSPORT_PACKET_SIZE;
+    if (numTSPackets == 0) { // our client's buffer is too small for even one packet
+      numTSPackets = 1;
+      fNumTruncatedBytes = TRANSPORT_PACKET_SIZE - fMaxSize;
+      fFrameSize = fMaxSize;
+    } else {
+      fFrameSize = numTSPackets*TRANSPORT_PACKET_SIZE;
+    }
+  }
+  unsigned char* const chunk = &fInputBuffer[fInputBufferStart];
+  memmove(fTo, chunk, fFrameSize);
+  fInputBufferStart += numTSPackets*TRANSPORT_PACKET_SIZE;
+
+  // Update our 'clock' from any PCR in the chunk.  (We use the PCRs from just one PID - the first that we see.)
+  double timeNow = timeNowAsDouble();
+  u_int64_t const chunkPacketNum = fTSPacketCount;
+  for (unsigned i = 0; i < numTSPackets; ++i) {
+    unsigned char const* pkt = &chunk[i*TRANSPORT_PACKET_SIZE];
+    double pcr;
+    unsigned pid;
+    Boolean discontinuity;
+    if (pkt[0] != TRANSPORT_SYNC_BYTE || !MPEG2TransportStreamFramer::getPCR(pkt, pcr, pid, discontinuity)) continue;
+    if (fHavePCR && pid != fPCRPID) continue;
+
+    u_int64_t const pcrPacketNum = chunkPacketNum + i;
+    if (!fHavePCR) {
+      fHavePCR = True;
+      fPCRPID = pid;
+    } else {
+      double const pcrGap = pcr - fLastPCR;
+      int64_t const numPacketsSinceLastPCR = (int64_t)(pcrPacketNum - fLastPCRPacketNum);
+      if (discontinuity || pcrGap <= 0.0 || pcrGap > MAX_PCR_GAP || numPacketsSinceLastPCR <= 0) {
+	// We can't use this PCR to measure the bit rate, and must rebuild our schedule from it:
+	fScheduleIsValid = False;
+      } else {
+	// The bit rate (and thus the duration of each packet) is assumed to be constant between PCRs:
+	fTSPacketDuration = pcrGap/numPacketsSinceLastPCR;
+      }
+    }
+    fLastPCR = pcr;
+    fLastPCRPacketNum = pcrPacketNum;
+  }
+  fTSPacketCount += numTSPackets;
+
+  fDurationInMicroseconds = 0; // because we do the pacing ourself
+  fPresentationTime.tv_sec = (long)timeNow;
+  fPresentationTime.tv_usec = (long)((timeNow - fPresentationTime.tv_sec)*1000000);
+
+  if (!fHavePCR || fTSPacketDuration == 0.0) {
+    // We don't yet know the bit rate, so can't pace this chunk; deliver it now:
+    afterGetting(this);
+    return;
+  }
+
+  // Compute the 'stream time' (in the PCR's timebase) of the start of this chunk, and thus when it's to be delivered:
+  double const streamTime = fLastPCR + ((int64_t)chunkPacketNum - (int64_t)fLastPCRPacketNum)*fTSPacketDuration;
+  if (!fScheduleIsValid) resync(streamTime, timeNow);
+  fScheduledTime = fScheduleRealTimeBase + (streamTime - fScheduleStreamTimeBase) + fLatency;
+
+  double delay = fScheduledTime - timeNow;
+  if (delay < -MAX_SCHEDULE_ERROR || delay > fLatency + MAX_SCHEDULE_ERROR) {
+    // The input's clock has drifted too far from ours:
+    resync(streamTime, timeNow);
+    fScheduledTime = timeNow + fLatency;
+    delay = fLatency;
+  }
+
+  if (delay > 0.0) {
+    int64_t uSecondsToGo = (int64_t)(delay*1000000);
+    nextTask() = envir().taskScheduler().scheduleDelayedTask(uSecondsToGo, deliverScheduledChunk, this);
+  } else {
+    // This chunk's data arrived too late to be delivered on time:
+    ++fNumLateChunks;
+    recordJitter(-delay);
+    afterGetting(this);
+  }
+}
+
+void MPEG2TransportStreamPacer::resync(double streamTime, double timeNow) {
+  fScheduleRealTimeBase = timeNow;
+  fScheduleStreamTimeBase = streamTime;
+  if (fScheduleIsValid) ++fNumResyncs; // don't count the initial synchronization
+  fScheduleIsValid = True;
+}
+
+void MPEG2TransportStreamPacer::deliverScheduledChunk(void* clientData) {
+  MPEG2TransportStreamPacer* pacer = (MPEG2TransportStreamPacer*)clientData;
+  pacer->nextTask() = NULL;
+
+  double timeNow = timeNowAsDouble();
+  double jitter = timeNow - pacer->fScheduledTime;
+  pacer->recordJitter(jitter < 0.0 ? -jitter : jitter);
+
+  pacer->fPresentationTime.tv_sec = (long)timeNow;
+  pacer->fPresentationTime.tv_usec = (long)((timeNow - pacer->fPresentationTime.tv_sec)*1000000);
+  FramedSource::afterGetting(pacer);
+}
+
+void MPEG2TransportStreamPacer::recordJitter(double jitter) {
+  double const jitterInMicroseconds = jitter*1000000;
+  ++fNumChunksDelivered;
+  fTotalJitter += jitterInMicroseconds;
+  if (jitterInMicroseconds > fMaxJitter) fMaxJitter = jitterInMicroseconds;
+}
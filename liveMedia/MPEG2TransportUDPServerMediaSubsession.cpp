@@ -24,6 +24,7 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 #include "SimpleRTPSource.hh"
 #include "MPEG2TransportStreamFramer.hh"
 #include "SimpleRTPSink.hh"
+#include "MPEG2TransportStreamDatagramRTPSink.hh"
 #include "GroupsockHelper.hh"
 
 
@@ -37,7 +38,8 @@ MPEG2TransportUDPServerMediaSubsession
 ::MPEG2TransportUDPServerMediaSubsession(UsageEnvironment& env,
                                          char const* inputAddressStr, Port const& inputPort, Boolean inputStreamIsRawUDP)
   : OnDemandServerMediaSubsession(env, True/*reuseFirstSource*/),
-    fInputPort(inputPort), fInputGroupsock(NULL), fInputStreamIsRawUDP(inputStreamIsRawUDP) {
+    fInputPort(inputPort), fInputGroupsock(NULL), fInputStreamIsRawUDP(inputStreamIsRawUDP),
+    fFanOut(False), fOutputBatchSize(1) {
   fInputAddressStr = strDup(inputAddressStr);
 }
 
@@ -47,6 +49,11 @@ MPEG2TransportUDPServerMediaSubsession::
   delete[] (char*)fInputAddressStr;
 }
 
+void MPEG2TransportUDPServerMediaSubsession::enableFanOut(unsigned outputBatchSize) {
+  fFanOut = True;
+  fOutputBatchSize = outputBatchSize;
+}
+
 FramedSource* MPEG2TransportUDPServerMediaSubsession
 ::createNewStreamSource(unsigned/* clientSessionId*/, unsigned& estBitrate) {
   estBitrate = 5000; // kbps, estimate
@@ -58,6 +65,11 @@ FramedSource* MPEG2TransportUDPServerMediaSubsession
     fInputGroupsock = new Groupsock(envir(), inputAddress, fInputPort, 255);
   }
 
+  if (fFanOut) {
+    // Our "MPEG2TransportStreamDatagramRTPSink" reads each incoming datagram (whether or not it's RTP) directly:
+    return BasicUDPSource::createNew(envir(), fInputGroupsock);
+  }
+
   FramedSource* transportStreamSource;
   if (fInputStreamIsRawUDP) {
     transportStreamSource = BasicUDPSource::createNew(envir(), fInputGroupsock);
@@ -69,6 +81,11 @@ FramedSource* MPEG2TransportUDPServerMediaSubsession
 
 RTPSink* MPEG2TransportUDPServerMediaSubsession
 ::createNewRTPSink(Groupsock* rtpGroupsock, unsigned char /*rtpPayloadTypeIfDynamic*/, FramedSource* /*inputSource*/) {
+  if (fFanOut) {
+    if (fOutputBatchSize > 1) rtpGroupsock->setOutputBatchSize(fOutputBatchSize);
+    return MPEG2TransportStreamDatagramRTPSink::createNew(envir(), rtpGroupsock, !fInputStreamIsRawUDP);
+  }
+
   return SimpleRTPSink::createNew(envir(), rtpGroupsock,
 				  33, 90000, "video", "MP2T",
 				  1, True, False /*no 'M' bit*/);
@@ -85,6 +85,14 @@ void MPEG4VideoFileServerMediaSubsession::checkForAuxSDPLine1() {
 char const* MPEG4VideoFileServerMediaSubsession::getAuxSDPLine(RTPSink* rtpSink, FramedSource* inputSource) {
   if (fAuxSDPLine != NULL) return fAuxSDPLine; // it's already been set up (for a previous client)
 
+  // If we've already found the 'config' information for this version of the file (perhaps in a previous run of
+  // the server), then use it, rather than reading the file again:
+  char const* cachedAuxSDPLine = lookupCachedAuxSDPLine("MPEG4Video", rtpSink);
+  if (cachedAuxSDPLine != NULL) {
+    fAuxSDPLine = strDup(cachedAuxSDPLine);
+    return fAuxSDPLine;
+  }
+
   if (fDummyRTPSink == NULL) { // we're not already setting it up for another, concurrent stream
     // Note: For MPEG-4 video files, the 'config' information isn't known
     // until we start reading the file.  This means that "rtpSink"s
@@ -100,6 +108,7 @@ char const* MPEG4VideoFileServerMediaSubsession::getAuxSDPLine(RTPSink* rtpSink,
 
   envir().taskScheduler().doEventLoop(&fDoneFlag);
 
+  cacheAuxSDPLine("MPEG4Video", rtpSink, fAuxSDPLine);
   return fAuxSDPLine;
 }
 
@@ -100,13 +100,14 @@ MatroskaFileServerDemux
 			  onCreationFunc* onCreation, void* onCreationClientData,
 			  char const* preferredLanguage)
   : Medium(env),
-    fFileName(fileName), fOnCreation(onCreation), fOnCreationClientData(onCreationClientData),
+    fFileName(strDup(fileName)), fOnCreation(onCreation), fOnCreationClientData(onCreationClientData),
     fNextTrackTypeToCheck(0x1), fLastClientSessionId(0), fLastCreatedDemux(NULL) {
   MatroskaFile::createNew(env, fileName, onMatroskaFileCreation, this, preferredLanguage);
 }
 
 MatroskaFileServerDemux::~MatroskaFileServerDemux() {
   Medium::close(fOurMatroskaFile);
+  delete[] (char*)fFileName;
 }
 
 void MatroskaFileServerDemux::onMatroskaFileCreation(MatroskaFile* newFile, void* clientData) {
@@ -20,6 +20,7 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 
 #include "Media.hh"
 #include "HashTable.hh"
+#include "MediaFileSDPCache.hh"
 
 ////////// Medium //////////
 
@@ -99,13 +100,14 @@ _Tables* _Tables::getOurTables(UsageEnvironment& env, Boolean createIfNotPresent
 
 void _Tables::reclaimIfPossible() {
   if (mediaTable == NULL && socketTable == NULL) {
+    delete (MediaFileSDPCache*)sdpCache;
     fEnv.liveMediaPriv = NULL;
     delete this;
   }
 }
 
 _Tables::_Tables(UsageEnvironment& env)
-  : mediaTable(NULL), socketTable(NULL), fEnv(env) {
+  : mediaTable(NULL), socketTable(NULL), sdpCache(NULL), fEnv(env) {
 }
 
 _Tables::~_Tables() {
@@ -0,0 +1,200 @@
+/**********
+This library is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the
+Free Software Foundation; either version 3 of the License, or (at your
+option) any later version. (See <http://www.gnu.org/copyleft/lesser.html>.)
+
+This library is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+**********/
+// "liveMedia"
+// Copyright (c) 1996-2017 Live Networks, Inc.  All rights reserved.
+// A cache of information about media files (e.g., the 'config' SDP lines of video files).
+// Implementation
+
+#include "MediaFileSDPCache.hh"
+#ifndef _WIN32_WCE
+#include <sys/stat.h>
+#endif
+#include <time.h>
+
+#define SIDECAR_FILE_NAME_SUFFIX ".sdpcache"
+#define SIDECAR_FILE_HEADER "LIVE555 SDP cache 1"
+#define MAX_SIDECAR_VALUE_SIZE 100000 // sanity check, when reading a sidecar file
+
+// The cached information for one version of one file:
+class MediaFileSDPCacheEntry {
+public:
+  MediaFileSDPCacheEntry(u_int64_t fileSize, long modificationTime)
+    : fFileSize(fileSize), fModificationTime(modificationTime), fValues(HashTable::create(STRING_HASH_KEYS)) {
+  }
+  virtual ~MediaFileSDPCacheEntry() {
+    char* value;
+    while ((value = (char*)fValues->RemoveNext()) != NULL) delete[] value;
+    delete fValues;
+  }
+
+  char const* lookup(char const* key) const { return (char const*)fValues->Lookup(key); }
+  void add(char const* key, char const* value) {
+    delete[] (char*)fValues->Add(key, strDup(value)); // replacing any old value
+  }
+
+  u_int64_t fFileSize;
+  long fModificationTime;
+  HashTable* fValues; // maps keys to (strDup()ed) values
+};
+
+static Boolean getFileVersion(char const* fileName, u_int64_t& fileSize, long& modificationTime) {
+#ifndef _WIN32_WCE
+  struct stat sb;
+  if (stat(fileName, &sb) != 0) return False;
+
+  fileSize = (u_int64_t)sb.st_size;
+  modificationTime = (long)sb.st_mtime;
+  return True;
+#else
+  return False;
+#endif
+}
+
+static char* sidecarFileName(char const* fileName) {
+  char* result = new char[strlen(fileName) + sizeof SIDECAR_FILE_NAME_SUFFIX];
+  sprintf(result, "%s%s", fileName, SIDECAR_FILE_NAME_SUFFIX);
+  return result;
+}
+
+MediaFileSDPCache* MediaFileSDPCache::ourCache(UsageEnvironment& env) {
+  _Tables* ourTables = _Tables::getOurTables(env);
+  if (ourTables->sdpCache == NULL) {
+    ourTables->sdpCache = new MediaFileSDPCache(env);
+  }
+  return (MediaFileSDPCache*)(ourTables->sdpCache);
+}
+
+MediaFileSDPCache::MediaFileSDPCache(UsageEnvironment& env)
+  : fEnv(env), fFileEntries(HashTable::create(STRING_HASH_KEYS)), fUseSidecarFiles(False),
+    fNumHits(0), fNumMisses(0) {
+}
+
+MediaFileSDPCache::~MediaFileSDPCache() {
+  MediaFileSDPCacheEntry* fileEntry;
+  while ((fileEntry = (MediaFileSDPCacheEntry*)fFileEntries->RemoveNext()) != NULL) delete fileEntry;
+  delete fFileEntries;
+}
+
+char const* MediaFileSDPCache::lookup(char const* fileName, char const* key) {
+  MediaFileSDPCacheEntry* fileEntry = lookupFileEntry(fileName, False);
+  char const* value = fileEntry == NULL ? NULL : fileEntry->lookup(key);
+
+  if (value != NULL) ++fNumHits; else ++fNumMisses;
+  return value;
+}
+
+void MediaFileSDPCache::add(char const* fileName, char const* key, char const* value) {
+  MediaFileSDPCacheEntry* fileEntry = lookupFileEntry(fileName, True);
+  if (fileEntry == NULL) return; // the file doesn't exist
+
+  fileEntry->add(key, value);
+  if (fUseSidecarFiles) writeSidecarFile(fileName, fileEntry);
+}
+
+MediaFileSDPCacheEntry* MediaFileSDPCache::lookupFileEntry(char const* fileName, Boolean createIfNotPresent) {
+  u_int64_t fileSize; long modificationTime;
+  if (!getFileVersion(fileName, fileSize, modificationTime)) return NULL;
+
+  MediaFileSDPCacheEntry* fileEntry = (MediaFileSDPCacheEntry*)fFileEntries->Lookup(fileName);
+  if (fileEntry != NULL
+      && (fileEntry->fFileSize != fileSize || fileEntry->fModificationTime != modificationTime)) {
+    // The file has changed since we cached information about it, so discard this information:
+    fFileEntries->Remove(fileName);
+    delete fileEntry;
+    fileEntry = NULL;
+  }
+
+  if (fileEntry == NULL) {
+    if (fUseSidecarFiles) fileEntry = readSidecarFile(fileName, fileSize, modificationTime);
+    if (fileEntry == NULL && createIfNotPresent) fileEntry = new MediaFileSDPCacheEntry(fileSize, modificationTime);
+    if (fileEntry != NULL) fFileEntries->Add(fileName, fileEntry);
+  }
+
+  return fileEntry;
+}
+
+// A sidecar file consists of a header line; a line containing the file's size and modification time; then,
+// for each entry: a line containing the sizes of the key and value, then the key and value themselves, then '\n'.
+
+MediaFileSDPCacheEntry* MediaFileSDPCache
+::readSidecarFile(char const* fileName, u_int64_t fileSize, long modificationTime) {
+  char* name = sidecarFileName(fileName);
+  FILE* fid = fopen(name, "rb");
+  delete[] name;
+  if (fid == NULL) return NULL;
+
+  MediaFileSDPCacheEntry* fileEntry = NULL;
+  char line[100];
+  unsigned long long sidecarFileSize; long sidecarModificationTime;
+  do {
+    if (fgets(line, sizeof line, fid) == NULL || strncmp(line, SIDECAR_FILE_HEADER, sizeof SIDECAR_FILE_HEADER - 1) != 0) break;
+    if (fgets(line, sizeof line, fid) == NULL
+	|| sscanf(line, "%llu %ld", &sidecarFileSize, &sidecarModificationTime) != 2) break;
+    if (sidecarFileSize != fileSize || sidecarModificationTime != modificationTime) break; // the sidecar file is stale
+
+    fileEntry = new MediaFileSDPCacheEntry(fileSize, modificationTime);
+    unsigned keySize, valueSize;
+    while (fgets(line, sizeof line, fid) != NULL && sscanf(line, "%u %u", &keySize, &valueSize) == 2) {
+      if (keySize > MAX_SIDECAR_VALUE_SIZE || valueSize > MAX_SIDECAR_VALUE_SIZE) break;
+
+      char* key = new char[keySize+1];
+      char* value = new char[valueSize+1];
+      Boolean readOK = fread(key, 1, keySize, fid) == keySize && fread(value, 1, valueSize, fid) == valueSize
+	&& fgetc(fid) == '\n';
+      key[keySize] = '\0'; value[valueSize] = '\0';
+      if (readOK) fileEntry->add(key, value);
+      delete[] key; delete[] value;
+      if (!readOK) break;
+    }
+  } while (0);
+
+  fclose(fid);
+  return fileEntry;
+}
+
+void MediaFileSDPCache::writeSidecarFile(char const* fileName, MediaFileSDPCacheEntry* fileEntry) {
+  // Write to a temporary file, then rename it, so that a reader (perhaps in another thread or process) never sees
+  // a partially-written file:
+  char* name = sidecarFileName(fileName);
+  char* tmpName = new char[strlen(name) + 30];
+  sprintf(tmpName, "%s.%lx", name, (unsigned long)this ^ (unsigned long)time(NULL));
+
+  FILE* fid = fopen(tmpName, "wb");
+  if (fid != NULL) {
+    fprintf(fid, "%s\n%llu %ld\n", SIDECAR_FILE_HEADER,
+	    (unsigned long long)fileEntry->fFileSize, fileEntry->fModificationTime);
+
+    HashTable::Iterator* iter = HashTable::Iterator::create(*fileEntry->fValues);
+    char const* key; char const* value;
+    while ((value = (char const*)iter->next(key)) != NULL) {
+      fprintf(fid, "%u %u\n", (unsigned)strlen(key), (unsigned)strlen(value));
+      fputs(key, fid); fputs(value, fid); fputc('\n', fid);
+    }
+    delete iter;
+
+    Boolean writeOK = ferror(fid) == 0;
+    if (fclose(fid) != 0) writeOK = False;
+#if defined(__WIN32__) || defined(_WIN32)
+    if (writeOK) remove(name); // because "rename()" won't replace an existing file
+#endif
+    if (!writeOK || rename(tmpName, name) != 0) {
+      remove(tmpName);
+      fEnv.setResultMsg("Failed to write SDP cache file \"", name, "\"");
+    }
+  }
+
+  delete[] tmpName; delete[] name;
+}
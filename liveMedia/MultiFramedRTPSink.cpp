@@ -34,6 +34,19 @@ void MultiFramedRTPSink::setPacketSizes(unsigned preferredPacketSize,
   fOurMaxPacketSize = maxPacketSize; // save value, in case subclasses need it
 }
 
+Boolean MultiFramedRTPSink::enableKernelPacing(unsigned lookaheadMicroseconds) {
+  Groupsock* gs = fRTPInterface.gs();
+  if (lookaheadMicroseconds == 0 || gs == NULL || !gs->enableLaunchTimes()) return False;
+
+  fKernelPacingLookahead = lookaheadMicroseconds;
+  return True;
+}
+
+Boolean MultiFramedRTPSink::setMaxPacingRate(unsigned bytesPerSecond) {
+  Groupsock* gs = fRTPInterface.gs();
+  return gs != NULL && gs->setMaxPacingRate(bytesPerSecond);
+}
+
 #ifndef RTP_PAYLOAD_MAX_SIZE
 #define RTP_PAYLOAD_MAX_SIZE 1456
       // Default max packet size (1500, minus allowance for IP, UDP, UMTP headers)
@@ -52,7 +65,7 @@ MultiFramedRTPSink::MultiFramedRTPSink(UsageEnvironment& env,
   : RTPSink(env, rtpGS, rtpPayloadType, rtpTimestampFrequency,
 	    rtpPayloadFormatName, numChannels),
     fOutBuf(NULL), fCurFragmentationOffset(0), fPreviousFrameEndedFragmentation(False),
-    fOnSendErrorFunc(NULL), fOnSendErrorData(NULL) {
+    fCurrentPacketIsDiscardable(False), fKernelPacingLookahead(0), fOnSendErrorFunc(NULL), fOnSendErrorData(NULL) {
   setPacketSizes((RTP_PAYLOAD_PREFERRED_SIZE), (RTP_PAYLOAD_MAX_SIZE));
 }
 
@@ -102,6 +115,13 @@ unsigned MultiFramedRTPSink::computeOverflowForNewFrame(unsigned newFrameSize) c
   return fOutBuf->numOverflowBytes(newFrameSize);
 }
 
+Boolean MultiFramedRTPSink
+::frameIsDiscardable(unsigned /*fragmentationOffset*/,
+		     unsigned char const* /*frameStart*/,
+		     unsigned /*numBytesInFrame*/) const {
+  return False;
+}
+
 void MultiFramedRTPSink::setMarkerBit() {
   unsigned rtpHdr = fOutBuf->extractWord(0);
   rtpHdr |= 0x00800000;
@@ -193,6 +213,7 @@ void MultiFramedRTPSink::buildAndSendPacket(Boolean isFirstPacket) {
   fOutBuf->skipBytes(fSpecialHeaderSize);
 
   // Begin packing as many (complete) frames into the packet as we can:
+  fCurrentPacketIsDiscardable = True; // until we see a frame that isn't
   fTotalFrameSpecificHeaderSizes = 0;
   fNoFramesLeft = False;
   fNumFramesUsedSoFar = 0;
@@ -242,6 +263,7 @@ void MultiFramedRTPSink
   if (fIsFirstPacket) {
     // Record the fact that we're starting to play now:
     gettimeofday(&fNextSendTime, NULL);
+    fCurPacketSendTime = fNextSendTime;
   }
 
   fMostRecentPresentationTime = presentationTime;
@@ -314,6 +336,10 @@ void MultiFramedRTPSink
     fOutBuf->increment(numFrameBytesToUse);
         // do this now, in case "doSpecialFrameHandling()" calls "setFramePadding()" to append padding bytes
 
+    if (!frameIsDiscardable(curFragmentationOffset, frameStart, numFrameBytesToUse)) {
+      fCurrentPacketIsDiscardable = False;
+    }
+
     // Here's where any payload format specific processing gets done:
     doSpecialFrameHandling(curFragmentationOffset, frameStart,
 			   numFrameBytesToUse, presentationTime,
@@ -365,10 +391,17 @@ Boolean MultiFramedRTPSink::isTooBigForAPacket(unsigned numBytes) const {
 void MultiFramedRTPSink::sendPacketIfNecessary() {
   if (fNumFramesUsedSoFar > 0) {
     // Send the packet:
+    if (fKernelPacingLookahead > 0 && !fRTPInterface.gs()->launchTimesEnabled()) {
+      // The kernel has been dropping our packets, so we've stopped using launch times.  Pace the packets ourself:
+      fKernelPacingLookahead = 0;
+    }
+    if (fKernelPacingLookahead > 0) {
+      fRTPInterface.gs()->setNextLaunchTime(OutputSocket::launchTimeFor(fCurPacketSendTime));
+    }
 #ifdef TEST_LOSS
     if ((our_random()%10) != 0) // simulate 10% packet loss #####
 #endif
-      if (!fRTPInterface.sendPacket(fOutBuf->packet(), fOutBuf->curPacketSize())) {
+      if (!fRTPInterface.sendPacket(fOutBuf->packet(), fOutBuf->curPacketSize(), fCurrentPacketIsDiscardable)) {
 	// if failure handler has been specified, call it
 	if (fOnSendErrorFunc != NULL) (*fOnSendErrorFunc)(fOnSendErrorData);
       }
@@ -410,6 +443,12 @@ void MultiFramedRTPSink::sendPacketIfNecessary() {
     if (uSecondsToGo < 0 || secsDiff < 0) { // sanity check: Make sure that the time-to-delay is non-negative:
       uSecondsToGo = 0;
     }
+    fCurPacketSendTime = fNextSendTime;
+    if (fKernelPacingLookahead > 0) {
+      // The kernel will hold each packet until its launch time, so we need to wake up only when we've fallen less than
+      // half of our 'lookahead' ahead of schedule:
+      uSecondsToGo = uSecondsToGo > fKernelPacingLookahead ? uSecondsToGo - fKernelPacingLookahead/2 : 0;
+    }
 
     // Delay this amount of time:
     nextTask() = envir().taskScheduler().scheduleDelayedTask(uSecondsToGo, (TaskFunc*)sendNext, this);
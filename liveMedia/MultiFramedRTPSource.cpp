@@ -38,11 +38,19 @@ public:
   void releaseUsedPacket(BufferedPacket* packet);
   void freePacket(BufferedPacket* packet) {
     if (packet != fSavedPacket) {
-      delete packet;
+      if (fNumFreePackets < fMaxNumFreePackets) {
+	// Keep this packet for reuse, rather than deleting it:
+	packet->nextPacket() = fFreePackets;
+	fFreePackets = packet;
+	++fNumFreePackets;
+      } else {
+	delete packet;
+      }
     } else {
       fSavedPacketFree = True;
     }
   }
+  void setMaxNumFreePackets(unsigned maxNumFreePackets) { fMaxNumFreePackets = maxNumFreePackets; }
   Boolean isEmpty() const { return fHeadPacket == NULL; }
 
   void setThresholdTime(unsigned uSeconds) { fThresholdTime = uSeconds; }
@@ -58,6 +66,9 @@ private:
   BufferedPacket* fSavedPacket;
       // to avoid calling new/free in the common case
   Boolean fSavedPacketFree;
+  BufferedPacket* fFreePackets;
+      // additional packets that are kept for reuse (when reading packets in batches)
+  unsigned fNumFreePackets, fMaxNumFreePackets;
 };
 
 
@@ -68,7 +79,8 @@ MultiFramedRTPSource
 		       unsigned char rtpPayloadFormat,
 		       unsigned rtpTimestampFrequency,
 		       BufferedPacketFactory* packetFactory)
-  : RTPSource(env, RTPgs, rtpPayloadFormat, rtpTimestampFrequency) {
+  : RTPSource(env, RTPgs, rtpPayloadFormat, rtpTimestampFrequency),
+    fReceiveBatchSize(1), fAfterGettingRTPPacketFunc(NULL), fAfterGettingRTPPacketClientData(NULL) {
   reset();
   fReorderingBuffer = new ReorderingPacketBuffer(packetFactory);
 
@@ -83,12 +95,28 @@ void MultiFramedRTPSource::reset() {
   fPacketReadInProgress = NULL;
   fNeedDelivery = False;
   fPacketLossInFragmentedFrame = False;
+  fNumDirectDeliveriesAllowed = 0;
 }
 
 MultiFramedRTPSource::~MultiFramedRTPSource() {
   delete fReorderingBuffer;
 }
 
+void MultiFramedRTPSource::setReceiveBatchSize(unsigned batchSize) {
+  if (batchSize == 0) batchSize = 1;
+  if (batchSize > MAX_DATAGRAMS_PER_BATCH) batchSize = MAX_DATAGRAMS_PER_BATCH;
+  fReceiveBatchSize = batchSize;
+
+  // Keep enough packet descriptors around to read each batch without allocating new ones:
+  fReorderingBuffer->setMaxNumFreePackets(batchSize);
+}
+
+void MultiFramedRTPSource::setPacketMode(afterGettingRTPPacketFunc* afterGettingRTPPacketFunc,
+					 void* afterGettingRTPPacketClientData) {
+  fAfterGettingRTPPacketFunc = afterGettingRTPPacketFunc;
+  fAfterGettingRTPPacketClientData = afterGettingRTPPacketClientData;
+}
+
 Boolean MultiFramedRTPSource
 ::processSpecialHeader(BufferedPacket* /*packet*/,
 		       unsigned& resultSpecialHeaderSize) {
@@ -132,6 +160,11 @@ void MultiFramedRTPSource::doGetNextFrame() {
 }
 
 void MultiFramedRTPSource::doGetNextFrame1() {
+  if (fAfterGettingRTPPacketFunc != NULL) {
+    deliverPackets();
+    return;
+  }
+
   while (fNeedDelivery) {
     // If we already have packet data available, then deliver it now.
     Boolean packetLossPrecededThis;
@@ -201,6 +234,11 @@ void MultiFramedRTPSource::doGetNextFrame1() {
 	// executed again without having first returned to the event loop.  Call our 'after getting' function
 	// directly, because there's no risk of a long chain of recursion (and thus stack overflow):
 	afterGetting(this);
+      } else if (fNumDirectDeliveriesAllowed > 0) {
+	// We've just read a batch of packets.  The resulting chain of recursion is bounded by the batch size,
+	// so we can also call our 'after getting' function directly (rather than via the event loop):
+	--fNumDirectDeliveriesAllowed;
+	afterGetting(this);
       } else {
 	// Special case: Call our 'after getting' function via the event loop.
 	nextTask() = envir().taskScheduler().scheduleDelayedTask(0,
@@ -215,6 +253,22 @@ void MultiFramedRTPSource::doGetNextFrame1() {
   }
 }
 
+void MultiFramedRTPSource::deliverPackets() {
+  // We're in 'packet mode': Deliver each (in-order) packet that we have, as is, without looking at its payload:
+  while (isCurrentlyAwaitingData()) {
+    Boolean packetLossPrecededThis; // not used
+    BufferedPacket* nextPacket
+      = fReorderingBuffer->getNextCompletedPacket(packetLossPrecededThis);
+    if (nextPacket == NULL) break;
+
+    (*fAfterGettingRTPPacketFunc)(fAfterGettingRTPPacketClientData, nextPacket);
+
+    // If our consumer stopped reading from us (in the call above), then our packets have already been discarded:
+    if (!isCurrentlyAwaitingData()) break;
+    fReorderingBuffer->releaseUsedPacket(nextPacket);
+  }
+}
+
 void MultiFramedRTPSource
 ::setPacketReorderingThresholdTime(unsigned uSeconds) {
   fReorderingBuffer->setThresholdTime(uSeconds);
@@ -227,6 +281,11 @@ void MultiFramedRTPSource::networkReadHandler(MultiFramedRTPSource* source, int
 }
 
 void MultiFramedRTPSource::networkReadHandler1() {
+  if (fReceiveBatchSize > 1 && fPacketReadInProgress == NULL && fRTPInterface.nextReadIsFromDatagramSocket()) {
+    readPacketBatch();
+    return;
+  }
+
   BufferedPacket* bPacket = fPacketReadInProgress;
   if (bPacket == NULL) {
     // Normal case: Get a free BufferedPacket descriptor to hold the new network packet:
@@ -252,6 +311,49 @@ void MultiFramedRTPSource::networkReadHandler1() {
     } else {
       fPacketReadInProgress = NULL;
     }
+    readSuccess = processIncomingPacket(bPacket, fromAddress);
+  } while (0);
+  if (!readSuccess) fReorderingBuffer->freePacket(bPacket);
+
+  doGetNextFrame1();
+  // If we didn't get proper data this time, we'll get another chance
+}
+
+void MultiFramedRTPSource::readPacketBatch() {
+  // Get enough free packet descriptors to hold the batch:
+  BufferedPacket* packets[MAX_DATAGRAMS_PER_BATCH];
+  unsigned char* buffers[MAX_DATAGRAMS_PER_BATCH];
+  unsigned bytesRead[MAX_DATAGRAMS_PER_BATCH];
+  struct sockaddr_in fromAddresses[MAX_DATAGRAMS_PER_BATCH];
+  unsigned maxBytesToRead = ~0;
+  unsigned i;
+  for (i = 0; i < fReceiveBatchSize; ++i) {
+    packets[i] = fReorderingBuffer->getFreePacket(this);
+    unsigned packetMaxBytesToRead;
+    buffers[i] = packets[i]->prepareForDatagramRead(packetMaxBytesToRead);
+    if (packetMaxBytesToRead < maxBytesToRead) maxBytesToRead = packetMaxBytesToRead;
+  }
+
+  // Read the batch, then process each packet in it (freeing any descriptors that we didn't use):
+  int numPackets = fRTPInterface.handleReadBatch(buffers, maxBytesToRead, bytesRead, fromAddresses, fReceiveBatchSize);
+  for (i = 0; i < fReceiveBatchSize; ++i) {
+    Boolean readSuccess = False;
+    if ((int)i < numPackets && bytesRead[i] > 0) {
+      packets[i]->noteDatagramRead(bytesRead[i]);
+      readSuccess = processIncomingPacket(packets[i], fromAddresses[i]);
+    }
+    if (!readSuccess) fReorderingBuffer->freePacket(packets[i]);
+  }
+
+  if (numPackets > 1) fNumDirectDeliveriesAllowed = numPackets - 1;
+  doGetNextFrame1();
+  // If we didn't get proper data this time, we'll get another chance
+}
+
+Boolean MultiFramedRTPSource::processIncomingPacket(BufferedPacket* bPacket, struct sockaddr_in& fromAddress) {
+  // Perform sanity checks on the RTP header:
+  Boolean readSuccess = False;
+  do {
 #ifdef TEST_LOSS
     setPacketReorderingThresholdTime(0);
        // don't wait for 'lost' packets to arrive out-of-order later
@@ -336,10 +438,8 @@ void MultiFramedRTPSource::networkReadHandler1() {
 
     readSuccess = True;
   } while (0);
-  if (!readSuccess) fReorderingBuffer->freePacket(bPacket);
 
-  doGetNextFrame1();
-  // If we didn't get proper data this time, we'll get another chance
+  return readSuccess;
 }
 
 
@@ -359,7 +459,7 @@ BufferedPacket::~BufferedPacket() {
 }
 
 void BufferedPacket::reset() {
-  fHead = fTail = 0;
+  fHead = fTail = fRTPPacketSize = 0;
   fUseCount = 0;
   fIsFirstPacket = False; // by default
 }
@@ -405,9 +505,16 @@ Boolean BufferedPacket::fillInData(RTPInterface& rtpInterface, struct sockaddr_i
     return False;
   }
   fTail += numBytesRead;
+  fRTPPacketSize = fTail;
   return True;
 }
 
+unsigned char* BufferedPacket::prepareForDatagramRead(unsigned& maxBytesToRead) {
+  reset();
+  maxBytesToRead = bytesAvailable();
+  return &fBuf[fTail];
+}
+
 void BufferedPacket
 ::assignMiscParams(unsigned short rtpSeqNo, unsigned rtpTimestamp,
 		   struct timeval presentationTime,
@@ -491,7 +598,8 @@ BufferedPacket* BufferedPacketFactory
 ReorderingPacketBuffer
 ::ReorderingPacketBuffer(BufferedPacketFactory* packetFactory)
   : fThresholdTime(100000) /* default reordering threshold: 100 ms */,
-    fHaveSeenFirstPacket(False), fHeadPacket(NULL), fTailPacket(NULL), fSavedPacket(NULL), fSavedPacketFree(True) {
+    fHaveSeenFirstPacket(False), fHeadPacket(NULL), fTailPacket(NULL), fSavedPacket(NULL), fSavedPacketFree(True),
+    fFreePackets(NULL), fNumFreePackets(0), fMaxNumFreePackets(0) {
   fPacketFactory = (packetFactory == NULL)
     ? (new BufferedPacketFactory)
     : packetFactory;
@@ -505,8 +613,10 @@ ReorderingPacketBuffer::~ReorderingPacketBuffer() {
 void ReorderingPacketBuffer::reset() {
   if (fSavedPacketFree) delete fSavedPacket; // because fSavedPacket is not in the list
   delete fHeadPacket; // will also delete fSavedPacket if it's in the list
+  delete fFreePackets; // will also delete the rest of the list
   resetHaveSeenFirstPacket();
-  fHeadPacket = fTailPacket = fSavedPacket = NULL;
+  fHeadPacket = fTailPacket = fSavedPacket = fFreePackets = NULL;
+  fNumFreePackets = 0;
 }
 
 BufferedPacket* ReorderingPacketBuffer::getFreePacket(MultiFramedRTPSource* ourSource) {
@@ -518,6 +628,12 @@ BufferedPacket* ReorderingPacketBuffer::getFreePacket(MultiFramedRTPSource* ourS
   if (fSavedPacketFree == True) {
     fSavedPacketFree = False;
     return fSavedPacket;
+  } else if (fFreePackets != NULL) {
+    BufferedPacket* packet = fFreePackets;
+    fFreePackets = packet->nextPacket();
+    packet->nextPacket() = NULL;
+    --fNumFreePackets;
+    return packet;
   } else {
     return fPacketFactory->createNewPacket(ourSource);
   }
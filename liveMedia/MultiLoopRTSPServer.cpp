@@ -0,0 +1,173 @@
+/**********
+This library is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the
+Free Software Foundation; either version 3 of the License, or (at your
+option) any later version. (See <http://www.gnu.org/copyleft/lesser.html>.)
+
+This library is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+**********/
+// "liveMedia"
+// Copyright (c) 1996-2017 Live Networks, Inc.  All rights reserved.
+// A RTSP server that runs several event loops (threads), sharing one port
+// Implementation
+
+#include "MultiLoopRTSPServer.hh"
+#include "BasicUsageEnvironment.hh"
+#include <unistd.h>
+#if defined(__linux__)
+#include <sched.h>
+#endif
+
+////////// MultiLoopRTSPServer implementation //////////
+
+MultiLoopRTSPServer* MultiLoopRTSPServer
+::createNew(UsageEnvironment& env, Port ourPort,
+	    createServerFunc* createServer, void* clientData,
+	    unsigned numLoops, Boolean pinToCores) {
+  if (ourPort.num() == 0) {
+    env.setResultMsg("MultiLoopRTSPServer: a nonzero port number is required");
+    return NULL;
+  }
+  if (createServer == NULL) {
+    env.setResultMsg("MultiLoopRTSPServer: no \"createServerFunc\" was specified");
+    return NULL;
+  }
+  if (numLoops == 0) {
+    long numCores = sysconf(_SC_NPROCESSORS_ONLN);
+    numLoops = numCores > 0 ? (unsigned)numCores : 1;
+  }
+
+  MultiLoopRTSPServer* server = new MultiLoopRTSPServer(ourPort, createServer, clientData, numLoops, pinToCores);
+  if (!server->startLoops(env)) {
+    delete server;
+    return NULL;
+  }
+
+  return server;
+}
+
+MultiLoopRTSPServer::MultiLoopRTSPServer(Port ourPort, createServerFunc* createServer, void* clientData,
+					 unsigned numLoops, Boolean pinToCores)
+  : fOurPort(ourPort), fCreateServerFunc(createServer), fClientData(clientData),
+    fNumLoops(numLoops), fPinToCores(pinToCores) {
+  fLoops = new EventLoop[fNumLoops];
+  for (unsigned i = 0; i < fNumLoops; ++i) {
+    fLoops[i].fOurServer = this;
+    fLoops[i].fLoopIndex = i;
+  }
+
+  pthread_mutex_init(&fMutex, NULL);
+  pthread_cond_init(&fSetupCond, NULL);
+}
+
+MultiLoopRTSPServer::~MultiLoopRTSPServer() {
+  stopLoops();
+  delete[] fLoops;
+
+  pthread_cond_destroy(&fSetupCond);
+  pthread_mutex_destroy(&fMutex);
+}
+
+Boolean MultiLoopRTSPServer::startLoops(UsageEnvironment& env) {
+  // Start the loops one at a time, waiting for each loop's server to be created before starting the next:
+  for (unsigned i = 0; i < fNumLoops; ++i) {
+    EventLoop& loop = fLoops[i];
+
+    int err = pthread_create(&loop.fThread, NULL, threadEntry, &loop);
+    if (err != 0) {
+      env.setResultErrMsg("MultiLoopRTSPServer: failed to create event loop thread: ", err);
+      return False;
+    }
+    loop.fThreadStarted = True;
+
+    pthread_mutex_lock(&fMutex);
+    while (loop.fSetupResult == 0) pthread_cond_wait(&fSetupCond, &fMutex);
+    pthread_mutex_unlock(&fMutex);
+
+    if (loop.fSetupResult < 0) {
+      env.setResultMsg("MultiLoopRTSPServer: failed to create a server: ",
+		       loop.fErrorMsg == NULL ? "" : loop.fErrorMsg);
+      return False;
+    }
+  }
+
+  return True;
+}
+
+void MultiLoopRTSPServer::stopLoops() {
+  // Tell each loop to stop, and then wait for each of their threads to finish:
+  for (unsigned i = 0; i < fNumLoops; ++i) fLoops[i].fWatchVariable = 1;
+  for (unsigned i = 0; i < fNumLoops; ++i) {
+    if (fLoops[i].fThreadStarted) {
+      pthread_join(fLoops[i].fThread, NULL);
+      fLoops[i].fThreadStarted = False;
+    }
+  }
+}
+
+void* MultiLoopRTSPServer::threadEntry(void* loopArg) {
+  EventLoop* loop = (EventLoop*)loopArg;
+  MultiLoopRTSPServer* ourServer = loop->fOurServer;
+
+#if defined(__linux__)
+  if (ourServer->fPinToCores) {
+    long numCores = sysconf(_SC_NPROCESSORS_ONLN);
+    if (numCores > 0) {
+      cpu_set_t cpuSet;
+      CPU_ZERO(&cpuSet);
+      CPU_SET(loop->fLoopIndex%numCores, &cpuSet);
+      pthread_setaffinity_np(pthread_self(), sizeof cpuSet, &cpuSet); // if this fails, we just run unpinned
+    }
+  }
+#endif
+
+  // Each loop gets its own task scheduler and usage environment:
+  TaskScheduler* scheduler = NULL;
+#if defined(__linux__)
+  scheduler = EpollTaskScheduler::createNew();
+#endif
+  if (scheduler == NULL) scheduler = BasicTaskScheduler::createNew();
+  UsageEnvironment* env = BasicUsageEnvironment::createNew(*scheduler);
+
+  RTSPServer* rtspServer
+    = (*ourServer->fCreateServerFunc)(*env, ourServer->fOurPort, True/*reusePort*/,
+				      loop->fLoopIndex, ourServer->fClientData);
+
+  pthread_mutex_lock(&ourServer->fMutex);
+  if (rtspServer == NULL) {
+    loop->fErrorMsg = strDup(env->getResultMsg());
+    loop->fSetupResult = -1;
+  } else {
+    loop->fSetupResult = 1;
+  }
+  pthread_cond_broadcast(&ourServer->fSetupCond);
+  pthread_mutex_unlock(&ourServer->fMutex);
+
+  if (rtspServer != NULL) {
+    env->taskScheduler().doEventLoop(&loop->fWatchVariable);
+    Medium::close(rtspServer);
+  }
+
+  env->reclaim();
+  delete scheduler;
+  return NULL;
+}
+
+
+////////// MultiLoopRTSPServer::EventLoop implementation //////////
+
+MultiLoopRTSPServer::EventLoop::EventLoop()
+  : fOurServer(NULL), fLoopIndex(0), fThreadStarted(False),
+    fWatchVariable(0), fSetupResult(0), fErrorMsg(NULL) {
+}
+
+MultiLoopRTSPServer::EventLoop::~EventLoop() {
+  delete[] fErrorMsg;
+}
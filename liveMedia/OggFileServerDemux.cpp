@@ -83,7 +83,7 @@ OggFileServerDemux
 ::OggFileServerDemux(UsageEnvironment& env, char const* fileName,
 		     onCreationFunc* onCreation, void* onCreationClientData)
   : Medium(env),
-    fFileName(fileName), fOnCreation(onCreation), fOnCreationClientData(onCreationClientData),
+    fFileName(strDup(fileName)), fOnCreation(onCreation), fOnCreationClientData(onCreationClientData),
     fIter(NULL/*until the OggFile is created*/),
     fLastClientSessionId(0), fLastCreatedDemux(NULL) {
   OggFile::createNew(env, fileName, onOggFileCreation, this);
@@ -91,6 +91,7 @@ OggFileServerDemux
 
 OggFileServerDemux::~OggFileServerDemux() {
   Medium::close(fOurOggFile);
+  delete[] (char*)fFileName;
 
   delete fIter;
 }
@@ -0,0 +1,255 @@
+/**********
+This library is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the
+Free Software Foundation; either version 3 of the License, or (at your
+option) any later version. (See <http://www.gnu.org/copyleft/lesser.html>.)
+
+This library is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+**********/
+// "liveMedia"
+// Copyright (c) 1996-2017 Live Networks, Inc.  All rights reserved.
+// A gateway that receives a RTP stream, and forwards the payload of each RTP packet as a UDP datagram - directly from
+// the socket read handler, and without copying.
+// Implementation
+
+#include "RTP2UDPGateway.hh"
+#include "GroupsockHelper.hh"
+
+#define MAX_HELD_PACKETS 64 // must be a power of 2
+#define MAX_DROPOUT 3000 // a jump (forwards) in sequence numbers larger than this means that the sender restarted
+#define MAX_MISORDER 100 // ditto, for a jump backwards
+
+RTP2UDPGateway* RTP2UDPGateway::createNew(UsageEnvironment& env, Groupsock* inputGS, Groupsock* outputGS,
+					  unsigned receiveBatchSize, unsigned maxPacketSize) {
+  return new RTP2UDPGateway(env, inputGS, outputGS, receiveBatchSize, maxPacketSize);
+}
+
+RTP2UDPGateway::RTP2UDPGateway(UsageEnvironment& env, Groupsock* inputGS, Groupsock* outputGS,
+			       unsigned receiveBatchSize, unsigned maxPacketSize)
+  : Medium(env), fInputGS(inputGS), fOutputGS(outputGS),
+    fReceiveBatchSize(receiveBatchSize), fMaxPacketSize(maxPacketSize),
+    fReorderingThresholdTime(100000), fRTPPayloadType(-1), fIsForwarding(False),
+    fNumHeldPackets(0), fHighestHeldSeqNo(0), fReorderingTimeoutTask(NULL),
+    fHaveSeenFirstPacket(False), fSSRC(0), fNextExpectedSeqNo(0),
+    fNumPacketsReceived(0), fNumPacketsForwarded(0), fNumPacketsReordered(0), fNumPacketsLost(0), fNumPacketsDiscarded(0),
+    fNumResyncs(0) {
+  if (fReceiveBatchSize == 0) fReceiveBatchSize = 1;
+  if (fReceiveBatchSize > MAX_DATAGRAMS_PER_BATCH) fReceiveBatchSize = MAX_DATAGRAMS_PER_BATCH;
+
+  // Each packet is read into one of our buffers, and (after its RTP header has been skipped) forwarded from there.
+  // A packet that has to be held back keeps its buffer; a spare buffer takes its place:
+  fReceiveBuffers = new unsigned char*[fReceiveBatchSize];
+  fReceivedPacketSizes = new unsigned[fReceiveBatchSize];
+  for (unsigned i = 0; i < fReceiveBatchSize; ++i) fReceiveBuffers[i] = new unsigned char[fMaxPacketSize];
+
+  fSpareBuffers = new unsigned char*[MAX_HELD_PACKETS];
+  for (unsigned i = 0; i < MAX_HELD_PACKETS; ++i) fSpareBuffers[i] = new unsigned char[fMaxPacketSize];
+  fNumSpareBuffers = MAX_HELD_PACKETS;
+
+  fHeldPackets = new HeldPacket[MAX_HELD_PACKETS];
+  for (unsigned i = 0; i < MAX_HELD_PACKETS; ++i) fHeldPackets[i].buffer = NULL;
+}
+
+RTP2UDPGateway::~RTP2UDPGateway() {
+  stopForwarding();
+
+  for (unsigned i = 0; i < fReceiveBatchSize; ++i) delete[] fReceiveBuffers[i];
+  delete[] fReceiveBuffers; delete[] fReceivedPacketSizes;
+  for (unsigned i = 0; i < fNumSpareBuffers; ++i) delete[] fSpareBuffers[i];
+  delete[] fSpareBuffers;
+  delete[] fHeldPackets; // (stopForwarding() made them all spare)
+}
+
+void RTP2UDPGateway::startForwarding() {
+  if (fIsForwarding) return;
+
+  envir().taskScheduler().turnOnBackgroundReadHandling(fInputGS->socketNum(),
+	(TaskScheduler::BackgroundHandlerProc*)&incomingPacketHandler, this);
+  fIsForwarding = True;
+}
+
+void RTP2UDPGateway::stopForwarding() {
+  if (!fIsForwarding) return;
+
+  envir().taskScheduler().turnOffBackgroundReadHandling(fInputGS->socketNum());
+  fIsForwarding = False;
+
+  // Discard any packets that we've been holding back, and start afresh (if we're restarted):
+  envir().taskScheduler().unscheduleDelayedTask(fReorderingTimeoutTask);
+  for (unsigned i = 0; i < MAX_HELD_PACKETS; ++i) {
+    HeldPacket& slot = fHeldPackets[i];
+    if (slot.buffer != NULL) {
+      fSpareBuffers[fNumSpareBuffers++] = slot.buffer;
+      slot.buffer = NULL;
+    }
+  }
+  fNumHeldPackets = 0;
+  fHaveSeenFirstPacket = False;
+}
+
+void RTP2UDPGateway::incomingPacketHandler(RTP2UDPGateway* gateway, int /*mask*/) {
+  gateway->incomingPacketHandler1();
+}
+
+void RTP2UDPGateway::incomingPacketHandler1() {
+  struct sockaddr_in fromAddresses[MAX_DATAGRAMS_PER_BATCH];
+  int numPackets = fInputGS->handleReadBatch(fReceiveBuffers, fMaxPacketSize, fReceivedPacketSizes,
+					     fromAddresses, fReceiveBatchSize);
+  for (int i = 0; i < numPackets; ++i) handlePacket((unsigned)i);
+}
+
+void RTP2UDPGateway::handlePacket(unsigned i) {
+  unsigned char* packet = fReceiveBuffers[i];
+  unsigned packetSize = fReceivedPacketSizes[i];
+  if (packetSize == 0) return; // the packet was not for us
+  ++fNumPacketsReceived;
+
+  // Check the RTP header, and skip over it (including any CSRCs and header extension), and any padding:
+  if (packetSize < 12 || (packet[0]&0xC0) != 0x80
+      || (fRTPPayloadType >= 0 && (packet[1]&0x7F) != fRTPPayloadType)) {
+    ++fNumPacketsDiscarded;
+    return;
+  }
+  unsigned rtpHdrSize = 12 + 4*(packet[0]&0x0F);
+  if ((packet[0]&0x10) != 0 && packetSize >= rtpHdrSize + 4) { // there's a header extension
+    rtpHdrSize += 4 + 4*((packet[rtpHdrSize+2]<<8)|packet[rtpHdrSize+3]);
+  }
+  unsigned numPaddingBytes = (packet[0]&0x20) != 0 ? packet[packetSize-1] : 0;
+  if (packetSize < rtpHdrSize + numPaddingBytes) {
+    ++fNumPacketsDiscarded;
+    return;
+  }
+  unsigned char* payload = &packet[rtpHdrSize];
+  unsigned payloadSize = packetSize - rtpHdrSize - numPaddingBytes;
+  u_int16_t seqNo = (packet[2]<<8)|packet[3];
+  u_int32_t ssrc = (packet[8]<<24)|(packet[9]<<16)|(packet[10]<<8)|packet[11];
+
+  if (!fHaveSeenFirstPacket || ssrc != fSSRC) resync(ssrc, seqNo);
+
+  int seqNoOffset = (int16_t)(seqNo - fNextExpectedSeqNo);
+  if (seqNoOffset > MAX_DROPOUT || seqNoOffset < -MAX_MISORDER) {
+    // The sender has probably restarted:
+    resync(ssrc, seqNo);
+    seqNoOffset = 0;
+  }
+
+  if (seqNoOffset == 0) {
+    // The normal case: This is the packet that we expected.  Forward it now (and then any held packets that follow it):
+    forwardPacket(payload, payloadSize);
+    ++fNextExpectedSeqNo;
+    if (fNumHeldPackets > 0) forwardHeldPackets();
+  } else if (seqNoOffset < 0) {
+    // This is a duplicate, or a packet that we already gave up waiting for:
+    ++fNumPacketsDiscarded;
+  } else if (seqNoOffset < MAX_HELD_PACKETS) {
+    // One or more earlier packets are missing.  Hold this one back until they arrive (or until we give up on them):
+    holdPacket(i, seqNo, payload, payloadSize);
+  } else {
+    // The gap is too large for us to wait for the missing packets:
+    releaseHeldPackets();
+    fNumPacketsLost += (u_int16_t)(seqNo - fNextExpectedSeqNo);
+    forwardPacket(payload, payloadSize);
+    fNextExpectedSeqNo = seqNo + 1;
+  }
+}
+
+void RTP2UDPGateway::forwardPacket(unsigned char* payload, unsigned payloadSize) {
+  if (payloadSize == 0) return;
+
+  fOutputGS->output(envir(), payload, payloadSize);
+  ++fNumPacketsForwarded;
+}
+
+void RTP2UDPGateway::holdPacket(unsigned i, u_int16_t seqNo, unsigned char* payload, unsigned payloadSize) {
+  HeldPacket& slot = fHeldPackets[seqNo&(MAX_HELD_PACKETS-1)];
+  if (slot.buffer != NULL || fNumSpareBuffers == 0) { // a duplicate (or no room; shouldn't happen)
+    ++fNumPacketsDiscarded;
+    return;
+  }
+
+  // The packet keeps its buffer; a spare buffer replaces it for future reads:
+  slot.buffer = fReceiveBuffers[i];
+  slot.payload = payload;
+  slot.payloadSize = payloadSize;
+  fReceiveBuffers[i] = fSpareBuffers[--fNumSpareBuffers];
+
+  if (fNumHeldPackets++ == 0 || (int16_t)(seqNo - fHighestHeldSeqNo) > 0) fHighestHeldSeqNo = seqNo;
+  ++fNumPacketsReordered;
+
+  if (fReorderingTimeoutTask == NULL) {
+    fReorderingTimeoutTask
+      = envir().taskScheduler().scheduleDelayedTask(fReorderingThresholdTime, reorderingTimeoutHandler, this);
+  }
+}
+
+void RTP2UDPGateway::forwardHeldPackets() {
+  // Forward each held packet that's now in order:
+  Boolean madeProgress = False;
+  while (fNumHeldPackets > 0) {
+    HeldPacket& slot = fHeldPackets[fNextExpectedSeqNo&(MAX_HELD_PACKETS-1)];
+    if (slot.buffer == NULL) break;
+
+    forwardPacket(slot.payload, slot.payloadSize);
+    fSpareBuffers[fNumSpareBuffers++] = slot.buffer;
+    slot.buffer = NULL;
+    --fNumHeldPackets;
+    ++fNextExpectedSeqNo;
+    madeProgress = True;
+  }
+
+  if (fNumHeldPackets == 0) {
+    envir().taskScheduler().unscheduleDelayedTask(fReorderingTimeoutTask);
+  } else if (madeProgress) {
+    // We're now waiting for a different missing packet; give it the full threshold time:
+    envir().taskScheduler().rescheduleDelayedTask(fReorderingTimeoutTask,
+						  fReorderingThresholdTime, reorderingTimeoutHandler, this);
+  }
+}
+
+void RTP2UDPGateway::releaseHeldPackets() {
+  // Forward all of the held packets (in order), treating the packets that are still missing as lost:
+  while (fNumHeldPackets > 0) {
+    HeldPacket& slot = fHeldPackets[fNextExpectedSeqNo&(MAX_HELD_PACKETS-1)];
+    if (slot.buffer != NULL) {
+      forwardPacket(slot.payload, slot.payloadSize);
+      fSpareBuffers[fNumSpareBuffers++] = slot.buffer;
+      slot.buffer = NULL;
+      --fNumHeldPackets;
+    } else {
+      ++fNumPacketsLost;
+    }
+    ++fNextExpectedSeqNo;
+  }
+
+  if (fNumHeldPackets == 0) envir().taskScheduler().unscheduleDelayedTask(fReorderingTimeoutTask);
+}
+
+void RTP2UDPGateway::reorderingTimeoutHandler(void* clientData) {
+  RTP2UDPGateway* gateway = (RTP2UDPGateway*)clientData;
+  gateway->reorderingTimeoutHandler1();
+}
+
+void RTP2UDPGateway::reorderingTimeoutHandler1() {
+  fReorderingTimeoutTask = NULL;
+
+  // We've waited long enough for the missing packet(s):
+  releaseHeldPackets();
+}
+
+void RTP2UDPGateway::resync(u_int32_t ssrc, u_int16_t seqNo) {
+  if (fHaveSeenFirstPacket) {
+    ++fNumResyncs;
+    releaseHeldPackets(); // (these are still good data)
+  }
+
+  fHaveSeenFirstPacket = True;
+  fSSRC = ssrc;
+  fNextExpectedSeqNo = seqNo;
+}
@@ -23,6 +23,9 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 #include "RTPInterface.hh"
 #include <GroupsockHelper.hh>
 #include <stdio.h>
+#if !defined(__WIN32__) && !defined(_WIN32)
+#include <sys/uio.h>
+#endif
 
 ////////// Helper Functions - Definition //////////
 
@@ -45,25 +48,50 @@ static HashTable* socketHashTable(UsageEnvironment& env, Boolean createIfNotPres
   return (HashTable*)(ourTables->socketTable);
 }
 
+// Data that's waiting to be sent over a TCP socket (because the socket's send buffer was full):
+class QueuedTCPData {
+public:
+  QueuedTCPData(u_int8_t const* header, unsigned headerSize, u_int8_t const* data, unsigned dataSize,
+		unsigned numBytesAlreadySent, Boolean isDiscardable);
+  virtual ~QueuedTCPData();
+
+public:
+  QueuedTCPData* fNext;
+  u_int8_t* fData;
+  unsigned fSize, fNumBytesSent;
+  Boolean fIsDiscardable;
+};
+
 class SocketDescriptor {
 public:
   SocketDescriptor(UsageEnvironment& env, int socketNum);
   virtual ~SocketDescriptor();
 
+  Boolean sendData(u_int8_t const* header, unsigned headerSize, u_int8_t const* data, unsigned dataSize,
+		   Boolean isDiscardable, Boolean& dataWasDropped);
+      // Sends "header" followed by "data" (as a unit), or else queues whatever can't be sent now.
+      // Returns False iff the TCP connection has failed (or is being closed).
+
   void registerRTPInterface(unsigned char streamChannelId,
 			    RTPInterface* rtpInterface);
   RTPInterface* lookupRTPInterface(unsigned char streamChannelId);
   void deregisterRTPInterface(unsigned char streamChannelId);
 
-  void setServerRequestAlternativeByteHandler(ServerRequestAlternativeByteHandler* handler, void* clientData) {
-    fServerRequestAlternativeByteHandler = handler;
-    fServerRequestAlternativeByteHandlerClientData = clientData;
-  }
+  void setServerRequestAlternativeByteHandler(ServerRequestAlternativeByteHandler* handler, void* clientData);
+      // Note: If "handler" is NULL, and no "RTPInterface"s are using us any more, then this deletes us
 
 private:
   static void tcpReadHandler(SocketDescriptor*, int mask);
   Boolean tcpReadHandler1(int mask);
 
+  void updateBackgroundHandling();
+  void enqueueData(u_int8_t const* header, unsigned headerSize, u_int8_t const* data, unsigned dataSize,
+		   unsigned numBytesAlreadySent, Boolean isDiscardable);
+  void removeDiscardableData();
+  Boolean sendQueuedData(); // returns False iff the TCP connection failed
+  void scheduleDisconnect();
+  static void disconnectTask(void* clientData);
+
 private:
   UsageEnvironment& fEnv;
   int fOurSocketNum;
@@ -73,6 +101,13 @@ private:
   u_int8_t fStreamChannelId, fSizeByte1;
   Boolean fReadErrorOccurred, fDeleteMyselfNext, fAreInReadHandlerLoop;
   enum { AWAITING_DOLLAR, AWAITING_STREAM_CHANNEL_ID, AWAITING_SIZE1, AWAITING_SIZE2, AWAITING_PACKET_DATA } fTCPReadingState;
+
+  // Data that's waiting to be sent:
+  QueuedTCPData* fSendQueueHead;
+  QueuedTCPData* fSendQueueTail;
+  unsigned fNumQueuedBytes;
+  unsigned fNumDroppedPackets;
+  TaskToken fDisconnectTask; // non-NULL iff we're about to close the connection
 };
 
 static SocketDescriptor* lookupSocketDescriptor(UsageEnvironment& env, int sockNum, Boolean createIfNotFound = True) {
@@ -114,6 +149,9 @@ static void removeSocketDescription(UsageEnvironment& env, int sockNum) {
 
 ////////// RTPInterface - Implementation //////////
 
+unsigned RTPInterface::tcpSendQueueMaxSize = 1000000;
+unsigned RTPInterface::tcpSendQueueDiscardThreshold = 250000;
+
 RTPInterface::RTPInterface(Medium* owner, Groupsock* gs)
   : fOwner(owner), fGS(gs),
     fTCPStreams(NULL),
@@ -208,7 +246,7 @@ void RTPInterface::clearServerRequestAlternativeByteHandler(UsageEnvironment& en
   setServerRequestAlternativeByteHandler(env, socketNum, NULL, NULL);
 }
 
-Boolean RTPInterface::sendPacket(unsigned char* packet, unsigned packetSize) {
+Boolean RTPInterface::sendPacket(unsigned char* packet, unsigned packetSize, Boolean isDiscardable) {
   Boolean success = True; // we'll return False instead if any of the sends fail
 
   // Normal case: Send as a UDP packet:
@@ -218,8 +256,7 @@ Boolean RTPInterface::sendPacket(unsigned char* packet, unsigned packetSize) {
   tcpStreamRecord* nextStream;
   for (tcpStreamRecord* stream = fTCPStreams; stream != NULL; stream = nextStream) {
     nextStream = stream->fNext; // Set this now, in case the following deletes "stream":
-    if (!sendRTPorRTCPPacketOverTCP(packet, packetSize,
-				    stream->fStreamSocketNum, stream->fStreamChannelId)) {
+    if (!sendRTPorRTCPPacketOverTCP(packet, packetSize, stream, isDiscardable)) {
       success = False;
     }
   }
@@ -227,6 +264,18 @@ Boolean RTPInterface::sendPacket(unsigned char* packet, unsigned packetSize) {
   return success;
 }
 
+Boolean RTPInterface::sendDataOverStreamSocket(UsageEnvironment& env, int socketNum,
+					       u_int8_t const* data, unsigned dataSize) {
+  SocketDescriptor* socketDescriptor = lookupSocketDescriptor(env, socketNum, False);
+  if (socketDescriptor == NULL) {
+    // The socket isn't being used for RTP/RTCP-over-TCP, so just send the data normally:
+    return send(socketNum, (char const*)data, dataSize, 0/*flags*/) == (int)dataSize;
+  }
+
+  Boolean dataWasDropped;
+  return socketDescriptor->sendData(NULL, 0, data, dataSize, False, dataWasDropped);
+}
+
 void RTPInterface
 ::startNetworkReading(TaskScheduler::BackgroundHandlerProc* handlerProc) {
   // Normal case: Arrange to read UDP packets:
@@ -295,6 +344,20 @@ Boolean RTPInterface::handleRead(unsigned char* buffer, unsigned bufferMaxSize,
   return readSuccess;
 }
 
+int RTPInterface::handleReadBatch(unsigned char* const* buffers, unsigned bufferMaxSize,
+				  unsigned* bytesRead, struct sockaddr_in* fromAddresses,
+				  unsigned maxPackets) {
+  int numPackets = fGS->handleReadBatch(buffers, bufferMaxSize, bytesRead, fromAddresses, maxPackets);
+
+  if (fAuxReadHandlerFunc != NULL) {
+    // Also pass the newly-read packet data to our auxilliary handler:
+    for (int i = 0; i < numPackets; ++i) {
+      if (bytesRead[i] > 0) (*fAuxReadHandlerFunc)(fAuxReadHandlerClientData, buffers[i], bytesRead[i]);
+    }
+  }
+  return numPackets;
+}
+
 void RTPInterface::stopNetworkReading() {
   // Normal case
   if (fGS != NULL) envir().taskScheduler().turnOffBackgroundReadHandling(fGS->socketNum());
@@ -308,97 +371,125 @@ void RTPInterface::stopNetworkReading() {
 
 ////////// Helper Functions - Implementation /////////
 
+#ifndef MAX_TCP_SEND_BUFFERS
+#define MAX_TCP_SEND_BUFFERS 64
+#endif
+
 Boolean RTPInterface::sendRTPorRTCPPacketOverTCP(u_int8_t* packet, unsigned packetSize,
-						 int socketNum, unsigned char streamChannelId) {
+						 tcpStreamRecord* stream, Boolean isDiscardable) {
+  int socketNum = stream->fStreamSocketNum;
+  unsigned char streamChannelId = stream->fStreamChannelId;
 #ifdef DEBUG_SEND
   fprintf(stderr, "sendRTPorRTCPPacketOverTCP: %d bytes over channel %d (socket %d)\n",
 	  packetSize, streamChannelId, socketNum); fflush(stderr);
 #endif
+  if (isDiscardable) {
+    // If we've already dropped an earlier packet from this stream, then drop this one also, because it's probably useless:
+    if (stream->fIsDroppingDiscardablePackets) return True;
+  } else {
+    stream->fIsDroppingDiscardablePackets = False;
+  }
+
+  SocketDescriptor* socketDescriptor = lookupSocketDescriptor(envir(), socketNum, False);
+  if (socketDescriptor == NULL) return False; // the TCP connection is no longer being used for RTP/RTCP
+
   // Send a RTP/RTCP packet over TCP, using the encoding defined in RFC 2326, section 10.12:
   //     $<streamChannelId><packetSize><packet>
-  // (If the initial "send()" of '$<streamChannelId><packetSize>' succeeds, then we force
-  // the subsequent "send()" for the <packet> data to succeed, even if we have to do so with
-  // a blocking "send()".)
-  do {
-    u_int8_t framingHeader[4];
-    framingHeader[0] = '$';
-    framingHeader[1] = streamChannelId;
-    framingHeader[2] = (u_int8_t) ((packetSize&0xFF00)>>8);
-    framingHeader[3] = (u_int8_t) (packetSize&0xFF);
-    if (!sendDataOverTCP(socketNum, framingHeader, 4, False)) break;
-
-    if (!sendDataOverTCP(socketNum, packet, packetSize, True)) break;
+  // (The framing header and the packet are sent together, so that they can't be separated by other data.)
+  u_int8_t framingHeader[4];
+  framingHeader[0] = '$';
+  framingHeader[1] = streamChannelId;
+  framingHeader[2] = (u_int8_t) ((packetSize&0xFF00)>>8);
+  framingHeader[3] = (u_int8_t) (packetSize&0xFF);
+
+  Boolean packetWasDropped;
+  if (!socketDescriptor->sendData(framingHeader, 4, packet, packetSize, isDiscardable, packetWasDropped)) {
 #ifdef DEBUG_SEND
-    fprintf(stderr, "sendRTPorRTCPPacketOverTCP: completed\n"); fflush(stderr);
+    fprintf(stderr, "sendRTPorRTCPPacketOverTCP: failed! (errno %d)\n", envir().getErrno()); fflush(stderr);
 #endif
+    return False;
+  }
+  if (packetWasDropped) stream->fIsDroppingDiscardablePackets = True;
 
-    return True;
-  } while (0);
-
-#ifdef DEBUG_SEND
-  fprintf(stderr, "sendRTPorRTCPPacketOverTCP: failed! (errno %d)\n", envir().getErrno()); fflush(stderr);
-#endif
-  return False;
+  return True;
 }
 
-#ifndef RTPINTERFACE_BLOCKING_WRITE_TIMEOUT_MS
-#define RTPINTERFACE_BLOCKING_WRITE_TIMEOUT_MS 500
-#endif
+// Sends (without blocking) as much as possible of the data in "bufs[]".  Returns the number of bytes sent, or -1 on error.
+static int sendBuffersOverTCP(int socketNum, u_int8_t const* const* bufs, unsigned const* sizes, unsigned numBufs) {
+#if defined(__WIN32__) || defined(_WIN32)
+  int totBytesSent = 0;
+  for (unsigned i = 0; i < numBufs; ++i) {
+    int sendResult = send(socketNum, (char const*)bufs[i], sizes[i], 0/*flags*/);
+    if (sendResult < 0) return totBytesSent > 0 ? totBytesSent : -1;
+    totBytesSent += sendResult;
+    if ((unsigned)sendResult < sizes[i]) break;
+  }
+  return totBytesSent;
+#else
+  struct iovec iov[MAX_TCP_SEND_BUFFERS];
+  if (numBufs > MAX_TCP_SEND_BUFFERS) numBufs = MAX_TCP_SEND_BUFFERS;
+  for (unsigned i = 0; i < numBufs; ++i) {
+    iov[i].iov_base = (void*)bufs[i];
+    iov[i].iov_len = sizes[i];
+  }
 
-Boolean RTPInterface::sendDataOverTCP(int socketNum, u_int8_t const* data, unsigned dataSize, Boolean forceSendToSucceed) {
-  int sendResult = send(socketNum, (char const*)data, dataSize, 0/*flags*/);
-  if (sendResult < (int)dataSize) {
-    // The TCP send() failed - at least partially.
-
-    unsigned numBytesSentSoFar = sendResult < 0 ? 0 : (unsigned)sendResult;
-    if (numBytesSentSoFar > 0 || (forceSendToSucceed && envir().getErrno() == EAGAIN)) {
-      // The OS's TCP send buffer has filled up (because the stream's bitrate has exceeded
-      // the capacity of the TCP connection!).
-      // Force this data write to succeed, by blocking if necessary until it does:
-      unsigned numBytesRemainingToSend = dataSize - numBytesSentSoFar;
-#ifdef DEBUG_SEND
-      fprintf(stderr, "sendDataOverTCP: resending %d-byte send (blocking)\n", numBytesRemainingToSend); fflush(stderr);
+  struct msghdr msg;
+  memset(&msg, 0, sizeof msg);
+  msg.msg_iov = iov;
+  msg.msg_iovlen = numBufs;
+#ifdef MSG_NOSIGNAL
+  int const flags = MSG_NOSIGNAL;
+#else
+  int const flags = 0;
 #endif
-      makeSocketBlocking(socketNum, RTPINTERFACE_BLOCKING_WRITE_TIMEOUT_MS);
-      sendResult = send(socketNum, (char const*)(&data[numBytesSentSoFar]), numBytesRemainingToSend, 0/*flags*/);
-      if ((unsigned)sendResult != numBytesRemainingToSend) {
-	// The blocking "send()" failed, or timed out.  In either case, we assume that the
-	// TCP connection has failed (or is 'hanging' indefinitely), and we stop using it
-	// (for both RTP and RTP).
-	// (If we kept using the socket here, the RTP or RTCP packet write would be in an
-	//  incomplete, inconsistent state.)
-#ifdef DEBUG_SEND
-	fprintf(stderr, "sendDataOverTCP: blocking send() failed (delivering %d bytes out of %d); closing socket %d\n", sendResult, numBytesRemainingToSend, socketNum); fflush(stderr);
+  int sendResult;
+  do {
+    sendResult = sendmsg(socketNum, &msg, flags);
+  } while (sendResult < 0 && errno == EINTR);
+  return sendResult;
 #endif
-	removeStreamSocket(socketNum, 0xFF);
-	return False;
-      }
-      makeSocketNonBlocking(socketNum);
+}
 
-      return True;
-    } else if (sendResult < 0 && envir().getErrno() != EAGAIN) {
-      // Because the "send()" call failed, assume that the socket is now unusable, so stop
-      // using it (for both RTP and RTCP):
-      removeStreamSocket(socketNum, 0xFF);
-    }
+static Boolean sendWouldBlock(UsageEnvironment& env) {
+  int err = env.getErrno();
+  return err == EAGAIN || err == EWOULDBLOCK;
+}
 
-    return False;
-  }
+QueuedTCPData::QueuedTCPData(u_int8_t const* header, unsigned headerSize, u_int8_t const* data, unsigned dataSize,
+			     unsigned numBytesAlreadySent, Boolean isDiscardable)
+  : fNext(NULL), fData(new u_int8_t[headerSize + dataSize]), fSize(headerSize + dataSize),
+    fNumBytesSent(numBytesAlreadySent), fIsDiscardable(isDiscardable) {
+  if (headerSize > 0) memmove(fData, header, headerSize);
+  memmove(&fData[headerSize], data, dataSize);
+}
 
-  return True;
+QueuedTCPData::~QueuedTCPData() {
+  delete[] fData;
 }
 
 SocketDescriptor::SocketDescriptor(UsageEnvironment& env, int socketNum)
   :fEnv(env), fOurSocketNum(socketNum),
     fSubChannelHashTable(HashTable::create(ONE_WORD_HASH_KEYS)),
    fServerRequestAlternativeByteHandler(NULL), fServerRequestAlternativeByteHandlerClientData(NULL),
-   fReadErrorOccurred(False), fDeleteMyselfNext(False), fAreInReadHandlerLoop(False), fTCPReadingState(AWAITING_DOLLAR) {
+   fReadErrorOccurred(False), fDeleteMyselfNext(False), fAreInReadHandlerLoop(False), fTCPReadingState(AWAITING_DOLLAR),
+   fSendQueueHead(NULL), fSendQueueTail(NULL), fNumQueuedBytes(0), fNumDroppedPackets(0), fDisconnectTask(NULL) {
 }
 
 SocketDescriptor::~SocketDescriptor() {
   fEnv.taskScheduler().turnOffBackgroundReadHandling(fOurSocketNum);
+  fEnv.taskScheduler().unscheduleDelayedTask(fDisconnectTask);
   removeSocketDescription(fEnv, fOurSocketNum);
 
+  // Discard any data that we couldn't send:
+  while (fSendQueueHead != NULL) {
+    QueuedTCPData* next = fSendQueueHead->fNext;
+    delete fSendQueueHead;
+    fSendQueueHead = next;
+  }
+#ifdef DEBUG_SEND
+  if (fNumDroppedPackets > 0) fprintf(stderr, "SocketDescriptor(socket %d): dropped %d packets\n", fOurSocketNum, fNumDroppedPackets);
+#endif
+
   if (fSubChannelHashTable != NULL) {
     // Remove knowledge of this socket from any "RTPInterface"s that are using it:
     HashTable::Iterator* iter = HashTable::Iterator::create(*fSubChannelHashTable);
@@ -439,10 +530,22 @@ void SocketDescriptor::registerRTPInterface(unsigned char streamChannelId,
 
   if (isFirstRegistration) {
     // Arrange to handle reads on this TCP socket:
-    TaskScheduler::BackgroundHandlerProc* handler
-      = (TaskScheduler::BackgroundHandlerProc*)&tcpReadHandler;
-    fEnv.taskScheduler().
-      setBackgroundHandling(fOurSocketNum, SOCKET_READABLE|SOCKET_EXCEPTION, handler, this);
+    updateBackgroundHandling();
+  }
+}
+
+void SocketDescriptor::setServerRequestAlternativeByteHandler(ServerRequestAlternativeByteHandler* handler, void* clientData) {
+  fServerRequestAlternativeByteHandler = handler;
+  fServerRequestAlternativeByteHandlerClientData = clientData;
+
+  if (handler == NULL && fSubChannelHashTable->IsEmpty()) {
+    // We were being kept around only to send queued data (see "deregisterRTPInterface()"), but the owner of the
+    // socket is about to close it, so there's no longer any point:
+    if (fAreInReadHandlerLoop) {
+      fDeleteMyselfNext = True;
+    } else {
+      delete this;
+    }
   }
 }
 
@@ -459,6 +562,16 @@ void SocketDescriptor
 #endif
   fSubChannelHashTable->Remove((char const*)(long)streamChannelId);
 
+  if (fSubChannelHashTable->IsEmpty() && fDisconnectTask == NULL && !fReadErrorOccurred) {
+    // No more interfaces are using us.  But if we still have queued data - perhaps including a partly-sent packet,
+    // without the rest of which the receiver couldn't parse anything that came after it - then we can't go away yet,
+    // because anything else that gets written to the socket (e.g., a RTSP response) would then be sent before it.
+    // Instead, stay around until this data has been sent (queueing anything else after it).  (But don't bother
+    // sending data that's not yet been started, and that our (now departed) interfaces said could be dropped.)
+    removeDiscardableData();
+    if (fSendQueueHead != NULL) return; // we'll delete ourself from "tcpReadHandler()", once the queue has drained
+  }
+
   if (fSubChannelHashTable->IsEmpty() || streamChannelId == 0xFF) {
     // No more interfaces are using us, so it's curtains for us now:
     if (fAreInReadHandlerLoop) {
@@ -470,6 +583,18 @@ void SocketDescriptor
 }
 
 void SocketDescriptor::tcpReadHandler(SocketDescriptor* socketDescriptor, int mask) {
+  if ((mask&SOCKET_WRITABLE) != 0) {
+    // We have queued data, and the socket can now accept more of it:
+    if (!socketDescriptor->sendQueuedData()) return; // the connection failed, and is being closed
+    if (socketDescriptor->fSendQueueHead == NULL && socketDescriptor->fSubChannelHashTable->IsEmpty()) {
+      // We were being kept around only to send this data (see "deregisterRTPInterface()"), so we're now done.
+      // (Our destructor hands the socket back to our "ServerRequestAlternativeByteHandler" (if any).)
+      delete socketDescriptor;
+      return;
+    }
+    if ((mask&(SOCKET_READABLE|SOCKET_EXCEPTION)) == 0) return;
+  }
+
   // Call the read handler until it returns false, with a limit to avoid starving other sockets
   unsigned count = 2000;
   socketDescriptor->fAreInReadHandlerLoop = True;
@@ -478,6 +603,171 @@ void SocketDescriptor::tcpReadHandler(SocketDescriptor* socketDescriptor, int ma
   if (socketDescriptor->fDeleteMyselfNext) delete socketDescriptor;
 }
 
+Boolean SocketDescriptor::sendData(u_int8_t const* header, unsigned headerSize, u_int8_t const* data, unsigned dataSize,
+				   Boolean isDiscardable, Boolean& dataWasDropped) {
+  dataWasDropped = False;
+  if (fDisconnectTask != NULL) return False; // we're closing the connection
+
+  unsigned totSize = headerSize + dataSize;
+  if (fSendQueueHead == NULL) {
+    // Common case: Nothing else is waiting to be sent, so try to send the data right away:
+    u_int8_t const* bufs[2]; unsigned sizes[2]; unsigned numBufs = 0;
+    if (headerSize > 0) { bufs[numBufs] = header; sizes[numBufs] = headerSize; ++numBufs; }
+    bufs[numBufs] = data; sizes[numBufs] = dataSize; ++numBufs;
+
+    int sendResult = sendBuffersOverTCP(fOurSocketNum, bufs, sizes, numBufs);
+    if (sendResult == (int)totSize) return True;
+    if (sendResult < 0) {
+      if (!sendWouldBlock(fEnv)) {
+	// The "send()" failed, so assume that the socket is now unusable:
+	scheduleDisconnect();
+	return False;
+      }
+      sendResult = 0;
+    }
+
+    // The OS's TCP send buffer has filled up (because the stream's bitrate has exceeded the capacity of the TCP
+    // connection!).  Queue the rest of the data, to be sent when the socket becomes writable again:
+    enqueueData(header, headerSize, data, dataSize, (unsigned)sendResult, sendResult == 0 && isDiscardable);
+    return True;
+  }
+
+  // Other data is already waiting to be sent, so we'll need to queue this data also - if there's room for it:
+  if (isDiscardable && fNumQueuedBytes + totSize > RTPInterface::tcpSendQueueDiscardThreshold) {
+    ++fNumDroppedPackets;
+    dataWasDropped = True;
+    return True;
+  }
+  if (fNumQueuedBytes + totSize > RTPInterface::tcpSendQueueMaxSize) {
+    // Make room by removing any discardable data from the queue.  If that's not enough, then give up on the connection:
+    removeDiscardableData();
+    if (fNumQueuedBytes + totSize > RTPInterface::tcpSendQueueMaxSize) {
+#ifdef DEBUG_SEND
+      fprintf(stderr, "SocketDescriptor(socket %d)::sendData(): send queue is full (%d bytes); closing the connection\n", fOurSocketNum, fNumQueuedBytes);
+#endif
+      scheduleDisconnect();
+      return False;
+    }
+  }
+  enqueueData(header, headerSize, data, dataSize, 0, isDiscardable);
+  return True;
+}
+
+void SocketDescriptor::updateBackgroundHandling() {
+  int conditionSet = 0;
+  if (!fSubChannelHashTable->IsEmpty() || fSendQueueHead != NULL) {
+    // Note: We keep reading the socket while we're still sending queued data after our last interface has gone away,
+    // so that any requests that arrive on it in the meantime still get passed to our "ServerRequestAlternativeByteHandler":
+    conditionSet |= SOCKET_READABLE|SOCKET_EXCEPTION;
+  }
+  if (fSendQueueHead != NULL) conditionSet |= SOCKET_WRITABLE;
+
+  if (conditionSet == 0) {
+    fEnv.taskScheduler().disableBackgroundHandling(fOurSocketNum);
+  } else {
+    fEnv.taskScheduler().setBackgroundHandling(fOurSocketNum, conditionSet,
+					       (TaskScheduler::BackgroundHandlerProc*)&tcpReadHandler, this);
+  }
+}
+
+void SocketDescriptor::enqueueData(u_int8_t const* header, unsigned headerSize, u_int8_t const* data, unsigned dataSize,
+				   unsigned numBytesAlreadySent, Boolean isDiscardable) {
+  QueuedTCPData* queuedData
+    = new QueuedTCPData(header, headerSize, data, dataSize, numBytesAlreadySent, isDiscardable);
+  fNumQueuedBytes += queuedData->fSize - numBytesAlreadySent;
+
+  Boolean queueWasEmpty = fSendQueueHead == NULL;
+  if (queueWasEmpty) {
+    fSendQueueHead = queuedData;
+  } else {
+    fSendQueueTail->fNext = queuedData;
+  }
+  fSendQueueTail = queuedData;
+
+  if (queueWasEmpty) updateBackgroundHandling(); // to handle writability of the socket
+}
+
+void SocketDescriptor::removeDiscardableData() {
+  // Remove each discardable item from the queue - except for one that's already been partially sent:
+  QueuedTCPData** queuedDataPtr = &fSendQueueHead;
+  fSendQueueTail = NULL;
+  while (*queuedDataPtr != NULL) {
+    QueuedTCPData* queuedData = *queuedDataPtr;
+    if (queuedData->fIsDiscardable && queuedData->fNumBytesSent == 0) {
+      *queuedDataPtr = queuedData->fNext;
+      fNumQueuedBytes -= queuedData->fSize;
+      ++fNumDroppedPackets;
+      delete queuedData;
+    } else {
+      fSendQueueTail = queuedData;
+      queuedDataPtr = &queuedData->fNext;
+    }
+  }
+  if (fSendQueueHead == NULL) updateBackgroundHandling(); // we no longer need to handle writability of the socket
+}
+
+Boolean SocketDescriptor::sendQueuedData() {
+  while (fSendQueueHead != NULL) {
+    // Send as many of the queued items as we can, with a single system call:
+    u_int8_t const* bufs[MAX_TCP_SEND_BUFFERS]; unsigned sizes[MAX_TCP_SEND_BUFFERS];
+    unsigned numBufs = 0, numBytesToSend = 0;
+    for (QueuedTCPData* queuedData = fSendQueueHead; queuedData != NULL && numBufs < MAX_TCP_SEND_BUFFERS;
+	 queuedData = queuedData->fNext) {
+      bufs[numBufs] = &queuedData->fData[queuedData->fNumBytesSent];
+      sizes[numBufs] = queuedData->fSize - queuedData->fNumBytesSent;
+      numBytesToSend += sizes[numBufs];
+      ++numBufs;
+    }
+
+    int sendResult = sendBuffersOverTCP(fOurSocketNum, bufs, sizes, numBufs);
+    if (sendResult < 0) {
+      if (sendWouldBlock(fEnv)) break;
+
+      // The "send()" failed, so assume that the socket is now unusable:
+      scheduleDisconnect();
+      return False;
+    }
+
+    // Remove the data that we sent from the queue:
+    unsigned numBytesSent = (unsigned)sendResult;
+    fNumQueuedBytes -= numBytesSent;
+    while (numBytesSent > 0) {
+      QueuedTCPData* queuedData = fSendQueueHead;
+      unsigned numBytesRemaining = queuedData->fSize - queuedData->fNumBytesSent;
+      if (numBytesSent < numBytesRemaining) {
+	queuedData->fNumBytesSent += numBytesSent;
+	break;
+      }
+      numBytesSent -= numBytesRemaining;
+      fSendQueueHead = queuedData->fNext;
+      if (fSendQueueHead == NULL) fSendQueueTail = NULL;
+      delete queuedData;
+    }
+
+    if ((unsigned)sendResult < numBytesToSend) break; // the socket's send buffer is full again
+  }
+
+  if (fSendQueueHead == NULL) updateBackgroundHandling(); // we no longer need to handle writability of the socket
+  return True;
+}
+
+void SocketDescriptor::scheduleDisconnect() {
+  // We can't delete ourself right now (because we might have been called - indirectly - by a "RTPInterface" that would
+  // then be using us), so do so (and close the connection) from the event loop instead:
+  if (fDisconnectTask == NULL) {
+    fDisconnectTask = fEnv.taskScheduler().scheduleDelayedTask(0, disconnectTask, this);
+  }
+}
+
+void SocketDescriptor::disconnectTask(void* clientData) {
+  SocketDescriptor* socketDescriptor = (SocketDescriptor*)clientData;
+  socketDescriptor->fDisconnectTask = NULL;
+
+  // Note that the connection failed, so that our "ServerRequestAlternativeByteHandler" (if any) will close it:
+  socketDescriptor->fReadErrorOccurred = True;
+  delete socketDescriptor;
+}
+
 Boolean SocketDescriptor::tcpReadHandler1(int mask) {
   // We expect the following data over the TCP channel:
   //   optional RTSP command or response bytes (before the first '$' character)
@@ -607,7 +897,7 @@ tcpStreamRecord
 ::tcpStreamRecord(int streamSocketNum, unsigned char streamChannelId,
 		  tcpStreamRecord* next)
   : fNext(next),
-    fStreamSocketNum(streamSocketNum), fStreamChannelId(streamChannelId) {
+    fStreamSocketNum(streamSocketNum), fStreamChannelId(streamChannelId), fIsDroppingDiscardablePackets(False) {
 }
 
 tcpStreamRecord::~tcpStreamRecord() {
@@ -0,0 +1,233 @@
+/**********
+This library is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the
+Free Software Foundation; either version 3 of the License, or (at your
+option) any later version. (See <http://www.gnu.org/copyleft/lesser.html>.)
+
+This library is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+**********/
+// "liveMedia"
+// Copyright (c) 1996-2017 Live Networks, Inc.  All rights reserved.
+// An incremental parser for RTSP requests (as received by a server).
+// Implementation
+
+#include "RTSPRequestParser.hh"
+#include "RTSPCommon.hh"
+#include <string.h>
+
+////////// RTSPStringView implementation //////////
+
+Boolean RTSPStringView::equals(char const* s) const {
+  return strlen(s) == fLength && (fLength == 0 || strncmp(fStr, s, fLength) == 0);
+}
+
+Boolean RTSPStringView::copyTo(char* result, unsigned resultMaxSize) const {
+  if (resultMaxSize == 0) return False;
+
+  unsigned n = fLength < resultMaxSize-1 ? fLength : resultMaxSize-1;
+  if (n > 0) memmove(result, fStr, n);
+  result[n] = '\0';
+  return n == fLength;
+}
+
+
+////////// RTSPRequestParser implementation //////////
+
+static Boolean isWhitespace(char c) {
+  return c == ' ' || c == '\t';
+}
+
+static Boolean headerNameIs(char const* name, unsigned nameLength, char const* s) {
+  return strlen(s) == nameLength && _strncasecmp(name, s, nameLength) == 0;
+}
+
+RTSPRequestParser::RTSPRequestParser()
+  : fRequest(NULL) {
+  reset();
+}
+
+RTSPRequestParser::~RTSPRequestParser() {
+}
+
+void RTSPRequestParser::reset() {
+  fState = SKIPPING_WHITESPACE;
+  fNextPos = fLineStart = 0;
+
+  fIsRTSPRequest = fHaveProtocol = False;
+  fCmdName.isPresent = fURLPreSuffix.isPresent = fURLSuffix.isPresent = fCSeq.isPresent = fSessionId.isPresent = False;
+  fContentLength = 0;
+  fNumHeaders = 0;
+  fHeaderSize = fEndOfHeaderLines = 0;
+}
+
+Boolean RTSPRequestParser::parse(char const* request, unsigned requestSize) {
+  fRequest = request;
+
+  while (fNextPos < requestSize) {
+    switch (fState) {
+      case SKIPPING_WHITESPACE: {
+	// "Be liberal in what you accept": Skip over any whitespace (e.g., <CR><LF>s) before the request line:
+	char c = request[fNextPos];
+	if (c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '\0') {
+	  ++fNextPos;
+	} else {
+	  fLineStart = fNextPos;
+	  fState = READING_REQUEST_LINE;
+	}
+	break;
+      }
+      case READING_REQUEST_LINE:
+      case READING_HEADERS: {
+	// Look for the end of the current line:
+	char const* nl = (char const*)memchr(&request[fNextPos], '\n', requestSize - fNextPos);
+	if (nl == NULL) {
+	  fNextPos = requestSize;
+	  return False; // subsequent data will be needed to complete the line
+	}
+	unsigned lineTerminator = nl - request;
+	fNextPos = lineTerminator + 1;
+	if (lineTerminator > fLineStart && request[lineTerminator-1] == '\r') --lineTerminator;
+
+	if (fState == READING_REQUEST_LINE) {
+	  handleRequestLine(fLineStart, lineTerminator);
+	  fEndOfHeaderLines = lineTerminator;
+	  fState = READING_HEADERS;
+	} else if (lineTerminator > fLineStart) {
+	  handleHeaderLine(fLineStart, lineTerminator);
+	  fEndOfHeaderLines = lineTerminator;
+	} else {
+	  // A blank line: This is the end of the headers:
+	  fHeaderSize = fNextPos;
+	  fIsRTSPRequest = fHaveProtocol && fCSeq.isPresent;
+	  fState = READING_BODY;
+	  if (requestSize >= this->requestSize()) fState = DONE;
+	}
+	fLineStart = fNextPos;
+	break;
+      }
+      case READING_BODY: {
+	if (requestSize < this->requestSize()) {
+	  fNextPos = requestSize;
+	  return False;
+	}
+	fState = DONE;
+	break;
+      }
+      case DONE: {
+	return True;
+      }
+    }
+    if (fState == DONE) return True;
+  }
+
+  return fState == DONE
+    || (fState == READING_BODY && requestSize >= this->requestSize());
+}
+
+RTSPStringView RTSPRequestParser::lookupHeader(char const* headerName) const {
+  for (unsigned i = 0; i < fNumHeaders; ++i) {
+    Header const& header = fHeaders[i];
+    if (headerNameIs(&fRequest[header.name.offset], header.name.length, headerName)) return view(header.value);
+  }
+
+  return RTSPStringView();
+}
+
+void RTSPRequestParser::setField(Field& field, unsigned from, unsigned to) {
+  field.offset = from;
+  field.length = to > from ? to - from : 0;
+  field.isPresent = True;
+}
+
+void RTSPRequestParser::handleRequestLine(unsigned lineStart, unsigned lineEnd) {
+  // The request line is "<command> <URL> RTSP/<version>".
+  // First, read everything up to the first space (or tab) as the command name:
+  unsigned i = lineStart;
+  while (i < lineEnd && !isWhitespace(fRequest[i])) ++i;
+  if (i == lineEnd) return; // there's no URL or protocol; this is not a RTSP request
+  setField(fCmdName, lineStart, i);
+  while (i < lineEnd && isWhitespace(fRequest[i])) ++i;
+  unsigned urlStart = i;
+
+  // The last token on the line should be the protocol, "RTSP/<version>".  (We take everything before this - even if
+  // it contains spaces - to be the URL.)
+  unsigned end = lineEnd;
+  while (end > urlStart && isWhitespace(fRequest[end-1])) --end;
+  unsigned protocolStart = end;
+  while (protocolStart > urlStart && !isWhitespace(fRequest[protocolStart-1])) --protocolStart;
+  if (end - protocolStart < 5 || strncmp(&fRequest[protocolStart], "RTSP/", 5) != 0) return; // this is not a RTSP request
+  fHaveProtocol = True;
+  unsigned urlEnd = protocolStart;
+  while (urlEnd > urlStart && isWhitespace(fRequest[urlEnd-1])) --urlEnd;
+
+  // Skip over the prefix of any "rtsp://" or "rtsp:/" URL:
+  unsigned pathStart = urlStart;
+  for (unsigned j = urlStart; j + 6 <= urlEnd; ++j) {
+    if (_strncasecmp(&fRequest[j], "rtsp:/", 6) == 0) {
+      j += 6;
+      if (j < urlEnd && fRequest[j] == '/') {
+	// This is a "rtsp://" URL; skip over the host:port part that follows (and the '/' after it):
+	++j;
+	while (j < urlEnd && fRequest[j] != '/') ++j;
+	if (j < urlEnd) ++j;
+      }
+      pathStart = j;
+      break;
+    }
+  }
+
+  // The URL suffix is the part of the path after its last '/'; the 'pre-suffix' is the part before this '/':
+  unsigned lastSlash = urlEnd;
+  while (lastSlash > pathStart && fRequest[lastSlash-1] != '/') --lastSlash;
+  if (lastSlash > pathStart) {
+    setField(fURLPreSuffix, pathStart, lastSlash-1);
+    setField(fURLSuffix, lastSlash, urlEnd);
+  } else {
+    setField(fURLPreSuffix, pathStart, pathStart);
+    setField(fURLSuffix, pathStart, urlEnd);
+  }
+}
+
+void RTSPRequestParser::handleHeaderLine(unsigned lineStart, unsigned lineEnd) {
+  if (isWhitespace(fRequest[lineStart])) return; // a continuation of the previous header; we ignore it
+
+  // The header is "<name>:<value>":
+  char const* colon = (char const*)memchr(&fRequest[lineStart], ':', lineEnd - lineStart);
+  if (colon == NULL) return; // not a valid header; ignore it
+  unsigned nameEnd = colon - fRequest;
+  unsigned valueStart = nameEnd + 1;
+  while (nameEnd > lineStart && isWhitespace(fRequest[nameEnd-1])) --nameEnd;
+  while (valueStart < lineEnd && isWhitespace(fRequest[valueStart])) ++valueStart;
+  unsigned valueEnd = lineEnd;
+  while (valueEnd > valueStart && isWhitespace(fRequest[valueEnd-1])) --valueEnd;
+
+  Field value;
+  setField(value, valueStart, valueEnd);
+  if (fNumHeaders < RTSP_REQUEST_PARSER_MAX_NUM_HEADERS) {
+    setField(fHeaders[fNumHeaders].name, lineStart, nameEnd);
+    fHeaders[fNumHeaders].value = value;
+    ++fNumHeaders;
+  }
+
+  // Check for the headers that we parse ourself:
+  char const* name = &fRequest[lineStart];
+  unsigned nameLength = nameEnd - lineStart;
+  if (headerNameIs(name, nameLength, "CSeq")) {
+    if (!fCSeq.isPresent) fCSeq = value;
+  } else if (headerNameIs(name, nameLength, "Session")) {
+    if (!fSessionId.isPresent) fSessionId = value;
+  } else if (headerNameIs(name, nameLength, "Content-Length")) {
+    unsigned contentLength = 0;
+    for (unsigned i = valueStart; i < valueEnd && fRequest[i] >= '0' && fRequest[i] <= '9'; ++i) {
+      contentLength = 10*contentLength + (fRequest[i] - '0');
+    }
+    fContentLength = contentLength;
+  }
+}
@@ -29,8 +29,8 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 RTSPServer*
 RTSPServer::createNew(UsageEnvironment& env, Port ourPort,
 		      UserAuthenticationDatabase* authDatabase,
-		      unsigned reclamationSeconds) {
-  int ourSocket = setUpOurSocket(env, ourPort);
+		      unsigned reclamationSeconds, Boolean reusePort) {
+  int ourSocket = setUpOurSocket(env, ourPort, reusePort);
   if (ourSocket == -1) return NULL;
   
   return new RTSPServer(env, ourSocket, ourPort, authDatabase, reclamationSeconds);
@@ -272,11 +272,18 @@ RTSPServer::RTSPClientConnection
 ::RTSPClientConnection(RTSPServer& ourServer, int clientSocket, struct sockaddr_in clientAddr)
   : GenericMediaServer::ClientConnection(ourServer, clientSocket, clientAddr),
     fOurRTSPServer(ourServer), fClientInputSocket(fOurSocket), fClientOutputSocket(fOurSocket),
-    fIsActive(True), fRecursionCount(0), fOurSessionCookie(NULL) {
+    fIsActive(True), fRecursionCount(0), fLookupIsPending(False), fResponseIsPending(False), fPendingCSeq(NULL),
+    fOurSessionCookie(NULL) {
   resetRequestBuffer();
 }
 
 RTSPServer::RTSPClientConnection::~RTSPClientConnection() {
+  if (fLookupIsPending) {
+    // Make sure that our server doesn't try to complete the lookup after we've gone:
+    fOurServer.cancelLookupServerMediaSession(DESCRIBELookupCompletionFunction, this);
+  }
+  delete[] fPendingCSeq;
+
   if (fOurSessionCookie != NULL) {
     // We were being used for RTSP-over-HTTP tunneling. Also remove ourselves from the 'session cookie' hash table before we go:
     fOurRTSPServer.fClientConnectionsForHTTPTunneling->Remove(fOurSessionCookie);
@@ -289,7 +296,7 @@ RTSPServer::RTSPClientConnection::~RTSPClientConnection() {
 // Handler routines for specific RTSP commands:
 
 void RTSPServer::RTSPClientConnection::handleCmd_OPTIONS() {
-  snprintf((char*)fResponseBuffer, sizeof fResponseBuffer,
+  snprintf((char*)fResponseBuffer, fResponseBufferSize,
 	   "RTSP/1.0 200 OK\r\nCSeq: %s\r\n%sPublic: %s\r\n\r\n",
 	   fCurrentCSeq, dateHeader(), fOurRTSPServer.allowedCommandNames());
 }
@@ -312,26 +319,41 @@ void RTSPServer::RTSPClientConnection
 
 void RTSPServer::RTSPClientConnection
 ::handleCmd_DESCRIBE(char const* urlPreSuffix, char const* urlSuffix, char const* fullRequestStr) {
-  ServerMediaSession* session = NULL;
+  char urlTotalSuffix[2*RTSP_PARAM_STRING_MAX];
+      // enough space for urlPreSuffix/urlSuffix'\0'
+  urlTotalSuffix[0] = '\0';
+  if (urlPreSuffix[0] != '\0') {
+    strcat(urlTotalSuffix, urlPreSuffix);
+    strcat(urlTotalSuffix, "/");
+  }
+  strcat(urlTotalSuffix, urlSuffix);
+  
+  if (!authenticationOK("DESCRIBE", urlTotalSuffix, fullRequestStr)) return;
+  
+  // We should really check that the request contains an "Accept:" #####
+  // for "application/sdp", because that's what we're sending back #####
+  
+  // Begin by looking up the "ServerMediaSession" object for the specified "urlTotalSuffix".
+  // (Our server might not be able to do this immediately - e.g., if it first has to read the file - in which case
+  //  we respond later, when the lookup completes.)
+  fLookupIsPending = True;
+  fOurServer.lookupServerMediaSession(urlTotalSuffix, DESCRIBELookupCompletionFunction, this);
+  if (fLookupIsPending) deferResponse();
+}
+
+void RTSPServer::RTSPClientConnection
+::DESCRIBELookupCompletionFunction(void* clientData, ServerMediaSession* sessionLookedUp) {
+  RTSPClientConnection* connection = (RTSPClientConnection*)clientData;
+  connection->fLookupIsPending = False;
+  connection->handleCmd_DESCRIBE_afterLookup(sessionLookedUp);
+
+  if (connection->fResponseIsPending) connection->sendDeferredResponse();
+}
+
+void RTSPServer::RTSPClientConnection::handleCmd_DESCRIBE_afterLookup(ServerMediaSession* session) {
   char* sdpDescription = NULL;
   char* rtspURL = NULL;
   do {
-    char urlTotalSuffix[2*RTSP_PARAM_STRING_MAX];
-        // enough space for urlPreSuffix/urlSuffix'\0'
-    urlTotalSuffix[0] = '\0';
-    if (urlPreSuffix[0] != '\0') {
-      strcat(urlTotalSuffix, urlPreSuffix);
-      strcat(urlTotalSuffix, "/");
-    }
-    strcat(urlTotalSuffix, urlSuffix);
-    
-    if (!authenticationOK("DESCRIBE", urlTotalSuffix, fullRequestStr)) break;
-    
-    // We should really check that the request contains an "Accept:" #####
-    // for "application/sdp", because that's what we're sending back #####
-    
-    // Begin by looking up the "ServerMediaSession" object for the specified "urlTotalSuffix":
-    session = fOurServer.lookupServerMediaSession(urlTotalSuffix);
     if (session == NULL) {
       handleCmd_notFound();
       break;
@@ -355,7 +377,7 @@ void RTSPServer::RTSPClientConnection
     // (which is necessary to ensure that the correct URL gets used in subsequent "SETUP" requests).
     rtspURL = fOurRTSPServer.rtspURL(session, fClientInputSocket);
     
-    snprintf((char*)fResponseBuffer, sizeof fResponseBuffer,
+    snprintf((char*)fResponseBuffer, fResponseBufferSize,
 	     "RTSP/1.0 200 OK\r\nCSeq: %s\r\n"
 	     "%s"
 	     "Content-Base: %s/\r\n"
@@ -405,13 +427,13 @@ static void lookForHeader(char const* headerName, char const* source, unsigned s
 
 void RTSPServer::RTSPClientConnection::handleCmd_bad() {
   // Don't do anything with "fCurrentCSeq", because it might be nonsense
-  snprintf((char*)fResponseBuffer, sizeof fResponseBuffer,
+  snprintf((char*)fResponseBuffer, fResponseBufferSize,
 	   "RTSP/1.0 400 Bad Request\r\n%sAllow: %s\r\n\r\n",
 	   dateHeader(), fOurRTSPServer.allowedCommandNames());
 }
 
 void RTSPServer::RTSPClientConnection::handleCmd_notSupported() {
-  snprintf((char*)fResponseBuffer, sizeof fResponseBuffer,
+  snprintf((char*)fResponseBuffer, fResponseBufferSize,
 	   "RTSP/1.0 405 Method Not Allowed\r\nCSeq: %s\r\n%sAllow: %s\r\n\r\n",
 	   fCurrentCSeq, dateHeader(), fOurRTSPServer.allowedCommandNames());
 }
@@ -482,13 +504,13 @@ Boolean RTSPServer::RTSPClientConnection::parseHTTPRequestString(char* resultCmd
 }
 
 void RTSPServer::RTSPClientConnection::handleHTTPCmd_notSupported() {
-  snprintf((char*)fResponseBuffer, sizeof fResponseBuffer,
+  snprintf((char*)fResponseBuffer, fResponseBufferSize,
 	   "HTTP/1.1 405 Method Not Allowed\r\n%s\r\n\r\n",
 	   dateHeader());
 }
 
 void RTSPServer::RTSPClientConnection::handleHTTPCmd_notFound() {
-  snprintf((char*)fResponseBuffer, sizeof fResponseBuffer,
+  snprintf((char*)fResponseBuffer, fResponseBufferSize,
 	   "HTTP/1.1 404 Not Found\r\n%s\r\n\r\n",
 	   dateHeader());
 }
@@ -498,7 +520,7 @@ void RTSPServer::RTSPClientConnection::handleHTTPCmd_OPTIONS() {
   fprintf(stderr, "Handled HTTP \"OPTIONS\" request\n");
 #endif
   // Construct a response to the "OPTIONS" command that notes that our special headers (for RTSP-over-HTTP tunneling) are allowed:
-  snprintf((char*)fResponseBuffer, sizeof fResponseBuffer,
+  snprintf((char*)fResponseBuffer, fResponseBufferSize,
 	   "HTTP/1.1 200 OK\r\n"
 	   "%s"
 	   "Access-Control-Allow-Origin: *\r\n"
@@ -522,7 +544,7 @@ void RTSPServer::RTSPClientConnection::handleHTTPCmd_TunnelingGET(char const* se
 #endif
   
   // Construct our response:
-  snprintf((char*)fResponseBuffer, sizeof fResponseBuffer,
+  snprintf((char*)fResponseBuffer, fResponseBufferSize,
 	   "HTTP/1.1 200 OK\r\n"
 	   "%s"
 	   "Cache-Control: no-cache\r\n"
@@ -565,13 +587,15 @@ void RTSPServer::RTSPClientConnection::handleHTTPCmd_StreamingGET(char const* /*
 void RTSPServer::RTSPClientConnection::resetRequestBuffer() {
   ClientConnection::resetRequestBuffer();
   
-  fLastCRLF = &fRequestBuffer[-3]; // hack: Ensures that we don't think we have end-of-msg if the data starts with <CR><LF>
+  fRequestParser.reset();
   fBase64RemainderCount = 0;
 }
 
 void RTSPServer::RTSPClientConnection::closeSocketsRTSP() {
   // First, tell our server to stop any streaming that it might be doing over our output socket:
   fOurRTSPServer.stopTCPStreamingOnSocket(fClientOutputSocket);
+  // (and to stop sending any RTP/RTCP data that might still be queued for it):
+  RTPInterface::clearServerRequestAlternativeByteHandler(envir(), fClientOutputSocket);
 
   // Turn off background handling on our input socket (and output socket, if different); then close it (or them):
   if (fClientOutputSocket != fClientInputSocket) {
@@ -598,14 +622,19 @@ void RTSPServer::RTSPClientConnection::handleAlternativeRequestByte1(u_int8_t re
 						  incomingRequestHandler, this);
   } else {
     // Normal case: Add this character to our buffer; then try to handle the data that we have buffered so far:
-    if (fRequestBufferBytesLeft == 0 || fRequestBytesAlreadySeen >= REQUEST_BUFFER_SIZE) return;
+    (void)ensureRequestBufferSpace(1);
+    if (fRequestBufferBytesLeft == 0 || fRequestBytesAlreadySeen >= fRequestBufferSize) return;
     fRequestBuffer[fRequestBytesAlreadySeen] = requestByte;
     handleRequestBytes(1);
   }
 }
 
 void RTSPServer::RTSPClientConnection::handleRequestBytes(int newBytesRead) {
-  int numBytesRemaining = 0;
+  handleRequestBytes1(newBytesRead, False);
+}
+
+void RTSPServer::RTSPClientConnection::handleRequestBytes1(int newBytesRead, Boolean newBytesAreDecoded) {
+  int numBytesRemaining = newBytesAreDecoded ? newBytesRead : 0;
   ++fRecursionCount;
   
   do {
@@ -621,7 +650,6 @@ void RTSPServer::RTSPClientConnection::handleRequestBytes(int newBytesRead) {
       break;
     }
     
-    Boolean endOfMsg = False;
     unsigned char* ptr = &fRequestBuffer[fRequestBytesAlreadySeen];
 #ifdef DEBUG
     ptr[newBytesRead] = '\0';
@@ -670,52 +698,41 @@ void RTSPServer::RTSPClientConnection::handleRequestBytes(int newBytesRead) {
       fBase64RemainderCount = newBase64RemainderCount;
     }
     
-    unsigned char* tmpPtr = fLastCRLF + 2;
-    if (fBase64RemainderCount == 0) { // no more Base-64 bytes remain to be read/decoded
-      // Look for the end of the message: <CR><LF><CR><LF>
-      if (tmpPtr < fRequestBuffer) tmpPtr = fRequestBuffer;
-      while (tmpPtr < &ptr[newBytesRead-1]) {
-	if (*tmpPtr == '\r' && *(tmpPtr+1) == '\n') {
-	  if (tmpPtr - fLastCRLF == 2) { // This is it:
-	    endOfMsg = True;
-	    break;
-	  }
-	  fLastCRLF = tmpPtr;
-	}
-	++tmpPtr;
-      }
-    }
-    
     fRequestBufferBytesLeft -= newBytesRead;
     fRequestBytesAlreadySeen += newBytesRead;
     
-    if (!endOfMsg) break; // subsequent reads will be needed to complete the request
+    // If we haven't yet responded to an earlier request, then we can't handle any new request until we have.
+    // We just keep the new data in our buffer until then:
+    if (fResponseIsPending) break;
+
+    // Parse the new data (continuing from where we left off).  The request is complete once we've seen the
+    // <CR><LF><CR><LF> at the end of its headers (and then any body specified by a "Content-Length:" header):
+    if (fBase64RemainderCount > 0) break; // more Base-64 bytes remain to be read/decoded
+    if (!fRequestParser.parse((char const*)fRequestBuffer, fRequestBytesAlreadySeen)) break;
+        // subsequent reads will be needed to complete the request
     
-    // Parse the request string into command name and 'CSeq', then handle the command:
+    // We now have a complete request.
+    // Get its command name, URL and 'CSeq' (these are the only fields that we copy, because the command handlers
+    // expect '\0'-terminated strings), then handle the command:
     fRequestBuffer[fRequestBytesAlreadySeen] = '\0';
+    getResponseBuffer();
     char cmdName[RTSP_PARAM_STRING_MAX];
     char urlPreSuffix[RTSP_PARAM_STRING_MAX];
     char urlSuffix[RTSP_PARAM_STRING_MAX];
     char cseq[RTSP_PARAM_STRING_MAX];
     char sessionIdStr[RTSP_PARAM_STRING_MAX];
-    unsigned contentLength = 0;
-    fLastCRLF[2] = '\0'; // temporarily, for parsing
-    Boolean parseSucceeded = parseRTSPRequestString((char*)fRequestBuffer, fLastCRLF+2 - fRequestBuffer,
-						    cmdName, sizeof cmdName,
-						    urlPreSuffix, sizeof urlPreSuffix,
-						    urlSuffix, sizeof urlSuffix,
-						    cseq, sizeof cseq,
-						    sessionIdStr, sizeof sessionIdStr,
-						    contentLength);
-    fLastCRLF[2] = '\r'; // restore its value
+    Boolean parseSucceeded = fRequestParser.isRTSPRequest()
+      && fRequestParser.cmdName().copyTo(cmdName, sizeof cmdName)
+      && fRequestParser.urlPreSuffix().copyTo(urlPreSuffix, sizeof urlPreSuffix)
+      && fRequestParser.urlSuffix().copyTo(urlSuffix, sizeof urlSuffix)
+      && fRequestParser.cseq().copyTo(cseq, sizeof cseq);
+    (void)fRequestParser.sessionId().copyTo(sessionIdStr, sizeof sessionIdStr);
     Boolean playAfterSetup = False;
     if (parseSucceeded) {
+      decodeURL(urlPreSuffix);
 #ifdef DEBUG
-      fprintf(stderr, "parseRTSPRequestString() succeeded, returning cmdName \"%s\", urlPreSuffix \"%s\", urlSuffix \"%s\", CSeq \"%s\", Content-Length %u, with %d bytes following the message.\n", cmdName, urlPreSuffix, urlSuffix, cseq, contentLength, ptr + newBytesRead - (tmpPtr + 2));
+      fprintf(stderr, "parsed RTSP request, with cmdName \"%s\", urlPreSuffix \"%s\", urlSuffix \"%s\", CSeq \"%s\", Content-Length %u, with %d bytes following the message.\n", cmdName, urlPreSuffix, urlSuffix, cseq, fRequestParser.contentLength(), fRequestBytesAlreadySeen - fRequestParser.requestSize());
 #endif
-      // If there was a "Content-Length:" header, then make sure we've received all of the data that it specified:
-      if (ptr + newBytesRead < tmpPtr + 2 + contentLength) break; // we still need more data; subsequent reads will give it to us 
-      
       // If the request included a "Session:" id, and it refers to a client session that's
       // current ongoing, then use this command to indicate 'liveness' on that client session:
       Boolean const requestIncludedSessionId = sessionIdStr[0] != '\0';
@@ -809,17 +826,19 @@ void RTSPServer::RTSPClientConnection::handleRequestBytes(int newBytesRead) {
       }
     } else {
 #ifdef DEBUG
-      fprintf(stderr, "parseRTSPRequestString() failed; checking now for HTTP commands (for RTSP-over-HTTP tunneling)...\n");
+      fprintf(stderr, "RTSP request parsing failed; checking now for HTTP commands (for RTSP-over-HTTP tunneling)...\n");
 #endif
       // The request was not (valid) RTSP, but check for a special case: HTTP commands (for setting up RTSP-over-HTTP tunneling):
       char sessionCookie[RTSP_PARAM_STRING_MAX];
       char acceptStr[RTSP_PARAM_STRING_MAX];
-      *fLastCRLF = '\0'; // temporarily, for parsing
+      unsigned char* endOfHeaderLines = &fRequestBuffer[fRequestParser.endOfHeaderLines()];
+      unsigned char savedChar = *endOfHeaderLines;
+      *endOfHeaderLines = '\0'; // temporarily, for parsing
       parseSucceeded = parseHTTPRequestString(cmdName, sizeof cmdName,
 					      urlSuffix, sizeof urlPreSuffix,
 					      sessionCookie, sizeof sessionCookie,
 					      acceptStr, sizeof acceptStr);
-      *fLastCRLF = '\r';
+      *endOfHeaderLines = savedChar;
       if (parseSucceeded) {
 #ifdef DEBUG
 	fprintf(stderr, "parseHTTPRequestString() succeeded, returning cmdName \"%s\", urlSuffix \"%s\", sessionCookie \"%s\", acceptStr \"%s\"\n", cmdName, urlSuffix, sessionCookie, acceptStr);
@@ -841,7 +860,7 @@ void RTSPServer::RTSPClientConnection::handleRequestBytes(int newBytesRead) {
 	} else if (strcmp(cmdName, "POST") == 0) {
 	  // We might have received additional data following the HTTP "POST" command - i.e., the first Base64-encoded RTSP command.
 	  // Check for this, and handle it if it exists:
-	  unsigned char const* extraData = fLastCRLF+4;
+	  unsigned char const* extraData = &fRequestBuffer[fRequestParser.headerSize()];
 	  unsigned extraDataSize = &fRequestBuffer[fRequestBytesAlreadySeen] - extraData;
 	  if (handleHTTPCmd_TunnelingPOST(sessionCookie, extraData, extraDataSize)) {
 	    // We don't respond to the "POST" command, and we go away:
@@ -862,10 +881,13 @@ void RTSPServer::RTSPClientConnection::handleRequestBytes(int newBytesRead) {
       }
     }
     
+    if (fResponseIsPending) break; // we'll send the response (and handle any further requests) later
+
 #ifdef DEBUG
     fprintf(stderr, "sending response: %s", fResponseBuffer);
 #endif
-    send(fClientOutputSocket, (char const*)fResponseBuffer, strlen((char*)fResponseBuffer), 0);
+    RTPInterface::sendDataOverStreamSocket(envir(), fClientOutputSocket, fResponseBuffer, strlen((char*)fResponseBuffer));
+        // (rather than "send()", in case we're also streaming RTP/RTCP-over-TCP on this connection)
     
     if (playAfterSetup) {
       // The client has asked for streaming to commence now, rather than after a
@@ -875,7 +897,7 @@ void RTSPServer::RTSPClientConnection::handleRequestBytes(int newBytesRead) {
     
     // Check whether there are extra bytes remaining in the buffer, after the end of the request (a rare case).
     // If so, move them to the front of our buffer, and keep processing it, because it might be a following, pipelined request.
-    unsigned requestSize = (fLastCRLF+4-fRequestBuffer) + contentLength;
+    unsigned requestSize = fRequestParser.requestSize();
     numBytesRemaining = fRequestBytesAlreadySeen - requestSize;
     resetRequestBuffer(); // to prepare for any subsequent request
     
@@ -891,6 +913,43 @@ void RTSPServer::RTSPClientConnection::handleRequestBytes(int newBytesRead) {
     // Note: The "fRecursionCount" test is for a pathological situation where we reenter the event loop and get called recursively
     // while handling a command (e.g., while handling a "DESCRIBE", to get a SDP description).
     // In such a case we don't want to actually delete ourself until we leave the outermost call.
+  } else if (fRecursionCount == 0 && !fResponseIsPending) {
+    // We've finished handling requests (for now), so return our buffers to our server's pool.
+    // (The request buffer is kept, however, if it contains a partial request.)
+    releaseResponseBuffer();
+    releaseRequestBuffer();
+  }
+}
+
+void RTSPServer::RTSPClientConnection::deferResponse() {
+  // Our response to the current request will be sent later, by "sendDeferredResponse()".
+  // Until then, we need our own copy of the request's 'CSeq':
+  fResponseIsPending = True;
+  delete[] fPendingCSeq; fPendingCSeq = strDup(fCurrentCSeq);
+  fCurrentCSeq = fPendingCSeq;
+}
+
+void RTSPServer::RTSPClientConnection::sendDeferredResponse() {
+  fResponseIsPending = False;
+#ifdef DEBUG
+  fprintf(stderr, "sending deferred response: %s", fResponseBuffer);
+#endif
+  RTPInterface::sendDataOverStreamSocket(envir(), fClientOutputSocket, fResponseBuffer, strlen((char*)fResponseBuffer));
+  fCurrentCSeq = NULL;
+  delete[] fPendingCSeq; fPendingCSeq = NULL;
+
+  // Then handle any data that arrived (or was pipelined) after the request, as "handleRequestBytes()" would have done.
+  // (This data has already been Base64-decoded, if we're doing RTSP-over-HTTP tunneling.)
+  unsigned requestSize = fRequestParser.requestSize();
+  unsigned numBytesRemaining = fRequestBytesAlreadySeen - requestSize;
+  resetRequestBuffer();
+  
+  if (numBytesRemaining > 0) {
+    memmove(fRequestBuffer, &fRequestBuffer[requestSize], numBytesRemaining);
+    handleRequestBytes1(numBytesRemaining, True);
+  } else if (fRecursionCount == 0) {
+    releaseResponseBuffer();
+    releaseRequestBuffer();
   }
 }
 
@@ -1009,7 +1068,7 @@ Boolean RTSPServer::RTSPClientConnection
   // If we get here, we failed to authenticate the user.
   // Send back a "401 Unauthorized" response, with a new random nonce:
   fCurrentAuthenticator.setRealmAndRandomNonce(authDB->realm());
-  snprintf((char*)fResponseBuffer, sizeof fResponseBuffer,
+  snprintf((char*)fResponseBuffer, fResponseBufferSize,
 	   "RTSP/1.0 401 Unauthorized\r\n"
 	   "CSeq: %s\r\n"
 	   "%s"
@@ -1022,7 +1081,7 @@ Boolean RTSPServer::RTSPClientConnection
 
 void RTSPServer::RTSPClientConnection
 ::setRTSPResponse(char const* responseStr) {
-  snprintf((char*)fResponseBuffer, sizeof fResponseBuffer,
+  snprintf((char*)fResponseBuffer, fResponseBufferSize,
 	   "RTSP/1.0 %s\r\n"
 	   "CSeq: %s\r\n"
 	   "%s\r\n",
@@ -1033,7 +1092,7 @@ void RTSPServer::RTSPClientConnection
 
 void RTSPServer::RTSPClientConnection
 ::setRTSPResponse(char const* responseStr, u_int32_t sessionId) {
-  snprintf((char*)fResponseBuffer, sizeof fResponseBuffer,
+  snprintf((char*)fResponseBuffer, fResponseBufferSize,
 	   "RTSP/1.0 %s\r\n"
 	   "CSeq: %s\r\n"
 	   "%s"
@@ -1049,7 +1108,7 @@ void RTSPServer::RTSPClientConnection
   if (contentStr == NULL) contentStr = "";
   unsigned const contentLen = strlen(contentStr);
   
-  snprintf((char*)fResponseBuffer, sizeof fResponseBuffer,
+  snprintf((char*)fResponseBuffer, fResponseBufferSize,
 	   "RTSP/1.0 %s\r\n"
 	   "CSeq: %s\r\n"
 	   "%s"
@@ -1067,7 +1126,7 @@ void RTSPServer::RTSPClientConnection
   if (contentStr == NULL) contentStr = "";
   unsigned const contentLen = strlen(contentStr);
   
-  snprintf((char*)fResponseBuffer, sizeof fResponseBuffer,
+  snprintf((char*)fResponseBuffer, fResponseBufferSize,
 	   "RTSP/1.0 %s\r\n"
 	   "CSeq: %s\r\n"
 	   "%s"
@@ -1090,6 +1149,7 @@ void RTSPServer::RTSPClientConnection
 						incomingRequestHandler, this);
   
   // Also write any extra data to our buffer, and handle it:
+  (void)ensureRequestBufferSpace(extraDataSize);
   if (extraDataSize > 0 && extraDataSize <= fRequestBufferBytesLeft/*sanity check; should always be true*/) {
     unsigned char* ptr = &fRequestBuffer[fRequestBytesAlreadySeen];
     for (unsigned i = 0; i < extraDataSize; ++i) {
@@ -1415,7 +1475,7 @@ void RTSPServer::RTSPClientSession
     if (fIsMulticast) {
       switch (streamingMode) {
           case RTP_UDP: {
-	    snprintf((char*)ourClientConnection->fResponseBuffer, sizeof ourClientConnection->fResponseBuffer,
+	    snprintf((char*)ourClientConnection->fResponseBuffer, ourClientConnection->fResponseBufferSize,
 		     "RTSP/1.0 200 OK\r\n"
 		     "CSeq: %s\r\n"
 		     "%s"
@@ -1433,7 +1493,7 @@ void RTSPServer::RTSPClientSession
 	    break;
 	  }
           case RAW_UDP: {
-	    snprintf((char*)ourClientConnection->fResponseBuffer, sizeof ourClientConnection->fResponseBuffer,
+	    snprintf((char*)ourClientConnection->fResponseBuffer, ourClientConnection->fResponseBufferSize,
 		     "RTSP/1.0 200 OK\r\n"
 		     "CSeq: %s\r\n"
 		     "%s"
@@ -1449,7 +1509,7 @@ void RTSPServer::RTSPClientSession
     } else {
       switch (streamingMode) {
           case RTP_UDP: {
-	    snprintf((char*)ourClientConnection->fResponseBuffer, sizeof ourClientConnection->fResponseBuffer,
+	    snprintf((char*)ourClientConnection->fResponseBuffer, ourClientConnection->fResponseBufferSize,
 		     "RTSP/1.0 200 OK\r\n"
 		     "CSeq: %s\r\n"
 		     "%s"
@@ -1465,7 +1525,7 @@ void RTSPServer::RTSPClientSession
 	    if (!fOurRTSPServer.fAllowStreamingRTPOverTCP) {
 	      ourClientConnection->handleCmd_unsupportedTransport();
 	    } else {
-	      snprintf((char*)ourClientConnection->fResponseBuffer, sizeof ourClientConnection->fResponseBuffer,
+	      snprintf((char*)ourClientConnection->fResponseBuffer, ourClientConnection->fResponseBufferSize,
 		       "RTSP/1.0 200 OK\r\n"
 		       "CSeq: %s\r\n"
 		       "%s"
@@ -1479,7 +1539,7 @@ void RTSPServer::RTSPClientSession
 	    break;
 	  }
           case RAW_UDP: {
-	    snprintf((char*)ourClientConnection->fResponseBuffer, sizeof ourClientConnection->fResponseBuffer,
+	    snprintf((char*)ourClientConnection->fResponseBuffer, ourClientConnection->fResponseBufferSize,
 		     "RTSP/1.0 200 OK\r\n"
 		     "CSeq: %s\r\n"
 		     "%s"
@@ -1782,7 +1842,7 @@ void RTSPServer::RTSPClientSession
   }
   
   // Fill in the response:
-  snprintf((char*)ourClientConnection->fResponseBuffer, sizeof ourClientConnection->fResponseBuffer,
+  snprintf((char*)ourClientConnection->fResponseBuffer, ourClientConnection->fResponseBufferSize,
 	   "RTSP/1.0 200 OK\r\n"
 	   "CSeq: %s\r\n"
 	   "%s"
@@ -28,8 +28,9 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 
 RTSPServerSupportingHTTPStreaming*
 RTSPServerSupportingHTTPStreaming::createNew(UsageEnvironment& env, Port rtspPort,
-					     UserAuthenticationDatabase* authDatabase, unsigned reclamationTestSeconds) {
-  int ourSocket = setUpOurSocket(env, rtspPort);
+					     UserAuthenticationDatabase* authDatabase, unsigned reclamationTestSeconds,
+					     Boolean reusePort) {
+  int ourSocket = setUpOurSocket(env, rtspPort, reusePort);
   if (ourSocket == -1) return NULL;
 
   return new RTSPServerSupportingHTTPStreaming(env, ourSocket, rtspPort, authDatabase, reclamationTestSeconds);
@@ -129,7 +130,7 @@ void RTSPServerSupportingHTTPStreaming::RTSPClientConnectionSupportingHTTPStream
       }
       
       // Construct our response:
-      snprintf((char*)fResponseBuffer, sizeof fResponseBuffer,
+      snprintf((char*)fResponseBuffer, fResponseBufferSize,
 	       "HTTP/1.1 200 OK\r\n"
 	       "%s"
 	       "Server: LIVE555 Streaming Media v%s\r\n"
@@ -226,7 +227,7 @@ void RTSPServerSupportingHTTPStreaming::RTSPClientConnectionSupportingHTTPStream
   unsigned playlistLen = s - playlist;
 
   // Construct our response:
-  snprintf((char*)fResponseBuffer, sizeof fResponseBuffer,
+  snprintf((char*)fResponseBuffer, fResponseBufferSize,
 	   "HTTP/1.1 200 OK\r\n"
 	   "%s"
 	   "Server: LIVE555 Streaming Media v%s\r\n"
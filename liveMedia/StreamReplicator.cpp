@@ -30,10 +30,11 @@ protected:
 
 private: // redefined virtual functions:
   virtual void doGetNextFrame();
+  virtual void doGetNextFrameRef();
   virtual void doStopGettingFrames();
 
 private:
-  static void copyReceivedFrame(StreamReplica* toReplica, StreamReplica* fromReplica);
+  static void copyReceivedFrame(StreamReplica* toReplica, StreamReplica* fromReplica, unsigned char const* fromData);
 
 private:
   StreamReplicator& fOurReplicator;
@@ -54,10 +55,12 @@ StreamReplicator::StreamReplicator(UsageEnvironment& env, FramedSource* inputSou
   : Medium(env),
     fInputSource(inputSource), fDeleteWhenLastReplicaDies(deleteWhenLastReplicaDies), fInputSourceHasClosed(False),
     fNumReplicas(0), fNumActiveReplicas(0), fNumDeliveriesMadeSoFar(0),
-    fFrameIndex(0), fMasterReplica(NULL), fReplicasAwaitingCurrentFrame(NULL), fReplicasAwaitingNextFrame(NULL) {
+    fFrameIndex(0), fIsDeliveringToReplicas(False),
+    fMasterReplica(NULL), fReplicasAwaitingCurrentFrame(NULL), fReplicasAwaitingNextFrame(NULL), fCurrentFrame(NULL) {
 }
 
 StreamReplicator::~StreamReplicator() {
+  releaseCurrentFrame();
   Medium::close(fInputSource);
 }
 
@@ -84,8 +87,7 @@ void StreamReplicator::getNextFrame(StreamReplica* replica) {
     fMasterReplica = replica;
 
     // Arrange to read the next frame into this replica's buffer:
-    if (fInputSource != NULL) fInputSource->getNextFrame(fMasterReplica->fTo, fMasterReplica->fMaxSize,
-							 afterGettingFrame, this, onSourceClosure, this);
+    readNextFrame();
   } else if (replica->fFrameIndex != fFrameIndex) {
     // This replica is already asking for the next frame (because it has already received the current frame).  Enqueue it:
     replica->fNext = fReplicasAwaitingNextFrame;
@@ -134,17 +136,21 @@ void StreamReplicator::deactivateStreamReplica(StreamReplica* replicaBeingDeacti
 	// We need to stop it, and retry the read with a new master (if available)
 	fInputSource->stopGettingFrames();
 
-	if (fMasterReplica != NULL) {
-	  fInputSource->getNextFrame(fMasterReplica->fTo, fMasterReplica->fMaxSize,
-				     afterGettingFrame, this, onSourceClosure, this);
-	}
+	releaseCurrentFrame();
+	if (fMasterReplica != NULL) readNextFrame();
       } else {
 	// The read into the old master replica's buffer has already completed.  Copy the data to the new master replica (if any):
 	if (fMasterReplica != NULL) {
-	  StreamReplica::copyReceivedFrame(fMasterReplica, replicaBeingDeactivated);
+	  if (fCurrentFrame == NULL && fMasterReplica->fIsReadingFrameRef) {
+	    // The new master replica wants a shared frame, so make one now, while the old master replica's buffer is still valid:
+	    makeCurrentFrame(replicaBeingDeactivated);
+	  }
+	  StreamReplica::copyReceivedFrame(fMasterReplica, replicaBeingDeactivated,
+					   fCurrentFrame != NULL ? fCurrentFrame->fData : replicaBeingDeactivated->fTo);
 	} else {
 	  // We don't have a new master replica, so we can't copy the received frame to any new replica that might ask for it.
 	  // Fortunately this should be a very rare occurrence.
+	  releaseCurrentFrame();
 	}
       }
     }
@@ -183,8 +189,10 @@ void StreamReplicator::deactivateStreamReplica(StreamReplica* replicaBeingDeacti
 
     // Check for the possibility that - now that a replica has been deactivated - all other
     // replicas have received the current frame, and so now we need to complete delivery to
-    // the master replica:
-    if (fMasterReplica != NULL && fInputSource != NULL && !fInputSource->isCurrentlyAwaitingData()) deliverReceivedFrame();
+    // the master replica.  (But if this replica was deactivated from within its own delivery (in "deliverReceivedFrame()"),
+    // then "deliverReceivedFrame()" will itself do this check when it's done, so we mustn't call it again, recursively.)
+    if (fMasterReplica != NULL && fInputSource != NULL && !fInputSource->isCurrentlyAwaitingData()
+	&& !fIsDeliveringToReplicas) deliverReceivedFrame();
   }
 
   if (fNumActiveReplicas == 0 && fInputSource != NULL) fInputSource->stopGettingFrames(); // tell our source to stop too
@@ -218,6 +226,12 @@ void StreamReplicator::afterGettingFrame(unsigned frameSize, unsigned numTruncat
   fMasterReplica->fNumTruncatedBytes = numTruncatedBytes;
   fMasterReplica->fPresentationTime = presentationTime;
   fMasterReplica->fDurationInMicroseconds = durationInMicroseconds;
+  if (fCurrentFrame != NULL) {
+    fCurrentFrame->fFrameSize = frameSize;
+    fCurrentFrame->fNumTruncatedBytes = numTruncatedBytes;
+    fCurrentFrame->fPresentationTime = presentationTime;
+    fCurrentFrame->fDurationInMicroseconds = durationInMicroseconds;
+  }
 
   deliverReceivedFrame();
 }
@@ -228,6 +242,7 @@ void StreamReplicator::onSourceClosure(void* clientData) {
 
 void StreamReplicator::onSourceClosure() {
   fInputSourceHasClosed = True;
+  releaseCurrentFrame();
 
   // Signal the closure to each replica that is currently awaiting a frame:
   StreamReplica* replica;
@@ -252,13 +267,22 @@ void StreamReplicator::deliverReceivedFrame() {
   // Copy it (and complete delivery) to any other replica that has requested this frame.
   // Then, if no more requests for this frame are expected, complete delivery to the 'master replica' itself.
   StreamReplica* replica;
+  fIsDeliveringToReplicas = True;
   while ((replica = fReplicasAwaitingCurrentFrame) != NULL) {
     fReplicasAwaitingCurrentFrame = replica->fNext;
     replica->fNext = NULL;
     
     // Assert: fMasterReplica != NULL
     if (fMasterReplica == NULL) fprintf(stderr, "StreamReplicator::deliverReceivedFrame() Internal Error 1!\n"); // shouldn't happen
-    StreamReplica::copyReceivedFrame(replica, fMasterReplica);
+    if (replica->fIsReadingFrameRef) {
+      // Give this replica a reference to the (shared) frame, rather than copying it:
+      if (fCurrentFrame == NULL) makeCurrentFrame(fMasterReplica);
+      fCurrentFrame->addRef();
+      if (replica->fFrameRef != NULL) replica->fFrameRef->release(); // sanity check; shouldn't happen
+      replica->fFrameRef = fCurrentFrame;
+    }
+    StreamReplica::copyReceivedFrame(replica, fMasterReplica,
+				     fCurrentFrame != NULL ? fCurrentFrame->fData : fMasterReplica->fTo);
     replica->fFrameIndex = 1 - replica->fFrameIndex; // toggle it (0<->1), because this replica no longer awaits the current frame
     ++fNumDeliveriesMadeSoFar;
 
@@ -268,6 +292,7 @@ void StreamReplicator::deliverReceivedFrame() {
     // Complete delivery to this replica:
     FramedSource::afterGetting(replica);
   }
+  fIsDeliveringToReplicas = False;
 
   if (fNumDeliveriesMadeSoFar == fNumActiveReplicas - 1 && fMasterReplica != NULL) {
     // No more requests for this frame are expected, so complete delivery to the 'master replica':
@@ -277,6 +302,15 @@ void StreamReplicator::deliverReceivedFrame() {
     fFrameIndex = 1 - fFrameIndex; // toggle it (0<->1) for the next frame
     fNumDeliveriesMadeSoFar = 0; // reset for the next frame
 
+    // Hand our reference to the shared frame (if any) to the 'master' replica, if it wants it; otherwise release it:
+    if (replica->fIsReadingFrameRef && fCurrentFrame != NULL) {
+      if (replica->fFrameRef != NULL) replica->fFrameRef->release(); // sanity check; shouldn't happen
+      replica->fFrameRef = fCurrentFrame;
+      fCurrentFrame = NULL;
+    } else {
+      releaseCurrentFrame();
+    }
+
     if (fReplicasAwaitingNextFrame != NULL) {
       // One of the other replicas has already requested the next frame, so make it the next 'master replica':
       fMasterReplica = fReplicasAwaitingNextFrame;
@@ -284,8 +318,7 @@ void StreamReplicator::deliverReceivedFrame() {
       fMasterReplica->fNext = NULL;
 
       // Arrange to read the next frame into this replica's buffer:
-      if (fInputSource != NULL) fInputSource->getNextFrame(fMasterReplica->fTo, fMasterReplica->fMaxSize,
-							   afterGettingFrame, this, onSourceClosure, this);
+      readNextFrame();
     }      
 
     // Move any other replicas that had already requested the next frame to the 'requesting current frame' list:
@@ -299,6 +332,41 @@ void StreamReplicator::deliverReceivedFrame() {
   }
 }
 
+void StreamReplicator::readNextFrame() {
+  if (fInputSource == NULL) return;
+
+  if (fMasterReplica->fIsReadingFrameRef) {
+    // The 'master' replica wants a shared frame (rather than a copy into its own buffer), so read into a new shared frame.
+    // Any other replicas that also want a shared frame will get a reference to the same frame - i.e., without copying.
+    unsigned bufferSize = fInputSource->maxFrameSize();
+    if (bufferSize == 0) bufferSize = FramedSource::frameRefBufferSize;
+    releaseCurrentFrame(); // sanity check; shouldn't be needed
+    fCurrentFrame = SharedFrame::createNew(bufferSize);
+    fInputSource->getNextFrame(fCurrentFrame->fData, bufferSize, afterGettingFrame, this, onSourceClosure, this);
+  } else {
+    fInputSource->getNextFrame(fMasterReplica->fTo, fMasterReplica->fMaxSize,
+			       afterGettingFrame, this, onSourceClosure, this);
+  }
+}
+
+void StreamReplicator::makeCurrentFrame(StreamReplica* fromReplica) {
+  // The current frame was read into "fromReplica"'s own buffer, but some replica wants a shared frame.
+  // Copy the frame (just once) into a new shared frame, that we'll then share among all such replicas:
+  fCurrentFrame = SharedFrame::createNew(fromReplica->fFrameSize > 0 ? fromReplica->fFrameSize : 1);
+  memmove(fCurrentFrame->fData, fromReplica->fTo, fromReplica->fFrameSize);
+  fCurrentFrame->fFrameSize = fromReplica->fFrameSize;
+  fCurrentFrame->fNumTruncatedBytes = fromReplica->fNumTruncatedBytes;
+  fCurrentFrame->fPresentationTime = fromReplica->fPresentationTime;
+  fCurrentFrame->fDurationInMicroseconds = fromReplica->fDurationInMicroseconds;
+}
+
+void StreamReplicator::releaseCurrentFrame() {
+  if (fCurrentFrame != NULL) {
+    fCurrentFrame->release();
+    fCurrentFrame = NULL;
+  }
+}
+
 
 ////////// StreamReplica implementation //////////
 
@@ -316,18 +384,25 @@ void StreamReplica::doGetNextFrame() {
   fOurReplicator.getNextFrame(this);
 }
 
+void StreamReplica::doGetNextFrameRef() {
+  // We don't need to allocate a frame of our own; our replicator gives us a reference to a shared frame:
+  fOurReplicator.getNextFrame(this);
+}
+
 void StreamReplica::doStopGettingFrames() {
   fOurReplicator.deactivateStreamReplica(this);
 }
 
-void StreamReplica::copyReceivedFrame(StreamReplica* toReplica, StreamReplica* fromReplica) {
+void StreamReplica::copyReceivedFrame(StreamReplica* toReplica, StreamReplica* fromReplica, unsigned char const* fromData) {
+  // (If "toReplica" is being read using "getNextFrameRef()", then it shares the frame, so we copy only its parameters.)
   // First, figure out how much data to copy.  ("toReplica" might have a smaller buffer than "fromReplica".)
   unsigned numNewBytesToTruncate
-    = toReplica->fMaxSize < fromReplica->fFrameSize ? fromReplica->fFrameSize - toReplica->fMaxSize : 0;
+    = !toReplica->fIsReadingFrameRef && toReplica->fMaxSize < fromReplica->fFrameSize
+    ? fromReplica->fFrameSize - toReplica->fMaxSize : 0;
   toReplica->fFrameSize = fromReplica->fFrameSize - numNewBytesToTruncate;
   toReplica->fNumTruncatedBytes = fromReplica->fNumTruncatedBytes + numNewBytesToTruncate;
 
-  memmove(toReplica->fTo, fromReplica->fTo, toReplica->fFrameSize);
+  if (!toReplica->fIsReadingFrameRef) memmove(toReplica->fTo, fromData, toReplica->fFrameSize);
   toReplica->fPresentationTime = fromReplica->fPresentationTime;
   toReplica->fDurationInMicroseconds = fromReplica->fDurationInMicroseconds;
 }
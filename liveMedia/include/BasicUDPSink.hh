@@ -32,6 +32,19 @@ class BasicUDPSink: public MediaSink {
 public:
   static BasicUDPSink* createNew(UsageEnvironment& env, Groupsock* gs,
 				  unsigned maxPayloadSize = 1450);
+
+  Boolean enableKernelPacing(unsigned lookaheadMicroseconds = 2000);
+      // Has the kernel - rather than our event loop - send each packet at its scheduled time (using "SO_TXTIME").
+      // We then hand packets to the kernel up to "lookaheadMicroseconds" before they're due, waking up less often.
+      // Returns False (and leaves pacing to the event loop, as before) if the kernel doesn't support this.
+      // NOTE: This works only if the outgoing interface uses the "fq" (or "etf") queueing discipline (see
+      // "OutputSocket::enableLaunchTimes()").  Otherwise, each packet is sent up to "lookaheadMicroseconds" early -
+      // so don't make this much larger than the default unless you know that "fq" or "etf" is being used.
+      // (If the kernel reports that it dropped packets, we go back to pacing them ourself.)
+  Boolean setMaxPacingRate(unsigned bytesPerSecond);
+      // Has the kernel spread out the packets that we send so that they're sent at no more than this rate (using
+      // "SO_MAX_PACING_RATE"; this also requires the "fq" queueing discipline).  Returns False if this isn't supported.
+
 protected:
   BasicUDPSink(UsageEnvironment& env, Groupsock* gs, unsigned maxPayloadSize);
       // called only by createNew()
@@ -59,6 +72,7 @@ private:
   unsigned fMaxPayloadSize;
   unsigned char* fOutputBuffer;
   struct timeval fNextSendTime;
+  unsigned fKernelPacingLookahead; // 0 if kernel pacing is not being used
   u_int16_t fLastRTPSeq;
 };
 
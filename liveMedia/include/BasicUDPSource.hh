@@ -36,12 +36,25 @@ public:
 
   Groupsock* gs() const { return fInputGS; }
 
+  void setReceiveBatchSize(unsigned batchSize, unsigned maxPacketSize = 65536);
+      // If "batchSize" > 1, then - when our socket becomes readable - we read up to "batchSize" packets
+      // (each of up to "maxPacketSize" bytes) at once, using a single system call (if possible), and
+      // then deliver them (one frame per packet) from an internal buffer.  (The default "batchSize" is 1.)
+      // (Groupsock::statsGroupIncomingBatches counts the sizes of the batches that we actually read.)
+
+  Boolean useArrivalTimestamps();
+      // Sets the presentation time of each frame to the time at which its packet arrived - as timestamped by the
+      // kernel (using "SO_TIMESTAMPNS") if possible, so that it's not affected by any delay in reading the packet.
+      // (Returns False if the kernel can't timestamp packets; they are then timestamped when they're read.)
+      // By default, frames' presentation times are not set.
+
 private:
   BasicUDPSource(UsageEnvironment& env, Groupsock* inputGS);
       // called only by createNew()
 
   static void incomingPacketHandler(BasicUDPSource* source, int mask);
   void incomingPacketHandler1();
+  void deliverBatchedPacket();
 
 private: // redefined virtual functions:
   virtual void doGetNextFrame();
@@ -50,6 +63,15 @@ private: // redefined virtual functions:
 private:
   Groupsock* fInputGS;
   Boolean fHaveStartedReading;
+  Boolean fUseArrivalTimestamps;
+
+  // Used to implement reading in batches:
+  unsigned fReceiveBatchSize, fMaxBatchedPacketSize;
+  unsigned char* fBatchBuffer;
+  unsigned char** fBatchedPackets;
+  unsigned* fBatchedPacketSizes;
+  struct timeval* fBatchedArrivalTimes;
+  unsigned fNumBatchedPackets, fNextBatchedPacket;
 };
 
 #endif
@@ -35,6 +35,12 @@ protected: // we're a virtual base class
 			    Boolean reuseFirstSource);
   virtual ~FileServerMediaSubsession();
 
+  // Used by subclasses whose "getAuxSDPLine()" has to read the file, to avoid doing so if the result has already
+  // been found (perhaps by a previous run of the server) for this version of the file.  "subsessionType" (e.g., "H264")
+  // distinguishes the aux SDP lines of different types of subsession:
+  char const* lookupCachedAuxSDPLine(char const* subsessionType, RTPSink* rtpSink);
+  void cacheAuxSDPLine(char const* subsessionType, RTPSink* rtpSink, char const* auxSDPLine);
+
 protected:
   char const* fFileName;
   u_int64_t fFileSize; // if known
@@ -28,6 +28,37 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 #include "MediaSource.hh"
 #endif
 
+// A reference-counted, read-only frame, which can be delivered (without copying) to several consumers.
+// (See "FramedSource::getNextFrameRef()", below.)
+class SharedFrame {
+public:
+  static SharedFrame* createNew(unsigned maxSize);
+
+  void addRef() { ++fRefCount; }
+  void release(); // deletes the frame when the last reference is released
+
+  unsigned char const* data() const { return fData; }
+  unsigned frameSize() const { return fFrameSize; }
+  unsigned numTruncatedBytes() const { return fNumTruncatedBytes; }
+  struct timeval const& presentationTime() const { return fPresentationTime; }
+  unsigned durationInMicroseconds() const { return fDurationInMicroseconds; }
+
+protected:
+  SharedFrame(unsigned maxSize); // called only by createNew()
+  virtual ~SharedFrame();
+
+private:
+  friend class FramedSource;
+  friend class StreamReplicator;
+  unsigned char* fData;
+  unsigned fMaxSize;
+  unsigned fFrameSize;
+  unsigned fNumTruncatedBytes;
+  struct timeval fPresentationTime;
+  unsigned fDurationInMicroseconds;
+  unsigned fRefCount;
+};
+
 class FramedSource: public MediaSource {
 public:
   static Boolean lookupByName(UsageEnvironment& env, char const* sourceName,
@@ -47,6 +78,19 @@ public:
 		    void* onCloseClientData,
         afterGettingPacketFunc* afterGettingPacketFunc = NULL);
 
+  typedef void (afterGettingFrameRefFunc)(void* clientData, SharedFrame* frame);
+  void getNextFrameRef(afterGettingFrameRefFunc* afterGettingFrameRefFunc,
+		       void* afterGettingClientData,
+		       onCloseFunc* onCloseFunc,
+		       void* onCloseClientData);
+      // An alternative to "getNextFrame()": Rather than copying the frame into a buffer that we provide, the source
+      // delivers a (read-only) "SharedFrame".  The caller then holds one reference to this frame, and must call
+      // "release()" on it when it's done with it.  Sources that can share a single frame between several readers
+      // (e.g., the replicas created by a "StreamReplicator") do this without copying the frame data.
+  static unsigned frameRefBufferSize;
+      // The size of the "SharedFrame" that's allocated for each frame read by "getNextFrameRef()" - unless the source
+      // specifies a "maxFrameSize()".  (Default: 300000 bytes.)
+
   static void handleClosure(void* clientData);
   void handleClosure();
       // This should be called (on ourself) if the source is discovered
@@ -74,6 +118,12 @@ protected:
 
   virtual void doStopGettingFrames();
 
+  virtual void doGetNextFrameRef();
+      // called by getNextFrameRef().  The default implementation allocates a new "SharedFrame", sets "fTo" and
+      // "fMaxSize" to its buffer, and then calls "doGetNextFrame()".  A subclass that can deliver frames without
+      // copying may redefine this, setting "fFrameRef" (to a frame holding one reference for our caller) before
+      // completing delivery by calling "afterGetting()", as usual.
+
 protected:
   // The following variables are typically accessed/set by doGetNextFrame()
   unsigned char* fTo; // in
@@ -82,6 +132,8 @@ protected:
   unsigned fNumTruncatedBytes; // out
   struct timeval fPresentationTime; // out
   unsigned fDurationInMicroseconds; // out
+  Boolean fIsReadingFrameRef; // in: True iff we're being read using "getNextFrameRef()"
+  SharedFrame* fFrameRef; // out (when "fIsReadingFrameRef")
 
 private:
   // redefined virtual functions:
@@ -93,6 +145,7 @@ private:
   onCloseFunc* fOnCloseFunc;
   void* fOnCloseClientData;
   afterGettingPacketFunc* fAfterGettingPacketFunc;
+  afterGettingFrameRefFunc* fAfterGettingFrameRefFunc;
 
   Boolean fIsCurrentlyAwaitingData;
 };
@@ -35,6 +35,44 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 #ifndef RESPONSE_BUFFER_SIZE
 #define RESPONSE_BUFFER_SIZE 20000
 #endif
+#ifndef REQUEST_BUFFER_INITIAL_SIZE
+#define REQUEST_BUFFER_INITIAL_SIZE 2048 // a request buffer grows (x4 each time, up to REQUEST_BUFFER_SIZE) only if needed
+#endif
+
+// A pool of buffers, from which a server's client connections get their request and response buffers.
+// Buffers are taken from the pool only while a connection is handling a request, and are returned to it afterwards,
+// so that idle connections (e.g., those that are just streaming, with occasional 'keep-alive' requests) hold no buffers.
+// Free buffers are kept in one list for each (distinct) buffer size that's been used.
+class ConnectionBufferPool {
+public:
+  ConnectionBufferPool(unsigned maxNumFreeBuffersPerSize = 32);
+      // At most "maxNumFreeBuffersPerSize" free buffers (of each size) are kept; any more get deleted.
+  virtual ~ConnectionBufferPool();
+
+  unsigned char* allocate(unsigned size);
+  void release(unsigned char* buffer, unsigned size); // "size" must be the same as the "size" given to "allocate()"
+
+  // Statistics:
+  unsigned numBuffersInUse() const { return fNumBuffersInUse; }
+  unsigned numBytesInUse() const { return fNumBytesInUse; }
+  unsigned numFreeBuffers() const;
+  unsigned numFreeBytes() const;
+
+private:
+  struct FreeList {
+    unsigned size;
+    unsigned char* head; // each free buffer begins with a pointer to the next one
+    unsigned numBuffers;
+  };
+  FreeList* lookupFreeList(unsigned size);
+
+private:
+  unsigned fMaxNumFreeBuffersPerSize;
+  enum { MAX_NUM_FREE_LISTS = 8 }; // buffers of any other sizes are simply allocated and deleted
+  FreeList fFreeLists[MAX_NUM_FREE_LISTS];
+  unsigned fNumFreeLists;
+  unsigned fNumBuffersInUse, fNumBytesInUse;
+};
 
 class GenericMediaServer: public Medium {
 public:
@@ -43,6 +81,18 @@ public:
   virtual ServerMediaSession*
   lookupServerMediaSession(char const* streamName, Boolean isFirstLookupInSession = True);
 
+  typedef void (lookupServerMediaSessionCompletionFunc)(void* clientData, ServerMediaSession* sessionLookedUp);
+  virtual void lookupServerMediaSession(char const* streamName,
+					lookupServerMediaSessionCompletionFunc* completionFunc, void* completionClientData,
+					Boolean isFirstLookupInSession = True);
+      // An asynchronous version of the above.  "completionFunc" gets called with the result - either before this function
+      // returns, or later, from the event loop.  The default implementation just calls the synchronous version; reimplement
+      // this in a subclass if (e.g.) a "ServerMediaSession" can't be created without waiting for file I/O.
+  virtual void cancelLookupServerMediaSession(lookupServerMediaSessionCompletionFunc* completionFunc,
+					      void* completionClientData);
+      // Ensures that "completionFunc" will not get called (with "completionClientData") for any outstanding lookup.
+      // (The default implementation does nothing, because its lookups are never outstanding.)
+
   void removeServerMediaSession(ServerMediaSession* serverMediaSession);
       // Removes the "ServerMediaSession" object from our lookup table, so it will no longer be accessible by new clients.
       // (However, any *existing* client sessions that use this "ServerMediaSession" object will continue streaming.
@@ -66,6 +116,9 @@ public:
       //     "closeAllClientSessionsForServerMediaSession(streamName); removeServerMediaSession(streamName);
 
   unsigned numClientSessions() const { return fClientSessions->numEntries(); }
+  unsigned numClientConnections() const { return fClientConnections->numEntries(); }
+
+  ConnectionBufferPool& connectionBufferPool() { return fConnectionBufferPool; }
 
 protected:
   GenericMediaServer(UsageEnvironment& env, int ourSocket, Port ourPort,
@@ -76,7 +129,8 @@ protected:
   virtual ~GenericMediaServer();
   void cleanup(); // MUST be called in the destructor of any subclass of us
 
-  static int setUpOurSocket(UsageEnvironment& env, Port& ourPort);
+  static int setUpOurSocket(UsageEnvironment& env, Port& ourPort, Boolean reusePort = False);
+      // If "reusePort" is True, other servers (e.g., in other threads) may also listen on "ourPort".
 
   static void incomingConnectionHandler(void*, int /*mask*/);
   void incomingConnectionHandler();
@@ -95,7 +149,17 @@ public: // should be protected, but some old compilers complain otherwise
     static void incomingRequestHandler(void*, int /*mask*/);
     void incomingRequestHandler();
     virtual void handleRequestBytes(int newBytesRead) = 0;
-    void resetRequestBuffer();
+    virtual void resetRequestBuffer();
+
+    // Our request and response buffers are taken from our server's "ConnectionBufferPool" only when needed:
+    Boolean ensureRequestBufferSpace(unsigned numBytes);
+        // Gets (or grows) our request buffer, if necessary, so that "numBytes" more bytes (and a trailing '\0') will fit.
+        // Returns False iff this isn't possible (because the request buffer is already at its maximum size).
+    virtual void requestBufferHasMoved(unsigned char* oldRequestBuffer);
+        // called after our request buffer has been grown; subclasses that keep pointers into the buffer adjust them here
+    void releaseRequestBuffer(); // if it contains no (partial) request
+    void getResponseBuffer();
+    void releaseResponseBuffer();
 
   protected:
     friend class GenericMediaServer;
@@ -104,8 +168,10 @@ public: // should be protected, but some old compilers complain otherwise
     GenericMediaServer& fOurServer;
     int fOurSocket;
     struct sockaddr_in fClientAddr;
-    unsigned char fRequestBuffer[REQUEST_BUFFER_SIZE];
-    unsigned char fResponseBuffer[RESPONSE_BUFFER_SIZE];
+    unsigned char* fRequestBuffer; // NULL if we're not handling a request
+    unsigned fRequestBufferSize;
+    unsigned char* fResponseBuffer; // NULL if we're not handling a request
+    unsigned fResponseBufferSize;
     unsigned fRequestBytesAlreadySeen, fRequestBufferBytesLeft;
   };
 
@@ -163,6 +229,7 @@ private:
   HashTable* fServerMediaSessions; // maps 'stream name' strings to "ServerMediaSession" objects
   HashTable* fClientConnections; // the "ClientConnection" objects that we're using
   HashTable* fClientSessions; // maps 'session id' strings to "ClientSession" objects
+  ConnectionBufferPool fConnectionBufferPool;
 };
 
 // A data structure used for optional user/password authentication:
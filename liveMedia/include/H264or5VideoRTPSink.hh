@@ -47,6 +47,9 @@ private: // redefined virtual functions:
                                       unsigned numRemainingBytes);
   virtual Boolean frameCanAppearAfterPacketStart(unsigned char const* frameStart,
 						 unsigned numBytesInFrame) const;
+  virtual Boolean frameIsDiscardable(unsigned fragmentationOffset,
+				     unsigned char const* frameStart,
+				     unsigned numBytesInFrame) const;
 
 protected:
   int fHNumber;
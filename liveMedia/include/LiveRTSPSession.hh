@@ -6,10 +6,75 @@
 #include <pthread.h>
 
 class RTPRelaySink;
+class LiveRTSPSessionPool;
+
+// A lock-free, single-producer/single-consumer ring of packet slots.  The session's event-loop thread (the producer)
+// copies each incoming packet into a slot; an application thread (the consumer) reads the packets - in batches - later.
+// If the consumer falls behind, so that the ring is full, incoming packets are dropped (and counted), rather than
+// delaying the reception of further packets.
+
+class LiveRTSPPacketRing {
+public:
+	LiveRTSPPacketRing(unsigned numSlots, unsigned slotSize);
+	// "numSlots" is rounded up to a power of 2
+	virtual ~LiveRTSPPacketRing();
+
+	struct Packet {
+		char*    data; // points into the ring; valid until the packet is released
+		unsigned size;
+		int      trackIndex;
+	};
+
+	struct Stats {
+		u_int64_t numPacketsEnqueued;
+		u_int64_t numPacketsDroppedBecauseFull;    // 'overflows'
+		u_int64_t numPacketsDroppedBecauseTooLarge; // larger than "slotSize"
+		unsigned  maxNumPacketsQueued;              // the ring's 'high-water mark'
+	};
+
+	// Producer:
+	bool Enqueue(char const* packetData, unsigned packetSize, int trackIndex);
+	// returns false (and counts the packet as dropped) if there's no room for it
+
+	// Consumer:
+	unsigned Poll(Packet* packets, unsigned maxPackets);
+	// Returns (in "packets") up to "maxPackets" of the oldest packets in the ring, without waiting.
+	// These packets remain in the ring until they are released, using "Release()".
+	void Release(unsigned numPackets);
+	bool Wait(unsigned timeoutMs);
+	// Waits (for up to "timeoutMs" milliseconds) until at least one packet is in the ring.
+	// Returns true iff a packet is available.
+
+	void GetStats(Stats& stats) const; // may be called from any thread
+
+private:
+	unsigned          fNumSlots; // a power of 2
+	unsigned          fSlotSize;
+	char*             fSlotData;
+	unsigned*         fSlotSizes;
+	int*              fSlotTrackIndexes;
+
+	// "fHead" is written only by the producer, and "fTail" only by the consumer:
+	unsigned volatile fHead; // the number of packets ever enqueued
+	unsigned volatile fTail; // the number of packets ever released
+
+	u_int64_t volatile fNumPacketsEnqueued;
+	u_int64_t volatile fNumPacketsDroppedBecauseFull;
+	u_int64_t volatile fNumPacketsDroppedBecauseTooLarge;
+	unsigned volatile  fMaxNumPacketsQueued;
+
+	// Used only if the consumer waits:
+	int volatile       fConsumerIsWaiting;
+	pthread_mutex_t    fWaitMutex;
+	pthread_cond_t     fWaitCond;
+};
 
 class LiveRTSPSession {
 public:
-	static LiveRTSPSession* createNew(char const* rtspURL, char const* progName = NULL);
+	static LiveRTSPSession* createNew(char const* rtspURL, char const* progName = NULL,
+					LiveRTSPSessionPool* pool = NULL);
+	// If "pool" is NULL, the session runs its own event loop, in its own thread.
+	// Otherwise, it shares one of the pool's event-loop threads with other sessions.
 	virtual ~LiveRTSPSession();
 
 	typedef void (OnGettingSDPFunc)(void* callbackData, char* sdpInfo);
@@ -22,10 +87,18 @@ public:
 	void StopAndWait();
 
 	char const* GetSDPInfo() { return fSDPInfo; }
+	const static u_int16_t kMaxURLLen = 256; // including the trailing '\0'
 	char const* GetURL() { return fURL; }
 
+	// Optionally, incoming packets can be delivered (from the session's event-loop thread) into a ring buffer, from which
+	// the application then reads them (in its own thread(s)), instead of "OnGettingPacketFunc" being called for each.
+	// This way, a slow application can't delay the reception of packets.
+	int EnablePacketRing(unsigned numSlots = 1024, unsigned slotSize = 2048);
+	// must be called before "Start()"; returns 0 on success
+	LiveRTSPPacketRing* GetPacketRing() { return fPacketRing; } // NULL if none
+
 private:
-	LiveRTSPSession(char const* rtspURL, char const* progName = NULL);
+	LiveRTSPSession(char const* rtspURL, char const* progName, LiveRTSPSessionPool* pool);
 	// called only by createNew
 
 	void NotifySDPInfo(char* const sdpInfo);
@@ -33,6 +106,10 @@ private:
 
 	static void* thread_entry(void* session);
 
+	// Used (instead of "thread_entry()") when the session shares a pool's event loop:
+	static void startInPool(void* session);
+	static void stopInPool(void* session);
+
 	static void continueAfterDESCRIBE(RTSPClient* rtspClient, int resultCode, char* resultString);
 	static void continueAfterSETUP(RTSPClient* rtspClient, int resultCode, char* resultString);
 	static void continueAfterPLAY(RTSPClient* rtspClient, int resultCode, char* resultString);
@@ -49,26 +126,77 @@ private:
 	// Used to shut down and close a stream (including its "RTSPClient" object):
 	static void shutdownStream(RTSPClient* rtspClient, int exitCode = 1);
 
-	const static u_int16_t kMaxURLLen = 64;
 	const static u_int16_t kMaxSDPLen = 1024;
 
 	RTSPClient*          fRTSPClient;
 	char                 fURL[kMaxURLLen];
+	char*                fProgName;
 	char                 fSDPInfo[kMaxSDPLen];
-	TaskScheduler*       fScheduler;
+	TaskScheduler*       fScheduler; // NULL if we use a pool's event loop
 	UsageEnvironment*    fEnv;
 
 	OnGettingSDPFunc*    fOnGettingSDPFunc;
 	OnGettingPacketFunc* fOnGettingPacketFunc;
 	void*                fCallbackData;
+	LiveRTSPPacketRing*  fPacketRing;
 
 	char                 fThreadWatchVariable; // keep this as 0 if you do not want to break the event loop.
-	bool                 fThreadStarted;
+	bool                 fThreadStarted; // (if we use a pool: true between "Start()" and "StopAndWait()")
 	pthread_t            fThread;
 
+	LiveRTSPSessionPool* fPool;
+	unsigned             fPoolLoopIndex;
+	bool                 fStoppedInPool;
+	pthread_mutex_t      fStopMutex;
+	pthread_cond_t       fStopCond;
+
 	friend class RTPRelaySink;
 };
 
+// A pool of event-loop threads, each of which can run many "LiveRTSPSession"s.
+// This lets a large number of sessions be run using a fixed number of threads.
+
+class LiveRTSPSessionPool {
+public:
+	static LiveRTSPSessionPool* createNew(unsigned numThreads = 0);
+	// If "numThreads" is 0 (the default), we use one thread for each CPU core.
+	virtual ~LiveRTSPSessionPool();
+	// Note: Each "LiveRTSPSession" that uses this pool must be deleted before the pool is.
+
+	unsigned GetNumThreads() const { return fNumLoops; }
+	unsigned GetNumSessions();
+
+private:
+	LiveRTSPSessionPool(unsigned numThreads);
+	// called only by createNew
+
+	bool StartThreads();
+	void StopThreads();
+
+	// Called by "LiveRTSPSession" to choose (and later, to give up) one of our event loops:
+	friend class LiveRTSPSession;
+	unsigned AssignSession(UsageEnvironment*& env);
+	void ReleaseSession(unsigned loopIndex);
+
+	static void* thread_entry(void* loop);
+	static void wakeupHandler(void* loop);
+
+	struct EventLoop {
+		EventLoop(): fScheduler(NULL), fEnv(NULL), fWatchVariable(0), fThreadStarted(false), fNumSessions(0) {}
+
+		TaskScheduler*    fScheduler;
+		UsageEnvironment* fEnv;
+		char              fWatchVariable;
+		bool              fThreadStarted;
+		pthread_t         fThread;
+		unsigned          fNumSessions;
+	};
+
+	unsigned        fNumLoops;
+	EventLoop*      fLoops;
+	pthread_mutex_t fMutex; // protects each loop's "fNumSessions"
+};
+
 // Define a class to hold per-stream state that we maintain throughout each stream's lifetime:
 
 class StreamClientState {
@@ -137,6 +265,7 @@ private:
 						struct timeval presentationTime, unsigned durationInMicroseconds);
 
 	static void afterGettingPacket(void* clientData, char* packetData, unsigned packetSize);
+	static void afterGettingRTPPacket(void* clientData, BufferedPacket* packet);
 	void afterGettingPacket(char* packetData, unsigned packetSize);
 
 private:
@@ -144,7 +273,7 @@ private:
 	virtual Boolean continuePlaying();
 
 private:
-	u_int8_t*        fReceiveBuffer;
+	u_int8_t*        fReceiveBuffer; // used only if our source is not a RTP source (which we read in 'packet mode')
 	MediaSubsession& fSubsession;
 	char*            fStreamId;
 	u_int16_t        fLastRTPSeq;
@@ -31,6 +31,18 @@ public:
   static MPEG2TransportStreamAccumulator* createNew(UsageEnvironment& env,
 						    FramedSource* inputSource,
 						    unsigned maxPacketSize = 1456);
+      // Input frames are gathered until another frame of the same size would no longer fit in "maxPacketSize".
+      // So an input frame that's already (close to) this size - e.g., a RTP payload of 7 Transport Stream packets -
+      // is delivered as is (without being copied).
+
+  void setFlushTimeout(unsigned timeoutInMicroseconds);
+      // If non-zero, then a chunk that's still being gathered gets delivered anyway, once this much time has passed
+      // since its first data arrived.  This limits the latency of low-bitrate streams.  (Any read from our input
+      // source that's still pending is left alone; its data will begin the next chunk.)
+
+  // Statistics:
+  u_int64_t numChunksPassedThrough() const { return fNumChunksPassedThrough; } // input frames that were delivered as is
+  u_int64_t numChunksFlushed() const { return fNumChunksFlushed; } // chunks that were delivered by the flush timeout
 
 protected:
   MPEG2TransportStreamAccumulator(UsageEnvironment& env,
@@ -41,8 +53,10 @@ protected:
 private:
   // redefined virtual functions:
   virtual void doGetNextFrame();
+  virtual void doStopGettingFrames();
 
 private:
+  void readInput();
   static void afterGettingFrame(void* clientData, unsigned frameSize,
                                 unsigned numTruncatedBytes,
                                 struct timeval presentationTime,
@@ -51,10 +65,26 @@ private:
                           unsigned numTruncatedBytes,
                           struct timeval presentationTime,
                           unsigned durationInMicroseconds);
+  Boolean addFrame(unsigned frameSize, struct timeval presentationTime, unsigned durationInMicroseconds);
+      // returns True iff the chunk is now complete
+  void deliverChunk();
+  static void flushChunk(void* clientData);
+  void flushChunk1();
 
 private:
   unsigned const fDesiredPacketSize;
-  unsigned fNumBytesGathered;
+  unsigned fNumBytesGathered; // in the chunk that we're gathering (in "fTo")
+  unsigned fChunkNumTruncatedBytes;
+  struct timeval fChunkPresentationTime;
+  unsigned fChunkDurationInMicroseconds;
+  unsigned char* fBuffer; // used for reads that are made after a chunk has been begun
+  Boolean fReadIsIntoBuffer; // for our most recent input read
+  unsigned fNumLeftoverBytes; // data (in "fBuffer") that will begin the next chunk
+  struct timeval fLeftoverPresentationTime;
+  unsigned fLeftoverDurationInMicroseconds;
+  unsigned fFlushTimeout; // in microseconds
+  TaskToken fFlushTask;
+  u_int64_t fNumChunksPassedThrough, fNumChunksFlushed;
 };
 
 #endif
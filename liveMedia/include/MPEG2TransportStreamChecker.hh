@@ -0,0 +1,84 @@
+/**********
+This library is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the
+Free Software Foundation; either version 3 of the License, or (at your
+option) any later version. (See <http://www.gnu.org/copyleft/lesser.html>.)
+
+This library is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+**********/
+// "liveMedia"
+// Copyright (c) 1996-2017 Live Networks, Inc.  All rights reserved.
+// Checks the sync bytes and continuity counters of MPEG Transport Stream packets, keeping per-PID error counts.
+// (The packet headers are extracted and checked several at a time, using SSE2 or AVX2 if available.)
+// C++ header
+
+#ifndef _MPEG2_TRANSPORT_STREAM_CHECKER_HH
+#define _MPEG2_TRANSPORT_STREAM_CHECKER_HH
+
+#ifndef _BOOLEAN_HH
+#include "Boolean.hh"
+#endif
+#ifndef _NET_COMMON_H
+#include "NetCommon.h"
+#endif
+
+class MPEG2TransportStreamChecker {
+public:
+  MPEG2TransportStreamChecker();
+  virtual ~MPEG2TransportStreamChecker();
+
+  unsigned checkPackets(unsigned char const* data, unsigned numPackets);
+      // Checks "numPackets" consecutive (188-byte) Transport Stream packets, beginning at "data".
+      // Returns the number of errors (bad sync bytes, continuity counter errors, or packets with the
+      // 'transport_error_indicator' set) that were found.
+  void reset(); // forgets all PIDs and statistics
+
+  static unsigned findSyncByte(unsigned char const* data, unsigned dataSize);
+      // Returns the position of the first sync byte (0x47) in "data", or "dataSize" if there is none
+
+  // How packet headers get extracted (for testing; normally, the fastest implementation that the CPU supports is used):
+  enum Implementation { BEST_IMPLEMENTATION, SCALAR_IMPLEMENTATION, SSE2_IMPLEMENTATION, AVX2_IMPLEMENTATION };
+  static Boolean setImplementation(Implementation implementation);
+      // Affects all checkers.  Returns False (and changes nothing) if "implementation" isn't supported here.
+
+  // Statistics:
+  u_int64_t numPackets() const { return fNumPackets; }
+  u_int64_t numSyncErrors() const { return fNumSyncErrors; }
+  u_int64_t numCCErrors() const { return fNumCCErrors; }
+  u_int64_t numTransportErrors() const { return fNumTransportErrors; }
+
+  struct PIDStats {
+    u_int16_t pid;
+    u_int64_t numPackets;
+    u_int64_t numCCErrors;
+    u_int64_t numTransportErrors;
+    u_int64_t numDiscontinuities; // signalled by the 'discontinuity_indicator'
+
+    // Used internally:
+    u_int8_t lastCC;
+    Boolean haveLastCC, lastWasDuplicate;
+  };
+  unsigned numPIDs() const { return fNumPIDs; } // the number of different PIDs seen
+  PIDStats const& pidStats(unsigned index) const { return fPIDStats[index]; } // 0 <= "index" < "numPIDs()"
+  PIDStats const* lookupPID(u_int16_t pid) const; // returns NULL if the PID hasn't been seen
+
+private:
+  PIDStats& pidStatsFor(u_int16_t pid);
+
+private:
+  u_int16_t* fPIDIndex; // for each PID: 1 + its index in "fPIDStats", or 0 if it hasn't been seen (allocated when needed)
+  PIDStats* fPIDStats;
+  unsigned fNumPIDs, fPIDStatsSize;
+  u_int32_t fPrevHeader; // the header of the last packet that we checked (or 0 if none)
+
+  u_int64_t fNumPackets, fNumSyncErrors, fNumCCErrors, fNumTransportErrors;
+};
+
+#endif
@@ -0,0 +1,71 @@
+/**********
+This library is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the
+Free Software Foundation; either version 3 of the License, or (at your
+option) any later version. (See <http://www.gnu.org/copyleft/lesser.html>.)
+
+This library is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+**********/
+// "liveMedia"
+// Copyright (c) 1996-2017 Live Networks, Inc.  All rights reserved.
+// A RTP sink that sends each incoming datagram of MPEG Transport Stream packets (e.g., read from a "BasicUDPSource")
+// as soon as it arrives, as the payload of a RTP packet - without copying, reassembling or pacing the data.
+// (Used to 'fan out' a live (multicast) Transport Stream to many clients.)
+// C++ header
+
+#ifndef _MPEG2_TRANSPORT_STREAM_DATAGRAM_RTP_SINK_HH
+#define _MPEG2_TRANSPORT_STREAM_DATAGRAM_RTP_SINK_HH
+
+#ifndef _RTP_SINK_HH
+#include "RTPSink.hh"
+#endif
+
+class MPEG2TransportStreamDatagramRTPSink: public RTPSink {
+public:
+  static MPEG2TransportStreamDatagramRTPSink* createNew(UsageEnvironment& env, Groupsock* RTPgs,
+							Boolean inputDatagramsAreRTP = False,
+							unsigned maxTSPacketsPerRTPPacket = 7);
+      // If "inputDatagramsAreRTP" is True, then each incoming datagram is a RTP packet, whose RTP header is replaced
+      // by our own.  Otherwise, each incoming datagram is just a sequence of Transport Stream packets.
+      // A datagram that holds more than "maxTSPacketsPerRTPPacket" Transport Stream packets is split into several
+      // RTP packets.
+
+  // Statistics:
+  u_int64_t numDatagramsForwarded() const { return fNumDatagramsForwarded; }
+  u_int64_t numDatagramsDiscarded() const { return fNumDatagramsDiscarded; }
+      // datagrams that didn't contain (only) whole Transport Stream packets
+
+protected:
+  MPEG2TransportStreamDatagramRTPSink(UsageEnvironment& env, Groupsock* RTPgs,
+				      Boolean inputDatagramsAreRTP, unsigned maxTSPacketsPerRTPPacket);
+      // called only by createNew()
+  virtual ~MPEG2TransportStreamDatagramRTPSink();
+
+private: // redefined virtual functions:
+  virtual Boolean continuePlaying();
+  virtual char const* sdpMediaType() const;
+
+private:
+  static void afterGettingFrame(void* clientData, unsigned frameSize,
+                                unsigned numTruncatedBytes,
+                                struct timeval presentationTime,
+                                unsigned durationInMicroseconds);
+  void afterGettingFrame1(unsigned frameSize, unsigned numTruncatedBytes,
+			  struct timeval presentationTime);
+  void sendPayload(unsigned char* payload, unsigned payloadSize);
+
+private:
+  Boolean fInputDatagramsAreRTP;
+  unsigned fMaxPayloadSize;
+  unsigned char* fBuffer;
+  u_int64_t fNumDatagramsForwarded, fNumDatagramsDiscarded;
+};
+
+#endif
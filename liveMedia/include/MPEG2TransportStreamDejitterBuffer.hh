@@ -0,0 +1,130 @@
+/**********
+This library is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the
+Free Software Foundation; either version 3 of the License, or (at your
+option) any later version. (See <http://www.gnu.org/copyleft/lesser.html>.)
+
+This library is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+**********/
+// "liveMedia"
+// Copyright (c) 1996-2017 Live Networks, Inc.  All rights reserved.
+// A de-jitter buffer for MPEG Transport Stream datagrams (e.g., received over UDP): Each datagram is held for a
+// while after it arrives, then released at a time given by a smoothed clock - derived from the stream's PCRs
+// if it has them, or else from the slope of the datagrams' arrival times.
+// C++ header
+
+#ifndef _MPEG2_TRANSPORT_STREAM_DEJITTER_BUFFER_HH
+#define _MPEG2_TRANSPORT_STREAM_DEJITTER_BUFFER_HH
+
+#ifndef _FRAMED_FILTER_HH
+#include "FramedFilter.hh"
+#endif
+
+class MPEG2TransportStreamDejitterBuffer: public FramedFilter {
+public:
+  static MPEG2TransportStreamDejitterBuffer* createNew(UsageEnvironment& env, FramedSource* inputSource,
+						       unsigned latencyInMicroseconds = 100000,
+						       unsigned maxNumDatagrams = 1024,
+						       unsigned maxDatagramSize = 1500);
+      // "inputSource" must deliver datagrams of whole (188-byte) Transport Stream packets, with the presentation time
+      // of each being its arrival time - e.g., a "BasicUDPSource" on which "useArrivalTimestamps()" has been called.
+      // "latencyInMicroseconds" is the target latency: how long the earliest-arriving datagrams are held.  (Datagrams
+      // that arrive later than this - relative to the smoothed clock - are 'late', and are released immediately.)
+      // "maxNumDatagrams" (each of up to "maxDatagramSize" bytes) is the size of the buffer.  If it fills up, we stop
+      // reading our input until there's room again (so the data then waits in the OS's socket buffer instead).
+      // We deliver one datagram per frame.  If our client calls "stopGettingFrames()", we stop reading our input, and
+      // discard any buffered data (and our clock).
+
+  // Buffer occupancy:
+  unsigned numDatagramsBuffered() const { return fNumDatagramsBuffered; }
+  unsigned numBytesBuffered() const { return fNumBytesBuffered; }
+  unsigned maxNumDatagramsBuffered() const { return fMaxNumDatagramsBuffered; } // since the stats were last reset
+  unsigned maxNumBytesBuffered() const { return fMaxNumBytesBuffered; }
+  unsigned numOverflows() const { return fNumOverflows; } // times that the buffer filled up
+
+  // Clock and release statistics:
+  Boolean clockIsFromPCR() const { return fStreamTimeIsFromPCR; } // False if the clock comes from arrival times
+  double bitrate() const; // in bits/second, as implied by the PCRs or the arrival times (0 if not yet known)
+  u_int64_t numDatagramsDelivered() const { return fNumDatagramsDelivered; }
+  u_int64_t numLateDatagrams() const { return fNumLateDatagrams; } // datagrams that arrived after their release time
+  unsigned numResyncs() const { return fNumResyncs; } // times that the clock was reset (e.g., at a PCR discontinuity)
+  double meanHoldTime() const; // in microseconds: the mean time that each datagram spent in the buffer
+  double maxHoldTime() const { return fMaxHoldTime; } // in microseconds
+  double meanJitter() const; // in microseconds: the mean difference between each datagram's actual and scheduled release
+  double maxJitter() const { return fMaxJitter; } // in microseconds
+  void resetBufferStats();
+
+protected:
+  MPEG2TransportStreamDejitterBuffer(UsageEnvironment& env, FramedSource* inputSource,
+				     unsigned latencyInMicroseconds, unsigned maxNumDatagrams, unsigned maxDatagramSize);
+      // called only by createNew()
+  virtual ~MPEG2TransportStreamDejitterBuffer();
+
+private:
+  // redefined virtual functions:
+  virtual void doGetNextFrame();
+  virtual void doStopGettingFrames();
+
+private:
+  void readInput();
+  static void afterGettingFrame(void* clientData, unsigned frameSize,
+                                unsigned numTruncatedBytes,
+                                struct timeval presentationTime,
+                                unsigned durationInMicroseconds);
+  void afterGettingFrame1(unsigned frameSize, struct timeval presentationTime);
+  static void handleInputClosure(void* clientData);
+
+  double streamTimeFor(unsigned char const* datagram, unsigned numTSPackets, double arrivalTime,
+		       Boolean& isDiscontinuity);
+  void updateClock(double offset, double arrivalTime, unsigned datagramSize);
+  void resync(double offset);
+
+  void deliverDatagram();
+  static void deliverScheduledDatagram(void* clientData);
+
+private:
+  double const fLatency; // seconds
+
+  // The buffer: a ring of "fMaxNumDatagrams" slots, each of "fMaxDatagramSize" bytes:
+  unsigned const fMaxNumDatagrams, fMaxDatagramSize;
+  unsigned char* fSlotData;
+  struct DejitterSlot {
+    unsigned size;
+    double arrivalTime, releaseTime;
+  }* fSlots;
+  unsigned fHead, fNumDatagramsBuffered, fNumBytesBuffered;
+  Boolean fHaveStartedReading, fInputHasClosed;
+
+  // The 'stream time' of each datagram - from the PCRs (of one PID), or else from the arrival bit rate:
+  u_int64_t fTSPacketCount;
+  Boolean fHavePCR;
+  unsigned fPCRPID;
+  double fLastPCR;
+  u_int64_t fLastPCRPacketNum;
+  double fTSPacketDuration; // seconds (0.0 if not yet known)
+  Boolean fStreamTimeIsFromPCR;
+  double fLastStreamTime;
+  unsigned fLastDatagramSize;
+  double fArrivalBitrate; // bits/second (0.0 if not yet known)
+
+  // Our clock: each datagram is released at its stream time + "fOffset" + "fLatency", where "fOffset" tracks the
+  // smallest (arrival time - stream time) - i.e., the earliest-arriving datagrams - of each measurement window:
+  Boolean fClockIsValid;
+  double fOffset;
+  double fWindowStartTime, fWindowMinOffset;
+  unsigned fWindowNumBytes;
+
+  unsigned fMaxNumDatagramsBuffered, fMaxNumBytesBuffered, fNumOverflows;
+  u_int64_t fNumDatagramsDelivered, fNumLateDatagrams;
+  unsigned fNumResyncs;
+  double fTotalHoldTime, fMaxHoldTime, fTotalJitter, fMaxJitter;
+};
+
+#endif
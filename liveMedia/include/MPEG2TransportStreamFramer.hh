@@ -30,6 +30,9 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 #ifndef _HASH_TABLE_HH
 #include "HashTable.hh"
 #endif
+#ifndef _MPEG2_TRANSPORT_STREAM_CHECKER_HH
+#include "MPEG2TransportStreamChecker.hh"
+#endif
 
 class MPEG2TransportStreamFramer: public FramedFilter {
 public:
@@ -44,6 +47,15 @@ public:
   void setNumTSPacketsToStream(unsigned long numTSRecordsToStream);
   void setPCRLimit(float pcrLimit);
 
+  MPEG2TransportStreamChecker* enableStreamChecking();
+      // Has each Transport Stream packet checked (for sync byte and continuity counter errors) as it passes through.
+      // Returns the checker, from which the error statistics can be read.
+  MPEG2TransportStreamChecker* streamChecker() const { return fStreamChecker; } // NULL unless checking was enabled
+
+  static Boolean getPCR(unsigned char const* pkt, double& pcr, unsigned& pid, Boolean& discontinuityIndicator);
+      // If the Transport Stream packet "pkt" contains a PCR, returns True, and sets "pcr" (in seconds), the packet's
+      // "pid", and "discontinuityIndicator" (from the packet's adaptation field).  Otherwise, returns False.
+
 protected:
   MPEG2TransportStreamFramer(UsageEnvironment& env, FramedSource* inputSource);
       // called only by createNew()
@@ -73,6 +85,7 @@ private:
   unsigned long fNumTSPacketsToStream; // used iff "fLimitNumTSPacketsToStream" is True
   Boolean fLimitTSPacketsToStreamByPCR;
   float fPCRLimit; // used iff "fLimitTSPacketsToStreamByPCR" is True
+  MPEG2TransportStreamChecker* fStreamChecker;
 };
 
 #endif
@@ -0,0 +1,112 @@
+/**********
+This library is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the
+Free Software Foundation; either version 3 of the License, or (at your
+option) any later version. (See <http://www.gnu.org/copyleft/lesser.html>.)
+
+This library is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+**********/
+// "liveMedia"
+// Copyright (c) 1996-2017 Live Networks, Inc.  All rights reserved.
+// A filter that removes unwanted PIDs from a MPEG Transport Stream: It keeps only the selected programs (and/or PIDs),
+// strips null packets, and rewrites the PAT and PMTs to describe only what's left.
+// C++ header
+
+#ifndef _MPEG2_TRANSPORT_STREAM_PID_FILTER_HH
+#define _MPEG2_TRANSPORT_STREAM_PID_FILTER_HH
+
+#ifndef _FRAMED_FILTER_HH
+#include "FramedFilter.hh"
+#endif
+
+class PIDFilterProgram; // forward
+class PIDFilterPSIStream; // forward
+
+class MPEG2TransportStreamPIDFilter: public FramedFilter {
+public:
+  static MPEG2TransportStreamPIDFilter* createNew(UsageEnvironment& env, FramedSource* inputSource);
+      // "inputSource" must deliver whole (188-byte) Transport Stream packets - e.g., a "MPEG2TransportStreamFramer",
+      // or a "BasicUDPSource" that's reading Transport Stream packets over UDP.
+
+  // Select what's to be kept.  By default, all programs are kept, and only null packets are removed:
+  void addProgram(u_int16_t programNumber);
+      // If called (one or more times), only these programs are kept; other programs (and any PIDs that aren't listed
+      // in the PMT of a kept program) are removed.
+  void addPID(u_int16_t pid); // Always keep this PID (e.g., for an EIT, or - for PID 0x1FFF - the null packets).
+  void removePID(u_int16_t pid);
+      // Never keep this PID (e.g., an unwanted audio track); it's also removed from the PMT of any kept program.
+      // (Note that if this is a program's PCR PID, then the program's PCRs will be removed too.)
+
+  // Statistics:
+  u_int64_t numPacketsIn() const { return fNumPacketsIn; }
+  u_int64_t numPacketsOut() const { return fNumPacketsOut; }
+  u_int64_t numNullPacketsRemoved() const { return fNumNullPacketsRemoved; }
+  u_int64_t numPacketsRemoved() const { return fNumPacketsRemoved; } // other than null packets and PSI
+  u_int64_t numBadPackets() const { return fNumBadPackets; } // packets without a sync byte
+  unsigned numSectionsRewritten() const { return fNumSectionsRewritten; }
+
+protected:
+  MPEG2TransportStreamPIDFilter(UsageEnvironment& env, FramedSource* inputSource);
+      // called only by createNew()
+  virtual ~MPEG2TransportStreamPIDFilter();
+
+private:
+  // redefined virtual functions:
+  virtual void doGetNextFrame();
+
+private:
+  static void afterGettingFrame(void* clientData, unsigned frameSize,
+                                unsigned numTruncatedBytes,
+                                struct timeval presentationTime,
+                                unsigned durationInMicroseconds);
+  void afterGettingFrame1(unsigned frameSize,
+                          struct timeval presentationTime,
+                          unsigned durationInMicroseconds);
+
+  Boolean packetIsToBeKept(u_int16_t pid) const;
+  void handlePSIPacket(PIDFilterPSIStream* psiStream, unsigned char const* pkt);
+  void appendToSection(PIDFilterPSIStream* psiStream, unsigned char const* data, unsigned dataSize);
+  void handleSection(PIDFilterPSIStream* psiStream);
+  Boolean rewritePAT(unsigned char* section, unsigned& sectionSize);
+  Boolean rewritePMT(u_int16_t pid, unsigned char* section, unsigned& sectionSize);
+  void queueSection(PIDFilterPSIStream* psiStream, unsigned char const* section, unsigned sectionSize);
+  void flushPendingPackets(unsigned char*& to, unsigned char const* limit);
+
+  Boolean programIsSelected(u_int16_t programNumber) const;
+  PIDFilterPSIStream* lookupPSIStream(u_int16_t pid) const;
+  void addPMTPID(u_int16_t pid);
+  void removePMTPID(u_int16_t pid);
+  void deleteProgram(unsigned index);
+
+private:
+  // Per-PID state:
+  u_int8_t fPIDFlags[0x2000];
+  u_int16_t fPIDUseCount[0x2000]; // the number of (PMT, PCR and elementary stream) uses by kept programs
+
+  u_int16_t* fSelectedPrograms;
+  unsigned fNumSelectedPrograms;
+
+  PIDFilterProgram** fPrograms; // the kept programs (from the most recent PAT)
+  unsigned fNumPrograms;
+  PIDFilterPSIStream** fPSIStreams; // the PAT, and PMTs, being parsed (and rewritten)
+  unsigned fNumPSIStreams;
+
+  // Rewritten PAT and PMT packets that have not yet been delivered:
+  unsigned char* fPendingPackets;
+  unsigned fNumPendingBytes;
+
+  unsigned fNumPendingBytesAtStart; // in "fTo" (for the current read)
+  unsigned fDurationOfRemovedData; // in microseconds
+
+  u_int64_t fNumPacketsIn, fNumPacketsOut, fNumNullPacketsRemoved, fNumPacketsRemoved, fNumBadPackets;
+  unsigned fNumSectionsRewritten;
+};
+
+#endif
@@ -0,0 +1,97 @@
+/**********
+This library is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the
+Free Software Foundation; either version 3 of the License, or (at your
+option) any later version. (See <http://www.gnu.org/copyleft/lesser.html>.)
+
+This library is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+**********/
+// "liveMedia"
+// Copyright (c) 1996-2017 Live Networks, Inc.  All rights reserved.
+// A filter that collects incoming MPEG Transport Stream packets into chunks (each to be sent in a single
+// outgoing (UDP or RTP) packet), and delivers each chunk at the time given by the stream's PCRs.
+// This turns a bursty input (e.g., a relayed stream) into a smooth, constant bit rate output.
+// C++ header
+
+#ifndef _MPEG2_TRANSPORT_STREAM_PACER_HH
+#define _MPEG2_TRANSPORT_STREAM_PACER_HH
+
+#ifndef _FRAMED_FILTER_HH
+#include "FramedFilter.hh"
+#endif
+
+class MPEG2TransportStreamPacer: public FramedFilter {
+public:
+  static MPEG2TransportStreamPacer* createNew(UsageEnvironment& env, FramedSource* inputSource,
+					      unsigned numTSPacketsPerChunk = 7,
+					      unsigned latencyInMicroseconds = 100000);
+      // "latencyInMicroseconds" is how long each chunk is delayed (beyond the time that's implied by the PCR schedule),
+      // to allow for input that arrives late.
+
+  // Pacing statistics:
+  u_int64_t numChunksDelivered() const { return fNumChunksDelivered; } // (not counting chunks delivered before the
+      // bit rate was known)
+  u_int64_t numLateChunks() const { return fNumLateChunks; } // chunks whose data arrived after their scheduled time
+  unsigned numResyncs() const { return fNumResyncs; } // times that the schedule was reset (e.g., at a PCR discontinuity)
+  double meanJitter() const; // in microseconds: the mean difference between each chunk's actual and scheduled delivery time
+  double maxJitter() const { return fMaxJitter; } // in microseconds
+  double bitrate() const; // in bits/second, as implied by the PCRs (0 if not yet known)
+  void resetPacingStats();
+
+protected:
+  MPEG2TransportStreamPacer(UsageEnvironment& env, FramedSource* inputSource,
+			    unsigned numTSPacketsPerChunk, unsigned latencyInMicroseconds);
+      // called only by createNew()
+  virtual ~MPEG2TransportStreamPacer();
+
+private:
+  // redefined virtual functions:
+  virtual void doGetNextFrame();
+  virtual void doStopGettingFrames();
+
+private:
+  static void afterGettingFrame(void* clientData, unsigned frameSize,
+                                unsigned numTruncatedBytes,
+                                struct timeval presentationTime,
+                                unsigned durationInMicroseconds);
+  void afterGettingFrame1(unsigned frameSize);
+  static void handleInputClosure(void* clientData);
+
+  void deliverChunk();
+  void resync(double streamTime, double timeNow);
+  static void deliverScheduledChunk(void* clientData);
+  void recordJitter(double jitter);
+
+private:
+  unsigned const fNumTSPacketsPerChunk;
+  double const fLatency; // seconds
+
+  unsigned char* fInputBuffer;
+  unsigned fInputBufferSize;
+  unsigned fInputBufferStart, fInputBufferEnd; // the unread data is [fInputBufferStart, fInputBufferEnd)
+  Boolean fInputHasClosed;
+
+  // The PCR 'clock' (from one PID), and the resulting schedule:
+  u_int64_t fTSPacketCount;
+  Boolean fHavePCR;
+  unsigned fPCRPID;
+  double fLastPCR;
+  u_int64_t fLastPCRPacketNum;
+  double fTSPacketDuration; // seconds (0.0 if not yet known)
+  Boolean fScheduleIsValid;
+  double fScheduleRealTimeBase, fScheduleStreamTimeBase;
+  double fScheduledTime;
+
+  u_int64_t fNumChunksDelivered, fNumLateChunks;
+  unsigned fNumResyncs;
+  double fTotalJitter, fMaxJitter;
+};
+
+#endif
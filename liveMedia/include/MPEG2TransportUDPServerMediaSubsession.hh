@@ -33,6 +33,16 @@ public:
 	    char const* inputAddressStr, // An IP multicast address, or use "0.0.0.0" or NULL for unicast input
 	    Port const& inputPort,
 	    Boolean inputStreamIsRawUDP = False); // otherwise (default) the input stream is RTP/UDP
+
+  void enableFanOut(unsigned outputBatchSize = 64);
+      // Call this (before any clients connect) to 'fan out' the input stream: Each incoming datagram is then sent -
+      // as soon as it arrives, without reassembly or pacing - as (usually) one RTP packet, which is built just once, and
+      // sent to all current clients (which share the same SSRC, sequence numbers and timestamps).  If "outputBatchSize"
+      // is > 1, then the copies of each packet (one per client) are sent using a single system call, if possible.
+      // (See "OutputSocket::setOutputBatchSize()".)
+      // Note: Because there's no reassembly, each incoming datagram (or RTP payload) must consist of whole (188-byte)
+      // Transport Stream packets; any that doesn't is dropped.  (Without fan-out, a 'framer' resynchronizes instead.)
+
 protected:
   MPEG2TransportUDPServerMediaSubsession(UsageEnvironment& env,
 					 char const* inputAddressStr, Port const& inputPort, Boolean inputStreamIsRawUDP);
@@ -50,6 +60,8 @@ protected:
   Port fInputPort;
   Groupsock* fInputGroupsock;
   Boolean fInputStreamIsRawUDP;
+  Boolean fFanOut;
+  unsigned fOutputBatchSize;
 };
 
 #endif
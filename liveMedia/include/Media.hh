@@ -125,6 +125,7 @@ public:
 
   MediaLookupTable* mediaTable;
   void* socketTable;
+  void* sdpCache; // a "MediaFileSDPCache"; not needed for us to be reclaimed
 
 protected:
   _Tables(UsageEnvironment& env);
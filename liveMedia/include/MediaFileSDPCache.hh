@@ -0,0 +1,69 @@
+/**********
+This library is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the
+Free Software Foundation; either version 3 of the License, or (at your
+option) any later version. (See <http://www.gnu.org/copyleft/lesser.html>.)
+
+This library is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+**********/
+// "liveMedia"
+// Copyright (c) 1996-2017 Live Networks, Inc.  All rights reserved.
+// A cache of information about media files - e.g., the 'config' SDP lines (parameter sets) of video files - that is
+// otherwise expensive to get (because the file needs to be read and parsed).  Each entry is keyed by the file's name,
+// size and modification time (so a changed file's entries are automatically discarded), and is kept in memory, and
+// (optionally) also in a 'sidecar' file ("<file-name>.sdpcache"), so that it survives a restart of the server.
+// C++ header
+
+#ifndef _MEDIA_FILE_SDP_CACHE_HH
+#define _MEDIA_FILE_SDP_CACHE_HH
+
+#ifndef _MEDIA_HH
+#include "Media.hh"
+#endif
+
+class MediaFileSDPCacheEntry; // forward
+
+class MediaFileSDPCache {
+public:
+  static MediaFileSDPCache* ourCache(UsageEnvironment& env);
+      // Returns the cache that's used in "env" (creating it, if necessary)
+
+  void setUseSidecarFiles(Boolean useSidecarFiles) { fUseSidecarFiles = useSidecarFiles; }
+      // By default, entries are kept only in memory.  If "useSidecarFiles" is True, they are also written to (and,
+      // if not already in memory, read from) a 'sidecar' file next to each media file.
+
+  char const* lookup(char const* fileName, char const* key);
+      // Returns the value that was cached for "key" and the current version (size and modification time) of
+      // "fileName", or NULL if none was.
+  void add(char const* fileName, char const* key, char const* value);
+      // (This does nothing if the file doesn't exist.)
+
+  // Statistics:
+  unsigned numHits() const { return fNumHits; }
+  unsigned numMisses() const { return fNumMisses; }
+
+protected:
+  MediaFileSDPCache(UsageEnvironment& env); // called only by "ourCache()"
+  virtual ~MediaFileSDPCache();
+  friend class _Tables; // which deletes us
+
+private:
+  MediaFileSDPCacheEntry* lookupFileEntry(char const* fileName, Boolean createIfNotPresent);
+  MediaFileSDPCacheEntry* readSidecarFile(char const* fileName, u_int64_t fileSize, long modificationTime);
+  void writeSidecarFile(char const* fileName, MediaFileSDPCacheEntry* fileEntry);
+
+private:
+  UsageEnvironment& fEnv;
+  HashTable* fFileEntries; // maps file names to "MediaFileSDPCacheEntry"s
+  Boolean fUseSidecarFiles;
+  unsigned fNumHits, fNumMisses;
+};
+
+#endif
@@ -37,6 +37,18 @@ public:
     fOnSendErrorData = onSendErrorFuncData;
   }
 
+  Boolean enableKernelPacing(unsigned lookaheadMicroseconds = 2000);
+      // Has the kernel - rather than our event loop - send each RTP packet at its scheduled time (using "SO_TXTIME").
+      // We then hand packets to the kernel up to "lookaheadMicroseconds" before they're due, waking up less often.
+      // Returns False (and leaves pacing to the event loop, as before) if the kernel doesn't support this.
+      // NOTE: This works only if the outgoing interface uses the "fq" (or "etf") queueing discipline (see
+      // "OutputSocket::enableLaunchTimes()").  Otherwise, each packet is sent up to "lookaheadMicroseconds" early -
+      // so don't make this much larger than the default unless you know that "fq" or "etf" is being used.
+      // (If the kernel reports that it dropped packets, we go back to pacing them ourself.)
+  Boolean setMaxPacingRate(unsigned bytesPerSecond);
+      // Has the kernel spread out the packets that we send so that they're sent at no more than this rate (using
+      // "SO_MAX_PACING_RATE"; this also requires the "fq" queueing discipline).  Returns False if this isn't supported.
+
 protected:
   MultiFramedRTPSink(UsageEnvironment& env,
 		     Groupsock* rtpgs, unsigned char rtpPayloadType,
@@ -72,6 +84,12 @@ protected:
       // frame of size "newFrameSize" to the current RTP packet.
       // (By default, this just calls "numOverflowBytes()", but subclasses can redefine
       // this to (e.g.) impose a granularity upon RTP payload fragments.)
+  virtual Boolean frameIsDiscardable(unsigned fragmentationOffset,
+				     unsigned char const* frameStart,
+				     unsigned numBytesInFrame) const;
+      // whether this frame (e.g., a non-key video frame) could be dropped - if the
+      // receiver can't keep up - without affecting the decoding of later key frames.
+      // A packet is sent as 'discardable' only if all of its frames are. (default: False)
 
   // Functions that might be called by doSpecialFrameHandling(), or other subclass virtual functions:
   Boolean isFirstPacket() const { return fIsFirstPacket; }
@@ -124,7 +142,10 @@ private:
   Boolean fPreviousFrameEndedFragmentation;
 
   Boolean fIsFirstPacket;
+  Boolean fCurrentPacketIsDiscardable;
   struct timeval fNextSendTime;
+  struct timeval fCurPacketSendTime; // when the packet that's being built is due to be sent
+  unsigned fKernelPacingLookahead; // 0 if kernel pacing is not being used
   unsigned fTimestampPosition;
   unsigned fSpecialHeaderPosition;
   unsigned fSpecialHeaderSize; // size in bytes of any special header used
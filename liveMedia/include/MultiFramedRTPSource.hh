@@ -30,6 +30,22 @@ class BufferedPacket; // forward
 class BufferedPacketFactory; // forward
 
 class MultiFramedRTPSource: public RTPSource {
+public:
+  void setReceiveBatchSize(unsigned batchSize);
+      // If "batchSize" > 1, then - when our (UDP) socket becomes readable - we read up to "batchSize" packets at once,
+      // using a single system call (if possible), before processing them.  (The default "batchSize" is 1.)
+      // (Groupsock::statsGroupIncomingBatches counts the sizes of the batches that we actually read.)
+
+  typedef void (afterGettingRTPPacketFunc)(void* clientData, BufferedPacket* packet);
+  void setPacketMode(afterGettingRTPPacketFunc* afterGettingRTPPacketFunc, void* afterGettingRTPPacketClientData);
+      // Puts us in 'packet mode', for consumers (e.g., relays) that want the incoming RTP packets, rather than frames.
+      // Once "getNextFrame()" has been called, each incoming packet - after its RTP header has been checked, and the
+      // packet has been put in sequence-number order - is passed, by reference, to "afterGettingRTPPacketFunc".
+      // The packet (including its RTP header: see "BufferedPacket::rtpPacket()") is valid only during this call.
+      // No frames are assembled, so the "getNextFrame()" call never completes; instead, packets continue to be
+      // delivered until "stopGettingFrames()" is called (which "afterGettingRTPPacketFunc" may do), or we're closed.
+      // (Call "setPacketMode(NULL, NULL)" to return to delivering frames.)
+
 protected:
   MultiFramedRTPSource(UsageEnvironment& env, Groupsock* RTPgs,
 		       unsigned char rtpPayloadFormat,
@@ -66,6 +82,9 @@ private:
 
   static void networkReadHandler(MultiFramedRTPSource* source, int /*mask*/);
   void networkReadHandler1();
+  void readPacketBatch();
+  Boolean processIncomingPacket(BufferedPacket* bPacket, struct sockaddr_in& fromAddress);
+  void deliverPackets();
 
   Boolean fAreDoingNetworkReads;
   BufferedPacket* fPacketReadInProgress;
@@ -73,6 +92,10 @@ private:
   Boolean fPacketLossInFragmentedFrame;
   unsigned char* fSavedTo;
   unsigned fSavedMaxSize;
+  unsigned fReceiveBatchSize;
+  unsigned fNumDirectDeliveriesAllowed;
+  afterGettingRTPPacketFunc* fAfterGettingRTPPacketFunc;
+  void* fAfterGettingRTPPacketClientData;
 
   // A buffer to (optionally) hold incoming pkts that have been reorderered
   class ReorderingPacketBuffer* fReorderingBuffer;
@@ -92,6 +115,9 @@ public:
   unsigned useCount() const { return fUseCount; }
 
   Boolean fillInData(RTPInterface& rtpInterface, struct sockaddr_in& fromAddress, Boolean& packetReadWasIncomplete);
+  unsigned char* prepareForDatagramRead(unsigned& maxBytesToRead);
+  void noteDatagramRead(unsigned numBytesRead) { fTail += numBytesRead; fRTPPacketSize = fTail; }
+      // an alternative to "fillInData()", used when a datagram is read (as part of a batch) directly into our buffer
   void assignMiscParams(unsigned short rtpSeqNo, unsigned rtpTimestamp,
 			struct timeval presentationTime,
 			Boolean hasBeenSyncedUsingRTCP,
@@ -108,8 +134,15 @@ public:
   BufferedPacket*& nextPacket() { return fNextPacket; }
 
   unsigned short rtpSeqNo() const { return fRTPSeqNo; }
+  unsigned rtpTimestamp() const { return fRTPTimestamp; }
+  struct timeval const& presentationTime() const { return fPresentationTime; }
+  Boolean hasBeenSyncedUsingRTCP() const { return fHasBeenSyncedUsingRTCP; }
   struct timeval const& timeReceived() const { return fTimeReceived; }
 
+  unsigned char* rtpPacket() const { return fBuf; }
+  unsigned rtpPacketSize() const { return fRTPPacketSize; }
+      // the complete RTP packet, as received (including its RTP header, and any padding)
+
   unsigned char* data() const { return &fBuf[fHead]; }
   unsigned dataSize() const { return fTail-fHead; }
   Boolean rtpMarkerBit() const { return fRTPMarkerBit; }
@@ -130,6 +163,7 @@ protected:
   unsigned char* fBuf;
   unsigned fHead;
   unsigned fTail;
+  unsigned fRTPPacketSize;
 
 private:
   BufferedPacket* fNextPacket; // used to link together packets
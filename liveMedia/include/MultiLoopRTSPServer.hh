@@ -0,0 +1,97 @@
+/**********
+This library is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the
+Free Software Foundation; either version 3 of the License, or (at your
+option) any later version. (See <http://www.gnu.org/copyleft/lesser.html>.)
+
+This library is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+**********/
+// "liveMedia"
+// Copyright (c) 1996-2017 Live Networks, Inc.  All rights reserved.
+// A RTSP server that runs several event loops (threads), sharing one port
+// C++ header
+
+#ifndef _MULTI_LOOP_RTSP_SERVER_HH
+#define _MULTI_LOOP_RTSP_SERVER_HH
+
+#ifndef _RTSP_SERVER_HH
+#include "RTSPServer.hh"
+#endif
+#include <pthread.h>
+
+// A "MultiLoopRTSPServer" runs several event loops - each in its own thread (pinned to a CPU core,
+// where supported), and each with its own "TaskScheduler", "UsageEnvironment" and "RTSPServer".
+// Each loop's server listens on the same port (using SO_REUSEPORT), so that the kernel spreads
+// incoming client connections among the loops.  Each client connection - and the streams that it
+// sets up - is then handled entirely by the loop that accepted it.
+//
+// Because "ServerMediaSession" objects belong to a single "UsageEnvironment", each loop has its own
+// copy of the server's catalog: The "createServerFunc" (which is called, within each loop's thread,
+// to create that loop's server) should add the same "ServerMediaSession"s to each server (or, like
+// "DynamicRTSPServer", should create a server that creates its "ServerMediaSession"s on demand).
+//
+// Note: A client that uses more than one TCP connection for the same RTSP session (including
+// RTSP-over-HTTP tunneling) may have those connections accepted by different loops.  Therefore,
+// RTSP-over-HTTP tunneling, if needed, should be set up on just one loop's server.
+
+class MultiLoopRTSPServer {
+public:
+  typedef RTSPServer* (createServerFunc)(UsageEnvironment& env, Port ourPort, Boolean reusePort,
+					 unsigned loopIndex, void* clientData);
+      // Should create a "RTSPServer" (or subclass) object - passing it "ourPort" and "reusePort" -
+      // and populate it.  Returns NULL (with "env"s result message set) on failure.
+
+  static MultiLoopRTSPServer* createNew(UsageEnvironment& env, Port ourPort,
+					createServerFunc* createServer, void* clientData = NULL,
+					unsigned numLoops = 0, Boolean pinToCores = True);
+      // Creates and starts "numLoops" event loops (or, if "numLoops" is 0, one per CPU core).
+      // "ourPort" must be nonzero.  We return only after each loop has created its server;
+      // if any loop fails to do so, we return NULL (and set "env"s result message).
+  virtual ~MultiLoopRTSPServer(); // stops each event loop, and waits for its thread to finish
+
+  unsigned numLoops() const { return fNumLoops; }
+
+private:
+  MultiLoopRTSPServer(Port ourPort, createServerFunc* createServer, void* clientData,
+		      unsigned numLoops, Boolean pinToCores);
+      // called only by createNew()
+
+  Boolean startLoops(UsageEnvironment& env);
+  void stopLoops();
+
+  static void* threadEntry(void* loop);
+
+private:
+  class EventLoop {
+  public:
+    EventLoop();
+    virtual ~EventLoop();
+
+    MultiLoopRTSPServer* fOurServer;
+    unsigned fLoopIndex;
+    pthread_t fThread;
+    Boolean fThreadStarted;
+    char volatile fWatchVariable; // set to 1 to make the loop's thread finish
+    int fSetupResult; // 0 while the server is being created; then 1 (success) or -1 (failure)
+    char* fErrorMsg; // set if "fSetupResult" is -1
+  };
+
+  Port fOurPort;
+  createServerFunc* fCreateServerFunc;
+  void* fClientData;
+  unsigned fNumLoops;
+  Boolean fPinToCores;
+  EventLoop* fLoops;
+
+  pthread_mutex_t fMutex;
+  pthread_cond_t fSetupCond; // signaled when a loop's "fSetupResult" becomes nonzero
+};
+
+#endif
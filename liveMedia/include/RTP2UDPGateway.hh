@@ -0,0 +1,109 @@
+/**********
+This library is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the
+Free Software Foundation; either version 3 of the License, or (at your
+option) any later version. (See <http://www.gnu.org/copyleft/lesser.html>.)
+
+This library is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+**********/
+// "liveMedia"
+// Copyright (c) 1996-2017 Live Networks, Inc.  All rights reserved.
+// A gateway that receives a RTP stream, and forwards the payload of each RTP packet as a UDP datagram - directly from
+// the socket read handler, and without copying.  Packets are reordered (by RTP sequence number) only if they arrive
+// out of order.  (This is a much cheaper alternative to a "SimpleRTPSource" feeding a "BasicUDPSink".)
+// C++ header
+
+#ifndef _RTP2UDP_GATEWAY_HH
+#define _RTP2UDP_GATEWAY_HH
+
+#ifndef _MEDIA_HH
+#include "Media.hh"
+#endif
+#ifndef _GROUPSOCK_HH
+#include "Groupsock.hh"
+#endif
+
+class RTP2UDPGateway: public Medium {
+public:
+  static RTP2UDPGateway* createNew(UsageEnvironment& env, Groupsock* inputGS, Groupsock* outputGS,
+				   unsigned receiveBatchSize = 32, unsigned maxPacketSize = 2048);
+      // "inputGS" receives the RTP stream; "outputGS" sends the payloads.
+      // When "inputGS"s socket becomes readable, we read up to "receiveBatchSize" packets (each of up to "maxPacketSize"
+      // bytes) at once, using a single system call (if possible).
+
+  void setReorderingThresholdTime(unsigned uSeconds) { fReorderingThresholdTime = uSeconds; }
+      // How long we wait for a missing packet (holding back the packets that follow it) before giving up on it.
+      // (The default is 100 ms - the same as for "RTPSource"s.)
+  void setPayloadType(unsigned char rtpPayloadType) { fRTPPayloadType = rtpPayloadType; }
+      // If called, then only RTP packets with this payload type are forwarded.  (By default, all are forwarded.)
+
+  void startForwarding();
+  void stopForwarding();
+
+  // Statistics:
+  u_int64_t numPacketsReceived() const { return fNumPacketsReceived; }
+  u_int64_t numPacketsForwarded() const { return fNumPacketsForwarded; }
+  u_int64_t numPacketsReordered() const { return fNumPacketsReordered; } // arrived early, and were held back
+  u_int64_t numPacketsLost() const { return fNumPacketsLost; } // that we gave up waiting for
+  u_int64_t numPacketsDiscarded() const { return fNumPacketsDiscarded; } // bad, duplicate, or arrived too late
+  unsigned numResyncs() const { return fNumResyncs; } // times that we started again (at a new SSRC or a large jump)
+
+protected:
+  RTP2UDPGateway(UsageEnvironment& env, Groupsock* inputGS, Groupsock* outputGS,
+		 unsigned receiveBatchSize, unsigned maxPacketSize);
+      // called only by createNew()
+  virtual ~RTP2UDPGateway();
+
+private:
+  static void incomingPacketHandler(RTP2UDPGateway* gateway, int mask);
+  void incomingPacketHandler1();
+  void handlePacket(unsigned i);
+  void forwardPacket(unsigned char* payload, unsigned payloadSize);
+  void holdPacket(unsigned i, u_int16_t seqNo, unsigned char* payload, unsigned payloadSize);
+  void forwardHeldPackets();
+  void releaseHeldPackets();
+  static void reorderingTimeoutHandler(void* clientData);
+  void reorderingTimeoutHandler1();
+  void resync(u_int32_t ssrc, u_int16_t seqNo);
+
+private:
+  Groupsock* fInputGS;
+  Groupsock* fOutputGS;
+  unsigned fReceiveBatchSize, fMaxPacketSize;
+  unsigned fReorderingThresholdTime; // in microseconds
+  int fRTPPayloadType; // -1 means 'any'
+  Boolean fIsForwarding;
+
+  // The buffers that we're reading the next batch into, and the spare buffers that can replace any that we hold back:
+  unsigned char** fReceiveBuffers;
+  unsigned* fReceivedPacketSizes;
+  unsigned char** fSpareBuffers;
+  unsigned fNumSpareBuffers;
+
+  // Packets that have been held back (awaiting an earlier packet), indexed by sequence number (mod the table size):
+  struct HeldPacket {
+    unsigned char* buffer; // NULL if the slot is empty
+    unsigned char* payload;
+    unsigned payloadSize;
+  };
+  HeldPacket* fHeldPackets;
+  unsigned fNumHeldPackets;
+  u_int16_t fHighestHeldSeqNo;
+  TaskToken fReorderingTimeoutTask;
+
+  Boolean fHaveSeenFirstPacket;
+  u_int32_t fSSRC;
+  u_int16_t fNextExpectedSeqNo;
+
+  u_int64_t fNumPacketsReceived, fNumPacketsForwarded, fNumPacketsReordered, fNumPacketsLost, fNumPacketsDiscarded;
+  unsigned fNumResyncs;
+};
+
+#endif
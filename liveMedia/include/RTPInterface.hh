@@ -50,6 +50,7 @@ public:
   tcpStreamRecord* fNext;
   int fStreamSocketNum;
   unsigned char fStreamChannelId;
+  Boolean fIsDroppingDiscardablePackets; // until the next non-discardable packet
 };
 
 class RTPInterface {
@@ -66,7 +67,24 @@ public:
 						     ServerRequestAlternativeByteHandler* handler, void* clientData);
   static void clearServerRequestAlternativeByteHandler(UsageEnvironment& env, int socketNum);
 
-  Boolean sendPacket(unsigned char* packet, unsigned packetSize);
+  Boolean sendPacket(unsigned char* packet, unsigned packetSize, Boolean isDiscardable = False);
+      // "isDiscardable" is a hint that the packet (e.g., one that contains part of a non-key video frame) may be dropped,
+      // if it's being sent over a TCP connection that can't keep up.  (See "tcpSendQueueMaxSize", below.)
+
+  // RTP/RTCP packets are sent over TCP connections without blocking: Data that can't be sent immediately is queued
+  // (for each TCP connection), and sent when the socket becomes writable again.  If a connection's queue has more than
+  // "tcpSendQueueDiscardThreshold" bytes, then 'discardable' packets are dropped (along with each subsequent discardable
+  // packet for the same stream, until the next non-discardable packet).  If a packet would make a connection's queue grow
+  // larger than "tcpSendQueueMaxSize" bytes, then the discardable packets are removed from the queue; if that's not enough,
+  // then the connection is closed.
+  static unsigned tcpSendQueueMaxSize; // default: 1000000 bytes
+  static unsigned tcpSendQueueDiscardThreshold; // default: 250000 bytes
+
+  static Boolean sendDataOverStreamSocket(UsageEnvironment& env, int socketNum, u_int8_t const* data, unsigned dataSize);
+      // Sends other data (e.g., a RTSP response) over a TCP connection that might also be carrying RTP/RTCP packets.
+      // If the connection has RTP/RTCP data queued for sending, then the new data is queued after it, so that it doesn't
+      // get interleaved within a partially-sent packet.  (This is so even after the connection's last RTP/RTCP stream
+      // has been closed - until its queued data has been sent.)
   void startNetworkReading(TaskScheduler::BackgroundHandlerProc*
                            handlerProc);
   Boolean handleRead(unsigned char* buffer, unsigned bufferMaxSize,
@@ -81,6 +99,15 @@ public:
   // Otherwise (if "tcpSocketNum" >= 0), the packet was received (interleaved) over TCP, and
   //   "tcpStreamChannelId" will return the channel id.
 
+  Boolean nextReadIsFromDatagramSocket() const { return fNextTCPReadStreamSocketNum < 0; }
+  int handleReadBatch(unsigned char* const* buffers, unsigned bufferMaxSize,
+		      // out parameters:
+		      unsigned* bytesRead, struct sockaddr_in* fromAddresses,
+		      unsigned maxPackets);
+  // Reads up to "maxPackets" packets at once from our 'groupsock'.  This may be called only if
+  //   "nextReadIsFromDatagramSocket()" is True.  Returns the number of packets read, or -1 on error.
+  //   (Packets that are to be ignored are returned with "bytesRead[i]" == 0.)
+
   void stopNetworkReading();
 
   UsageEnvironment& envir() const { return fOwner->envir(); }
@@ -97,10 +124,9 @@ public:
     // is also being read from elsewhere.)
 
 private:
-  // Helper functions for sending a RTP or RTCP packet over a TCP connection:
+  // Helper function for sending a RTP or RTCP packet over a TCP connection:
   Boolean sendRTPorRTCPPacketOverTCP(unsigned char* packet, unsigned packetSize,
-				     int socketNum, unsigned char streamChannelId);
-  Boolean sendDataOverTCP(int socketNum, u_int8_t const* data, unsigned dataSize, Boolean forceSendToSucceed);
+				     tcpStreamRecord* stream, Boolean isDiscardable);
 
 private:
   friend class SocketDescriptor;
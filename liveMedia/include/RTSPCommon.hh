@@ -51,6 +51,9 @@ Boolean parseRTSPRequestString(char const *reqStr, unsigned reqStrSize,
 			       unsigned resultSessionIdMaxSize,
 			       unsigned& contentLength);
 
+void decodeURL(char* url);
+    // Replaces (in place) any %<hex><hex> sequences in "url" with the corresponding 8-bit character
+
 Boolean parseRangeParam(char const* paramStr, double& rangeStart, double& rangeEnd, char*& absStartTime, char*& absEndTime, Boolean& startTimeIsNow);
 Boolean parseRangeHeader(char const* buf, double& rangeStart, double& rangeEnd, char*& absStartTime, char*& absEndTime, Boolean& startTimeIsNow);
 
@@ -0,0 +1,116 @@
+/**********
+This library is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the
+Free Software Foundation; either version 3 of the License, or (at your
+option) any later version. (See <http://www.gnu.org/copyleft/lesser.html>.)
+
+This library is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+**********/
+// "liveMedia"
+// Copyright (c) 1996-2017 Live Networks, Inc.  All rights reserved.
+// An incremental parser for RTSP requests (as received by a server).  It keeps its place between calls, so that
+// each byte of a request is examined only once, however many reads it takes to arrive, and it returns the
+// parsed fields as 'views' of (i.e., pointers into) the request, rather than copies.
+// C++ header
+
+#ifndef _RTSP_REQUEST_PARSER_HH
+#define _RTSP_REQUEST_PARSER_HH
+
+#ifndef _BOOLEAN_HH
+#include "Boolean.hh"
+#endif
+#ifndef _NET_COMMON_H
+#include "NetCommon.h"
+#endif
+
+// A (non-'\0'-terminated) string within a request:
+class RTSPStringView {
+public:
+  RTSPStringView(char const* str = NULL, unsigned length = 0): fStr(str), fLength(length) {}
+
+  char const* str() const { return fStr; } // NULL if the field wasn't present
+  unsigned length() const { return fLength; }
+
+  Boolean equals(char const* s) const; // a case-sensitive comparison with the '\0'-terminated string "s"
+  Boolean copyTo(char* result, unsigned resultMaxSize) const;
+      // Copies the string (truncated, if necessary), '\0'-terminated, into "result".
+      // Returns False iff it had to be truncated.
+
+private:
+  char const* fStr;
+  unsigned fLength;
+};
+
+#define RTSP_REQUEST_PARSER_MAX_NUM_HEADERS 32
+
+class RTSPRequestParser {
+public:
+  RTSPRequestParser();
+  virtual ~RTSPRequestParser();
+
+  void reset(); // prepares for parsing a new request
+
+  Boolean parse(char const* request, unsigned requestSize);
+      // "request" contains the "requestSize" bytes of the request that have been received so far (beginning with the
+      // first byte of the request).  (The data may have been moved since the previous call, but the bytes that were
+      // seen before must not have changed.)  Only those bytes that weren't seen by a previous call are examined.
+      // Returns True iff the request is complete: its headers, and any body (given by a "Content-Length:" header).
+      // (Any bytes after the end of the request - i.e., at "requestSize()" and beyond - are the start of another,
+      // pipelined, request, which can be parsed after calling "reset()".)
+
+  // The following can be called once "parse()" has returned True.  The returned 'views' point into "request",
+  // and remain valid only as long as it does:
+  Boolean isRTSPRequest() const { return fIsRTSPRequest; }
+      // False if the request line did not end with "RTSP/<version>", or there was no "CSeq:" header
+      // (e.g., because the request is a HTTP request)
+  RTSPStringView cmdName() const { return view(fCmdName); }
+  RTSPStringView urlPreSuffix() const { return view(fURLPreSuffix); }
+      // the part of the URL path before the last '/' (still URL-encoded)
+  RTSPStringView urlSuffix() const { return view(fURLSuffix); } // the part of the URL path after the last '/'
+  RTSPStringView cseq() const { return view(fCSeq); }
+  RTSPStringView sessionId() const { return view(fSessionId); } // an empty (NULL) view if there was no "Session:" header
+  unsigned contentLength() const { return fContentLength; } // (0 if there was no "Content-Length:" header)
+  RTSPStringView lookupHeader(char const* headerName) const; // a case-insensitive search; returns the header's value
+
+  unsigned headerSize() const { return fHeaderSize; } // the size of the request line and headers (including the blank line)
+  unsigned endOfHeaderLines() const { return fEndOfHeaderLines; } // the offset of the line ending of the last (non-blank) line
+  unsigned requestSize() const { return fHeaderSize + (fIsRTSPRequest ? fContentLength : 0); }
+      // (Note that we don't wait for the body of a non-RTSP request.)
+
+private:
+  struct Field {
+    unsigned offset, length;
+    Boolean isPresent;
+  };
+  RTSPStringView view(Field const& field) const {
+    return field.isPresent ? RTSPStringView(&fRequest[field.offset], field.length) : RTSPStringView();
+  }
+  static void setField(Field& field, unsigned from, unsigned to); // to the range [from,to)
+
+  void handleRequestLine(unsigned lineStart, unsigned lineEnd);
+  void handleHeaderLine(unsigned lineStart, unsigned lineEnd);
+
+private:
+  char const* fRequest; // as given to the most recent call to "parse()"
+  enum { SKIPPING_WHITESPACE, READING_REQUEST_LINE, READING_HEADERS, READING_BODY, DONE } fState;
+  unsigned fNextPos; // the offset of the first byte that we haven't yet examined
+  unsigned fLineStart;
+
+  Boolean fIsRTSPRequest, fHaveProtocol;
+  Field fCmdName, fURLPreSuffix, fURLSuffix, fCSeq, fSessionId;
+  unsigned fContentLength;
+  struct Header {
+    Field name, value;
+  } fHeaders[RTSP_REQUEST_PARSER_MAX_NUM_HEADERS]; // only the first RTSP_REQUEST_PARSER_MAX_NUM_HEADERS are kept
+  unsigned fNumHeaders;
+  unsigned fHeaderSize, fEndOfHeaderLines;
+};
+
+#endif
@@ -27,13 +27,19 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 #ifndef _DIGEST_AUTHENTICATION_HH
 #include "DigestAuthentication.hh"
 #endif
+#ifndef _RTSP_REQUEST_PARSER_HH
+#include "RTSPRequestParser.hh"
+#endif
 
 class RTSPServer: public GenericMediaServer {
 public:
   static RTSPServer* createNew(UsageEnvironment& env, Port ourPort = 554,
 			       UserAuthenticationDatabase* authDatabase = NULL,
-			       unsigned reclamationSeconds = 65);
+			       unsigned reclamationSeconds = 65,
+			       Boolean reusePort = False);
       // If ourPort.num() == 0, we'll choose the port number
+      // If "reusePort" is True, other servers (e.g., in other threads) may listen on the same port;
+      // see "MultiLoopRTSPServer".
       // Note: The caller is responsible for reclaiming "authDatabase"
       // If "reclamationSeconds" > 0, then the "RTSPClientSession" state for
       //     each client will get reclaimed (and the corresponding RTP stream(s)
@@ -152,6 +158,7 @@ public: // should be protected, but some old compilers complain otherwise
     };
   protected: // redefined virtual functions:
     virtual void handleRequestBytes(int newBytesRead);
+    virtual void resetRequestBuffer();
 
   protected:
     RTSPClientConnection(RTSPServer& ourServer, int clientSocket, struct sockaddr_in clientAddr);
@@ -166,6 +173,8 @@ public: // should be protected, but some old compilers complain otherwise
     virtual void handleCmd_GET_PARAMETER(char const* fullRequestStr); // when operating on the entire server
     virtual void handleCmd_SET_PARAMETER(char const* fullRequestStr); // when operating on the entire server
     virtual void handleCmd_DESCRIBE(char const* urlPreSuffix, char const* urlSuffix, char const* fullRequestStr);
+    virtual void handleCmd_DESCRIBE_afterLookup(ServerMediaSession* session);
+        // called once the "ServerMediaSession" for the "DESCRIBE" has been looked up (which may be done asynchronously)
     virtual void handleCmd_REGISTER(char const* cmd/*"REGISTER" or "DEREGISTER"*/,
 				    char const* url, char const* urlSuffix, char const* fullRequestStr,
 				    Boolean reuseConnection, Boolean deliverViaTCP, char const* proxyURLSuffix);
@@ -188,7 +197,6 @@ public: // should be protected, but some old compilers complain otherwise
     virtual Boolean handleHTTPCmd_TunnelingPOST(char const* sessionCookie, unsigned char const* extraData, unsigned extraDataSize);
     virtual void handleHTTPCmd_StreamingGET(char const* urlSuffix, char const* fullRequestStr);
   protected:
-    void resetRequestBuffer();
     void closeSocketsRTSP();
     static void handleAlternativeRequestByte(void*, u_int8_t requestByte);
     void handleAlternativeRequestByte1(u_int8_t requestByte);
@@ -197,6 +205,10 @@ public: // should be protected, but some old compilers complain otherwise
       // used to implement RTSP-over-HTTP tunneling
     static void continueHandlingREGISTER(ParamsForREGISTER* params);
     virtual void continueHandlingREGISTER1(ParamsForREGISTER* params);
+    static void DESCRIBELookupCompletionFunction(void* clientData, ServerMediaSession* sessionLookedUp);
+    void handleRequestBytes1(int newBytesRead, Boolean newBytesAreDecoded);
+    void deferResponse();
+    void sendDeferredResponse();
 
     // Shortcuts for setting up a RTSP response (prior to sending it):
     void setRTSPResponse(char const* responseStr);
@@ -208,9 +220,14 @@ public: // should be protected, but some old compilers complain otherwise
     int& fClientInputSocket; // aliased to ::fOurSocket
     int fClientOutputSocket;
     Boolean fIsActive;
-    unsigned char* fLastCRLF;
+    RTSPRequestParser fRequestParser; // parses the request in our request buffer
     unsigned fRecursionCount;
     char const* fCurrentCSeq;
+    Boolean fLookupIsPending; // True while we're waiting for an asynchronous "ServerMediaSession" lookup to complete
+    Boolean fResponseIsPending;
+        // True if we've not yet responded to the current request (because we're waiting for something to complete).
+        // Until we do, further requests are read into our buffer, but not handled.
+    char* fPendingCSeq; // a copy of the current request's 'CSeq', while "fResponseIsPending"
     Authenticator fCurrentAuthenticator; // used if access control is needed
     char* fOurSessionCookie; // used for optional RTSP-over-HTTP tunneling
     unsigned fBase64RemainderCount; // used for optional RTSP-over-HTTP tunneling (possible values: 0,1,2,3)
@@ -35,7 +35,8 @@ class RTSPServerSupportingHTTPStreaming: public RTSPServer {
 public:
   static RTSPServerSupportingHTTPStreaming* createNew(UsageEnvironment& env, Port rtspPort = 554,
 						      UserAuthenticationDatabase* authDatabase = NULL,
-						      unsigned reclamationTestSeconds = 65);
+						      unsigned reclamationTestSeconds = 65,
+						      Boolean reusePort = False);
 
   Boolean setHTTPPort(Port httpPort) { return setUpTunnelingOverHTTP(httpPort); }
 
@@ -38,6 +38,9 @@ public:
     //   "StreamReplicator" object by calling "Medium::close()" on it - but you must do so only when "numReplicas()" returns 0.
 
   FramedSource* createStreamReplica();
+    // Each replica can be read either using "getNextFrame()" (in which case each frame is copied into the reader's buffer),
+    // or using "getNextFrameRef()" (in which case each frame is read just once, into a reference-counted "SharedFrame",
+    // which all such readers share - without copying).
 
   unsigned numReplicas() const { return fNumReplicas; }
 
@@ -70,15 +73,20 @@ private:
   void onSourceClosure();
 
   void deliverReceivedFrame();
+  void readNextFrame();
+  void makeCurrentFrame(StreamReplica* fromReplica);
+  void releaseCurrentFrame();
 
 private:
   FramedSource* fInputSource;
   Boolean fDeleteWhenLastReplicaDies, fInputSourceHasClosed; 
   unsigned fNumReplicas, fNumActiveReplicas, fNumDeliveriesMadeSoFar;
   int fFrameIndex; // 0 or 1; used to figure out if a replica is requesting the current frame, or the next frame
+  Boolean fIsDeliveringToReplicas; // True while "deliverReceivedFrame()" is delivering to the non-'master' replicas
 
   StreamReplica* fMasterReplica; // the first replica that requests each frame.  We use its buffer when copying to the others.
   StreamReplica* fReplicasAwaitingCurrentFrame; // other than the 'master' replica
   StreamReplica* fReplicasAwaitingNextFrame; // replicas that have already received the current frame, and have asked for the next
+  SharedFrame* fCurrentFrame; // if non-NULL, the current frame, shared by replicas that were read using "getNextFrameRef()"
 };
 #endif
@@ -28,6 +28,7 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 #include "MP3ADURTPSink.hh"
 #include "MPEG1or2VideoRTPSink.hh"
 #include "MPEG4ESVideoRTPSink.hh"
+#include "MPEG2TransportStreamDatagramRTPSink.hh"
 #include "AMRAudioFileSink.hh"
 #include "H264VideoFileSink.hh"
 #include "H265VideoFileSink.hh"
@@ -71,6 +72,10 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 #include "MPEG2TransportStreamFromPESSource.hh"
 #include "MPEG2TransportStreamFromESSource.hh"
 #include "MPEG2TransportStreamFramer.hh"
+#include "MPEG2TransportStreamPacer.hh"
+#include "MPEG2TransportStreamDejitterBuffer.hh"
+#include "MPEG2TransportStreamPIDFilter.hh"
+#include "MPEG2TransportStreamChecker.hh"
 #include "ADTSAudioFileSource.hh"
 #include "H261VideoRTPSource.hh"
 #include "H263plusVideoRTPSource.hh"
@@ -97,6 +102,7 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 #include "AudioInputDevice.hh"
 #include "WAVAudioFileSource.hh"
 #include "StreamReplicator.hh"
+#include "RTP2UDPGateway.hh"
 #include "RTSPRegisterSender.hh"
 #include "RTSPServerSupportingHTTPStreaming.hh"
 #include "RTSPClient.hh"
@@ -105,6 +111,7 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 #include "QuickTimeGenericRTPSource.hh"
 #include "AVIFileSink.hh"
 #include "PassiveServerMediaSubsession.hh"
+#include "MediaFileSDPCache.hh"
 #include "MPEG4VideoFileServerMediaSubsession.hh"
 #include "H264VideoFileServerMediaSubsession.hh"
 #include "H265VideoFileServerMediaSubsession.hh"
@@ -21,89 +21,330 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 #include "DynamicRTSPServer.hh"
 #include <liveMedia.hh>
 #include <string.h>
+#include <sys/stat.h>
+#if defined(__linux__)
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
 
 DynamicRTSPServer*
 DynamicRTSPServer::createNew(UsageEnvironment& env, Port ourPort,
 			     UserAuthenticationDatabase* authDatabase,
-			     unsigned reclamationTestSeconds) {
-  int ourSocket = setUpOurSocket(env, ourPort);
+			     unsigned reclamationTestSeconds, Boolean reusePort) {
+  int ourSocket = setUpOurSocket(env, ourPort, reusePort);
   if (ourSocket == -1) return NULL;
 
   return new DynamicRTSPServer(env, ourSocket, ourPort, authDatabase, reclamationTestSeconds);
 }
 
+// The version of a file that a "ServerMediaSession" was created from:
+class FileVersion {
+public:
+  Boolean getFor(char const* fileName); // returns False if the file doesn't exist (or isn't a regular file)
+  Boolean operator==(FileVersion const& other) const {
+    return fDevice == other.fDevice && fInode == other.fInode && fSize == other.fSize
+      && fModificationTime == other.fModificationTime;
+  }
+
+public:
+  int watchDescriptor; // if >= 0, changes to the file will be reported to us (so we don't need to check its version)
+
+private:
+  dev_t fDevice;
+  ino_t fInode;
+  off_t fSize;
+  time_t fModificationTime;
+};
+
+Boolean FileVersion::getFor(char const* fileName) {
+  struct stat sb;
+  if (stat(fileName, &sb) != 0 || !S_ISREG(sb.st_mode)) return False;
+
+  fDevice = sb.st_dev;
+  fInode = sb.st_ino;
+  fSize = sb.st_size;
+  fModificationTime = sb.st_mtime;
+  watchDescriptor = -1;
+  return True;
+}
+
+// A "ServerMediaSession" (for a Matroska or Ogg file) that's being created asynchronously - because the file's headers
+// have to be parsed first - along with the lookups that are waiting for it:
+class SMSCreation {
+public:
+  SMSCreation(DynamicRTSPServer& server, char const* streamName, FileVersion const& fileVersion);
+  virtual ~SMSCreation();
+
+  static Boolean start(DynamicRTSPServer& server, char const* streamName, FileVersion const& fileVersion,
+		       GenericMediaServer::lookupServerMediaSessionCompletionFunc* completionFunc,
+		       void* completionClientData);
+      // Returns False (having done nothing) if this type of file doesn't need to be created asynchronously
+
+  char const* streamName() const { return fStreamName; }
+  FileVersion const& fileVersion() const { return fFileVersion; }
+
+  void addWaiter(GenericMediaServer::lookupServerMediaSessionCompletionFunc* completionFunc, void* completionClientData);
+  Boolean removeWaiter(GenericMediaServer::lookupServerMediaSessionCompletionFunc* completionFunc,
+		       void* completionClientData);
+  Boolean removeFirstWaiter(GenericMediaServer::lookupServerMediaSessionCompletionFunc*& completionFunc,
+			    void*& completionClientData);
+  void detachFromServer() { fServer = NULL; } // called if our server is deleted before we complete
+
+private:
+  static void onMatroskaDemuxCreation(MatroskaFileServerDemux* newDemux, void* clientData);
+  static void onOggDemuxCreation(OggFileServerDemux* newDemux, void* clientData);
+  void completeCreation(Medium* demux, ServerMediaSession* sms);
+
+private:
+  DynamicRTSPServer* fServer;
+  char* fStreamName;
+  FileVersion fFileVersion;
+  struct Waiter {
+    GenericMediaServer::lookupServerMediaSessionCompletionFunc* completionFunc;
+    void* completionClientData;
+    Waiter* next;
+  };
+  Waiter* fWaiters;
+};
+
 DynamicRTSPServer::DynamicRTSPServer(UsageEnvironment& env, int ourSocket,
 				     Port ourPort,
 				     UserAuthenticationDatabase* authDatabase, unsigned reclamationTestSeconds)
-  : RTSPServerSupportingHTTPStreaming(env, ourSocket, ourPort, authDatabase, reclamationTestSeconds) {
+  : RTSPServerSupportingHTTPStreaming(env, ourSocket, ourPort, authDatabase, reclamationTestSeconds),
+    fFileVersions(HashTable::create(STRING_HASH_KEYS)), fFileWatchSocket(-1),
+    fSMSCreations(HashTable::create(STRING_HASH_KEYS)) {
+#if defined(__linux__)
+  fFileWatchSocket = inotify_init1(IN_NONBLOCK|IN_CLOEXEC);
+  if (fFileWatchSocket >= 0) {
+    envir().taskScheduler().setBackgroundHandling(fFileWatchSocket, SOCKET_READABLE,
+						  incomingFileEventHandler, this);
+  }
+#endif
 }
 
 DynamicRTSPServer::~DynamicRTSPServer() {
+  // Any "SMSCreation"s that are still in progress will delete themselves when they complete:
+  SMSCreation* creation;
+  while ((creation = (SMSCreation*)fSMSCreations->RemoveNext()) != NULL) creation->detachFromServer();
+  delete fSMSCreations;
+
+  FileVersion* version;
+  while ((version = (FileVersion*)fFileVersions->RemoveNext()) != NULL) delete version;
+  delete fFileVersions;
+
+  if (fFileWatchSocket >= 0) {
+    envir().taskScheduler().turnOffBackgroundReadHandling(fFileWatchSocket);
+    ::close(fFileWatchSocket);
+  }
 }
 
-static ServerMediaSession* createNewSMS(UsageEnvironment& env,
-					char const* fileName, FILE* fid); // forward
+static ServerMediaSession* createNewSMS(UsageEnvironment& env, char const* fileName); // forward
+
+// Synchronous lookups (used, e.g., for "SETUP" or HTTP streaming, rather than "DESCRIBE") are done using the asynchronous
+// lookup.  If this doesn't complete immediately (which is rare, because a "DESCRIBE" will usually have created the
+// "ServerMediaSession" already), then we have to wait for it, within the event loop:
+struct SynchronousLookupState {
+  ServerMediaSession* sms;
+  char watchVariable;
+};
+static void synchronousLookupCompletionFunc(void* clientData, ServerMediaSession* sessionLookedUp) {
+  SynchronousLookupState* lookupState = (SynchronousLookupState*)clientData;
+  lookupState->sms = sessionLookedUp;
+  lookupState->watchVariable = 1;
+}
 
 ServerMediaSession* DynamicRTSPServer
 ::lookupServerMediaSession(char const* streamName, Boolean isFirstLookupInSession) {
-  // First, check whether the specified "streamName" exists as a local file:
-  FILE* fid = fopen(streamName, "rb");
-  Boolean fileExists = fid != NULL;
-
-  // Next, check whether we already have a "ServerMediaSession" for this file:
-  ServerMediaSession* sms = RTSPServer::lookupServerMediaSession(streamName);
-  Boolean smsExists = sms != NULL;
-
-  // Handle the four possibilities for "fileExists" and "smsExists":
-  if (!fileExists) {
-    if (smsExists) {
-      // "sms" was created for a file that no longer exists. Remove it:
-      removeServerMediaSession(sms);
-      sms = NULL;
+  SynchronousLookupState lookupState;
+  lookupState.sms = NULL;
+  lookupState.watchVariable = 0;
+
+  lookupServerMediaSession(streamName, synchronousLookupCompletionFunc, &lookupState, isFirstLookupInSession);
+  if (lookupState.watchVariable == 0) envir().taskScheduler().doEventLoop(&lookupState.watchVariable);
+
+  return lookupState.sms;
+}
+
+void DynamicRTSPServer
+::lookupServerMediaSession(char const* streamName,
+			   lookupServerMediaSessionCompletionFunc* completionFunc, void* completionClientData,
+			   Boolean isFirstLookupInSession) {
+  // If a "ServerMediaSession" for this file is already being created, then just wait for it:
+  SMSCreation* creation = (SMSCreation*)fSMSCreations->Lookup(streamName);
+  if (creation != NULL) {
+    creation->addWaiter(completionFunc, completionClientData);
+    return;
+  }
+
+  ServerMediaSession* sms;
+  if (!isFirstLookupInSession) {
+    // This lookup is for a session that's already using the "ServerMediaSession" for this stream name (e.g., it's
+    // for the session's second "SETUP").  If that "ServerMediaSession" is still registered, then use it, even if the
+    // file has changed in the meantime; otherwise the session would get a different one, and its request would fail:
+    sms = RTSPServer::lookupServerMediaSession(streamName);
+    if (sms != NULL) {
+      (*completionFunc)(completionClientData, sms);
+      return;
+    }
+  }
+
+  // Next, check whether we already have a (still valid) "ServerMediaSession" for this file:
+  FileVersion currentVersion;
+  if (!lookupExistingSMS(streamName, sms, currentVersion)) {
+    // The file is new to us, or has changed in some way.  Create a new "ServerMediaSession" for it.
+    // (We start watching the file first, so that we'll be told if it changes while we're doing this.)
+    forgetFile(streamName);
+    FileVersion* version = new FileVersion(currentVersion);
+    fFileVersions->Add(streamName, version);
+    watchFile(streamName);
+
+    if (SMSCreation::start(*this, streamName, currentVersion, completionFunc, completionClientData)) {
+      return; // "completionFunc" will get called later, once the file's headers have been parsed
     }
+    sms = finishSMSCreation(streamName, createNewSMS(envir(), streamName), currentVersion);
+  }
 
+  (*completionFunc)(completionClientData, sms);
+}
+
+void DynamicRTSPServer
+::cancelLookupServerMediaSession(lookupServerMediaSessionCompletionFunc* completionFunc, void* completionClientData) {
+  HashTable::Iterator* iter = HashTable::Iterator::create(*fSMSCreations);
+  char const* key;
+  SMSCreation* creation;
+  while ((creation = (SMSCreation*)iter->next(key)) != NULL) {
+    while (creation->removeWaiter(completionFunc, completionClientData)) {}
+  }
+  delete iter;
+}
+
+Boolean DynamicRTSPServer
+::lookupExistingSMS(char const* streamName, ServerMediaSession*& sms, FileVersion& currentVersion) {
+  sms = RTSPServer::lookupServerMediaSession(streamName);
+  FileVersion* version = (FileVersion*)fFileVersions->Lookup(streamName);
+
+  // If the file is being watched, then it hasn't changed since "sms" was created (otherwise we'd have forgotten its version),
+  // so we can reuse "sms" without even looking at the file:
+  if (sms != NULL && version != NULL && version->watchDescriptor >= 0) return True;
+
+  // Next, check whether the specified "streamName" exists as a local file:
+  if (!currentVersion.getFor(streamName)) {
+    // Remove any "ServerMediaSession" that was created for a file that no longer exists:
+    forgetFile(streamName);
+    sms = NULL;
+    return True;
+  }
+
+  // Reuse "sms" if the file hasn't changed since it was created:
+  return sms != NULL && version != NULL && *version == currentVersion;
+}
+
+ServerMediaSession* DynamicRTSPServer
+::finishSMSCreation(char const* streamName, ServerMediaSession* sms, FileVersion const& fileVersion) {
+  if (sms == NULL) {
+    forgetFile(streamName); // so that we'll try again next time
     return NULL;
-  } else {
-    if (smsExists && isFirstLookupInSession) { 
-      // Remove the existing "ServerMediaSession" and create a new one, in case the underlying
-      // file has changed in some way:
-      removeServerMediaSession(sms); 
-      sms = NULL;
-    } 
-
-    if (sms == NULL) {
-      sms = createNewSMS(envir(), streamName, fid); 
-      addServerMediaSession(sms);
+  }
+  addServerMediaSession(sms);
+
+  if (fFileVersions->Lookup(streamName) == NULL) {
+    // The file changed while "sms" was being created (so the record of its version was removed).  Use "sms"
+    // for now, but record the earlier version, so that the file will get checked (and "sms" recreated) next time:
+    fFileVersions->Add(streamName, new FileVersion(fileVersion));
+  }
+  return sms;
+}
+
+void DynamicRTSPServer::completeSMSCreation(SMSCreation* creation, ServerMediaSession* sms) {
+  sms = finishSMSCreation(creation->streamName(), sms, creation->fileVersion());
+
+  // Complete each of the lookups that were waiting for "sms".  (We remove each one before calling its
+  // completion function, in case that function cancels - or adds - lookups.)
+  lookupServerMediaSessionCompletionFunc* completionFunc;
+  void* completionClientData;
+  while (creation->removeFirstWaiter(completionFunc, completionClientData)) {
+    (*completionFunc)(completionClientData, sms);
+  }
+
+  fSMSCreations->Remove(creation->streamName());
+  delete creation;
+}
+
+void DynamicRTSPServer::forgetFile(char const* streamName) {
+  removeServerMediaSession(streamName);
+  forgetFileVersion(streamName);
+}
+
+void DynamicRTSPServer::forgetFileVersion(char const* streamName) {
+  FileVersion* version = (FileVersion*)fFileVersions->Lookup(streamName);
+  if (version == NULL) return;
+  fFileVersions->Remove(streamName);
+
+#if defined(__linux__)
+  if (version->watchDescriptor >= 0) {
+    // Stop watching the file, unless it's also being watched for another stream name (e.g., a hard link):
+    HashTable::Iterator* iter = HashTable::Iterator::create(*fFileVersions);
+    char const* key;
+    FileVersion* other;
+    while ((other = (FileVersion*)iter->next(key)) != NULL) {
+      if (other->watchDescriptor == version->watchDescriptor) break;
     }
+    delete iter;
 
-    fclose(fid);
-    return sms;
+    if (other == NULL) inotify_rm_watch(fFileWatchSocket, version->watchDescriptor);
   }
+#endif
+  delete version;
 }
 
-// Special code for handling Matroska files:
-struct MatroskaDemuxCreationState {
-  MatroskaFileServerDemux* demux;
-  char watchVariable;
-};
-static void onMatroskaDemuxCreation(MatroskaFileServerDemux* newDemux, void* clientData) {
-  MatroskaDemuxCreationState* creationState = (MatroskaDemuxCreationState*)clientData;
-  creationState->demux = newDemux;
-  creationState->watchVariable = 1;
+void DynamicRTSPServer::watchFile(char const* streamName) {
+#if defined(__linux__)
+  FileVersion* version = (FileVersion*)fFileVersions->Lookup(streamName);
+  if (fFileWatchSocket < 0 || version == NULL) return;
+
+  version->watchDescriptor
+    = inotify_add_watch(fFileWatchSocket, streamName,
+			IN_MODIFY|IN_ATTRIB|IN_CLOSE_WRITE|IN_MOVE_SELF|IN_DELETE_SELF);
+      // If this fails (e.g., because we've reached the system's limit on watches), we'll just check the file's
+      // version on each lookup instead
+#endif
 }
-// END Special code for handling Matroska files:
 
-// Special code for handling Ogg files:
-struct OggDemuxCreationState {
-  OggFileServerDemux* demux;
-  char watchVariable;
-};
-static void onOggDemuxCreation(OggFileServerDemux* newDemux, void* clientData) {
-  OggDemuxCreationState* creationState = (OggDemuxCreationState*)clientData;
-  creationState->demux = newDemux;
-  creationState->watchVariable = 1;
+void DynamicRTSPServer::incomingFileEventHandler(void* instance, int /*mask*/) {
+  ((DynamicRTSPServer*)instance)->incomingFileEventHandler1();
+}
+
+void DynamicRTSPServer::incomingFileEventHandler1() {
+#if defined(__linux__)
+  char buffer[4096] __attribute__ ((aligned(__alignof__(struct inotify_event))));
+  int bytesRead;
+  while ((bytesRead = read(fFileWatchSocket, buffer, sizeof buffer)) > 0) {
+    for (char* ptr = buffer; ptr < buffer + bytesRead; ) {
+      struct inotify_event const* event = (struct inotify_event const*)ptr;
+      ptr += sizeof (struct inotify_event) + event->len;
+
+      // Forget the version of each file that has changed (or - if events were lost - of every file that we're watching).
+      // Note that more than one stream name might refer to the same file.  (Each file's "ServerMediaSession" stays
+      // registered - so that sessions that are still being set up can go on using it - until the next lookup that
+      // begins a new session; that lookup will find that the file's version is unknown, and so will check the file.)
+      Boolean forgetAll = (event->mask&IN_Q_OVERFLOW) != 0;
+      while (1) {
+	HashTable::Iterator* iter = HashTable::Iterator::create(*fFileVersions);
+	char const* streamName;
+	FileVersion* version;
+	while ((version = (FileVersion*)iter->next(streamName)) != NULL) {
+	  if (version->watchDescriptor >= 0 && (forgetAll || version->watchDescriptor == event->wd)) break;
+	}
+	delete iter;
+	if (version == NULL) break;
+
+	if (event->mask&IN_IGNORED) version->watchDescriptor = -1; // the watch has already been removed
+	forgetFileVersion(streamName);
+      }
+    }
+  }
+#endif
 }
-// END Special code for handling Ogg files:
 
 #define NEW_SMS(description) do {\
 char const* descStr = description\
@@ -111,8 +352,7 @@ char const* descStr = description\
 sms = ServerMediaSession::createNew(env, fileName, fileName, descStr);\
 } while(0)
 
-static ServerMediaSession* createNewSMS(UsageEnvironment& env,
-					char const* fileName, FILE* /*fid*/) {
+static ServerMediaSession* createNewSMS(UsageEnvironment& env, char const* fileName) {
   // Use the file name extension to determine the type of "ServerMediaSession":
   char const* extension = strrchr(fileName, '.');
   if (extension == NULL) return NULL;
@@ -203,38 +443,129 @@ static ServerMediaSession* createNewSMS(UsageEnvironment& env,
 
     NEW_SMS("DV Video");
     sms->addSubsession(DVVideoFileServerMediaSubsession::createNew(env, fileName, reuseSource));
-  } else if (strcmp(extension, ".mkv") == 0 || strcmp(extension, ".webm") == 0) {
-    // Assumed to be a Matroska file (note that WebM ('.webm') files are also Matroska files)
+  }
+  // (Matroska and Ogg files are handled by "SMSCreation", below.)
+
+  return sms;
+}
+
+
+////////// SMSCreation implementation //////////
+
+SMSCreation::SMSCreation(DynamicRTSPServer& server, char const* streamName, FileVersion const& fileVersion)
+  : fServer(&server), fStreamName(strDup(streamName)), fFileVersion(fileVersion), fWaiters(NULL) {
+}
+
+SMSCreation::~SMSCreation() {
+  while (fWaiters != NULL) {
+    Waiter* next = fWaiters->next;
+    delete fWaiters;
+    fWaiters = next;
+  }
+  delete[] fStreamName;
+}
+
+Boolean SMSCreation::start(DynamicRTSPServer& server, char const* streamName, FileVersion const& fileVersion,
+			   GenericMediaServer::lookupServerMediaSessionCompletionFunc* completionFunc,
+			   void* completionClientData) {
+  char const* extension = strrchr(streamName, '.');
+  if (extension == NULL) return False;
+
+  // Note that WebM ('.webm') files are also Matroska files:
+  Boolean isMatroska = strcmp(extension, ".mkv") == 0 || strcmp(extension, ".webm") == 0;
+  Boolean isOgg = strcmp(extension, ".ogg") == 0 || strcmp(extension, ".ogv") == 0 || strcmp(extension, ".opus") == 0;
+  if (!isMatroska && !isOgg) return False;
+
+  SMSCreation* creation = new SMSCreation(server, streamName, fileVersion);
+  server.fSMSCreations->Add(streamName, creation);
+  creation->addWaiter(completionFunc, completionClientData);
+
+  // Create a file server demultiplexor for the file.  This parses the file's headers - one read at a time, from
+  // the event loop - and then calls us back.  (Note that "creation" might get deleted before "createNew()" returns,
+  // if the file couldn't be opened.)
+  UsageEnvironment& env = server.envir();
+  if (isMatroska) {
     OutPacketBuffer::maxSize = 10000000; // allow for some possibly large VP8 or VP9 frames
-    NEW_SMS("Matroska video+audio+(optional)subtitles");
-
-    // Create a Matroska file server demultiplexor for the specified file.
-    // (We enter the event loop to wait for this to complete.)
-    MatroskaDemuxCreationState creationState;
-    creationState.watchVariable = 0;
-    MatroskaFileServerDemux::createNew(env, fileName, onMatroskaDemuxCreation, &creationState);
-    env.taskScheduler().doEventLoop(&creationState.watchVariable);
-
-    ServerMediaSubsession* smss;
-    while ((smss = creationState.demux->newServerMediaSubsession()) != NULL) {
-      sms->addSubsession(smss);
-    }
-  } else if (strcmp(extension, ".ogg") == 0 || strcmp(extension, ".ogv") == 0 || strcmp(extension, ".opus") == 0) {
-    // Assumed to be an Ogg file
-    NEW_SMS("Ogg video and/or audio");
-
-    // Create a Ogg file server demultiplexor for the specified file.
-    // (We enter the event loop to wait for this to complete.)
-    OggDemuxCreationState creationState;
-    creationState.watchVariable = 0;
-    OggFileServerDemux::createNew(env, fileName, onOggDemuxCreation, &creationState);
-    env.taskScheduler().doEventLoop(&creationState.watchVariable);
-
-    ServerMediaSubsession* smss;
-    while ((smss = creationState.demux->newServerMediaSubsession()) != NULL) {
-      sms->addSubsession(smss);
+    MatroskaFileServerDemux::createNew(env, creation->fStreamName, onMatroskaDemuxCreation, creation);
+  } else {
+    OggFileServerDemux::createNew(env, creation->fStreamName, onOggDemuxCreation, creation);
+  }
+  return True;
+}
+
+void SMSCreation::addWaiter(GenericMediaServer::lookupServerMediaSessionCompletionFunc* completionFunc,
+			    void* completionClientData) {
+  // Add the new waiter to the end of the list, so that waiters get completed in order:
+  Waiter** ptr = &fWaiters;
+  while (*ptr != NULL) ptr = &(*ptr)->next;
+
+  Waiter* waiter = new Waiter;
+  waiter->completionFunc = completionFunc;
+  waiter->completionClientData = completionClientData;
+  waiter->next = NULL;
+  *ptr = waiter;
+}
+
+Boolean SMSCreation::removeWaiter(GenericMediaServer::lookupServerMediaSessionCompletionFunc* completionFunc,
+				  void* completionClientData) {
+  for (Waiter** ptr = &fWaiters; *ptr != NULL; ptr = &(*ptr)->next) {
+    Waiter* waiter = *ptr;
+    if (waiter->completionFunc == completionFunc && waiter->completionClientData == completionClientData) {
+      *ptr = waiter->next;
+      delete waiter;
+      return True;
     }
   }
 
-  return sms;
+  return False;
+}
+
+Boolean SMSCreation::removeFirstWaiter(GenericMediaServer::lookupServerMediaSessionCompletionFunc*& completionFunc,
+				       void*& completionClientData) {
+  Waiter* waiter = fWaiters;
+  if (waiter == NULL) return False;
+
+  completionFunc = waiter->completionFunc;
+  completionClientData = waiter->completionClientData;
+  fWaiters = waiter->next;
+  delete waiter;
+  return True;
+}
+
+void SMSCreation::onMatroskaDemuxCreation(MatroskaFileServerDemux* newDemux, void* clientData) {
+  SMSCreation* creation = (SMSCreation*)clientData;
+  ServerMediaSession* sms
+    = ServerMediaSession::createNew(newDemux->envir(), creation->fStreamName, creation->fStreamName,
+				    "Matroska video+audio+(optional)subtitles, streamed by the LIVE555 Media Server");
+
+  ServerMediaSubsession* smss;
+  while ((smss = newDemux->newServerMediaSubsession()) != NULL) {
+    sms->addSubsession(smss);
+  }
+  creation->completeCreation(newDemux, sms);
+}
+
+void SMSCreation::onOggDemuxCreation(OggFileServerDemux* newDemux, void* clientData) {
+  SMSCreation* creation = (SMSCreation*)clientData;
+  ServerMediaSession* sms
+    = ServerMediaSession::createNew(newDemux->envir(), creation->fStreamName, creation->fStreamName,
+				    "Ogg video and/or audio, streamed by the LIVE555 Media Server");
+
+  ServerMediaSubsession* smss;
+  while ((smss = newDemux->newServerMediaSubsession()) != NULL) {
+    sms->addSubsession(smss);
+  }
+  creation->completeCreation(newDemux, sms);
+}
+
+void SMSCreation::completeCreation(Medium* demux, ServerMediaSession* sms) {
+  if (fServer == NULL) {
+    // Our server was deleted while we were being created, so nobody needs "sms" (or "demux") any more:
+    Medium::close(sms);
+    Medium::close(demux);
+    delete this;
+    return;
+  }
+
+  fServer->completeSMSCreation(this, sms); // also deletes us
 }
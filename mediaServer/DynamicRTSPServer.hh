@@ -25,11 +25,15 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 #include "RTSPServerSupportingHTTPStreaming.hh"
 #endif
 
+class FileVersion; // forward
+class SMSCreation; // forward
+
 class DynamicRTSPServer: public RTSPServerSupportingHTTPStreaming {
 public:
   static DynamicRTSPServer* createNew(UsageEnvironment& env, Port ourPort,
 				      UserAuthenticationDatabase* authDatabase,
-				      unsigned reclamationTestSeconds = 65);
+				      unsigned reclamationTestSeconds = 65,
+				      Boolean reusePort = False);
 
 protected:
   DynamicRTSPServer(UsageEnvironment& env, int ourSocket, Port ourPort,
@@ -40,6 +44,38 @@ protected:
 protected: // redefined virtual functions
   virtual ServerMediaSession*
   lookupServerMediaSession(char const* streamName, Boolean isFirstLookupInSession);
+  virtual void lookupServerMediaSession(char const* streamName,
+					lookupServerMediaSessionCompletionFunc* completionFunc, void* completionClientData,
+					Boolean isFirstLookupInSession);
+  virtual void cancelLookupServerMediaSession(lookupServerMediaSessionCompletionFunc* completionFunc,
+					      void* completionClientData);
+
+private:
+  friend class SMSCreation;
+  Boolean lookupExistingSMS(char const* streamName, ServerMediaSession*& sms, FileVersion& currentVersion);
+      // Returns True if "sms" (possibly NULL, if the file doesn't exist) is the result of the lookup.
+      // Otherwise, a new "ServerMediaSession" needs to be created for version "currentVersion" of the file.
+  ServerMediaSession* finishSMSCreation(char const* streamName, ServerMediaSession* sms,
+					FileVersion const& fileVersion);
+  void completeSMSCreation(SMSCreation* creation, ServerMediaSession* sms);
+      // called (from the event loop) when a "ServerMediaSession" that had to be created asynchronously is ready
+  void forgetFile(char const* streamName);
+      // removes our "ServerMediaSession" (if any) for the file, so that it'll get recreated on the next lookup
+  void forgetFileVersion(char const* streamName);
+      // stops watching the file, and forgets its version, so that it'll get checked on the next lookup that
+      // begins a new session (but leaves our "ServerMediaSession" (if any) for the file registered, for now)
+  void watchFile(char const* streamName);
+  static void incomingFileEventHandler(void* instance, int mask);
+  void incomingFileEventHandler1();
+
+private:
+  // For each file for which we've created a "ServerMediaSession": the version of the file that it was created from.
+  // We keep reusing the "ServerMediaSession" for as long as the file's version remains the same:
+  HashTable* fFileVersions;
+  int fFileWatchSocket; // an "inotify" instance (on Linux), or -1 if we have none
+
+  // "ServerMediaSession"s (e.g., for Matroska or Ogg files) that are being created asynchronously, keyed by stream name:
+  HashTable* fSMSCreations;
 };
 
 #endif
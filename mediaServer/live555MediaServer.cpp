@@ -18,15 +18,56 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 // main program
 
 #include <BasicUsageEnvironment.hh>
+#include <MultiLoopRTSPServer.hh>
+#include <MediaFileSDPCache.hh>
 #include "DynamicRTSPServer.hh"
 #include "version.hh"
 
+// In "multi-loop" mode (enabled with the "-l <number-of-event-loops>" option), we run several event loops
+// (threads), each with its own "DynamicRTSPServer", all sharing the same RTSP port:
+static unsigned numEventLoops = 1;
+static UserAuthenticationDatabase* authDB = NULL;
+
+// With the "-s" option, the 'config' information (e.g., H.264 SPS and PPS) that's found by reading each file
+// is also saved in a "<file-name>.sdpcache" file alongside it, so that it survives restarts of the server:
+static Boolean useSDPCacheFiles = False;
+
+static void printBanner(UsageEnvironment& env, RTSPServer* rtspServer); // forward
+static void setUpTunnelingOverHTTP(UsageEnvironment& env, RTSPServer* rtspServer); // forward
+
+static RTSPServer* createServerForEventLoop(UsageEnvironment& env, Port ourPort, Boolean reusePort,
+					    unsigned loopIndex, void* /*clientData*/) {
+  if (useSDPCacheFiles) MediaFileSDPCache::ourCache(env)->setUseSidecarFiles(True);
+
+  RTSPServer* rtspServer = DynamicRTSPServer::createNew(env, ourPort, authDB, 65, reusePort);
+  if (rtspServer != NULL && loopIndex == 0) {
+    printBanner(env, rtspServer);
+
+    // RTSP-over-HTTP tunneling needs both of a client's HTTP connections to reach the same server,
+    // so we set it up (on its own, unshared port) only for the first event loop:
+    setUpTunnelingOverHTTP(env, rtspServer);
+  }
+
+  return rtspServer;
+}
+
 int main(int argc, char** argv) {
+  for (int i = 1; i < argc; ++i) {
+    if (strcmp(argv[i], "-l") == 0 && i+1 < argc) {
+      numEventLoops = (unsigned)atoi(argv[++i]);
+    } else if (strcmp(argv[i], "-s") == 0) {
+      useSDPCacheFiles = True;
+    } else {
+      fprintf(stderr, "Usage: %s [-l <number-of-event-loops> (0 means: one per CPU core)] [-s (save SDP 'config' information in \"<file-name>.sdpcache\" files)]\n", argv[0]);
+      exit(1);
+    }
+  }
+
   // Begin by setting up our usage environment:
   TaskScheduler* scheduler = BasicTaskScheduler::createNew();
   UsageEnvironment* env = BasicUsageEnvironment::createNew(*scheduler);
+  if (useSDPCacheFiles) MediaFileSDPCache::ourCache(*env)->setUseSidecarFiles(True);
 
-  UserAuthenticationDatabase* authDB = NULL;
 #ifdef ACCESS_CONTROL
   // To implement client access control to the RTSP server, do the following:
   authDB = new UserAuthenticationDatabase;
@@ -35,6 +76,25 @@ int main(int argc, char** argv) {
   // access to the server.
 #endif
 
+  if (numEventLoops != 1) {
+    // Create the event loops (and their RTSP servers).  Try first with the default port number (554),
+    // and then with the alternative port number (8554):
+    MultiLoopRTSPServer* multiLoopServer
+      = MultiLoopRTSPServer::createNew(*env, 554, createServerForEventLoop, NULL, numEventLoops);
+    if (multiLoopServer == NULL) {
+      multiLoopServer = MultiLoopRTSPServer::createNew(*env, 8554, createServerForEventLoop, NULL, numEventLoops);
+    }
+    if (multiLoopServer == NULL) {
+      *env << "Failed to create RTSP server: " << env->getResultMsg() << "\n";
+      exit(1);
+    }
+    *env << "(Running " << multiLoopServer->numLoops() << " event loops.)\n";
+        // (If "-l 0" was given, this is the number of CPU cores.)
+
+    env->taskScheduler().doEventLoop(); // does not return (the event loops run in their own threads)
+    return 0; // only to prevent compiler warning
+  }
+
   // Create the RTSP server.  Try first with the default port number (554),
   // and then with the alternative port number (8554):
   RTSPServer* rtspServer;
@@ -49,44 +109,52 @@ int main(int argc, char** argv) {
     exit(1);
   }
 
-  *env << "LIVE555 Media Server\n";
-  *env << "\tversion " << MEDIA_SERVER_VERSION_STRING
-       << " (LIVE555 Streaming Media library version "
-       << LIVEMEDIA_LIBRARY_VERSION_STRING << ").\n";
+  printBanner(*env, rtspServer);
+  setUpTunnelingOverHTTP(*env, rtspServer);
+
+  env->taskScheduler().doEventLoop(); // does not return
+
+  return 0; // only to prevent compiler warning
+}
+
+static void printBanner(UsageEnvironment& env, RTSPServer* rtspServer) {
+  env << "LIVE555 Media Server\n";
+  env << "\tversion " << MEDIA_SERVER_VERSION_STRING
+      << " (LIVE555 Streaming Media library version "
+      << LIVEMEDIA_LIBRARY_VERSION_STRING << ").\n";
 
   char* urlPrefix = rtspServer->rtspURLPrefix();
-  *env << "Play streams from this server using the URL\n\t"
-       << urlPrefix << "<filename>\nwhere <filename> is a file present in the current directory.\n";
-  *env << "Each file's type is inferred from its name suffix:\n";
-  *env << "\t\".264\" => a H.264 Video Elementary Stream file\n";
-  *env << "\t\".265\" => a H.265 Video Elementary Stream file\n";
-  *env << "\t\".aac\" => an AAC Audio (ADTS format) file\n";
-  *env << "\t\".ac3\" => an AC-3 Audio file\n";
-  *env << "\t\".amr\" => an AMR Audio file\n";
-  *env << "\t\".dv\" => a DV Video file\n";
-  *env << "\t\".m4e\" => a MPEG-4 Video Elementary Stream file\n";
-  *env << "\t\".mkv\" => a Matroska audio+video+(optional)subtitles file\n";
-  *env << "\t\".mp3\" => a MPEG-1 or 2 Audio file\n";
-  *env << "\t\".mpg\" => a MPEG-1 or 2 Program Stream (audio+video) file\n";
-  *env << "\t\".ogg\" or \".ogv\" or \".opus\" => an Ogg audio and/or video file\n";
-  *env << "\t\".ts\" => a MPEG Transport Stream file\n";
-  *env << "\t\t(a \".tsx\" index file - if present - provides server 'trick play' support)\n";
-  *env << "\t\".vob\" => a VOB (MPEG-2 video with AC-3 audio) file\n";
-  *env << "\t\".wav\" => a WAV Audio file\n";
-  *env << "\t\".webm\" => a WebM audio(Vorbis)+video(VP8) file\n";
-  *env << "See http://www.live555.com/mediaServer/ for additional documentation.\n";
+  env << "Play streams from this server using the URL\n\t"
+      << urlPrefix << "<filename>\nwhere <filename> is a file present in the current directory.\n";
+  delete[] urlPrefix;
+  env << "Each file's type is inferred from its name suffix:\n";
+  env << "\t\".264\" => a H.264 Video Elementary Stream file\n";
+  env << "\t\".265\" => a H.265 Video Elementary Stream file\n";
+  env << "\t\".aac\" => an AAC Audio (ADTS format) file\n";
+  env << "\t\".ac3\" => an AC-3 Audio file\n";
+  env << "\t\".amr\" => an AMR Audio file\n";
+  env << "\t\".dv\" => a DV Video file\n";
+  env << "\t\".m4e\" => a MPEG-4 Video Elementary Stream file\n";
+  env << "\t\".mkv\" => a Matroska audio+video+(optional)subtitles file\n";
+  env << "\t\".mp3\" => a MPEG-1 or 2 Audio file\n";
+  env << "\t\".mpg\" => a MPEG-1 or 2 Program Stream (audio+video) file\n";
+  env << "\t\".ogg\" or \".ogv\" or \".opus\" => an Ogg audio and/or video file\n";
+  env << "\t\".ts\" => a MPEG Transport Stream file\n";
+  env << "\t\t(a \".tsx\" index file - if present - provides server 'trick play' support)\n";
+  env << "\t\".vob\" => a VOB (MPEG-2 video with AC-3 audio) file\n";
+  env << "\t\".wav\" => a WAV Audio file\n";
+  env << "\t\".webm\" => a WebM audio(Vorbis)+video(VP8) file\n";
+  env << "See http://www.live555.com/mediaServer/ for additional documentation.\n";
+}
 
+static void setUpTunnelingOverHTTP(UsageEnvironment& env, RTSPServer* rtspServer) {
   // Also, attempt to create a HTTP server for RTSP-over-HTTP tunneling.
   // Try first with the default HTTP port (80), and then with the alternative HTTP
   // port numbers (8000 and 8080).
 
   if (rtspServer->setUpTunnelingOverHTTP(80) || rtspServer->setUpTunnelingOverHTTP(8000) || rtspServer->setUpTunnelingOverHTTP(8080)) {
-    *env << "(We use port " << rtspServer->httpServerPortNum() << " for optional RTSP-over-HTTP tunneling, or for HTTP live streaming (for indexed Transport Stream files only).)\n";
+    env << "(We use port " << rtspServer->httpServerPortNum() << " for optional RTSP-over-HTTP tunneling, or for HTTP live streaming (for indexed Transport Stream files only).)\n";
   } else {
-    *env << "(RTSP-over-HTTP tunneling is not available.)\n";
+    env << "(RTSP-over-HTTP tunneling is not available.)\n";
   }
-
-  env->taskScheduler().doEventLoop(); // does not return
-
-  return 0; // only to prevent compiler warning
 }
@@ -0,0 +1,631 @@
+/**********
+This library is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the
+Free Software Foundation; either version 3 of the License, or (at your
+option) any later version. (See <http://www.gnu.org/copyleft/lesser.html>.)
+
+This library is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+**********/
+// Copyright (c) 1996-2017, Live Networks, Inc.  All rights reserved
+// LIVE555 RTSP-to-UDP Relay Server
+// main program
+//
+// Receives each of the "rtsp://" streams that are listed in a configuration file, and relays each one -
+// as raw UDP (e.g., for MPEG Transport Streams), or as RTP - to a (unicast or multicast) UDP destination.
+// The streams are shared among a (fixed size) pool of event-loop threads.  Each line of the configuration file is:
+//     <rtsp-url> <destination-address>:<port> [ttl=<ttl>] [if=<interface-address>] [rtp]
+// (Blank lines, and lines beginning with '#', are ignored.)
+// Sending "SIGHUP" causes the configuration file to be reread.  Streams that were added (or whose line was changed)
+// are started, and streams that were removed are stopped; all other streams continue, uninterrupted.
+
+#include "liveMedia.hh"
+#include "BasicUsageEnvironment.hh"
+#include "GroupsockHelper.hh"
+#include "LiveRTSPSession.hh"
+#include <signal.h>
+
+char const* progName;
+UsageEnvironment* env;
+LiveRTSPSessionPool* pool;
+
+// Default values of command-line parameters:
+unsigned numThreads = 0; // i.e., one per CPU core
+unsigned statsInterval = 10; // seconds (0 means: don't report statistics)
+char const* statsFileName = NULL; // if NULL, statistics are reported to "env"
+unsigned restartTimeout = 10; // seconds (0 means: never restart streams)
+char const* configFileName;
+
+static char volatile eventLoopWatchVariable = 0;
+static int volatile reloadRequested = 0;
+
+#define MAX_CONFIG_LINE_SIZE 2048
+#define OUTPUT_SOCKET_SEND_BUFFER_SIZE 1000000
+
+// A UDP socket used for sending.  One such socket is shared by all streams that are relayed from the same
+// network interface, with the same TTL.  (Because each datagram is sent with a single "sendto()" call, the socket
+// can be used - concurrently - by each of the pool's threads.)
+class RelayOutputSocket {
+public:
+  static RelayOutputSocket* lookupOrCreate(netAddressBits interfaceAddr, u_int8_t ttl);
+  void release();
+
+  int socketNum() const { return fSocketNum; }
+
+private:
+  RelayOutputSocket(char const* key, int socketNum);
+  ~RelayOutputSocket();
+
+  static HashTable* fTable; // indexed by "<interface-address>/<ttl>"
+
+  char* fKey;
+  int fSocketNum;
+  unsigned fReferenceCount;
+};
+
+// A stream that's being relayed (or, while the configuration file is being read, that's to be relayed):
+class RelayStream {
+public:
+  static RelayStream* createFromConfigLine(char* line, unsigned lineNum);
+  // returns NULL (after reporting an error) if "line" is not valid
+  ~RelayStream();
+
+  char const* key() const { return fKey; } // identifies the stream's configuration
+  char const* url() const { return fURL; }
+
+  Boolean start();
+  void stop();
+  void restart();
+
+  void checkForActivity(); // called once each second
+  void reportStats(FILE* fid, double secondsSinceLastReport,
+		   u_int64_t& totNumBytes, u_int64_t& totNumPackets, u_int64_t& totNumPacketsLost);
+
+private:
+  RelayStream(char const* url, struct sockaddr_in const& destAddr,
+	      u_int8_t ttl, netAddressBits interfaceAddr, Boolean relayRTP);
+
+  static void afterGettingPacket(void* clientData, char* packetData, unsigned packetSize, int trackIndex);
+  void afterGettingPacket(u_int8_t* packet, unsigned packetSize);
+
+private:
+  char* fKey;
+  char* fURL;
+  struct sockaddr_in fDestAddr;
+  u_int8_t fTTL;
+  netAddressBits fInterfaceAddr;
+  Boolean fRelayRTP; // if False, we relay just the RTP payload
+  RelayOutputSocket* fOutputSocket;
+  LiveRTSPSession* fSession;
+
+  // Statistics (written only by our session's event-loop thread):
+  u_int64_t volatile fNumPackets;
+  u_int64_t volatile fNumBytes;
+  u_int64_t volatile fNumPacketsLost;
+  u_int64_t volatile fNumSendErrors;
+  u_int64_t volatile fNumTSErrors; // if the stream is a Transport Stream: sync byte and continuity counter errors
+  MPEG2TransportStreamChecker fTSChecker;
+  Boolean fHaveSeqNum;
+  u_int16_t fLastSeqNum;
+
+  // Used (only by the main thread) to report rates, and to detect inactive streams:
+  u_int64_t fPrevNumPackets, fPrevNumBytes, fPrevNumPacketsLost;
+  u_int64_t fNumPacketsAtLastCheck;
+  unsigned fNumInactiveSecs;
+};
+
+// The currently-relayed streams, indexed by their "key()":
+static HashTable* streams = NULL;
+
+static void incrementCounter(u_int64_t volatile& counter, u_int64_t increment) {
+  __atomic_store_n(&counter, counter + increment, __ATOMIC_RELAXED);
+}
+
+static u_int64_t readCounter(u_int64_t volatile const& counter) {
+  return __atomic_load_n(&counter, __ATOMIC_RELAXED);
+}
+
+void usage() {
+  *env << "Usage: " << progName
+       << " [-t <num-threads>]"
+       << " [-s <stats-interval-seconds>] [-o <stats-file>]"
+       << " [-r <restart-timeout-seconds>]"
+       << " <config-file>\n";
+  *env << "\tEach line of <config-file> is: <rtsp-url> <destination-address>:<port> [ttl=<ttl>] [if=<interface-address>] [rtp]\n";
+  exit(1);
+}
+
+// Reads the configuration file, returning a table of (not yet started) "RelayStream"s, indexed by their "key()".
+// Returns NULL if the file could not be opened.
+static HashTable* readConfigFile() {
+  FILE* fid = fopen(configFileName, "r");
+  if (fid == NULL) {
+    *env << "Failed to open the configuration file \"" << configFileName << "\"\n";
+    return NULL;
+  }
+
+  HashTable* result = HashTable::create(STRING_HASH_KEYS);
+  char line[MAX_CONFIG_LINE_SIZE];
+  unsigned lineNum = 0;
+  while (fgets(line, sizeof line, fid) != NULL) {
+    ++lineNum;
+    RelayStream* stream = RelayStream::createFromConfigLine(line, lineNum);
+    if (stream == NULL) continue;
+
+    if (result->Lookup(stream->key()) != NULL) {
+      *env << configFileName << ", line " << lineNum << ": ignoring duplicate stream \"" << stream->key() << "\"\n";
+      delete stream;
+      continue;
+    }
+    result->Add(stream->key(), stream);
+  }
+  fclose(fid);
+
+  return result;
+}
+
+// (Re)reads the configuration file, and starts/stops streams accordingly:
+static void loadConfigFile() {
+  HashTable* newStreams = readConfigFile();
+  if (newStreams == NULL) return; // keep relaying our current streams (if any)
+
+  // First, stop each current stream that's no longer in the configuration file:
+  HashTable* keptStreams = HashTable::create(STRING_HASH_KEYS);
+  unsigned numStopped = 0;
+  if (streams != NULL) {
+    HashTable::Iterator* iter = HashTable::Iterator::create(*streams);
+    char const* key;
+    RelayStream* stream;
+    while ((stream = (RelayStream*)iter->next(key)) != NULL) {
+      if (newStreams->Lookup(stream->key()) != NULL) {
+	keptStreams->Add(stream->key(), stream);
+      } else {
+	*env << "Stopping \"" << stream->key() << "\"\n";
+	delete stream;
+	++numStopped;
+      }
+    }
+    delete iter;
+    delete streams;
+  }
+  streams = keptStreams;
+
+  // Then, start each new stream:
+  unsigned numStarted = 0;
+  RelayStream* stream;
+  while ((stream = (RelayStream*)newStreams->RemoveNext()) != NULL) {
+    if (streams->Lookup(stream->key()) != NULL) {
+      delete stream; // we're already relaying this stream
+    } else if (stream->start()) {
+      streams->Add(stream->key(), stream);
+      ++numStarted;
+    } else {
+      delete stream;
+    }
+  }
+  delete newStreams;
+
+  *env << "Read \"" << configFileName << "\": " << numStarted << " streams started, " << numStopped << " stopped; "
+       << streams->numEntries() << " streams are being relayed (using " << pool->GetNumThreads() << " threads)\n";
+}
+
+static void stopAllStreams() {
+  RelayStream* stream;
+  while ((stream = (RelayStream*)streams->RemoveNext()) != NULL) delete stream;
+}
+
+static void reportStats() {
+  FILE* fid = stderr;
+  if (statsFileName != NULL) {
+    fid = fopen(statsFileName, "w");
+    if (fid == NULL) {
+      *env << "Failed to open the statistics file \"" << statsFileName << "\"\n";
+      return;
+    }
+  }
+
+  u_int64_t totNumBytes = 0, totNumPackets = 0, totNumPacketsLost = 0;
+  HashTable::Iterator* iter = HashTable::Iterator::create(*streams);
+  char const* key;
+  RelayStream* stream;
+  while ((stream = (RelayStream*)iter->next(key)) != NULL) {
+    stream->reportStats(fid, statsInterval, totNumBytes, totNumPackets, totNumPacketsLost);
+  }
+  delete iter;
+
+  u_int64_t totNumPacketsExpected = totNumPackets + totNumPacketsLost;
+  fprintf(fid, "total: %u streams, %.1f kbps, %.1f packets/s, %llu packets lost (%.3f%%)\n",
+	  streams->numEntries(), totNumBytes*8.0/1000/statsInterval, (double)totNumPackets/statsInterval,
+	  (unsigned long long)totNumPacketsLost,
+	  totNumPacketsExpected == 0 ? 0.0 : 100.0*totNumPacketsLost/totNumPacketsExpected);
+
+  if (fid != stderr) fclose(fid);
+}
+
+static void periodicTask(void* /*clientData*/) {
+  static unsigned secondsUntilStats = statsInterval;
+
+  if (reloadRequested) {
+    reloadRequested = 0;
+    loadConfigFile();
+  }
+
+  if (restartTimeout > 0) {
+    HashTable::Iterator* iter = HashTable::Iterator::create(*streams);
+    char const* key;
+    RelayStream* stream;
+    while ((stream = (RelayStream*)iter->next(key)) != NULL) stream->checkForActivity();
+    delete iter;
+  }
+
+  if (statsInterval > 0 && --secondsUntilStats == 0) {
+    reportStats();
+    secondsUntilStats = statsInterval;
+  }
+
+  env->taskScheduler().scheduleDelayedTask(1000000, periodicTask, NULL);
+}
+
+static void handleSIGHUP(int /*sig*/) {
+  reloadRequested = 1;
+}
+
+static void handleTerminationSignal(int /*sig*/) {
+  eventLoopWatchVariable = 1;
+}
+
+static Boolean parseUnsignedArg(char const* arg, unsigned& result) {
+  return arg != NULL && arg[0] != '-' && sscanf(arg, "%u", &result) == 1;
+}
+
+int main(int argc, char** argv) {
+  // Begin by setting up our usage environment:
+  TaskScheduler* scheduler = BasicTaskScheduler::createNew();
+  env = BasicUsageEnvironment::createNew(*scheduler);
+
+  *env << "LIVE555 RTSP-to-UDP Relay Server\n"
+       << "\t(LIVE555 Streaming Media library version "
+       << LIVEMEDIA_LIBRARY_VERSION_STRING
+       << "; licensed under the GNU LGPL)\n\n";
+
+  // Check command-line arguments: optional parameters, then the name of the configuration file:
+  progName = argv[0];
+  while (argc > 2) {
+    char* const opt = argv[1];
+    if (opt[0] != '-') usage();
+
+    switch (opt[1]) {
+    case 't': { // the number of event-loop threads
+      if (!parseUnsignedArg(argv[2], numThreads)) usage();
+      break;
+    }
+
+    case 's': { // the interval (in seconds) at which statistics are reported
+      if (!parseUnsignedArg(argv[2], statsInterval)) usage();
+      break;
+    }
+
+    case 'o': { // the file into which statistics are written
+      statsFileName = argv[2];
+      break;
+    }
+
+    case 'r': { // restart each stream from which no packets have been received for this many seconds
+      if (!parseUnsignedArg(argv[2], restartTimeout)) usage();
+      break;
+    }
+
+    default: {
+      usage();
+      break;
+    }
+    }
+
+    argv += 2; argc -= 2;
+  }
+  if (argc != 2 || argv[1][0] == '-') usage();
+  configFileName = argv[1];
+
+  pool = LiveRTSPSessionPool::createNew(numThreads);
+  if (pool == NULL) {
+    *env << "Failed to create the event-loop threads\n";
+    exit(1);
+  }
+
+  loadConfigFile();
+  if (streams == NULL) exit(1);
+
+  signal(SIGHUP, handleSIGHUP);
+  signal(SIGINT, handleTerminationSignal);
+  signal(SIGTERM, handleTerminationSignal);
+  signal(SIGPIPE, SIG_IGN);
+
+  // All subsequent activity (in this thread) takes place within the event loop:
+  periodicTask(NULL);
+  env->taskScheduler().doEventLoop(&eventLoopWatchVariable);
+
+  *env << "Stopping all streams\n";
+  stopAllStreams();
+  delete streams;
+  delete pool;
+
+  env->reclaim(); env = NULL;
+  delete scheduler; scheduler = NULL;
+
+  return 0;
+}
+
+
+////////// RelayOutputSocket implementation //////////
+
+HashTable* RelayOutputSocket::fTable = NULL;
+
+RelayOutputSocket* RelayOutputSocket::lookupOrCreate(netAddressBits interfaceAddr, u_int8_t ttl) {
+  if (fTable == NULL) fTable = HashTable::create(STRING_HASH_KEYS);
+
+  char key[100];
+  struct in_addr interfaceInAddr; interfaceInAddr.s_addr = interfaceAddr;
+  sprintf(key, "%s/%u", AddressString(interfaceInAddr).val(), ttl);
+
+  RelayOutputSocket* outputSocket = (RelayOutputSocket*)fTable->Lookup(key);
+  if (outputSocket == NULL) {
+    int socketNum = socket(AF_INET, SOCK_DGRAM, 0);
+    if (socketNum < 0) {
+      env->setResultErrMsg("unable to create datagram socket: ");
+      return NULL;
+    }
+
+    // Bind the socket to the interface (so that unicast datagrams get sent from its address), and use the
+    // interface - and the TTL - for multicast datagrams also:
+    MAKE_SOCKADDR_IN(name, interfaceAddr, 0);
+    u_int8_t multicastTTL = ttl;
+    int unicastTTL = ttl;
+    if (bind(socketNum, (struct sockaddr*)&name, sizeof name) != 0
+	|| setsockopt(socketNum, IPPROTO_IP, IP_MULTICAST_TTL, (const char*)&multicastTTL, sizeof multicastTTL) < 0
+	|| setsockopt(socketNum, IPPROTO_IP, IP_TTL, (const char*)&unicastTTL, sizeof unicastTTL) < 0
+	|| (interfaceAddr != INADDR_ANY
+	    && setsockopt(socketNum, IPPROTO_IP, IP_MULTICAST_IF, (const char*)&interfaceInAddr, sizeof interfaceInAddr) < 0)) {
+      env->setResultErrMsg("unable to set up datagram socket: ");
+      closeSocket(socketNum);
+      return NULL;
+    }
+    increaseSendBufferTo(*env, socketNum, OUTPUT_SOCKET_SEND_BUFFER_SIZE);
+
+    outputSocket = new RelayOutputSocket(key, socketNum);
+    fTable->Add(key, outputSocket);
+  }
+
+  ++outputSocket->fReferenceCount;
+  return outputSocket;
+}
+
+void RelayOutputSocket::release() {
+  if (--fReferenceCount == 0) {
+    fTable->Remove(fKey);
+    delete this;
+  }
+}
+
+RelayOutputSocket::RelayOutputSocket(char const* key, int socketNum)
+  : fKey(strDup(key)), fSocketNum(socketNum), fReferenceCount(0) {
+}
+
+RelayOutputSocket::~RelayOutputSocket() {
+  closeSocket(fSocketNum);
+  delete[] fKey;
+}
+
+
+////////// RelayStream implementation //////////
+
+RelayStream* RelayStream::createFromConfigLine(char* line, unsigned lineNum) {
+  char const* const whitespace = " \t\r\n";
+  char* url = strtok(line, whitespace);
+  if (url == NULL || url[0] == '#') return NULL; // a blank line, or a comment
+
+  do {
+    if (strncmp(url, "rtsp://", 7) != 0) {
+      *env << configFileName << ", line " << lineNum << ": \"" << url << "\" is not a \"rtsp://\" URL\n";
+      break;
+    }
+    if (strlen(url) >= LiveRTSPSession::kMaxURLLen) {
+      *env << configFileName << ", line " << lineNum << ": the URL is too long\n";
+      break;
+    }
+
+    // Parse the destination "<address>:<port>":
+    char* dest = strtok(NULL, whitespace);
+    char* colon = dest == NULL ? NULL : strrchr(dest, ':');
+    unsigned portNum;
+    if (colon == NULL || sscanf(colon+1, "%u", &portNum) != 1 || portNum == 0 || portNum > 65535) {
+      *env << configFileName << ", line " << lineNum << ": missing or bad \"<destination-address>:<port>\"\n";
+      break;
+    }
+    *colon = '\0';
+    NetAddressList destAddresses(dest);
+    if (destAddresses.numAddresses() == 0) {
+      *env << configFileName << ", line " << lineNum << ": unknown destination address \"" << dest << "\"\n";
+      break;
+    }
+    netAddressBits destAddr = *(netAddressBits*)(destAddresses.firstAddress()->data());
+    MAKE_SOCKADDR_IN(destSockAddr, destAddr, htons((u_int16_t)portNum));
+
+    // Parse the optional parameters:
+    unsigned ttl = 1;
+    netAddressBits interfaceAddr = INADDR_ANY;
+    Boolean relayRTP = False;
+    Boolean badParameter = False;
+    char* param;
+    while ((param = strtok(NULL, whitespace)) != NULL) {
+      if (strncmp(param, "ttl=", 4) == 0 && sscanf(param+4, "%u", &ttl) == 1 && ttl <= 255) {
+      } else if (strncmp(param, "if=", 3) == 0 && (interfaceAddr = our_inet_addr(param+3)) != INADDR_NONE) {
+      } else if (strcmp(param, "rtp") == 0) {
+	relayRTP = True;
+      } else {
+	*env << configFileName << ", line " << lineNum << ": bad parameter \"" << param << "\"\n";
+	badParameter = True;
+	break;
+      }
+    }
+    if (badParameter) break;
+
+    return new RelayStream(url, destSockAddr, (u_int8_t)ttl, interfaceAddr, relayRTP);
+  } while (0);
+
+  return NULL;
+}
+
+RelayStream::RelayStream(char const* url, struct sockaddr_in const& destAddr,
+			 u_int8_t ttl, netAddressBits interfaceAddr, Boolean relayRTP)
+  : fURL(strDup(url)), fDestAddr(destAddr), fTTL(ttl), fInterfaceAddr(interfaceAddr), fRelayRTP(relayRTP),
+    fOutputSocket(NULL), fSession(NULL),
+    fNumPackets(0), fNumBytes(0), fNumPacketsLost(0), fNumSendErrors(0), fNumTSErrors(0), fHaveSeqNum(False), fLastSeqNum(0),
+    fPrevNumPackets(0), fPrevNumBytes(0), fPrevNumPacketsLost(0), fNumPacketsAtLastCheck(0), fNumInactiveSecs(0) {
+  // The stream's "key" is a canonical form of its configuration line:
+  struct in_addr interfaceInAddr; interfaceInAddr.s_addr = interfaceAddr;
+  AddressString destAddrStr(destAddr.sin_addr);
+  AddressString interfaceAddrStr(interfaceInAddr);
+  fKey = new char[strlen(url) + strlen(destAddrStr.val()) + strlen(interfaceAddrStr.val()) + 100];
+  sprintf(fKey, "%s %s:%u ttl=%u if=%s%s", url, destAddrStr.val(), ntohs(destAddr.sin_port), ttl,
+	  interfaceAddrStr.val(), relayRTP ? " rtp" : "");
+}
+
+RelayStream::~RelayStream() {
+  stop();
+  delete[] fKey;
+  delete[] fURL;
+}
+
+Boolean RelayStream::start() {
+  if (fSession != NULL) return True; // we've already been started
+
+  if (fOutputSocket == NULL) {
+    fOutputSocket = RelayOutputSocket::lookupOrCreate(fInterfaceAddr, fTTL);
+    if (fOutputSocket == NULL) {
+      *env << "Failed to start \"" << fKey << "\": " << env->getResultMsg() << "\n";
+      return False;
+    }
+  }
+
+  fHaveSeqNum = False;
+  fTSChecker.reset(); // because the new session's continuity counters won't follow on from the old one's
+  fNumPacketsAtLastCheck = readCounter(fNumPackets);
+  fNumInactiveSecs = 0;
+
+  fSession = LiveRTSPSession::createNew(fURL, progName, pool);
+  fSession->Start(NULL, afterGettingPacket, this);
+  return True;
+}
+
+void RelayStream::stop() {
+  if (fSession != NULL) {
+    fSession->StopAndWait();
+    delete fSession; fSession = NULL;
+  }
+
+  // Our session's thread will no longer use our socket, so we can now give it up:
+  if (fOutputSocket != NULL) {
+    fOutputSocket->release();
+    fOutputSocket = NULL;
+  }
+}
+
+void RelayStream::restart() {
+  // Note that we keep our output socket (and our statistics):
+  if (fSession != NULL) {
+    fSession->StopAndWait();
+    delete fSession; fSession = NULL;
+  }
+  start();
+}
+
+void RelayStream::checkForActivity() {
+  u_int64_t numPackets = readCounter(fNumPackets);
+  if (numPackets != fNumPacketsAtLastCheck) {
+    fNumPacketsAtLastCheck = numPackets;
+    fNumInactiveSecs = 0;
+  } else if (++fNumInactiveSecs >= restartTimeout) {
+    *env << "No packets received for " << fNumInactiveSecs << " seconds; restarting \"" << fKey << "\"\n";
+    restart();
+  }
+}
+
+void RelayStream::reportStats(FILE* fid, double secondsSinceLastReport,
+			      u_int64_t& totNumBytes, u_int64_t& totNumPackets, u_int64_t& totNumPacketsLost) {
+  u_int64_t numPackets = readCounter(fNumPackets);
+  u_int64_t numBytes = readCounter(fNumBytes);
+  u_int64_t numPacketsLost = readCounter(fNumPacketsLost);
+
+  u_int64_t numNewPackets = numPackets - fPrevNumPackets;
+  u_int64_t numNewBytes = numBytes - fPrevNumBytes;
+  u_int64_t numNewPacketsLost = numPacketsLost - fPrevNumPacketsLost;
+  u_int64_t numPacketsExpected = numPackets + numPacketsLost;
+
+  fprintf(fid, "%s: %.1f kbps, %.1f packets/s, %llu packets lost in interval, %llu total (%.3f%%), %llu send errors, %llu TS errors\n",
+	  fKey, numNewBytes*8.0/1000/secondsSinceLastReport, numNewPackets/secondsSinceLastReport,
+	  (unsigned long long)numNewPacketsLost, (unsigned long long)numPacketsLost,
+	  numPacketsExpected == 0 ? 0.0 : 100.0*numPacketsLost/numPacketsExpected,
+	  (unsigned long long)readCounter(fNumSendErrors), (unsigned long long)readCounter(fNumTSErrors));
+
+  fPrevNumPackets = numPackets;
+  fPrevNumBytes = numBytes;
+  fPrevNumPacketsLost = numPacketsLost;
+  totNumBytes += numNewBytes;
+  totNumPackets += numNewPackets;
+  totNumPacketsLost += numNewPacketsLost;
+}
+
+void RelayStream::afterGettingPacket(void* clientData, char* packetData, unsigned packetSize, int trackIndex) {
+  if (trackIndex != 0) return; // we relay only the stream's first track
+
+  RelayStream* stream = (RelayStream*)clientData;
+  stream->afterGettingPacket((u_int8_t*)packetData, packetSize);
+}
+
+void RelayStream::afterGettingPacket(u_int8_t* packet, unsigned packetSize) {
+  // Note: This is called from within our session's event-loop thread.
+  if (packetSize < 12 || (packet[0]&0xC0) != 0x80) return; // not a RTP (version 2) packet
+
+  // Use the RTP sequence number to detect lost packets:
+  u_int16_t seqNum = (packet[2]<<8)|packet[3];
+  if (fHaveSeqNum) {
+    u_int16_t seqNumGap = seqNum - fLastSeqNum - 1;
+    if (seqNumGap >= 0x8000) return; // a duplicate, or a (late) out-of-order packet; ignore it
+    if (seqNumGap > 0) incrementCounter(fNumPacketsLost, seqNumGap);
+  }
+  fHaveSeqNum = True;
+  fLastSeqNum = seqNum;
+
+  // Find the RTP payload; skip over the RTP header (including any CSRCs and header extension), and any padding:
+  unsigned headerSize = 12 + 4*(packet[0]&0x0F);
+  if ((packet[0]&0x10) != 0 && packetSize >= headerSize + 4) { // there's a header extension
+    headerSize += 4 + 4*((packet[headerSize+2]<<8)|packet[headerSize+3]);
+  }
+  unsigned paddingSize = (packet[0]&0x20) != 0 ? packet[packetSize-1] : 0;
+  u_int8_t* payload = &packet[headerSize];
+  unsigned payloadSize = headerSize + paddingSize < packetSize ? packetSize - (headerSize + paddingSize) : 0;
+  if (payloadSize == 0 && !fRelayRTP) return; // there's nothing to send
+
+  // If the payload is Transport Stream packets, check them:
+  if (payloadSize > 0 && payloadSize%188 == 0 && payload[0] == 0x47) {
+    unsigned numTSErrors = fTSChecker.checkPackets(payload, payloadSize/188);
+    if (numTSErrors > 0) incrementCounter(fNumTSErrors, numTSErrors);
+  }
+
+  // Send either the whole RTP packet, or just its payload:
+  u_int8_t* data = fRelayRTP ? packet : payload;
+  unsigned dataSize = fRelayRTP ? packetSize : payloadSize;
+
+  incrementCounter(fNumPackets, 1);
+  incrementCounter(fNumBytes, dataSize);
+  if (sendto(fOutputSocket->socketNum(), (char const*)data, dataSize, 0,
+	     (struct sockaddr const*)&fDestAddr, sizeof fDestAddr) < 0) {
+    incrementCounter(fNumSendErrors, 1);
+  }
+}
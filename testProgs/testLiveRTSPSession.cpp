@@ -11,13 +11,77 @@ void OnGettingPacketFunc(void* callbackData, char* packetData,
 	printf("received packet seq=%u, track=%d, size=%u\n", ntohs(seqNumPtr[1]), trackIndex, packetSize);
 }
 
+// Reads (in batches) from each session's packet ring, until "durationSecs" have passed:
+static void DrainPacketRings(LiveRTSPSession** sessions, int numSessions, unsigned durationSecs)
+{
+	LiveRTSPPacketRing::Packet packets[64];
+	time_t endTime = time(NULL) + durationSecs;
+
+	while (time(NULL) < endTime) {
+		bool gotPackets = false;
+		for (int i = 0; i < numSessions; ++i) {
+			LiveRTSPPacketRing* ring = sessions[i]->GetPacketRing();
+			unsigned numPackets = ring->Poll(packets, sizeof packets/sizeof packets[0]);
+			for (unsigned j = 0; j < numPackets; ++j) {
+				OnGettingPacketFunc(NULL, packets[j].data, packets[j].size, packets[j].trackIndex);
+			}
+			ring->Release(numPackets);
+			if (numPackets > 0) gotPackets = true;
+		}
+		if (!gotPackets) sessions[0]->GetPacketRing()->Wait(10);
+	}
+
+	for (int i = 0; i < numSessions; ++i) {
+		LiveRTSPPacketRing::Stats stats;
+		sessions[i]->GetPacketRing()->GetStats(stats);
+		printf("[%s] ring: %llu packets, %llu overflows, %llu too large, high-water mark %u\n", sessions[i]->GetURL(),
+			(unsigned long long)stats.numPacketsEnqueued, (unsigned long long)stats.numPacketsDroppedBecauseFull,
+			(unsigned long long)stats.numPacketsDroppedBecauseTooLarge, stats.maxNumPacketsQueued);
+	}
+}
+
+// Usage: testLiveRTSPSession [-p <num-threads>] [-r] [<rtsp-url> ...]
+//   With "-p", the sessions share a "LiveRTSPSessionPool" with <num-threads> threads (0 means one per CPU core),
+//   rather than each running in its own thread.
+//   With "-r", packets are read - by the main thread - from each session's packet ring, rather than being delivered
+//   by callbacks.
 int main(int argc, char** argv) {
-	LiveRTSPSession *session = LiveRTSPSession::createNew("rtsp://192.168.199.157:8554/h264.mkv",
-		"LiveRTSPSession");
+	LiveRTSPSessionPool* pool = NULL;
+	bool useRings = false;
+	while (argc > 1 && argv[1][0] == '-') {
+		if (argc > 2 && strcmp(argv[1], "-p") == 0) {
+			pool = LiveRTSPSessionPool::createNew((unsigned)atoi(argv[2]));
+			if (pool == NULL) return 1;
+			printf("using a pool of %u threads\n", pool->GetNumThreads());
+			argc -= 2; argv += 2;
+		} else if (strcmp(argv[1], "-r") == 0) {
+			useRings = true;
+			--argc; ++argv;
+		} else {
+			fprintf(stderr, "Usage: testLiveRTSPSession [-p <num-threads>] [-r] [<rtsp-url> ...]\n");
+			return 1;
+		}
+	}
 
-	session->Start(OnGettingSDPFunc, OnGettingPacketFunc, NULL);
-	sleep(10);
+	char const* defaultURL = "rtsp://192.168.199.157:8554/h264.mkv";
+	int numSessions = argc > 1 ? argc - 1 : 1;
+	LiveRTSPSession** sessions = new LiveRTSPSession*[numSessions];
+	for (int i = 0; i < numSessions; ++i) {
+		sessions[i] = LiveRTSPSession::createNew(argc > 1 ? argv[i+1] : defaultURL,
+			"LiveRTSPSession", pool);
+		if (useRings) sessions[i]->EnablePacketRing();
+		sessions[i]->Start(OnGettingSDPFunc, OnGettingPacketFunc, NULL);
+	}
+	if (useRings) {
+		DrainPacketRings(sessions, numSessions, 10);
+	} else {
+		sleep(10);
+	}
 
-	session->StopAndWait();
-	delete session;
+	for (int i = 0; i < numSessions; ++i) {
+		sessions[i]->StopAndWait();
+		delete sessions[i];
+	}
+	delete[] sessions;
+	delete pool;
 }
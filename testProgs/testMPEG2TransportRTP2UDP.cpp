@@ -32,12 +32,26 @@ void afterPlaying(void* clientData); // forward
 // It is used in the "afterPlaying()" function to clean up the session.
 struct SessionState_t {
   RTPSource* videoSource;
+  MPEG2TransportStreamPacer* pacer;
   MediaSink* videoSink;
   RTCPInstance* rtcpInstance;
 } sessionState;
 
 UsageEnvironment* env;
 
+#define PACING_STATS_INTERVAL 10 // seconds
+
+void reportPacingStats(void* /*clientData*/) {
+  MPEG2TransportStreamPacer* pacer = sessionState.pacer;
+  if (pacer->numChunksDelivered() > 0) {
+    *env << "Pacing: " << (unsigned)(pacer->bitrate()/1000) << " kbps; "
+	 << (unsigned)pacer->numChunksDelivered() << " packets, " << (unsigned)pacer->numLateChunks() << " late; jitter: mean "
+	 << pacer->meanJitter() << " us, max " << pacer->maxJitter() << " us; " << pacer->numResyncs() << " resyncs\n";
+    pacer->resetPacingStats();
+  }
+  env->taskScheduler().scheduleDelayedTask(PACING_STATS_INTERVAL*1000000, reportPacingStats, NULL);
+}
+
 int main(int argc, char** argv) {
   // Begin by setting up our usage environment:
   TaskScheduler* scheduler = BasicTaskScheduler::createNew();
@@ -81,11 +95,16 @@ int main(int argc, char** argv) {
           NULL /* we're a client */, sessionState.videoSource);
   // Note: This starts RTCP running automatically
 
+  // Send the Transport Stream packets at the rate given by their PCRs, rather than in the bursts in which they may arrive:
+  sessionState.pacer = MPEG2TransportStreamPacer::createNew(*env, sessionState.videoSource,
+							    TRANSPORT_PACKETS_PER_NETWORK_PACKET);
+
   /*
    * 3. Finally, start playing.
    */
   *env << "Beginning reading on \""  << rtpGroupsock << "\"\n";
-  sessionState.videoSink->startPlaying(*sessionState.videoSource, afterPlaying, NULL);
+  sessionState.videoSink->startPlaying(*sessionState.pacer, afterPlaying, NULL);
+  reportPacingStats(NULL);
 
   env->taskScheduler().doEventLoop(); // does not return
 
@@ -99,5 +118,5 @@ void afterPlaying(void* /*clientData*/) {
   // End by closing the media:
   Medium::close(sessionState.rtcpInstance); // Note: Sends a RTCP BYE
   Medium::close(sessionState.videoSink);
-  Medium::close(sessionState.videoSource);
+  Medium::close(sessionState.pacer); // Note: This also closes the input source ("videoSource")
 }
@@ -0,0 +1,209 @@
+/**********
+This library is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the
+Free Software Foundation; either version 3 of the License, or (at your
+option) any later version. (See <http://www.gnu.org/copyleft/lesser.html>.)
+
+This library is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+**********/
+// Copyright (c) 1996-2017, Live Networks, Inc.  All rights reserved
+// A benchmark that runs the same (valid, and corrupted) Transport Stream data through each of the
+// "MPEG2TransportStreamChecker" implementations (scalar, SSE2, AVX2), checks that they all produce the same
+// counts, and measures the time that each takes per packet.
+// main program
+
+#include "liveMedia.hh"
+#include "MPEG2TransportStreamChecker.hh"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TRANSPORT_PACKET_SIZE 188
+#define NUM_PACKETS 100000
+#define NUM_TIMED_PASSES 20
+
+// A simple (deterministic) pseudo-random number generator, so that every run checks the same data:
+static u_int32_t randomState = 12345;
+static unsigned randomNum(unsigned limit) {
+  randomState = randomState*1103515245 + 12345;
+  return (randomState>>8)%limit;
+}
+
+// Fills "data" with "numPackets" Transport Stream packets: mostly video and audio (as long runs, and interleaved),
+// with some PAT and null packets, adaptation fields, 'discontinuity_indicator's and duplicate packets.
+// If "corrupt" is True, then some packets also get a bad sync byte, the 'transport_error_indicator', or a
+// continuity counter that skips ahead:
+static void makeStream(unsigned char* data, unsigned numPackets, Boolean corrupt) {
+  u_int8_t cc[0x2000];
+  memset(cc, 0, sizeof cc);
+  Boolean prevWasDuplicate = False;
+
+  for (unsigned i = 0; i < numPackets; ++i) {
+    unsigned char* pkt = &data[i*TRANSPORT_PACKET_SIZE];
+    memset(pkt, 0xFF, TRANSPORT_PACKET_SIZE);
+
+    unsigned r = randomNum(100);
+    u_int16_t pid = r < 70 ? 0x100 : r < 85 ? 0x101 : r < 90 ? 0x000 : 0x1FFF;
+    if (i > 0 && randomNum(100) < 80) {
+      // Continue the previous packet's PID:
+      unsigned char const* prevPkt = pkt - TRANSPORT_PACKET_SIZE;
+      pid = ((prevPkt[1]&0x1F)<<8) | prevPkt[2];
+    }
+
+    u_int8_t adaptationFieldControl = 0x10; // payload only
+    Boolean discontinuity = False, duplicate = False;
+    r = randomNum(1000);
+    if (r < 50) {
+      adaptationFieldControl = 0x30; // adaptation field and payload
+    } else if (r < 60) {
+      adaptationFieldControl = 0x20; // adaptation field only
+    } else if (r < 65) {
+      adaptationFieldControl = 0x30;
+      discontinuity = True;
+    } else if (r < 75 && i > 0 && !prevWasDuplicate && (data[(i-1)*TRANSPORT_PACKET_SIZE + 3]&0x30) == 0x10) {
+      duplicate = True; // (only a packet with just a payload may be sent twice - and only twice)
+    }
+    prevWasDuplicate = duplicate;
+
+    if (discontinuity) {
+      cc[pid] = (u_int8_t)randomNum(16);
+    } else if (adaptationFieldControl != 0x20 && !duplicate) {
+      cc[pid] = (cc[pid]+1)&0x0F;
+    }
+    if (corrupt && randomNum(1000) < 5) cc[pid] = (cc[pid]+2)&0x0F; // as if a packet had been lost
+
+    pkt[0] = 0x47;
+    pkt[1] = (u_int8_t)(pid>>8);
+    pkt[2] = (u_int8_t)pid;
+    pkt[3] = adaptationFieldControl | cc[pid];
+    if (adaptationFieldControl&0x20) {
+      pkt[4] = 7; // adaptation_field_length
+      pkt[5] = discontinuity ? 0x80 : 0x10; // 'discontinuity_indicator' or 'PCR_flag'
+    }
+    if (duplicate) {
+      // Repeat the previous packet:
+      memcpy(pkt, pkt - TRANSPORT_PACKET_SIZE, TRANSPORT_PACKET_SIZE);
+    }
+
+    if (corrupt) {
+      r = randomNum(1000);
+      if (r < 5) {
+	pkt[0] = 0x46; // a bad sync byte
+      } else if (r < 8) {
+	pkt[1] |= 0x80; // the 'transport_error_indicator'
+      }
+    }
+  }
+}
+
+// Checks "data" using the current implementation, "packetsPerCall" packets at a time:
+static void runChecker(MPEG2TransportStreamChecker& checker, unsigned char const* data, unsigned numPackets,
+		       unsigned packetsPerCall) {
+  for (unsigned i = 0; i < numPackets; i += packetsPerCall) {
+    unsigned n = numPackets - i < packetsPerCall ? numPackets - i : packetsPerCall;
+    checker.checkPackets(&data[i*TRANSPORT_PACKET_SIZE], n);
+  }
+}
+
+static Boolean sameResults(MPEG2TransportStreamChecker const& a, MPEG2TransportStreamChecker const& b) {
+  if (a.numPackets() != b.numPackets() || a.numSyncErrors() != b.numSyncErrors()
+      || a.numCCErrors() != b.numCCErrors() || a.numTransportErrors() != b.numTransportErrors()
+      || a.numPIDs() != b.numPIDs()) return False;
+
+  for (unsigned i = 0; i < a.numPIDs(); ++i) {
+    MPEG2TransportStreamChecker::PIDStats const& sa = a.pidStats(i);
+    MPEG2TransportStreamChecker::PIDStats const& sb = b.pidStats(i);
+    if (sa.pid != sb.pid || sa.numPackets != sb.numPackets || sa.numCCErrors != sb.numCCErrors
+	|| sa.numTransportErrors != sb.numTransportErrors || sa.numDiscontinuities != sb.numDiscontinuities) return False;
+  }
+  return True;
+}
+
+static void printResults(FILE* fid, MPEG2TransportStreamChecker const& checker) {
+  fprintf(fid, "\t%llu packets; %llu sync errors, %llu CC errors, %llu transport errors; %u PIDs\n",
+	  (unsigned long long)checker.numPackets(), (unsigned long long)checker.numSyncErrors(),
+	  (unsigned long long)checker.numCCErrors(), (unsigned long long)checker.numTransportErrors(),
+	  checker.numPIDs());
+}
+
+static struct {
+  MPEG2TransportStreamChecker::Implementation implementation;
+  char const* name;
+} const implementations[] = {
+  { MPEG2TransportStreamChecker::SCALAR_IMPLEMENTATION, "scalar" },
+  { MPEG2TransportStreamChecker::SSE2_IMPLEMENTATION, "SSE2" },
+  { MPEG2TransportStreamChecker::AVX2_IMPLEMENTATION, "AVX2" },
+};
+#define NUM_IMPLEMENTATIONS (sizeof implementations/sizeof implementations[0])
+
+int main(int /*argc*/, char** /*argv*/) {
+  unsigned char* data = new unsigned char[NUM_PACKETS*TRANSPORT_PACKET_SIZE];
+  unsigned const packetsPerCallValues[] = { 7, 1000 }; // e.g., one UDP datagram at a time; a large file read
+  Boolean allAgree = True;
+
+  printf("%u packets, checked %u times (nanoseconds per packet):\n", NUM_PACKETS, NUM_TIMED_PASSES);
+  printf("%-34s", "");
+  for (unsigned k = 0; k < NUM_IMPLEMENTATIONS; ++k) printf("%10s", implementations[k].name);
+  printf("\n");
+
+  for (unsigned corrupt = 0; corrupt <= 1; ++corrupt) {
+    makeStream(data, NUM_PACKETS, corrupt != 0);
+
+    for (unsigned p = 0; p < sizeof packetsPerCallValues/sizeof packetsPerCallValues[0]; ++p) {
+      unsigned const packetsPerCall = packetsPerCallValues[p];
+      char label[100];
+      snprintf(label, sizeof label, "%s, %u packets per call", corrupt ? "corrupted" : "valid", packetsPerCall);
+      printf("%-34s", label);
+
+      // The scalar implementation - with the whole input checked at once - is our reference:
+      MPEG2TransportStreamChecker reference;
+      MPEG2TransportStreamChecker::setImplementation(MPEG2TransportStreamChecker::SCALAR_IMPLEMENTATION);
+      reference.checkPackets(data, NUM_PACKETS);
+
+      for (unsigned k = 0; k < NUM_IMPLEMENTATIONS; ++k) {
+	if (!MPEG2TransportStreamChecker::setImplementation(implementations[k].implementation)) {
+	  printf("%10s", "-"); // not supported here
+	  continue;
+	}
+
+	MPEG2TransportStreamChecker checker;
+	runChecker(checker, data, NUM_PACKETS, packetsPerCall);
+	if (!sameResults(checker, reference)) {
+	  fprintf(stderr, "\nThe %s implementation's results (%s) differ from those of the reference:\n",
+		  implementations[k].name, label);
+	  printResults(stderr, checker);
+	  printResults(stderr, reference);
+	  allAgree = False;
+	}
+
+	struct timeval timeStart, timeEnd;
+	gettimeofday(&timeStart, NULL);
+	for (unsigned n = 0; n < NUM_TIMED_PASSES; ++n) {
+	  checker.reset();
+	  runChecker(checker, data, NUM_PACKETS, packetsPerCall);
+	}
+	gettimeofday(&timeEnd, NULL);
+	double const elapsedNs = ((timeEnd.tv_sec - timeStart.tv_sec)*1000000.0 + (timeEnd.tv_usec - timeStart.tv_usec))*1000;
+	printf("%10.2f", elapsedNs/((double)NUM_PACKETS*NUM_TIMED_PASSES));
+      }
+      printf("\n");
+      if (p == 0) printResults(stdout, reference);
+    }
+  }
+  MPEG2TransportStreamChecker::setImplementation(MPEG2TransportStreamChecker::BEST_IMPLEMENTATION);
+
+  delete[] data;
+  if (!allAgree) {
+    printf("FAILED: the implementations' results differ\n");
+    return 1;
+  }
+  printf("All implementations' results agree.\n");
+  return 0;
+}
@@ -40,12 +40,31 @@ void afterPlaying(void* clientData); // forward
 // It is used in the "afterPlaying()" function to clean up the session.
 struct SessionState_t {
   FramedSource* videoSource;
+  MPEG2TransportStreamDejitterBuffer* dejitterBuffer;
   RTPSink*      videoSink;
   RTCPInstance* rtcpInstance;
 } sessionState;
 
 UsageEnvironment* env;
 
+#define DEJITTER_STATS_INTERVAL 10 // seconds
+
+void reportDejitterStats(void* /*clientData*/) {
+  // Report the de-jitter buffer's occupancy (to help choose its latency and size for this feed):
+  MPEG2TransportStreamDejitterBuffer* buffer = sessionState.dejitterBuffer;
+  if (buffer->numDatagramsDelivered() > 0) {
+    *env << "De-jitter: " << (unsigned)(buffer->bitrate()/1000) << " kbps (from "
+	 << (buffer->clockIsFromPCR() ? "PCRs" : "arrival times") << "); "
+	 << buffer->numDatagramsBuffered() << " packets (" << buffer->numBytesBuffered() << " bytes) buffered, max "
+	 << buffer->maxNumDatagramsBuffered() << " (" << buffer->maxNumBytesBuffered() << " bytes); hold time: mean "
+	 << buffer->meanHoldTime() << " us, max " << buffer->maxHoldTime() << " us; "
+	 << (unsigned)buffer->numDatagramsDelivered() << " packets, " << (unsigned)buffer->numLateDatagrams() << " late, "
+	 << buffer->numOverflows() << " overflows, " << buffer->numResyncs() << " resyncs\n";
+    buffer->resetBufferStats();
+  }
+  env->taskScheduler().scheduleDelayedTask(DEJITTER_STATS_INTERVAL*1000000, reportDejitterStats, NULL);
+}
+
 int main(int argc, char** argv) {
   // Begin by setting up our usage environment:
   TaskScheduler* scheduler = BasicTaskScheduler::createNew();
@@ -100,16 +119,28 @@ int main(int argc, char** argv) {
     *env << "Unable to create udp source on \"" << receiveGroupsock << "\"\n";
     exit(1);
   }
+  udpSource->useArrivalTimestamps();
+
+  // Smooth out any bursts in the input, by re-timing each datagram from the stream's PCRs (or, if it has none, from
+  // the average arrival rate).  Each datagram is held for up to 200 ms:
+  sessionState.dejitterBuffer = MPEG2TransportStreamDejitterBuffer::createNew(*env, udpSource, 200000);
+
+  // Remove null packets (and, optionally, unwanted programs or PIDs) from the input stream.  (To keep only one program,
+  // call "addProgram()"; to remove an unwanted track, call "removePID()".)
+  MPEG2TransportStreamPIDFilter* pidFilter = MPEG2TransportStreamPIDFilter::createNew(*env, sessionState.dejitterBuffer);
 
   // Create a 'framer' for the input source (to give us proper inter-packet gaps):
-  sessionState.videoSource = MPEG2TransportStreamAccumulator::createNew(*env, udpSource,
+  MPEG2TransportStreamAccumulator* accumulator = MPEG2TransportStreamAccumulator::createNew(*env, pidFilter,
                     TRANSPORT_PACKET_SIZE * TRANSPORT_PACKETS_PER_NETWORK_PACKET);
+  accumulator->setFlushTimeout(50000); // don't hold back data for more than 50 ms (if the bitrate is low)
+  sessionState.videoSource = accumulator;
 
   /*
    * 4. Finally, start playing.
    */
   *env << "Beginning reading on \""  << receiveGroupsock << "\"\n";
   sessionState.videoSink->startPlaying(*sessionState.videoSource, afterPlaying, sessionState.videoSink);
+  reportDejitterStats(NULL);
 
   env->taskScheduler().doEventLoop(); // does not return
 
@@ -123,7 +154,7 @@ void afterPlaying(void* /*clientData*/) {
   Medium::close(sessionState.rtcpInstance);
   Medium::close(sessionState.videoSink);
   Medium::close(sessionState.videoSource);
-  // Note that this also closes the udp source that this source read from.
+  // Note that this also closes the PID filter, de-jitter buffer and udp source that this source read from.
 }
 
 void initRTSPServer() {
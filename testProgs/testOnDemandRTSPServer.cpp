@@ -413,8 +413,12 @@ int main(int argc, char** argv) {
     ServerMediaSession* sms
       = ServerMediaSession::createNew(*env, streamName, streamName,
 				      descriptionString);
-    sms->addSubsession(MPEG2TransportUDPServerMediaSubsession
-		       ::createNew(*env, inputAddressStr, inputPortNum, inputStreamIsRawUDP));
+    MPEG2TransportUDPServerMediaSubsession* subsession
+      = MPEG2TransportUDPServerMediaSubsession::createNew(*env, inputAddressStr, inputPortNum, inputStreamIsRawUDP);
+    // To send each incoming datagram straight on to all clients (as one RTP packet), rather than reassembling it,
+    // uncomment the following.  (Note: Each datagram must then consist of whole (188-byte) Transport Stream packets.)
+    //subsession->enableFanOut();
+    sms->addSubsession(subsession);
     rtspServer->addServerMediaSession(sms);
 
     char* url = rtspServer->rtspURL(sms);
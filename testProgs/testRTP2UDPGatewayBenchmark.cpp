@@ -0,0 +1,189 @@
+/**********
+This library is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the
+Free Software Foundation; either version 3 of the License, or (at your
+option) any later version. (See <http://www.gnu.org/copyleft/lesser.html>.)
+
+This library is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+**********/
+// Copyright (c) 1996-2017, Live Networks, Inc.  All rights reserved
+// A benchmark that compares two ways of forwarding the payloads of an incoming RTP stream as UDP datagrams
+// (as done by "testMPEG2TransportRTP2UDP"): a "SimpleRTPSource" feeding a "BasicUDPSink", and a "RTP2UDPGateway".
+// It reports the number of packets forwarded per second of CPU time (i.e., per core).
+// (The RTP packets are sent - over the loopback interface - by a child process, whose CPU time is not counted.)
+// main program
+
+#include "liveMedia.hh"
+#include "BasicUsageEnvironment.hh"
+#include "GroupsockHelper.hh"
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+#define TRANSPORT_PACKET_SIZE 188
+#define TRANSPORT_PACKETS_PER_NETWORK_PACKET 7
+
+static portNumBits const inputPortNum = 47004;
+static portNumBits const outputPortNum = 47006;
+
+// Sends "numPackets" RTP packets (each containing 7 Transport Stream packets) to our input port, at "packetsPerSecond".
+// (This rate should be one that both pipelines can keep up with, so that neither loses packets in the kernel.)
+// Every "1/reorderFraction"th pair of packets is sent in the wrong order:
+static void sendPackets(unsigned numPackets, unsigned packetsPerSecond, unsigned reorderFraction) {
+  int sock = socket(AF_INET, SOCK_DGRAM, 0);
+  struct sockaddr_in dest;
+  memset(&dest, 0, sizeof dest);
+  dest.sin_family = AF_INET;
+  dest.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  dest.sin_port = htons(inputPortNum);
+
+  unsigned const packetSize = 12 + TRANSPORT_PACKET_SIZE*TRANSPORT_PACKETS_PER_NETWORK_PACKET;
+  unsigned char packets[2][packetSize];
+  memset(packets, 0xFF, sizeof packets);
+
+  usleep(100000); // give our parent time to start reading
+  unsigned const burstSize = 16;
+  struct timeval startTime;
+  gettimeofday(&startTime, NULL);
+  for (unsigned i = 0; i < numPackets; ++i) {
+    if (i%burstSize == 0) {
+      // Wait until it's time for this burst:
+      struct timeval timeNow;
+      gettimeofday(&timeNow, NULL);
+      double elapsed = (timeNow.tv_sec - startTime.tv_sec) + (timeNow.tv_usec - startTime.tv_usec)/1000000.0;
+      double burstTime = (double)i/packetsPerSecond;
+      if (burstTime > elapsed) usleep((unsigned)((burstTime - elapsed)*1000000));
+    }
+
+    unsigned seqNo = i;
+    if (reorderFraction > 0 && i%reorderFraction == 0 && i + 1 < numPackets) seqNo = i + 1; // send i+1 first
+    else if (reorderFraction > 0 && i%reorderFraction == 1) seqNo = i - 1;
+
+    unsigned char* packet = packets[i%2];
+    packet[0] = 0x80; packet[1] = 33;
+    packet[2] = seqNo>>8; packet[3] = seqNo;
+    packet[4] = packet[5] = packet[6] = packet[7] = 0; // timestamp
+    packet[8] = 0x12; packet[9] = 0x34; packet[10] = 0x56; packet[11] = 0x78; // SSRC
+    for (unsigned j = 0; j < TRANSPORT_PACKETS_PER_NETWORK_PACKET; ++j) packet[12 + j*TRANSPORT_PACKET_SIZE] = 0x47;
+
+    sendto(sock, (char*)packet, packetSize, 0, (struct sockaddr*)&dest, sizeof dest);
+  }
+  close(sock);
+}
+
+static double cpuTime() {
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec)/1000000.0;
+}
+
+static char stopFlag;
+static pid_t senderPid;
+static Groupsock* inputGroupsock;
+static unsigned numPacketsSeen;
+
+static void checkForCompletion(void* clientData) {
+  UsageEnvironment* env = (UsageEnvironment*)clientData;
+
+  // We're done once the sender has exited, and no more packets are arriving:
+  unsigned numPacketsNow = inputGroupsock->statsGroupIncoming.totNumPackets();
+  if (senderPid == 0 && numPacketsNow == numPacketsSeen) {
+    stopFlag = 1;
+    return;
+  }
+  numPacketsSeen = numPacketsNow;
+  if (senderPid != 0 && waitpid(senderPid, NULL, WNOHANG) == senderPid) senderPid = 0;
+  env->taskScheduler().scheduleDelayedTask(100000, checkForCompletion, env);
+}
+
+// Returns the CPU time (in seconds) that was used to forward the stream:
+static double runBenchmark(UsageEnvironment& env, Boolean useGateway,
+			   unsigned numPackets, unsigned packetsPerSecond, unsigned reorderFraction,
+			   unsigned& numPacketsForwarded) {
+  struct in_addr inputAddress; inputAddress.s_addr = 0;
+  Groupsock inputGS(env, inputAddress, Port(inputPortNum), 255);
+  increaseReceiveBufferTo(env, inputGS.socketNum(), 4*1024*1024);
+
+  // Our output goes to a socket that we never read (so the kernel just discards the data):
+  int outputReceiverSocket = setupDatagramSocket(env, Port(outputPortNum));
+  struct in_addr outputAddress; outputAddress.s_addr = htonl(INADDR_LOOPBACK);
+  Groupsock outputGS(env, outputAddress, Port(outputPortNum), 255);
+
+  RTPSource* source = NULL;
+  MediaSink* sink = NULL;
+  RTP2UDPGateway* gateway = NULL;
+  if (useGateway) {
+    gateway = RTP2UDPGateway::createNew(env, &inputGS, &outputGS);
+    gateway->startForwarding();
+  } else {
+    source = SimpleRTPSource::createNew(env, &inputGS, 33, 90000, "video/MP2T", 0, False /*no 'M' bit*/);
+    sink = BasicUDPSink::createNew(env, &outputGS, TRANSPORT_PACKET_SIZE*TRANSPORT_PACKETS_PER_NETWORK_PACKET);
+    sink->startPlaying(*source, NULL, NULL);
+  }
+
+  senderPid = fork();
+  if (senderPid == 0) {
+    sendPackets(numPackets, packetsPerSecond, reorderFraction);
+    _exit(0);
+  }
+
+  inputGroupsock = &inputGS;
+  numPacketsSeen = 0;
+  stopFlag = 0;
+  double startTime = cpuTime();
+  env.taskScheduler().scheduleDelayedTask(100000, checkForCompletion, &env);
+  env.taskScheduler().doEventLoop(&stopFlag);
+  double cpuSeconds = cpuTime() - startTime;
+
+  numPacketsForwarded = outputGS.statsGroupOutgoing.totNumPackets();
+  Medium::close(gateway);
+  Medium::close(sink);
+  Medium::close(source);
+  closeSocket(outputReceiverSocket);
+
+  return cpuSeconds;
+}
+
+int main(int argc, char** argv) {
+  TaskScheduler* scheduler = BasicTaskScheduler::createNew();
+  UsageEnvironment* env = BasicUsageEnvironment::createNew(*scheduler);
+
+  unsigned numPackets = 200000;
+  unsigned packetsPerSecond = 40000; // about 420 Mbps of Transport Stream data
+  if (argc > 1) numPackets = (unsigned)atoi(argv[1]);
+  if (argc > 2) packetsPerSecond = (unsigned)atoi(argv[2]);
+  if (numPackets == 0 || packetsPerSecond == 0) {
+    *env << "usage: " << argv[0] << " [<number-of-packets> [<packets-per-second>]]\n";
+    return 1;
+  }
+  fprintf(stderr, "Forwarding %u RTP packets (each containing %d Transport Stream packets), at %u packets/second\n",
+	  numPackets, TRANSPORT_PACKETS_PER_NETWORK_PACKET, packetsPerSecond);
+  fprintf(stderr, "%-42s %12s %10s %16s\n", "pipeline", "forwarded", "CPU (s)", "packets/s/core");
+
+  unsigned const reorderFractions[] = { 0, 100 }; // no reordering; 1 pair in 100 swapped
+  for (unsigned i = 0; i < sizeof reorderFractions/sizeof reorderFractions[0]; ++i) {
+    for (int useGateway = 0; useGateway <= 1; ++useGateway) {
+      unsigned numPacketsForwarded;
+      double cpuSeconds = runBenchmark(*env, useGateway, numPackets, packetsPerSecond, reorderFractions[i],
+					numPacketsForwarded);
+
+      char description[100];
+      sprintf(description, "%s%s", useGateway ? "RTP2UDPGateway" : "SimpleRTPSource->BasicUDPSink",
+	      reorderFractions[i] > 0 ? " (reordered)" : "");
+      fprintf(stderr, "%-42s %12u %10.2f %16.0f\n", description, numPacketsForwarded, cpuSeconds,
+	      cpuSeconds > 0.0 ? numPacketsForwarded/cpuSeconds : 0.0);
+    }
+  }
+
+  env->reclaim();
+  delete scheduler;
+  return 0;
+}
@@ -339,6 +339,10 @@ void continueAfterSETUP(RTSPClient* rtspClient, int resultCode, char* resultStri
 
     env << *rtspClient << "Created a data sink for the \"" << *scs.subsession << "\" subsession\n";
     scs.subsession->miscPtr = rtspClient; // a hack to let subsession handler functions get the "RTSPClient" from the subsession 
+
+    // Send the Transport Stream packets at the rate given by their PCRs, rather than in the bursts in which they may arrive:
+    scs.subsession->addFilter(MPEG2TransportStreamPacer::createNew(env, scs.subsession->readSource(),
+								   TRANSPORT_PACKETS_PER_NETWORK_PACKET));
     scs.subsession->sink->startPlaying(*(scs.subsession->readSource()),
 				       subsessionAfterPlaying, scs.subsession);
     // Also set a handler to be called if a RTCP "BYE" arrives for this subsession:
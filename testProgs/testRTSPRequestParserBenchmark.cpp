@@ -0,0 +1,328 @@
+/**********
+This library is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the
+Free Software Foundation; either version 3 of the License, or (at your
+option) any later version. (See <http://www.gnu.org/copyleft/lesser.html>.)
+
+This library is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+**********/
+// Copyright (c) 1996-2017, Live Networks, Inc.  All rights reserved
+// A benchmark that compares the two ways that a RTSP server can parse incoming requests:
+// - "parseRTSPRequestString()", called (as the server used to do) each time more data arrives, once a
+//   <CR><LF><CR><LF> has been found; and
+// - "RTSPRequestParser", which examines each new byte just once, however the request is split into reads.
+// The requests are taken from a corpus of requests sent by common players and cameras, and are delivered
+// whole, in small (TCP-segment-like) pieces, and all together (pipelined).
+// main program
+
+#include "liveMedia.hh"
+#include "RTSPCommon.hh"
+#include "RTSPRequestParser.hh"
+#include "GroupsockHelper.hh"
+#include <stdio.h>
+#include <stdlib.h>
+
+static char const* corpus[] = {
+  // VLC:
+  "OPTIONS rtsp://192.168.1.20:8554/cam1 RTSP/1.0\r\n"
+  "CSeq: 2\r\n"
+  "User-Agent: LibVLC/3.0.8 (LIVE555 Streaming Media v2018.08.28)\r\n"
+  "\r\n",
+  "DESCRIBE rtsp://192.168.1.20:8554/cam1 RTSP/1.0\r\n"
+  "CSeq: 3\r\n"
+  "User-Agent: LibVLC/3.0.8 (LIVE555 Streaming Media v2018.08.28)\r\n"
+  "Accept: application/sdp\r\n"
+  "\r\n",
+  "SETUP rtsp://192.168.1.20:8554/cam1/track1 RTSP/1.0\r\n"
+  "CSeq: 4\r\n"
+  "User-Agent: LibVLC/3.0.8 (LIVE555 Streaming Media v2018.08.28)\r\n"
+  "Transport: RTP/AVP;unicast;client_port=54970-54971\r\n"
+  "\r\n",
+  "PLAY rtsp://192.168.1.20:8554/cam1/ RTSP/1.0\r\n"
+  "CSeq: 5\r\n"
+  "User-Agent: LibVLC/3.0.8 (LIVE555 Streaming Media v2018.08.28)\r\n"
+  "Session: 5A3F7C21\r\n"
+  "Range: npt=0.000-\r\n"
+  "\r\n",
+  "GET_PARAMETER rtsp://192.168.1.20:8554/cam1/ RTSP/1.0\r\n"
+  "CSeq: 6\r\n"
+  "User-Agent: LibVLC/3.0.8 (LIVE555 Streaming Media v2018.08.28)\r\n"
+  "Session: 5A3F7C21\r\n"
+  "\r\n",
+  // FFmpeg:
+  "DESCRIBE rtsp://10.0.0.5/live/main RTSP/1.0\r\n"
+  "Accept: application/sdp\r\n"
+  "CSeq: 2\r\n"
+  "User-Agent: Lavf58.29.100\r\n"
+  "\r\n",
+  "SETUP rtsp://10.0.0.5/live/main/trackID=0 RTSP/1.0\r\n"
+  "Transport: RTP/AVP/TCP;unicast;interleaved=0-1\r\n"
+  "CSeq: 3\r\n"
+  "User-Agent: Lavf58.29.100\r\n"
+  "\r\n",
+  "PLAY rtsp://10.0.0.5/live/main/ RTSP/1.0\r\n"
+  "Range: npt=0.000-\r\n"
+  "CSeq: 5\r\n"
+  "User-Agent: Lavf58.29.100\r\n"
+  "Session: 1B6D4E02\r\n"
+  "\r\n",
+  // GStreamer:
+  "SETUP rtsp://10.0.0.5:554/Streaming/Channels/101/trackID=1 RTSP/1.0\r\n"
+  "CSeq: 3\r\n"
+  "User-Agent: GStreamer/1.16.2\r\n"
+  "Transport: RTP/AVP;unicast;client_port=41234-41235;mode=\"PLAY\"\r\n"
+  "Date: Thu, 12 Mar 2020 10:15:02 GMT\r\n"
+  "\r\n",
+  // A NVR (with digest authentication), polling a camera:
+  "DESCRIBE rtsp://admin@10.0.0.64:554/Streaming/Channels/102?transportmode=unicast&profile=Profile_2 RTSP/1.0\r\n"
+  "CSeq: 4\r\n"
+  "Authorization: Digest username=\"admin\", realm=\"LIVE555 Streaming Media\", nonce=\"0d6a1c7e3f9b2a4c8e5d7f1a3b6c9e2d\", "
+  "uri=\"rtsp://10.0.0.64:554/Streaming/Channels/102?transportmode=unicast&profile=Profile_2\", "
+  "response=\"8f4b2c1d9e7a6b5c3d2e1f0a9b8c7d6e\"\r\n"
+  "User-Agent: NVR Client/2.3.1\r\n"
+  "Accept: application/sdp\r\n"
+  "\r\n",
+  // QuickTime:
+  "OPTIONS * RTSP/1.0\r\n"
+  "CSeq: 1\r\n"
+  "User-Agent: QuickTime/7.7.3 (qtver=7.7.3;os=Windows NT 6.1Service Pack 1)\r\n"
+  "x-retransmit: our-retransmit\r\n"
+  "x-dynamic-rate: 1\r\n"
+  "x-transport-options: late-tolerance=2.384000\r\n"
+  "\r\n",
+  // A keep-alive, with a body:
+  "SET_PARAMETER rtsp://192.168.1.20:8554/cam1/ RTSP/1.0\r\n"
+  "CSeq: 9\r\n"
+  "Session: 5A3F7C21\r\n"
+  "Content-Type: text/parameters\r\n"
+  "Content-Length: 32\r\n"
+  "\r\n"
+  "barparam: barstuff\r\n"
+  "ping: 1234\r\n",
+  // A 'pause' and 'teardown', with an URL-encoded path:
+  "PAUSE rtsp://192.168.1.20:8554/my%20cams/front%20door/ RTSP/1.0\r\n"
+  "CSeq: 10\r\n"
+  "Session: 5A3F7C21\r\n"
+  "\r\n",
+  "TEARDOWN rtsp://192.168.1.20:8554/cam1/ RTSP/1.0\r\n"
+  "CSeq: 11\r\n"
+  "User-Agent: LibVLC/3.0.8 (LIVE555 Streaming Media v2018.08.28)\r\n"
+  "Session: 5A3F7C21\r\n"
+  "\r\n",
+};
+static unsigned const numRequests = sizeof corpus/sizeof corpus[0];
+
+// The results of parsing one request:
+struct ParsedRequest {
+  char cmdName[RTSP_PARAM_STRING_MAX], urlPreSuffix[RTSP_PARAM_STRING_MAX], urlSuffix[RTSP_PARAM_STRING_MAX];
+  char cseq[RTSP_PARAM_STRING_MAX], sessionId[RTSP_PARAM_STRING_MAX];
+  unsigned contentLength;
+};
+
+static Boolean sameResults(ParsedRequest const& a, ParsedRequest const& b) {
+  return strcmp(a.cmdName, b.cmdName) == 0 && strcmp(a.urlPreSuffix, b.urlPreSuffix) == 0
+    && strcmp(a.urlSuffix, b.urlSuffix) == 0 && strcmp(a.cseq, b.cseq) == 0
+    && strcmp(a.sessionId, b.sessionId) == 0 && a.contentLength == b.contentLength;
+}
+
+#define BUFFER_SIZE 20000
+
+// A connection's request buffer, parsed the old way:
+class OldStyleConnection {
+public:
+  OldStyleConnection() { reset(); }
+
+  void reset() {
+    fBytesAlreadySeen = 0;
+    fLastCRLF = -3; // (so that a CRLF at the very start of the buffer doesn't look like the end of a message)
+  }
+
+  // Adds "size" bytes from "data".  Returns the number of requests that were completed:
+  unsigned handleBytes(char const* data, unsigned size, ParsedRequest* results) {
+    memcpy(&fBuffer[fBytesAlreadySeen], data, size);
+    unsigned newBytesRead = size;
+    unsigned numCompleted = 0;
+
+    while (1) {
+      int end = (int)(fBytesAlreadySeen + newBytesRead);
+      Boolean endOfMsg = False;
+      int tmp = fLastCRLF + 2;
+      if (tmp < 0) tmp = 0;
+      while (tmp < end-1) {
+	if (fBuffer[tmp] == '\r' && fBuffer[tmp+1] == '\n') {
+	  if (tmp - fLastCRLF == 2) {
+	    endOfMsg = True;
+	    break;
+	  }
+	  fLastCRLF = tmp;
+	}
+	++tmp;
+      }
+      fBytesAlreadySeen += newBytesRead;
+      if (!endOfMsg) break;
+
+      ParsedRequest& r = results[numCompleted];
+      if (!parseRTSPRequestString(fBuffer, fLastCRLF+2, r.cmdName, sizeof r.cmdName,
+				  r.urlPreSuffix, sizeof r.urlPreSuffix, r.urlSuffix, sizeof r.urlSuffix,
+				  r.cseq, sizeof r.cseq, r.sessionId, sizeof r.sessionId, r.contentLength)) {
+	fprintf(stderr, "parseRTSPRequestString() failed!\n");
+	exit(1);
+      }
+      if (end < tmp + 2 + (int)r.contentLength) break; // we still need more data
+
+      // Move any following (pipelined) request to the front of the buffer:
+      unsigned requestSize = (fLastCRLF+4) + r.contentLength;
+      unsigned numBytesRemaining = fBytesAlreadySeen - requestSize;
+      ++numCompleted;
+      reset();
+      if (numBytesRemaining == 0) break;
+      memmove(fBuffer, &fBuffer[requestSize], numBytesRemaining);
+      newBytesRead = numBytesRemaining;
+    }
+
+    return numCompleted;
+  }
+
+private:
+  char fBuffer[BUFFER_SIZE];
+  unsigned fBytesAlreadySeen;
+  int fLastCRLF; // offset (within "fBuffer") of the most recent CRLF; may be negative
+};
+
+// A connection's request buffer, parsed using a "RTSPRequestParser":
+class NewStyleConnection {
+public:
+  NewStyleConnection(): fBytesAlreadySeen(0) {}
+
+  unsigned handleBytes(char const* data, unsigned size, ParsedRequest* results) {
+    memcpy(&fBuffer[fBytesAlreadySeen], data, size);
+    fBytesAlreadySeen += size;
+    unsigned numCompleted = 0;
+
+    while (fParser.parse(fBuffer, fBytesAlreadySeen)) {
+      // Copy the fields, as "RTSPServer" does:
+      ParsedRequest& r = results[numCompleted];
+      if (!(fParser.isRTSPRequest()
+	    && fParser.cmdName().copyTo(r.cmdName, sizeof r.cmdName)
+	    && fParser.urlPreSuffix().copyTo(r.urlPreSuffix, sizeof r.urlPreSuffix)
+	    && fParser.urlSuffix().copyTo(r.urlSuffix, sizeof r.urlSuffix)
+	    && fParser.cseq().copyTo(r.cseq, sizeof r.cseq))) {
+	fprintf(stderr, "RTSPRequestParser failed!\n");
+	exit(1);
+      }
+      fParser.sessionId().copyTo(r.sessionId, sizeof r.sessionId);
+      decodeURL(r.urlPreSuffix);
+      r.contentLength = fParser.contentLength();
+
+      unsigned requestSize = fParser.requestSize();
+      unsigned numBytesRemaining = fBytesAlreadySeen - requestSize;
+      ++numCompleted;
+      fParser.reset();
+      fBytesAlreadySeen = numBytesRemaining;
+      if (numBytesRemaining == 0) break;
+      memmove(fBuffer, &fBuffer[requestSize], numBytesRemaining);
+    }
+
+    return numCompleted;
+  }
+
+private:
+  char fBuffer[BUFFER_SIZE];
+  unsigned fBytesAlreadySeen;
+  RTSPRequestParser fParser;
+};
+
+static double timeNow() {
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return tv.tv_sec + tv.tv_usec/1000000.0;
+}
+
+// Delivers each request in the corpus (in pieces of "pieceSize" bytes, or all at once if "pieceSize" is 0), or the
+// whole corpus at once (if "pipelined"), "numIterations" times.  Returns the time per request (in nanoseconds):
+template <class Connection>
+static double runBenchmark(Connection& connection, unsigned pieceSize, Boolean pipelined, unsigned numIterations,
+			   ParsedRequest* results) {
+  static char pipelinedCorpus[BUFFER_SIZE];
+  unsigned pipelinedCorpusSize = 0;
+  unsigned i;
+  if (pipelined) {
+    for (i = 0; i < numRequests; ++i) {
+      unsigned len = strlen(corpus[i]);
+      memcpy(&pipelinedCorpus[pipelinedCorpusSize], corpus[i], len);
+      pipelinedCorpusSize += len;
+    }
+  }
+
+  double start = timeNow();
+  for (unsigned iter = 0; iter < numIterations; ++iter) {
+    unsigned numCompleted = 0;
+    if (pipelined) {
+      numCompleted += connection.handleBytes(pipelinedCorpus, pipelinedCorpusSize, results);
+    } else {
+      for (i = 0; i < numRequests; ++i) {
+	char const* request = corpus[i];
+	unsigned len = strlen(request);
+	unsigned step = pieceSize == 0 ? len : pieceSize;
+	for (unsigned j = 0; j < len; j += step) {
+	  numCompleted += connection.handleBytes(&request[j], j + step <= len ? step : len - j, &results[numCompleted]);
+	}
+      }
+    }
+    if (numCompleted != numRequests) {
+      fprintf(stderr, "Only %u of %u requests were completed!\n", numCompleted, numRequests);
+      exit(1);
+    }
+  }
+
+  return (timeNow() - start)*1e9/((double)numIterations*numRequests);
+}
+
+int main(int argc, char** argv) {
+  unsigned numIterations = 100000;
+  if (argc > 1) numIterations = atoi(argv[1]);
+  if (numIterations == 0) {
+    fprintf(stderr, "Usage: %s [<number-of-iterations>]\n", argv[0]);
+    return 1;
+  }
+
+  ParsedRequest oldResults[numRequests], newResults[numRequests];
+  struct {
+    char const* name;
+    unsigned pieceSize;
+    Boolean pipelined;
+  } const modes[] = {
+    { "whole requests", 0, False },
+    { "in 64-byte pieces", 64, False },
+    { "in 16-byte pieces", 16, False },
+    { "pipelined", 0, True },
+  };
+
+  printf("%u requests, each parsed %u times (nanoseconds per request):\n", numRequests, numIterations);
+  printf("%-20s %22s %18s %8s\n", "", "parseRTSPRequestString", "RTSPRequestParser", "speedup");
+  for (unsigned m = 0; m < sizeof modes/sizeof modes[0]; ++m) {
+    OldStyleConnection* oldConnection = new OldStyleConnection;
+    NewStyleConnection* newConnection = new NewStyleConnection;
+    double oldTime = runBenchmark(*oldConnection, modes[m].pieceSize, modes[m].pipelined, numIterations, oldResults);
+    double newTime = runBenchmark(*newConnection, modes[m].pieceSize, modes[m].pipelined, numIterations, newResults);
+    delete oldConnection; delete newConnection;
+
+    for (unsigned i = 0; i < numRequests; ++i) {
+      if (!sameResults(oldResults[i], newResults[i])) {
+	fprintf(stderr, "The two parsers gave different results for request #%u (\"%s\" vs \"%s\")!\n",
+		i, oldResults[i].cmdName, newResults[i].cmdName);
+	return 1;
+      }
+    }
+    printf("%-20s %22.0f %18.0f %7.1fx\n", modes[m].name, oldTime, newTime, oldTime/newTime);
+  }
+
+  return 0;
+}
@@ -0,0 +1,159 @@
+/**********
+This library is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the
+Free Software Foundation; either version 3 of the License, or (at your
+option) any later version. (See <http://www.gnu.org/copyleft/lesser.html>.)
+
+This library is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+**********/
+// Copyright (c) 1996-2017, Live Networks, Inc.  All rights reserved
+// A benchmark that measures the memory used by each idle connection to a "RTSPServer".
+// It opens many TCP connections to a RTSP server (in this process), sends a "GET_PARAMETER" ('keep-alive')
+// request on each one, waits for all of the responses, and then reports the growth in our virtual and
+// resident size, per connection.  (Only memory in our address space is counted, not kernel socket buffers.)
+// main program
+
+#include "liveMedia.hh"
+#include "BasicUsageEnvironment.hh"
+#include "GroupsockHelper.hh"
+#include <stdio.h>
+#include <stdlib.h>
+
+static char stopFlag;
+static unsigned numResponsesReceived = 0;
+
+// Gets our virtual and resident size (in bytes).  Returns False if this isn't possible on this OS:
+static Boolean getMemoryUsage(double& virtualSize, double& residentSize) {
+  FILE* fid = fopen("/proc/self/statm", "r");
+  if (fid == NULL) return False;
+
+  unsigned long numVirtualPages, numResidentPages;
+  Boolean result = fscanf(fid, "%lu %lu", &numVirtualPages, &numResidentPages) == 2;
+  fclose(fid);
+
+  double const pageSize = 4096.0;
+  virtualSize = numVirtualPages*pageSize;
+  residentSize = numResidentPages*pageSize;
+  return result;
+}
+
+static void stopEventLoop(void* /*clientData*/) {
+  stopFlag = 1;
+}
+
+static void runEventLoopFor(UsageEnvironment& env, unsigned microseconds) {
+  stopFlag = 0;
+  env.taskScheduler().scheduleDelayedTask(microseconds, stopEventLoop, NULL);
+  env.taskScheduler().doEventLoop(&stopFlag);
+}
+
+static void responseHandler(void* clientData, int /*mask*/) {
+  int sock = (int)(long)clientData;
+  char buffer[1000];
+  int bytesRead = recv(sock, buffer, sizeof buffer, 0);
+  if (bytesRead > 0) ++numResponsesReceived; // assume that each response arrives in one piece
+}
+
+int main(int argc, char** argv) {
+  unsigned numConnections = 2000;
+  if (argc > 1) numConnections = atoi(argv[1]);
+  if (numConnections == 0) {
+    fprintf(stderr, "Usage: %s [<number-of-connections>]\n", argv[0]);
+    return 1;
+  }
+
+  // We use an "epoll()"-based scheduler (if available), because we may have more than FD_SETSIZE sockets:
+  TaskScheduler* scheduler = NULL;
+#if defined(__linux__)
+  scheduler = EpollTaskScheduler::createNew();
+#endif
+  if (scheduler == NULL) scheduler = BasicTaskScheduler::createNew();
+  UsageEnvironment* env = BasicUsageEnvironment::createNew(*scheduler);
+
+  RTSPServer* rtspServer = NULL;
+  portNumBits portNum;
+  for (portNum = 8554; portNum < 8654 && rtspServer == NULL; ++portNum) {
+    rtspServer = RTSPServer::createNew(*env, portNum);
+  }
+  if (rtspServer == NULL) {
+    *env << "Failed to create RTSP server: " << env->getResultMsg() << "\n";
+    return 1;
+  }
+  --portNum;
+
+  struct sockaddr_in serverAddr;
+  memset(&serverAddr, 0, sizeof serverAddr);
+  serverAddr.sin_family = AF_INET;
+  serverAddr.sin_addr.s_addr = our_inet_addr("127.0.0.1");
+  serverAddr.sin_port = htons(portNum);
+
+  double virtualSizeBefore, residentSizeBefore;
+  if (!getMemoryUsage(virtualSizeBefore, residentSizeBefore)) {
+    fprintf(stderr, "This benchmark needs \"/proc/self/statm\", which is not available on this OS\n");
+    return 1;
+  }
+
+  // Open the connections, a few at a time (so that the server's 'listen' queue doesn't overflow):
+  int* sockets = new int[numConnections];
+  unsigned i;
+  for (i = 0; i < numConnections; ++i) {
+    sockets[i] = socket(AF_INET, SOCK_STREAM, 0);
+    if (sockets[i] < 0) {
+      fprintf(stderr, "Failed to create socket #%u (is the open file limit too low?)\n", i);
+      numConnections = i;
+      break;
+    }
+    makeSocketNonBlocking(sockets[i]);
+    connect(sockets[i], (struct sockaddr*)&serverAddr, sizeof serverAddr); // will complete asynchronously
+
+    if (i%10 == 9) runEventLoopFor(*env, 1000);
+  }
+  for (unsigned j = 0; j < 100 && rtspServer->numClientConnections() < numConnections; ++j) {
+    runEventLoopFor(*env, 10000);
+  }
+  if (rtspServer->numClientConnections() < numConnections) {
+    fprintf(stderr, "Only %u of %u connections were accepted\n", rtspServer->numClientConnections(), numConnections);
+  }
+
+  // Send one 'keep-alive' request on each connection, and wait for the responses:
+  for (i = 0; i < numConnections; ++i) {
+    char request[200];
+    snprintf(request, sizeof request, "GET_PARAMETER rtsp://127.0.0.1:%u/ RTSP/1.0\r\nCSeq: 1\r\n\r\n", portNum);
+    send(sockets[i], request, strlen(request), 0);
+    env->taskScheduler().setBackgroundHandling(sockets[i], SOCKET_READABLE, responseHandler, (void*)(long)sockets[i]);
+
+    if (i%100 == 99) runEventLoopFor(*env, 1000);
+  }
+  for (unsigned j = 0; j < 100 && numResponsesReceived < numConnections; ++j) {
+    runEventLoopFor(*env, 10000);
+  }
+
+  double virtualSizeAfter, residentSizeAfter;
+  getMemoryUsage(virtualSizeAfter, residentSizeAfter);
+
+  ConnectionBufferPool& pool = rtspServer->connectionBufferPool();
+  printf("%u idle connections (%u responses received):\n", rtspServer->numClientConnections(), numResponsesReceived);
+  printf("\tvirtual size: +%.0f bytes (%.0f bytes per connection)\n",
+	 virtualSizeAfter - virtualSizeBefore, (virtualSizeAfter - virtualSizeBefore)/numConnections);
+  printf("\tresident size: +%.0f bytes (%.0f bytes per connection)\n",
+	 residentSizeAfter - residentSizeBefore, (residentSizeAfter - residentSizeBefore)/numConnections);
+  printf("\tconnection buffer pool: %u buffers (%u bytes) in use; %u free buffers (%u bytes)\n",
+	 pool.numBuffersInUse(), pool.numBytesInUse(), pool.numFreeBuffers(), pool.numFreeBytes());
+
+  for (i = 0; i < numConnections; ++i) {
+    env->taskScheduler().turnOffBackgroundReadHandling(sockets[i]);
+    closeSocket(sockets[i]);
+  }
+  delete[] sockets;
+  Medium::close(rtspServer);
+  env->reclaim(); delete scheduler;
+
+  return 0;
+}
@@ -0,0 +1,178 @@
+/**********
+This library is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the
+Free Software Foundation; either version 3 of the License, or (at your
+option) any later version. (See <http://www.gnu.org/copyleft/lesser.html>.)
+
+This library is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+**********/
+// Copyright (c) 1996-2017, Live Networks, Inc.  All rights reserved
+// A benchmark that compares the two ways of reading the replicas of a "StreamReplicator":
+// "getNextFrame()" (each frame is copied into each reader's buffer), and
+// "getNextFrameRef()" (each frame is read once, and shared by all readers),
+// showing the memory bandwidth that's saved for each replica.
+// main program
+
+#include "liveMedia.hh"
+#include "BasicUsageEnvironment.hh"
+#include <stdio.h>
+#include <stdlib.h>
+
+// A source that generates (synthetic) frames of a fixed size, as fast as they are requested.
+// It writes only a small header into each frame, so that the cost of filling the frame doesn't dominate the benchmark:
+class SyntheticFrameSource: public FramedSource {
+public:
+  SyntheticFrameSource(UsageEnvironment& env, unsigned frameSize)
+    : FramedSource(env), fOurFrameSize(frameSize), fNumFramesGenerated(0) {
+  }
+
+  unsigned numFramesGenerated() const { return fNumFramesGenerated; }
+
+private: // redefined virtual functions:
+  virtual unsigned maxFrameSize() const { return fOurFrameSize; }
+  virtual void doGetNextFrame() {
+    fFrameSize = fOurFrameSize;
+    if (fFrameSize > fMaxSize) {
+      fNumTruncatedBytes = fFrameSize - fMaxSize;
+      fFrameSize = fMaxSize;
+    }
+    if (fFrameSize >= sizeof fNumFramesGenerated) memcpy(fTo, &fNumFramesGenerated, sizeof fNumFramesGenerated);
+    ++fNumFramesGenerated;
+    gettimeofday(&fPresentationTime, NULL);
+
+    // Deliver the frame from the event loop (rather than recursively):
+    nextTask() = envir().taskScheduler().scheduleDelayedTask(0, (TaskFunc*)FramedSource::afterGetting, this);
+  }
+
+private:
+  unsigned fOurFrameSize;
+  unsigned fNumFramesGenerated;
+};
+
+// A reader of one replica:
+class ReplicaReader {
+public:
+  ReplicaReader(FramedSource* replica, unsigned bufferSize, Boolean readByReference)
+    : fReplica(replica), fBufferSize(bufferSize), fReadByReference(readByReference), fNumFramesReceived(0) {
+    fBuffer = readByReference ? NULL : new unsigned char[bufferSize];
+  }
+  virtual ~ReplicaReader() {
+    Medium::close(fReplica);
+    delete[] fBuffer;
+  }
+
+  void startReading() {
+    if (fReadByReference) {
+      fReplica->getNextFrameRef(afterGettingFrameRef, this, NULL, NULL);
+    } else {
+      fReplica->getNextFrame(fBuffer, fBufferSize, afterGettingFrame, this, NULL, NULL);
+    }
+  }
+
+  unsigned numFramesReceived() const { return fNumFramesReceived; }
+
+private:
+  static void afterGettingFrame(void* clientData, unsigned /*frameSize*/, unsigned /*numTruncatedBytes*/,
+				struct timeval /*presentationTime*/, unsigned /*durationInMicroseconds*/) {
+    ReplicaReader* reader = (ReplicaReader*)clientData;
+    ++reader->fNumFramesReceived;
+    reader->startReading();
+  }
+
+  static void afterGettingFrameRef(void* clientData, SharedFrame* frame) {
+    ReplicaReader* reader = (ReplicaReader*)clientData;
+    ++reader->fNumFramesReceived;
+    frame->release();
+    reader->startReading();
+  }
+
+private:
+  FramedSource* fReplica;
+  unsigned char* fBuffer;
+  unsigned fBufferSize;
+  Boolean fReadByReference;
+  unsigned fNumFramesReceived;
+};
+
+static char stopFlag;
+
+static void checkForCompletion(void* clientData) {
+  SyntheticFrameSource* source = (SyntheticFrameSource*)clientData;
+  static unsigned const numFramesToGenerate = 2000;
+  if (source->numFramesGenerated() >= numFramesToGenerate) {
+    stopFlag = 1;
+  } else {
+    source->envir().taskScheduler().scheduleDelayedTask(1000, checkForCompletion, source);
+  }
+}
+
+// Returns the time (in microseconds) per frame:
+static double runBenchmark(UsageEnvironment& env, unsigned frameSize, unsigned numReplicas, Boolean readByReference,
+			   unsigned& numFramesDelivered) {
+  SyntheticFrameSource* source = new SyntheticFrameSource(env, frameSize);
+  StreamReplicator* replicator = StreamReplicator::createNew(env, source);
+
+  ReplicaReader** readers = new ReplicaReader*[numReplicas];
+  unsigned i;
+  for (i = 0; i < numReplicas; ++i) {
+    readers[i] = new ReplicaReader(replicator->createStreamReplica(), frameSize, readByReference);
+  }
+
+  struct timeval start, end;
+  gettimeofday(&start, NULL);
+  for (i = 0; i < numReplicas; ++i) readers[i]->startReading();
+
+  stopFlag = 0;
+  env.taskScheduler().scheduleDelayedTask(1000, checkForCompletion, source);
+  env.taskScheduler().doEventLoop(&stopFlag);
+  gettimeofday(&end, NULL);
+
+  numFramesDelivered = readers[0]->numFramesReceived();
+  for (i = 0; i < numReplicas; ++i) delete readers[i]; // this also deletes "replicator" (and "source")
+  delete[] readers;
+
+  double elapsed = (end.tv_sec - start.tv_sec)*1000000.0 + (end.tv_usec - start.tv_usec);
+  return numFramesDelivered == 0 ? 0.0 : elapsed/numFramesDelivered;
+}
+
+int main(int argc, char** argv) {
+  TaskScheduler* scheduler = BasicTaskScheduler::createNew();
+  UsageEnvironment* env = BasicUsageEnvironment::createNew(*scheduler);
+
+  unsigned frameSize = 200000; // a typical size for a HD video key frame
+  if (argc > 1) frameSize = (unsigned)atoi(argv[1]);
+  if (frameSize == 0) {
+    *env << "usage: " << argv[0] << " [<frame-size-in-bytes>]\n";
+    return 1;
+  }
+  fprintf(stderr, "Frame size: %u bytes\n", frameSize);
+  fprintf(stderr, "%10s %16s %16s %22s %22s\n", "#replicas", "copy: us/frame", "ref: us/frame",
+	  "copy: MB/s per replica", "saved: MB/s per replica");
+
+  unsigned const replicaCounts[] = { 1, 2, 10, 50, 100 };
+  for (unsigned i = 0; i < sizeof replicaCounts/sizeof replicaCounts[0]; ++i) {
+    unsigned numReplicas = replicaCounts[i];
+    unsigned numCopyFrames, numRefFrames;
+    double copyTime = runBenchmark(*env, frameSize, numReplicas, False, numCopyFrames);
+    double refTime = runBenchmark(*env, frameSize, numReplicas, True, numRefFrames);
+
+    // When reading with "getNextFrame()", each frame is copied into every replica's buffer except the first
+    // (which the input source reads into directly).  When reading with "getNextFrameRef()", no frame is copied at all.
+    // Report the copying rate (per replica) that was needed to keep up with the frame rate that we achieved:
+    double bytesCopiedPerFramePerReplica = numReplicas > 1 ? (double)frameSize*(numReplicas-1)/numReplicas : 0.0;
+    double copyRate = copyTime > 0.0 ? bytesCopiedPerFramePerReplica/copyTime : 0.0; // bytes/us == MB/s
+    double savedRate = refTime > 0.0 ? bytesCopiedPerFramePerReplica/refTime : 0.0;
+    fprintf(stderr, "%10u %16.2f %16.2f %22.1f %22.1f\n", numReplicas, copyTime, refTime, copyRate, savedRate);
+  }
+
+  env->reclaim();
+  delete scheduler;
+  return 0;
+}
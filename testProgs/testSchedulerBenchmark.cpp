@@ -0,0 +1,236 @@
+/**********
+This library is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the
+Free Software Foundation; either version 3 of the License, or (at your
+option) any later version. (See <http://www.gnu.org/copyleft/lesser.html>.)
+
+This library is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+**********/
+// Copyright (c) 1996-2017, Live Networks, Inc.  All rights reserved
+// A benchmark that compares the cost of one event loop iteration, for
+// "BasicTaskScheduler" ("select()") and "EpollTaskScheduler" ("epoll()"),
+// as the number of watched sockets grows; and that measures the cost of
+// scheduling and unscheduling large numbers of delayed tasks, and the throughput of
+// "postEvent()" calls made from several threads at once.
+// main program
+
+#include "BasicUsageEnvironment.hh"
+#include "GroupsockHelper.hh"
+#include <stdio.h>
+#include <sys/resource.h>
+#include <pthread.h>
+
+static unsigned numHandled;
+
+static void readHandler(void* clientData, int /*mask*/) {
+  int sock = (int)(long)clientData;
+  unsigned char buf[16];
+  while (recv(sock, buf, sizeof buf, 0) > 0) {}
+  ++numHandled;
+}
+
+// Returns the average time (in microseconds) per "SingleStep()", or -1 if the test couldn't be run:
+static double runBenchmark(BasicTaskScheduler0* scheduler, unsigned numSockets, unsigned numIterations) {
+  int* sockets = new int[numSockets];
+  struct sockaddr_in* addrs = new struct sockaddr_in[numSockets];
+  unsigned numCreated = 0;
+  double result = -1.0;
+
+  do {
+    for (; numCreated < numSockets; ++numCreated) {
+      int sock = socket(AF_INET, SOCK_DGRAM, 0);
+      if (sock < 0) break;
+      sockets[numCreated] = sock;
+
+      struct sockaddr_in& addr = addrs[numCreated];
+      memset(&addr, 0, sizeof addr);
+      addr.sin_family = AF_INET;
+      addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+      addr.sin_port = 0;
+      SOCKLEN_T len = sizeof addr;
+      if (bind(sock, (struct sockaddr*)&addr, sizeof addr) < 0
+	  || getsockname(sock, (struct sockaddr*)&addr, &len) < 0
+	  || !makeSocketNonBlocking(sock)) {
+	close(sock);
+	break;
+      }
+#if defined(FD_SETSIZE)
+      if (dynamic_cast<BasicTaskScheduler*>(scheduler) != NULL && sock >= (int)FD_SETSIZE) {
+	++numCreated;
+	break; // "select()" can't handle this socket
+      }
+#endif
+      scheduler->turnOnBackgroundReadHandling(sock, readHandler, (void*)(long)sock);
+    }
+    if (numCreated < numSockets) break;
+
+    int sender = socket(AF_INET, SOCK_DGRAM, 0);
+    if (sender < 0) break;
+
+    unsigned char const datagram = 0;
+    numHandled = 0;
+    struct timeval timeStart, timeEnd;
+    gettimeofday(&timeStart, NULL);
+    for (unsigned i = 0; i < numIterations; ++i) {
+      // Make one (pseudo-randomly chosen) socket readable, then run one loop iteration to handle it:
+      struct sockaddr_in& dest = addrs[(i*7919)%numSockets];
+      sendto(sender, &datagram, sizeof datagram, 0, (struct sockaddr*)&dest, sizeof dest);
+      scheduler->SingleStep();
+    }
+    gettimeofday(&timeEnd, NULL);
+    close(sender);
+
+    double elapsed = (timeEnd.tv_sec - timeStart.tv_sec)*1000000.0 + (timeEnd.tv_usec - timeStart.tv_usec);
+    result = elapsed/numIterations;
+  } while (0);
+
+  for (unsigned i = 0; i < numCreated; ++i) {
+    scheduler->disableBackgroundHandling(sockets[i]);
+    close(sockets[i]);
+  }
+  delete[] addrs; delete[] sockets;
+  return result;
+}
+
+static void dummyTask(void* /*clientData*/) {
+}
+
+static double usecsSince(struct timeval const& timeStart) {
+  struct timeval timeNow;
+  gettimeofday(&timeNow, NULL);
+  return (timeNow.tv_sec - timeStart.tv_sec)*1000000.0 + (timeNow.tv_usec - timeStart.tv_usec);
+}
+
+static void runTimerBenchmark(unsigned numTimers) {
+  BasicTaskScheduler* scheduler = BasicTaskScheduler::createNew(0);
+  TaskToken* tokens = new TaskToken[numTimers];
+  struct timeval timeStart;
+
+  // Schedule "numTimers" tasks, with (pseudo-random) delays of up to 10 seconds:
+  gettimeofday(&timeStart, NULL);
+  for (unsigned i = 0; i < numTimers; ++i) {
+    tokens[i] = scheduler->scheduleDelayedTask((i*7919)%10000000, dummyTask, NULL);
+  }
+  double scheduleTime = usecsSince(timeStart);
+
+  // Reschedule each of them:
+  gettimeofday(&timeStart, NULL);
+  for (unsigned i = 0; i < numTimers; ++i) {
+    scheduler->rescheduleDelayedTask(tokens[i], (i*104729)%10000000, dummyTask, NULL);
+  }
+  double rescheduleTime = usecsSince(timeStart);
+
+  // Then unschedule them all, in a different order from that in which they were scheduled:
+  gettimeofday(&timeStart, NULL);
+  for (unsigned i = 0; i < numTimers; ++i) {
+    scheduler->unscheduleDelayedTask(tokens[(i*7)%numTimers]);
+  }
+  double unscheduleTime = usecsSince(timeStart);
+
+  fprintf(stderr, "%u timers:\tschedule %.3f us, reschedule %.3f us, unschedule %.3f us (per timer)\n",
+	  numTimers, scheduleTime/numTimers, rescheduleTime/numTimers, unscheduleTime/numTimers);
+
+  delete[] tokens;
+  delete scheduler;
+}
+
+// "postEvent()" benchmark:
+static unsigned const numEventsPerPoster = 250000;
+static unsigned numEventsHandled;
+static char volatile postedEventWatchVariable;
+static unsigned numPosters;
+
+static void postedEventHandler(void* /*clientData*/) {
+  if (++numEventsHandled == numPosters*numEventsPerPoster) postedEventWatchVariable = 1;
+}
+
+static void* posterThread(void* clientData) {
+  TaskScheduler* scheduler = (TaskScheduler*)clientData;
+  for (unsigned i = 0; i < numEventsPerPoster; ++i) {
+    scheduler->postEvent(postedEventHandler, NULL);
+  }
+  return NULL;
+}
+
+static void runPostEventBenchmark(BasicTaskScheduler0* scheduler, char const* name, unsigned numThreads) {
+  numPosters = numThreads;
+  numEventsHandled = 0;
+  postedEventWatchVariable = 0;
+
+  struct timeval timeStart;
+  gettimeofday(&timeStart, NULL);
+  pthread_t* threads = new pthread_t[numThreads];
+  for (unsigned i = 0; i < numThreads; ++i) pthread_create(&threads[i], NULL, posterThread, scheduler);
+  scheduler->doEventLoop(&postedEventWatchVariable);
+  double elapsed = usecsSince(timeStart);
+  for (unsigned i = 0; i < numThreads; ++i) pthread_join(threads[i], NULL);
+  delete[] threads;
+
+  fprintf(stderr, "%-20s %u posting threads:\t%.2f million events/second (%u handled)\n",
+	  name, numThreads, numEventsHandled/elapsed, numEventsHandled);
+}
+
+static void report(char const* name, unsigned numSockets, double usecsPerStep) {
+  if (usecsPerStep < 0) {
+    fprintf(stderr, "%-20s %6u sockets:\tnot supported\n", name, numSockets);
+  } else {
+    fprintf(stderr, "%-20s %6u sockets:\t%8.2f us/iteration (%u handled)\n", name, numSockets, usecsPerStep, numHandled);
+  }
+}
+
+int main(int argc, char** argv) {
+  unsigned numIterations = 20000;
+  if (argc > 1) numIterations = (unsigned)atoi(argv[1]);
+  if (numIterations == 0) numIterations = 1;
+
+  // We need lots of sockets, so raise our descriptor limit as far as we can:
+  struct rlimit rl;
+  if (getrlimit(RLIMIT_NOFILE, &rl) == 0) {
+    rl.rlim_cur = rl.rlim_max;
+    setrlimit(RLIMIT_NOFILE, &rl);
+  }
+
+  unsigned const socketCounts[] = { 100, 1000, 10000 };
+  for (unsigned i = 0; i < sizeof socketCounts/sizeof socketCounts[0]; ++i) {
+    unsigned numSockets = socketCounts[i];
+
+    // (We use a "maxSchedulerGranularity" of 0, so that periodic 'ticks' don't distort the result.)
+    BasicTaskScheduler* selectScheduler = BasicTaskScheduler::createNew(0);
+    report("BasicTaskScheduler", numSockets, runBenchmark(selectScheduler, numSockets, numIterations));
+    delete selectScheduler;
+
+#if defined(__linux__)
+    EpollTaskScheduler* epollScheduler = EpollTaskScheduler::createNew(0);
+    if (epollScheduler != NULL) {
+      report("EpollTaskScheduler", numSockets, runBenchmark(epollScheduler, numSockets, numIterations));
+      delete epollScheduler;
+    }
+#endif
+  }
+
+  runTimerBenchmark(100000); // (not a multiple of 7, so that every timer gets unscheduled)
+
+  unsigned const posterCounts[] = { 1, 4 };
+  for (unsigned i = 0; i < sizeof posterCounts/sizeof posterCounts[0]; ++i) {
+    BasicTaskScheduler* selectScheduler = BasicTaskScheduler::createNew();
+    runPostEventBenchmark(selectScheduler, "BasicTaskScheduler", posterCounts[i]);
+    delete selectScheduler;
+
+#if defined(__linux__)
+    EpollTaskScheduler* epollScheduler = EpollTaskScheduler::createNew();
+    if (epollScheduler != NULL) {
+      runPostEventBenchmark(epollScheduler, "EpollTaskScheduler", posterCounts[i]);
+      delete epollScheduler;
+    }
+#endif
+  }
+
+  return 0;
+}